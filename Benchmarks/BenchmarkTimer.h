@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <chrono>
+
+//================================================================================
+// Benchmark Timer
+// Shared by the micro benchmarks. Each prints a table to stdout, -quick cuts
+// the runs down so CTest can smoke test them without timing anything useful.
+//================================================================================
+struct BenchmarkOptions
+{
+	bool quick = false;
+	const char* pAssetPath = "NormalMapping/Assets/Models"; // relative to the repository root
+};
+
+inline BenchmarkOptions parse_benchmark_options(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-quick") == 0)
+		{
+			options.quick = true;
+		}
+		else if (strcmp(argv[i], "-assets") == 0 && i + 1 < argc)
+		{
+			options.pAssetPath = argv[++i];
+		}
+	}
+	return options;
+}
+
+// Mean milliseconds per call over kRuns calls, after one call to warm the caches.
+template <typename Fn>
+f64 time_ms(const u32 kRuns, Fn fn)
+{
+	fn();
+	const auto kStart = std::chrono::high_resolution_clock::now();
+	for (u32 run = 0; run < kRuns; ++run)
+	{
+		fn();
+	}
+	const auto kEnd = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<f64, std::milli>(kEnd - kStart).count() / (f64)std::max(kRuns, 1u);
+}
@@ -0,0 +1,54 @@
+#include "BenchmarkTimer.h"
+#include "Culling.h"
+
+//================================================================================
+// Frustum culling throughput per kernel for spheres and boxes scattered about
+// the frustum, and the cost of merging the two eyes' visible lists.
+//================================================================================
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions kOptions = parse_benchmark_options(argc, argv);
+	const u32 kRuns = kOptions.quick ? 2 : 50;
+	const char* kKernelNames[] = { "scalar", "sse", "avx" };
+
+	v4 leftPlanes[kNumFrustumPlanes];
+	v4 rightPlanes[kNumFrustumPlanes];
+	const m4x4 kProj = m4x4::CreatePerspectiveOffCenter(-0.6f, 0.5f, -0.5f, 0.5f, 0.1f, 200.f);
+	extract_frustum_planes(m4x4::CreateTranslation(0.032f, 0.f, 0.f) * kProj, leftPlanes);
+	extract_frustum_planes(m4x4::CreateTranslation(-0.032f, 0.f, 0.f) * kProj, rightPlanes);
+
+	std::printf("%-10s %-8s %10s %10s %12s %10s %12s\n", "volumes", "kernel", "visible", "spheres ms", "ns/sphere", "boxes ms", "ns/box");
+	for (const u32 kCount : { 10000u, 100000u, 1000000u })
+	{
+		Random random(kCount);
+		SphereBoundsSoA spheres;
+		AabbBoundsSoA aabbs;
+		spheres.reserve(kCount);
+		aabbs.reserve(kCount);
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			const v3 kCenter(random.range(-150.f, 150.f), random.range(-20.f, 20.f), random.range(-150.f, 150.f));
+			spheres.add(kCenter, random.range(0.5f, 2.f));
+			aabbs.add(kCenter, v3(random.range(0.5f, 2.f), random.range(0.5f, 2.f), random.range(0.5f, 2.f)));
+		}
+
+		std::vector<u32> visible(kCount);
+		for (u32 kernel = 0; kernel <= (u32)best_cull_kernel(); ++kernel)
+		{
+			u32 count = 0;
+			const f64 kSphereMs = time_ms(kRuns, [&]() { count = cull_spheres((CullKernel)kernel, leftPlanes, spheres, visible.data()); });
+			const f64 kAabbMs = time_ms(kRuns, [&]() { cull_aabbs((CullKernel)kernel, leftPlanes, aabbs, visible.data()); });
+			std::printf("%-10u %-8s %10u %10.3f %12.2f %10.3f %12.2f\n", kCount, kKernelNames[kernel], count,
+				kSphereMs, kSphereMs * 1e6 / kCount, kAabbMs, kAabbMs * 1e6 / kCount);
+		}
+
+		// Both eyes separately then merged, against culling once with a combined frustum would need.
+		std::vector<u32> left(kCount), right(kCount), merged(2 * kCount);
+		const u32 kLeft = cull_spheres(leftPlanes, spheres, left.data());
+		const u32 kRight = cull_spheres(rightPlanes, spheres, right.data());
+		u32 kMerged = 0;
+		const f64 kMergeMs = time_ms(kRuns, [&]() { kMerged = merge_visible(left.data(), kLeft, right.data(), kRight, merged.data()); });
+		std::printf("%-10u %-8s %10u %10.3f %12.2f   (merge of both eyes)\n", kCount, "merge", kMerged, kMergeMs, kMergeMs * 1e6 / std::max(kLeft + kRight, 1u));
+	}
+	return 0;
+}
@@ -0,0 +1,283 @@
+#include "BenchmarkTimer.h"
+#include "Benchmark.h"
+#include "FrameLifecycle.h"
+#include "MeshSimplify.h"
+#include "PerfStats.h"
+#include "PoseSource.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "StereoFrustum.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+//================================================================================
+// Headless Frame Benchmark
+// The app's -benchmark run with no window, device or headset, so the CPU side
+// of a frame can be measured and compared on any machine.
+//
+// Takes the app's arguments: -frames, -warmup, -camera, -out and the scene
+// generator's -scene, -instances, -animated and -seed, and -assets for where
+// the models are. The meshes are the app's models loaded and simplified as
+// it loads them, with no device buffers behind them. Each frame runs the
+// app's Scene steps: spin the animated objects, update the transforms and
+// the bounds of what moved, cull against the frustum enclosing both eyes,
+// pick the levels of detail, then queue and sort what is visible and submit
+// it to a recording backend. The clock, the head and the camera are the
+// Benchmark's stand ins, so every run does the same work, and the report is
+// the same JSON the app writes.
+//
+// -quick runs a few frames of a small scene, CTest uses it as a smoke test.
+//================================================================================
+namespace
+{
+	// The app's meshes in the order its objects index them, scaled as it loads them. No file is the cube.
+	struct HeadlessModel
+	{
+		const char* pFile;
+		f32 scale;
+	};
+
+	const HeadlessModel kModels[] =
+	{
+		{ nullptr, 0.5f },
+		{ "WoodCrate/wc1.obj", 1.f },
+		{ "Plane/plane.obj", 2.f },
+		{ "House/house.obj", 0.006f },
+		{ "Bus/bus.obj", 0.1f },
+		{ "House2/house2.obj", 1.f },
+	};
+	const u32 kNumModels = sizeof(kModels) / sizeof(kModels[0]);
+	const u32 kNumTextures = 10;
+
+	// The app's generated types, every mesh but the floor.
+	const SceneObject kGeneratedTypes[] =
+	{
+		{ 0, 0, 0, 1 }, //cube
+		{ 1, 0, 0, 1 }, //crate
+		{ 3, 4, 0, 1 }, //house
+		{ 4, 6, 0, 1 }, //bus
+		{ 5, 8, 0, 1 }, //house2
+	};
+	const u32 kNumGeneratedTypes = sizeof(kGeneratedTypes) / sizeof(kGeneratedTypes[0]);
+
+	// The app's clip range and a headset's eyes, asymmetric like each eye's field of view, and its
+	// default level of detail error.
+	const f32 kNearClip = 0.2f;
+	const f32 kFarClip = 1000.f;
+	const FovTangents kLeftEye = { 1.3f, 1.4f, 1.2f, 1.0f };
+	const FovTangents kRightEye = { 1.3f, 1.4f, 1.0f, 1.2f };
+	const f32 kEyeWidth = 1344.f;
+	const f32 kEyeHeight = 1600.f;
+	const f32 kLodPixelError = 1.f;
+
+	// The queue only compares addresses, so shaders, meshes and textures are bytes of this.
+	u8 g_deviceObjects[1 + kNumModels + kNumTextures];
+
+	template <typename T>
+	const T* fake(const u32 i)
+	{
+		return reinterpret_cast<const T*>(&g_deviceObjects[i]);
+	}
+
+	f32 eye_pixels_per_unit(const FovTangents& fov)
+	{
+		const m4x4 kProj = m4x4::CreatePerspectiveOffCenter(-fov.left * kNearClip, fov.right * kNearClip, -fov.down * kNearClip, fov.up * kNearClip,
+			kNearClip, kFarClip);
+		return lod_pixels_per_unit(kProj, kEyeWidth, kEyeHeight);
+	}
+
+	// The bounds and levels of detail of a model, as create_mesh_from_obj and create_mesh_cube build them.
+	bool load_scene_mesh(const char* pAssetPath, const HeadlessModel& model, const u32 kIndex, SceneMesh& rMeshOut)
+	{
+		std::vector<MeshVertex> vertices;
+		std::vector<u16> indices;
+		if (model.pFile == nullptr)
+		{
+			build_cube_geometry(model.scale, vertices, indices);
+		}
+		else
+		{
+			char path[512];
+			std::snprintf(path, sizeof(path), "%s/%s", pAssetPath, model.pFile);
+			if (!load_obj_geometry(path, model.scale, vertices, indices) || indices.empty())
+			{
+				errorF("Can't load %s\n", path);
+				return false;
+			}
+		}
+
+		rMeshOut.pMesh = fake<Mesh>(1 + kIndex);
+		v3 extents;
+		compute_mesh_bounds(&vertices[0], (u32)vertices.size(), rMeshOut.boundsCenter, extents, rMeshOut.boundsRadius);
+		std::vector<u16> lodIndices;
+		rMeshOut.numLods = build_lod_chain(&vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size(), rMeshOut.lods, lodIndices);
+		return true;
+	}
+
+	class HeadlessScene
+	{
+	public:
+		bool build(const char* pAssetPath, SceneGeneratorDesc& rDesc)
+		{
+			SceneMesh meshes[kNumModels] = {};
+			for (u32 i = 0; i < kNumModels; ++i)
+			{
+				if (!load_scene_mesh(pAssetPath, kModels[i], i, meshes[i]))
+				{
+					return false;
+				}
+			}
+			const Texture* pTextures[kNumTextures];
+			for (u32 i = 0; i < kNumTextures; ++i)
+			{
+				pTextures[i] = fake<Texture>(1 + kNumModels + i);
+			}
+
+			m_scene.set_meshes(meshes, kNumModels);
+			m_scene.set_textures(pTextures, kNumTextures);
+			m_scene.add_generated(rDesc, kGeneratedTypes, kNumGeneratedTypes);
+			m_visible.resize(m_scene.size());
+			m_renderQueue.set_depth_range(kNearClip, kFarClip);
+
+			// Both eyes pick with the larger of their scales, as the app does.
+			m_pixelsPerUnit = std::max(eye_pixels_per_unit(kLeftEye), eye_pixels_per_unit(kRightEye));
+			return true;
+		}
+
+		void render_frame(const FrameLifecycle& lifecycle, PoseSource& rPoses, const v3& cameraEye, const v3& cameraTarget)
+		{
+			// Spun by the display clock, as the app does, so every run matches.
+			m_scene.animate(lifecycle.predicted_display_time());
+			const u32 kTransformUpdates = m_scene.update_transforms();
+
+			// The head turns the camera, the frustum encloses both of its eyes.
+			const PoseSample kPose = rPoses.sample(lifecycle.frame_index(), lifecycle.predicted_display_time());
+			v3 forward = v3::Transform(cameraTarget - cameraEye, kPose.eyes[0].orientation);
+			forward.Normalize();
+			const m4x4 kCenterView = m4x4::CreateLookAt(cameraEye, cameraEye + forward, v3::UnitY);
+			const f32 kEyeSeparation = v3::Distance(kPose.eyes[0].position, kPose.eyes[1].position);
+			const StereoCullFrustum kFrustum = compute_stereo_cull_frustum(kCenterView, kLeftEye, kRightEye, kEyeSeparation, kNearClip, kFarClip);
+			const u32 kNumVisible = m_scene.cull(kFrustum.planes, m_visible.data());
+
+			m_scene.select_lods(cameraEye, kNearClip, m_pixelsPerUnit, kLodPixelError);
+			const u32 kTriangles = m_scene.build_queue(m_renderQueue, fake<ShaderSet>(0), kFrustum.viewProj, m_visible.data(), kNumVisible);
+
+			{
+				PROFILE_SCOPE("Record");
+				m_backend.commands.clear();
+				m_renderQueue.submit(m_backend);
+			}
+
+			perf_count(PerfCounter::kDrawCalls, m_backend.count(RecordingQueueBackend::kDraw));
+			perf_count(PerfCounter::kTriangles, kTriangles);
+			perf_count(PerfCounter::kVisibleObjects, kNumVisible);
+			perf_count(PerfCounter::kCulledObjects, m_scene.size() - kNumVisible);
+			perf_count(PerfCounter::kTransformUpdates, kTransformUpdates);
+		}
+
+		u32 size() const { return m_scene.size(); }
+		u32 animated() const { return m_scene.animated(); }
+		const u32* lod_counts() const { return m_scene.lod_counts(); }
+
+	private:
+		Scene m_scene;
+		std::vector<u32> m_visible;
+		f32 m_pixelsPerUnit = 0.f;
+		RenderQueue m_renderQueue;
+		RecordingQueueBackend m_backend;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions kOptions = parse_benchmark_options(argc, argv);
+
+	// The app's parsers take its command line as one string.
+	std::string commandLine;
+	for (int i = 1; i < argc; ++i)
+	{
+		commandLine += (i > 1 ? " \"" : "\"") + std::string(argv[i]) + "\"";
+	}
+
+	BenchmarkDesc desc;
+	parse_benchmark_args(commandLine.c_str(), desc);
+	desc.enabled = true;
+	SceneGeneratorDesc sceneDesc;
+	parse_scene_args(commandLine.c_str(), sceneDesc);
+	if (kOptions.quick)
+	{
+		desc.frames = 30;
+		desc.warmupFrames = 5;
+		sceneDesc.count = std::min(sceneDesc.count, 2000u);
+	}
+
+	Profiler profiler;
+	profiler.init(ProfilerDesc());
+	set_current_profiler(&profiler);
+	PROFILE_THREAD("Main");
+
+	PerfStatsDesc perfDesc;
+	perfDesc.refreshMs = (f32)(1000.0 / desc.refreshRate);
+	PerfStats perfStats;
+	perfStats.init(perfDesc);
+	set_current_perf_stats(&perfStats);
+
+	// A report left by an earlier run mustn't pass for this one's.
+	std::remove(desc.outputPath.c_str());
+	Benchmark benchmark;
+	benchmark.init(desc, &profiler, &perfStats);
+	FrameLifecycle lifecycle;
+	lifecycle.init(benchmark.hmd());
+
+	HeadlessScene scene;
+	if (!scene.build(kOptions.pAssetPath, sceneDesc))
+	{
+		return 1;
+	}
+	std::printf("%s scene of %u objects, %u animated, %u frames after %u warm up\n", scene_layout_name(sceneDesc.layout), scene.size(), scene.animated(),
+		desc.frames, desc.warmupFrames);
+
+	// Not paced, each frame starts as the last ends, so the frame time is its CPU cost.
+	for (;;)
+	{
+		profiler.begin_frame();
+		if (!benchmark.begin_frame())
+		{
+			break;
+		}
+
+		const auto kStart = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_SCOPE("Frame");
+			if (lifecycle.begin_frame() != HmdFrameStatus::kRender)
+			{
+				errorF("The simulated HMD skipped a frame");
+				return 1;
+			}
+
+			v3 eye;
+			v3 target;
+			benchmark.camera(eye, target);
+			scene.render_frame(lifecycle, *benchmark.poses(), eye, target);
+			lifecycle.end_frame(nullptr, 0);
+		}
+		perfStats.end_frame(std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - kStart).count());
+	}
+
+	const std::string kSummary = perfStats.summary();
+	fputs(kSummary.c_str(), stdout);
+	const u32* pLodCounts = scene.lod_counts();
+	std::printf("LOD objects in the last frame: %u / %u / %u / %u\n", pLodCounts[0], pLodCounts[1], pLodCounts[2], pLodCounts[3]);
+	set_current_perf_stats(nullptr);
+	set_current_profiler(nullptr);
+
+	// The report is written as the last frame ends, a missing one has already been logged.
+	if (!std::ifstream(desc.outputPath.c_str()))
+	{
+		return 1;
+	}
+	std::printf("Wrote %s\n", desc.outputPath.c_str());
+	return 0;
+}
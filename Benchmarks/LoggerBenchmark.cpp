@@ -0,0 +1,149 @@
+#include "BenchmarkTimer.h"
+#include "LogRing.h"
+
+//================================================================================
+// Cost of a log call on the calling thread, against formatting the same
+// message in place with snprintf, which is the least a synchronous logger
+// pays before any output. Also with several threads logging at once, and for
+// calls the rate limit drops. The writer throws the text away, so only the
+// call is timed. Dropped counts records lost to a full ring, nonzero means
+// the timing flatters the logger, suppressed the calls the rate limit took.
+//================================================================================
+namespace
+{
+	const char* kFormat0 = "Frame submitted";
+	const char* kFormat3 = "Frame %u took %.3f ms on %s";
+	const char* kFormat6 = "Frame %u took %.3f ms on %s, %d draws, %u views, %p";
+
+	void init_logger(Logger& rLogger, const u32 kCalls, const u32 kRateLimit)
+	{
+		LoggerDesc desc;
+		desc.minLevel = LogLevel::kDebug;
+		desc.ringCapacity = kCalls;
+		desc.rateLimit = kRateLimit;
+		desc.sink = [](LogLevel, const char*) {};
+		rLogger.init(desc);
+	}
+
+	// Best of kRepeats passes of fn over kCalls, in nanoseconds per call. between runs untimed after each pass.
+	template <typename Fn, typename Between>
+	f64 best_ns_per_call(const u32 kRepeats, const u32 kCalls, Fn fn, Between between)
+	{
+		f64 best = 1e30;
+		for (u32 repeat = 0; repeat < kRepeats; ++repeat)
+		{
+			const auto kStart = std::chrono::high_resolution_clock::now();
+			fn();
+			const auto kEnd = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<f64, std::nano>(kEnd - kStart).count() / kCalls);
+			between();
+		}
+		return best;
+	}
+
+	// One of the messages above, logged or formatted i times.
+	void log_message(Logger& rLogger, const u32 kArgs, const u32 i)
+	{
+		switch (kArgs)
+		{
+		case 0: rLogger.log(LogLevel::kInfo, kFormat0); break;
+		case 3: rLogger.log(LogLevel::kInfo, kFormat3, i, (f32)i * 0.01f, "render"); break;
+		default: rLogger.log(LogLevel::kInfo, kFormat6, i, (f32)i * 0.01f, "render", (s32)i, 2u, (const void*)&rLogger); break;
+		}
+	}
+
+	void format_message(char* pBuffer, const u32 kSize, const u32 kArgs, const u32 i)
+	{
+		switch (kArgs)
+		{
+		case 0: snprintf(pBuffer, kSize, "%s", kFormat0); break;
+		case 3: snprintf(pBuffer, kSize, kFormat3, i, (f32)i * 0.01f, "render"); break;
+		default: snprintf(pBuffer, kSize, kFormat6, i, (f32)i * 0.01f, "render", (s32)i, 2u, (const void*)pBuffer); break;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions kOptions = parse_benchmark_options(argc, argv);
+	const u32 kCalls = kOptions.quick ? 1000 : 100000;
+	const u32 kRepeats = kOptions.quick ? 1 : 5;
+
+	std::printf("%-12s %-8s %-8s %12s %12s %10s %10s\n", "case", "args", "threads", "log ns", "snprintf ns", "dropped", "suppressed");
+
+	// One thread, each message size.
+	for (const u32 kArgs : { 0u, 3u, 6u })
+	{
+		Logger logger;
+		init_logger(logger, kCalls, 0);
+		logger.log(LogLevel::kInfo, "warm up"); // the first call hands the thread its ring
+
+		const f64 kLogNs = best_ns_per_call(kRepeats, kCalls, [&]()
+		{
+			for (u32 i = 0; i < kCalls; ++i)
+			{
+				log_message(logger, kArgs, i);
+			}
+		}, [&]() { logger.flush(); });
+
+		char buffer[256];
+		const f64 kFormatNs = best_ns_per_call(kRepeats, kCalls, [&]()
+		{
+			for (u32 i = 0; i < kCalls; ++i)
+			{
+				format_message(buffer, sizeof(buffer), kArgs, i);
+			}
+		}, []() {});
+		logger.shutdown();
+		std::printf("%-12s %-8u %-8u %12.1f %12.1f %10llu %10llu\n", "single", kArgs, 1u, kLogNs, kFormatNs, (unsigned long long)logger.stats().dropped,
+			(unsigned long long)logger.stats().suppressed);
+	}
+
+	// Threads logging at once, each into its own ring, so the cost per call should hold.
+	for (const u32 kThreads : { 2u, 4u, 8u })
+	{
+		Logger logger;
+		init_logger(logger, kCalls, 0);
+		std::vector<f64> threadNs(kThreads);
+		std::vector<std::thread> threads;
+		for (u32 t = 0; t < kThreads; ++t)
+		{
+			threads.emplace_back([&logger, &threadNs, t, kCalls, kRepeats]()
+			{
+				logger.log(LogLevel::kInfo, "warm up");
+				threadNs[t] = best_ns_per_call(kRepeats, kCalls, [&]()
+				{
+					for (u32 i = 0; i < kCalls; ++i)
+					{
+						log_message(logger, 3, i);
+					}
+				}, [&]() { logger.flush(); });
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		logger.shutdown();
+		std::printf("%-12s %-8u %-8u %12.1f %12s %10llu %10llu\n", "threads", 3u, kThreads, *std::max_element(threadNs.begin(), threadNs.end()), "-",
+			(unsigned long long)logger.stats().dropped, (unsigned long long)logger.stats().suppressed);
+	}
+
+	// One format over and over, all but the first few are dropped by the rate limit before the ring.
+	{
+		Logger logger;
+		init_logger(logger, kCalls, 8);
+		logger.log(LogLevel::kInfo, "warm up");
+		const f64 kLimitedNs = best_ns_per_call(kRepeats, kCalls, [&]()
+		{
+			for (u32 i = 0; i < kCalls; ++i)
+			{
+				log_message(logger, 3, i);
+			}
+		}, []() {});
+		logger.shutdown();
+		std::printf("%-12s %-8u %-8u %12.1f %12s %10llu %10llu\n", "rate limited", 3u, 1u, kLimitedNs, "-", (unsigned long long)logger.stats().dropped,
+			(unsigned long long)logger.stats().suppressed);
+	}
+	return 0;
+}
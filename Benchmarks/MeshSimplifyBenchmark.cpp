@@ -0,0 +1,138 @@
+#include "BenchmarkTimer.h"
+#include "MeshSimplify.h"
+#include <cfloat>
+
+//================================================================================
+// Level of detail chains of the scene's models, as create_mesh_from_obj builds
+// them: triangles and error per level, and the time to simplify each level
+// from the one before. Errors are in model units after the app's scale, and as
+// a share of the model's bounding box diagonal.
+//
+// The level build_lod_chain stops at is printed too, marked dropped. Locked
+// positions are where open edges meet, slides the collapses that moved a
+// corner across a uv seam.
+//
+// Then the level select_lod picks for each model at a range of distances,
+// with the pixel scale of a headset eye and the app's default error of one
+// pixel.
+//================================================================================
+namespace
+{
+	struct Model
+	{
+		const char* pName;
+		const char* pFile; // under the asset path
+		f32 scale;         // as loaded by the app
+	};
+
+	const Model kModels[] =
+	{
+		{ "bus", "Bus/bus.obj", 0.1f },
+		{ "house", "House/house.obj", 0.006f },
+		{ "house2", "House2/house2.obj", 1.f },
+		{ "truck", "Truck/truck.obj", 1.f },
+	};
+	const u32 kNumModels = sizeof(kModels) / sizeof(kModels[0]);
+
+	// One eye of a headset at its default pixel density, and the app's default error in pixels.
+	const f32 kEyeLeft = 1.2f;
+	const f32 kEyeRight = 1.f;
+	const f32 kEyeDown = 1.4f;
+	const f32 kEyeUp = 1.3f;
+	const f32 kEyeWidth = 1344.f;
+	const f32 kEyeHeight = 1600.f;
+	const f32 kLodPixelError = 1.f;
+
+	const f32 kDistances[] = { 2.f, 5.f, 10.f, 25.f, 50.f, 100.f, 200.f, 500.f };
+
+	f32 bounds_diagonal(const std::vector<MeshVertex>& vertices)
+	{
+		v3 lo(FLT_MAX, FLT_MAX, FLT_MAX);
+		v3 hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (const MeshVertex& vertex : vertices)
+		{
+			const v3 kPosition(vertex.pos);
+			lo = v3::Min(lo, kPosition);
+			hi = v3::Max(hi, kPosition);
+		}
+		return (hi - lo).Length();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions kOptions = parse_benchmark_options(argc, argv);
+	const u32 kRuns = kOptions.quick ? 1 : 10;
+
+	MeshLod chains[kNumModels][kMaxMeshLods];
+	u32 chainLengths[kNumModels];
+
+	std::printf("%-8s %-4s %10s %10s %10s %10s %10s %10s %10s\n", "model", "lod", "triangles", "error", "error %", "locked", "slides", "rejected", "ms");
+	for (u32 m = 0; m < kNumModels; ++m)
+	{
+		const Model& model = kModels[m];
+		char path[512];
+		std::snprintf(path, sizeof(path), "%s/%s", kOptions.pAssetPath, model.pFile);
+		std::vector<MeshVertex> vertices;
+		std::vector<u16> indices;
+		if (!load_obj_geometry(path, model.scale, vertices, indices) || indices.empty())
+		{
+			errorF("Can't load %s\n", path);
+			return 1;
+		}
+		const f32 kDiagonal = bounds_diagonal(vertices);
+
+		std::vector<u16> lodIndices;
+		const f64 kChainMs = time_ms(kRuns, [&]()
+		{
+			chainLengths[m] = build_lod_chain(&vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size(), chains[m], lodIndices);
+		});
+		std::printf("%-8s %-4u %10u %10.4f %10.3f %10s %10s %10s %10s\n", model.pName, 0u, (u32)indices.size() / 3, 0.f, 0.f, "-", "-", "-", "-");
+
+		// Each level from the level before, with the target and the stopping rule of build_lod_chain.
+		std::vector<u16> previous = indices;
+		f32 error = 0.f;
+		for (u32 i = 1; i < kMaxMeshLods; ++i)
+		{
+			const u32 kTarget = ((u32)previous.size() / 6) * 3;
+			std::vector<u16> level;
+			SimplifyStats stats = {};
+			f32 levelError = 0.f;
+			const f64 kMs = time_ms(kRuns, [&]()
+			{
+				levelError = simplify_mesh(&vertices[0], (u32)vertices.size(), &previous[0], (u32)previous.size(), kTarget, level, &stats);
+			});
+			error += levelError;
+
+			const bool kDropped = level.empty() || level.size() * 4 > previous.size() * 3;
+			std::printf("%-8s %-4u %10u %10.4f %10.3f %10u %10u %10u %10.3f%s\n", model.pName, i, (u32)level.size() / 3, error,
+				100.f * error / std::max(kDiagonal, FLT_MIN), stats.locked, stats.slides, stats.rejected, kMs, kDropped ? " dropped" : "");
+			if (kDropped)
+			{
+				break;
+			}
+			previous.swap(level);
+		}
+		std::printf("%-8s %-4s %10s %10s %10s %10s %10s %10s %10.3f\n", model.pName, "all", "-", "-", "-", "-", "-", "-", kChainMs);
+	}
+
+	const f32 kNear = 0.2f;
+	const m4x4 kProj = m4x4::CreatePerspectiveOffCenter(-kEyeLeft * kNear, kEyeRight * kNear, -kEyeDown * kNear, kEyeUp * kNear, kNear, 1000.f);
+	const f32 kPixelsPerUnit = lod_pixels_per_unit(kProj, kEyeWidth, kEyeHeight);
+	std::printf("\nlevel at distance, %.0f pixels per unit, %.0f pixel error\n%-8s", kPixelsPerUnit, kLodPixelError, "model");
+	for (const f32 kDistance : kDistances)
+	{
+		std::printf(" %6.0fm", kDistance);
+	}
+	std::printf("\n");
+	for (u32 m = 0; m < kNumModels; ++m)
+	{
+		std::printf("%-8s", kModels[m].pName);
+		for (const f32 kDistance : kDistances)
+		{
+			std::printf(" %7u", select_lod(chains[m], chainLengths[m], kDistance, kPixelsPerUnit, kLodPixelError));
+		}
+		std::printf("\n");
+	}
+	return 0;
+}
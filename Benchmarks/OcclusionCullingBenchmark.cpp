@@ -0,0 +1,96 @@
+#include "BenchmarkTimer.h"
+#include "OcclusionCulling.h"
+
+namespace
+{
+	const char* kKernelNames[] = { "scalar", "sse", "avx" };
+
+	OccluderMesh make_box(const v3& extents)
+	{
+		OccluderMesh mesh;
+		for (u32 i = 0; i < 8; ++i)
+		{
+			mesh.positions.push_back(v3((i & 1) ? extents.x : -extents.x, (i & 2) ? extents.y : -extents.y, (i & 4) ? extents.z : -extents.z));
+		}
+		const u16 kIndices[] = { 0,1,3,0,3,2, 4,6,7,4,7,5, 0,4,5,0,5,1, 2,3,7,2,7,6, 0,2,6,0,6,4, 1,5,7,1,7,3 };
+		mesh.indices.assign(kIndices, kIndices + 36);
+		return mesh;
+	}
+}
+
+//================================================================================
+// Stereo occlusion buffers of 256x224 per eye, as the sample uses, filled with
+// box occluders. Times a frame's render per kernel and worker count, then the
+// box tests against both eyes.
+//================================================================================
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions kOptions = parse_benchmark_options(argc, argv);
+	const u32 kRuns = kOptions.quick ? 2 : 100;
+	const u32 kWidth = 256;
+	const u32 kHeight = 224;
+
+	Random random(7);
+	std::vector<OccluderMesh> meshes;
+	for (u32 i = 0; i < 6; ++i)
+	{
+		meshes.push_back(make_box(v3(random.range(0.5f, 3.f), random.range(0.5f, 3.f), random.range(0.2f, 2.f))));
+	}
+
+	const m4x4 kProj = m4x4::CreatePerspectiveOffCenter(-0.2f, 0.2f, -0.22f, 0.22f, 0.2f, 1000.f);
+	const m4x4 kViewProj[2] = { m4x4::CreateTranslation(0.032f, 0.f, 0.f) * kProj, m4x4::CreateTranslation(-0.032f, 0.f, 0.f) * kProj };
+
+	std::printf("%-10s %-8s %-8s %10s %10s\n", "occluders", "kernel", "workers", "triangles", "ms");
+	for (const u32 kOccluders : { 50u, 200u, 800u })
+	{
+		std::vector<OccluderInstance> occluders;
+		for (u32 i = 0; i < kOccluders; ++i)
+		{
+			const v3 kPosition(random.range(-30.f, 30.f), random.range(-10.f, 10.f), random.range(2.f, 80.f));
+			occluders.push_back({ &meshes[i % meshes.size()], m4x4::CreateTranslation(kPosition) });
+		}
+
+		for (u32 kernel = 0; kernel <= (u32)best_cull_kernel(); ++kernel)
+		{
+			for (const u32 kWorkers : { 0u, 1u, 3u })
+			{
+				OcclusionCuller culler;
+				culler.init(kWorkers, kWidth, kHeight);
+				const f64 kMs = time_ms(kRuns, [&]()
+				{
+					culler.render((CullKernel)kernel, kViewProj, 2, occluders.data(), (u32)occluders.size());
+				});
+				std::printf("%-10u %-8s %-8u %10u %10.3f\n", kOccluders, kKernelNames[kernel], kWorkers, culler.stats().triangles, kMs);
+			}
+		}
+	}
+
+	// Box tests against both eyes of the last scene.
+	OcclusionCuller culler;
+	culler.init(0, kWidth, kHeight);
+	std::vector<OccluderInstance> occluders;
+	for (u32 i = 0; i < 200; ++i)
+	{
+		const v3 kPosition(random.range(-30.f, 30.f), random.range(-10.f, 10.f), random.range(2.f, 80.f));
+		occluders.push_back({ &meshes[i % meshes.size()], m4x4::CreateTranslation(kPosition) });
+	}
+	culler.render(best_cull_kernel(), kViewProj, 2, occluders.data(), (u32)occluders.size());
+
+	const u32 kTests = 10000;
+	std::vector<v3> centers(kTests);
+	for (v3& center : centers)
+	{
+		center = v3(random.range(-30.f, 30.f), random.range(-10.f, 10.f), random.range(2.f, 100.f));
+	}
+	u32 occluded = 0;
+	const f64 kTestMs = time_ms(kRuns, [&]()
+	{
+		occluded = 0;
+		for (const v3& center : centers)
+		{
+			occluded += culler.is_occluded(center, v3(0.5f, 0.5f, 0.5f)) ? 1 : 0;
+		}
+	});
+	std::printf("\n%u box tests: %.3f ms, %.1f ns per box, %u occluded\n", kTests, kTestMs, kTestMs * 1e6 / kTests, occluded);
+	return 0;
+}
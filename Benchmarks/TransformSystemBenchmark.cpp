@@ -0,0 +1,61 @@
+#include "BenchmarkTimer.h"
+#include "TransformSystem.h"
+
+//================================================================================
+// Transform update cost per kernel as the share of moving transforms grows,
+// for a scene laid out like the stress scenes: mostly static roots with a few
+// small hierarchies, and the animated ones scattered through the arrays.
+//================================================================================
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions kOptions = parse_benchmark_options(argc, argv);
+	const u32 kRuns = kOptions.quick ? 2 : 20;
+	const char* kKernelNames[] = { "scalar", "sse" };
+
+	std::printf("%-10s %-8s %-8s %10s %10s %12s\n", "transforms", "moving", "kernel", "updated", "ms", "ns/updated");
+	for (const u32 kCount : { 10000u, 100000u, 1000000u })
+	{
+		// Every eighth transform is a root with seven children.
+		Random random(kCount);
+		TransformSystem transforms;
+		transforms.reserve(kCount);
+		u32 root = TransformSystem::kNoParent;
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			const u32 kParent = (i % 8 == 0) ? TransformSystem::kNoParent : root;
+			const u32 kIndex = transforms.create(kParent, v3(random.range(-100.f, 100.f), 0.f, random.range(-100.f, 100.f)), quat::Identity, v3::One);
+			root = (i % 8 == 0) ? kIndex : root;
+		}
+		transforms.update();
+
+		for (const f32 kFraction : { 0.f, 0.001f, 0.01f, 0.1f, 1.f })
+		{
+			std::vector<u32> moving;
+			for (u32 i = 0; i < kCount; ++i)
+			{
+				if (random.next_f32() < kFraction)
+				{
+					moving.push_back(i);
+				}
+			}
+
+			for (u32 kernel = 0; kernel <= (u32)TransformKernel::kSSE; ++kernel)
+			{
+				f32 angle = 0.f;
+				u32 updated = 0;
+				const f64 kMs = time_ms(kRuns, [&]()
+				{
+					angle += 0.01f;
+					const quat kRotation = quat::CreateFromAxisAngle(v3::UnitY, angle);
+					for (const u32 i : moving)
+					{
+						transforms.set_rotation(i, kRotation);
+					}
+					updated = transforms.update((TransformKernel)kernel);
+				});
+				std::printf("%-10u %-8.3f %-8s %10u %10.3f %12.2f\n", kCount, kFraction, kKernelNames[kernel], updated, kMs, kMs * 1e6 / std::max(updated, 1u));
+			}
+		}
+	}
+	return 0;
+}
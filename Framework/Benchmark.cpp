@@ -0,0 +1,341 @@
+#include "Benchmark.h"
+#include "FrameLifecycle.h"
+#include "PoseSource.h"
+#include "Profiler.h"
+#include "PerfStats.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	void write_json_string(std::ofstream& rFile, const char* pText)
+	{
+		rFile << '"';
+		for (const char* p = pText; *p; ++p)
+		{
+			if (*p == '"' || *p == '\\')
+			{
+				rFile << '\\';
+			}
+			rFile << *p;
+		}
+		rFile << '"';
+	}
+}
+
+std::vector<std::string> split_command_line(const char* pCommandLine)
+{
+	std::vector<std::string> args;
+	const char* p = pCommandLine ? pCommandLine : "";
+	while (*p)
+	{
+		while (*p == ' ' || *p == '\t')
+		{
+			++p;
+		}
+		if (!*p)
+		{
+			break;
+		}
+		std::string arg;
+		const bool kQuoted = *p == '"';
+		if (kQuoted)
+		{
+			++p;
+		}
+		while (*p && (kQuoted ? *p != '"' : (*p != ' ' && *p != '\t')))
+		{
+			arg += *p++;
+		}
+		if (kQuoted && *p == '"')
+		{
+			++p;
+		}
+		args.push_back(arg);
+	}
+	return args;
+}
+
+//================================================================================
+// Camera Path
+//================================================================================
+
+CameraPath CameraPath::orbit(const v3& kCenter, const f32 kRadius, const f32 kSeconds, const u32 kKeys)
+{
+	ASSERT(kKeys >= 2 && kSeconds > 0.f);
+	CameraPath path;
+	for (u32 i = 0; i < kKeys; ++i)
+	{
+		const f32 kFraction = (f32)i / (f32)(kKeys - 1);
+		const f32 kAngle = kFraction * 6.2831853f;
+		path.add({ kFraction * kSeconds, kCenter + v3(sinf(kAngle) * kRadius, 0.f, cosf(kAngle) * kRadius), kCenter });
+	}
+	return path;
+}
+
+void CameraPath::add(const CameraKey& key)
+{
+	ASSERT(m_keys.empty() || key.time >= m_keys.back().time);
+	m_keys.push_back(key);
+}
+
+bool CameraPath::load(const char* pPath)
+{
+	std::ifstream file(pPath);
+	if (!file)
+	{
+		return false;
+	}
+
+	m_keys.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		std::istringstream fields(line);
+		CameraKey key;
+		if (!(fields >> key.time >> key.eye.x >> key.eye.y >> key.eye.z >> key.target.x >> key.target.y >> key.target.z)
+			|| (!m_keys.empty() && key.time < m_keys.back().time))
+		{
+			errorF("Camera path %s: bad key \"%s\"", pPath, line.c_str());
+			m_keys.clear();
+			return false;
+		}
+		m_keys.push_back(key);
+	}
+	return !m_keys.empty();
+}
+
+bool CameraPath::save(const char* pPath) const
+{
+	std::ofstream file(pPath, std::ios::out | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	char line[256];
+	file << "# time eye.x eye.y eye.z target.x target.y target.z\n";
+	for (const CameraKey& key : m_keys)
+	{
+		snprintf(line, sizeof(line), "%.4f %.4f %.4f %.4f %.4f %.4f %.4f\n", key.time, key.eye.x, key.eye.y, key.eye.z,
+			key.target.x, key.target.y, key.target.z);
+		file << line;
+	}
+	return (bool)file;
+}
+
+void CameraPath::sample(const f32 kTime, v3& rEye, v3& rTarget) const
+{
+	ASSERT(!m_keys.empty());
+	if (kTime <= m_keys.front().time || m_keys.size() == 1)
+	{
+		rEye = m_keys.front().eye;
+		rTarget = m_keys.front().target;
+		return;
+	}
+	if (kTime >= m_keys.back().time)
+	{
+		rEye = m_keys.back().eye;
+		rTarget = m_keys.back().target;
+		return;
+	}
+
+	// The first key after kTime, there is one before it as kTime is past the front.
+	const auto it = std::upper_bound(m_keys.begin(), m_keys.end(), kTime, [](const f32 kT, const CameraKey& key) { return kT < key.time; });
+	const CameraKey& a = *(it - 1);
+	const CameraKey& b = *it;
+	const f32 kSpan = b.time - a.time;
+	const f32 kT = kSpan > 0.f ? (kTime - a.time) / kSpan : 1.f;
+	rEye = v3::Lerp(a.eye, b.eye, kT);
+	rTarget = v3::Lerp(a.target, b.target, kT);
+}
+
+//================================================================================
+// Arguments
+//================================================================================
+
+bool parse_benchmark_args(const char* pCommandLine, BenchmarkDesc& rDesc)
+{
+	rDesc.commandLine = pCommandLine ? pCommandLine : "";
+	const std::vector<std::string> kArgs = split_command_line(pCommandLine);
+	for (size_t i = 0; i < kArgs.size(); ++i)
+	{
+		const std::string& arg = kArgs[i];
+		const bool kHasValue = i + 1 < kArgs.size();
+		if (arg == "-benchmark")
+		{
+			rDesc.enabled = true;
+		}
+		else if (arg == "-frames" && kHasValue)
+		{
+			rDesc.frames = (u32)strtoul(kArgs[++i].c_str(), nullptr, 10);
+		}
+		else if (arg == "-warmup" && kHasValue)
+		{
+			rDesc.warmupFrames = (u32)strtoul(kArgs[++i].c_str(), nullptr, 10);
+		}
+		else if (arg == "-camera" && kHasValue)
+		{
+			rDesc.cameraPath = kArgs[++i];
+		}
+		else if (arg == "-out" && kHasValue)
+		{
+			rDesc.outputPath = kArgs[++i];
+		}
+		else if (arg == "-recordcamera" && kHasValue)
+		{
+			rDesc.recordCameraPath = kArgs[++i];
+		}
+	}
+
+	if (rDesc.frames == 0)
+	{
+		rDesc.frames = 1;
+	}
+	return rDesc.enabled;
+}
+
+//================================================================================
+// Benchmark
+//================================================================================
+
+Benchmark::Benchmark()
+	: m_pProfiler(nullptr)
+	, m_pStats(nullptr)
+	, m_frame(0)
+	, m_finished(false)
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+void Benchmark::init(const BenchmarkDesc& desc, Profiler* pProfiler, PerfStats* pStats)
+{
+	ASSERT(pProfiler && pStats && desc.refreshRate > 0.0);
+	m_desc = desc;
+	m_pProfiler = pProfiler;
+	m_pStats = pStats;
+	m_pHmd.reset(new SimulatedHmd(desc.refreshRate));
+	m_pPoses.reset(new SyntheticPoseSource(m_pHmd.get()));
+	m_frame = 0;
+	m_finished = false;
+
+	// Without a recording, once round the crate grid and the props over the whole run.
+	if (desc.cameraPath.empty() || !m_path.load(desc.cameraPath.c_str()))
+	{
+		if (!desc.cameraPath.empty())
+		{
+			errorF("Failed to load camera path %s, orbiting instead", desc.cameraPath.c_str());
+		}
+		const f32 kSeconds = (f32)((desc.warmupFrames + desc.frames) / desc.refreshRate);
+		m_path = CameraPath::orbit(v3(3.f, 1.5f, 2.f), 8.f, kSeconds);
+	}
+}
+
+HmdInterface* Benchmark::hmd()
+{
+	return m_pHmd.get();
+}
+
+PoseSource* Benchmark::poses()
+{
+	return m_pPoses.get();
+}
+
+bool Benchmark::begin_frame()
+{
+	if (m_finished)
+	{
+		return false;
+	}
+
+	if (m_frame == m_desc.warmupFrames)
+	{
+		m_pStats->reset();
+		m_pProfiler->start_recording();
+	}
+	else if (m_frame == m_desc.warmupFrames + m_desc.frames)
+	{
+		m_pProfiler->stop_recording();
+		m_finished = true;
+		if (write_report(m_desc.outputPath.c_str()))
+		{
+			debugF("Benchmark: wrote %u frames to %s\n", m_desc.frames, m_desc.outputPath.c_str());
+		}
+		else
+		{
+			errorF("Benchmark: failed to write %s", m_desc.outputPath.c_str());
+		}
+		return false;
+	}
+
+	m_frame++;
+	m_pHmd->advance(m_pHmd->refresh_interval());
+	return true;
+}
+
+void Benchmark::camera(v3& rEye, v3& rTarget) const
+{
+	m_path.sample((f32)m_pHmd->time_seconds(), rEye, rTarget);
+}
+
+bool Benchmark::write_report(const char* pPath) const
+{
+	std::ofstream file(pPath, std::ios::out | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	char number[128];
+	const FrameTimeHistogram& histogram = m_pStats->histogram();
+	const u64 kFrames = m_pStats->frames();
+
+	file << "{\n  \"frames\": " << kFrames << ",\n  \"warmupFrames\": " << m_desc.warmupFrames << ",\n  \"cameraPath\": ";
+	write_json_string(file, m_desc.cameraPath.empty() ? "orbit" : m_desc.cameraPath.c_str());
+	file << ",\n  \"commandLine\": ";
+	write_json_string(file, m_desc.commandLine.c_str());
+	snprintf(number, sizeof(number), "%.3f", 1000.0 / m_desc.refreshRate);
+	file << ",\n  \"refreshMs\": " << number;
+	snprintf(number, sizeof(number), "\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f", histogram.mean_ms(),
+		histogram.percentile(0.5f), histogram.percentile(0.95f), histogram.percentile(0.99f), histogram.max_ms());
+	file << ",\n  \"frameMs\": { " << number << " },\n  \"missedFrames\": " << m_pStats->missed_frames();
+
+	// CPU time summed over threads, so parallel phases can add up to more than the frame.
+	file << ",\n  \"phases\": [";
+	const std::vector<ProfilePhase> kPhases = m_pProfiler->phases();
+	for (size_t i = 0; i < kPhases.size(); ++i)
+	{
+		const ProfilePhase& phase = kPhases[i];
+		const f64 kTotalMs = profiler_ticks_to_ms(phase.totalTicks);
+		file << (i ? ",\n" : "\n") << "    { \"name\": ";
+		write_json_string(file, phase.name);
+		snprintf(number, sizeof(number), "\"calls\": %llu, \"totalMs\": %.3f, \"perFrameMs\": %.4f, \"maxMs\": %.3f", (unsigned long long)phase.calls,
+			kTotalMs, kFrames ? kTotalMs / (f64)kFrames : 0.0, profiler_ticks_to_ms(phase.maxTicks));
+		file << ", " << number << " }";
+	}
+	file << "\n  ],\n  \"droppedEvents\": " << m_pProfiler->stats().dropped;
+
+	file << ",\n  \"counters\": {";
+	for (u32 i = 0; i < kNumPerfCounters; ++i)
+	{
+		const PerfCounter kCounter = (PerfCounter)i;
+		file << (i ? ",\n" : "\n") << "    ";
+		write_json_string(file, perf_counter_name(kCounter));
+		snprintf(number, sizeof(number), "\"perFrame\": %.2f, \"total\": %llu", kFrames ? (f64)m_pStats->total(kCounter) / (f64)kFrames : 0.0,
+			(unsigned long long)m_pStats->total(kCounter));
+		file << ": { " << number << " }";
+	}
+	file << "\n  }\n}\n";
+	return (bool)file;
+}
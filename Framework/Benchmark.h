@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class HmdInterface;
+class PoseSource;
+class Profiler;
+class PerfStats;
+class SimulatedHmd;
+class SyntheticPoseSource;
+
+// Where the camera is at a time along a path.
+struct CameraKey
+{
+	f32 time; // seconds from the start of the path
+	v3 eye;
+	v3 target;
+};
+
+//================================================================================
+// Camera Path
+// Keys in time order, interpolated linearly and held at either end.
+//
+// As text, one key per line: time, eye x y z, target x y z, separated by
+// spaces. Lines starting with # are comments.
+//================================================================================
+class CameraPath
+{
+public:
+	// A circle of kRadius around kCenter at its height, looking in at it, once round in kSeconds.
+	static CameraPath orbit(const v3& kCenter, const f32 kRadius, const f32 kSeconds, const u32 kKeys = 64);
+
+	// Keys must come in time order.
+	void add(const CameraKey& key);
+	void clear() { m_keys.clear(); }
+
+	bool load(const char* pPath);
+	bool save(const char* pPath) const;
+
+	void sample(const f32 kTime, v3& rEye, v3& rTarget) const;
+
+	bool empty() const { return m_keys.empty(); }
+	u32 size() const { return (u32)m_keys.size(); }
+	f32 duration() const { return m_keys.empty() ? 0.f : m_keys.back().time; }
+
+private:
+	std::vector<CameraKey> m_keys;
+};
+
+struct BenchmarkDesc
+{
+	bool enabled = false;
+	u32 frames = 600;           // measured, after the warm up
+	u32 warmupFrames = 60;      // run first and thrown away, so caches and pools have settled
+	f64 refreshRate = 90.0;     // the simulated clock moves on one refresh per frame
+	std::string cameraPath;     // recorded path to replay, empty orbits the scene
+	std::string outputPath = "benchmark.json";
+	std::string recordCameraPath; // outside a benchmark, where to save the camera's path at exit
+	std::string commandLine;    // written to the report, so a run says what it was run with
+};
+
+// Splits on spaces, a double quoted argument can have spaces in it.
+std::vector<std::string> split_command_line(const char* pCommandLine);
+
+// Reads -benchmark, -frames N, -warmup N, -camera path, -out path and -recordcamera path.
+// Arguments it doesn't know are left for other parsers, e.g. the scene generator's. Returns rDesc.enabled.
+bool parse_benchmark_args(const char* pCommandLine, BenchmarkDesc& rDesc);
+
+//================================================================================
+// Benchmark
+// Runs a fixed number of frames with the same content every run, then writes
+// what they cost as JSON.
+//
+// Nothing in a frame depends on the wall clock or the user: time is a
+// simulated HMD clock that moves on exactly one refresh per frame, the head
+// is a scripted synthetic pose, and the camera follows a recorded or scripted
+// path by that clock. The loop isn't paced, each frame starts as soon as the
+// last ended, so the measured frame time is the CPU cost of the frame.
+//
+// The warm up frames run first, then the profiler records the measured ones
+// and the stats collector is reset for them. The report has the frame time
+// percentiles, CPU time per profiled scope and the API counts per frame.
+//================================================================================
+class Benchmark
+{
+public:
+	Benchmark();
+	~Benchmark();
+
+	void init(const BenchmarkDesc& desc, Profiler* pProfiler, PerfStats* pStats);
+
+	// The stand ins the frame loop should use instead of the headset.
+	HmdInterface* hmd();
+	PoseSource* poses();
+
+	// Start the next frame, moving the clock on. False once every frame has run, the report is written by then.
+	bool begin_frame();
+
+	// Where the camera is this frame.
+	void camera(v3& rEye, v3& rTarget) const;
+
+	f32 frame_seconds() const { return (f32)(1.0 / m_desc.refreshRate); }
+	u32 frame() const { return m_frame; }
+	bool finished() const { return m_finished; }
+
+	bool write_report(const char* pPath) const;
+
+private:
+	Benchmark(const Benchmark&) = delete;
+	Benchmark& operator=(const Benchmark&) = delete;
+
+	BenchmarkDesc m_desc;
+	Profiler* m_pProfiler;
+	PerfStats* m_pStats;
+	std::unique_ptr<SimulatedHmd> m_pHmd;
+	std::unique_ptr<SyntheticPoseSource> m_pPoses;
+	CameraPath m_path;
+	u32 m_frame;     // frames begun, warm up included
+	bool m_finished;
+};
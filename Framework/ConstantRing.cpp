@@ -0,0 +1,139 @@
+#include "ConstantRing.h"
+#include "PerfStats.h"
+
+//================================================================================
+// Constant Ring
+//================================================================================
+
+ConstantRing::ConstantRing()
+	: m_pBuffer(nullptr)
+	, m_pMapped(nullptr)
+	, m_noOverwrite(false)
+	, m_discardNext(true)
+{
+}
+
+ConstantRing::~ConstantRing()
+{
+	SAFE_RELEASE(m_pBuffer);
+}
+
+void ConstantRing::init(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, const u32 kCapacity)
+{
+	ASSERT(!m_pBuffer);
+
+	// Offset binding needs the 11.1 context and driver support for it.
+	ComPtr<ID3D11DeviceContext1> pContext1;
+	if (FAILED(pContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)pContext1.GetAddressOf())))
+	{
+		debugF("Constant ring: ID3D11DeviceContext1 unavailable, using per draw constant buffers.\n");
+		return;
+	}
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (FAILED(pDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) || !options.ConstantBufferOffsetting)
+	{
+		debugF("Constant ring: constant buffer offsetting unsupported, using per draw constant buffers.\n");
+		return;
+	}
+
+	m_noOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer != 0;
+	create_buffer(pDevice, kCapacity);
+}
+
+void ConstantRing::reserve(ID3D11Device* pDevice, const u32 kCapacity)
+{
+	ASSERT(!m_pMapped);
+	const u32 kClamped = std::min(kCapacity, kMaxCapacity);
+	if (!m_pBuffer || kClamped <= m_allocator.capacity())
+	{
+		return;
+	}
+
+	// Keep the old buffer if the new one can't be made, the ring still works at its old size.
+	ID3D11Buffer* pOld = m_pBuffer;
+	const u32 kOldCapacity = m_allocator.capacity();
+	if (create_buffer(pDevice, kClamped))
+	{
+		SAFE_RELEASE(pOld);
+	}
+	else
+	{
+		m_pBuffer = pOld;
+		m_allocator.init(kOldCapacity, kSliceAlignment);
+	}
+	m_discardNext = true;
+}
+
+bool ConstantRing::create_buffer(ID3D11Device* pDevice, const u32 kCapacity)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = RingAllocator::align_up(kCapacity, kSliceAlignment);
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	m_pBuffer = nullptr;
+	if (FAILED(pDevice->CreateBuffer(&desc, NULL, &m_pBuffer)))
+	{
+		m_pBuffer = nullptr;
+		return false;
+	}
+
+	m_allocator.init(desc.ByteWidth, kSliceAlignment);
+	return true;
+}
+
+bool ConstantRing::begin(ID3D11DeviceContext* pContext)
+{
+	ASSERT(!m_pMapped);
+	if (!m_pBuffer)
+	{
+		return false;
+	}
+
+	// Later passes of a frame append behind the slices already bound, without renaming the buffer.
+	// Discarding renames the whole buffer, slices bound by earlier passes stay valid in the old one.
+	const bool kDiscard = m_discardNext || !m_noOverwrite || pContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED;
+	D3D11_MAPPED_SUBRESOURCE subresource;
+	perf_count(PerfCounter::kMapCalls, 1);
+	if (FAILED(pContext->Map(m_pBuffer, 0, kDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &subresource)))
+	{
+		return false;
+	}
+
+	m_pMapped = (u8*)subresource.pData;
+	if (kDiscard)
+	{
+		m_allocator.reset();
+	}
+	m_discardNext = false;
+	return true;
+}
+
+bool ConstantRing::push(const void* pData, const u32 kSize, ConstantSlice& rSliceOut)
+{
+	if (!m_pMapped)
+	{
+		return false;
+	}
+
+	const u32 kOffset = m_allocator.allocate(kSize);
+	if (kOffset == RingAllocator::kInvalidOffset)
+	{
+		return false;
+	}
+
+	memcpy(m_pMapped + kOffset, pData, kSize);
+
+	rSliceOut.pBuffer = m_pBuffer;
+	constant_range(m_allocator, kOffset, kSize, rSliceOut.firstConstant, rSliceOut.numConstants);
+	return true;
+}
+
+void ConstantRing::end(ID3D11DeviceContext* pContext)
+{
+	ASSERT(m_pMapped);
+	pContext->Unmap(m_pBuffer, 0);
+	m_pMapped = nullptr;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "RingAllocator.h"
+
+// Part of a constant buffer, in the units *SetConstantBuffers1 takes.
+struct ConstantSlice
+{
+	ID3D11Buffer* pBuffer;
+	u32 firstConstant; // in 16 byte shader constants
+	u32 numConstants;
+};
+
+//================================================================================
+// Constant Ring
+// One large dynamic constant buffer, discarded once per frame. Draws take 256
+// byte aligned slices of it which are bound with D3D11.1 offsets, rather than
+// mapping (and renaming) a small buffer for every draw.
+//
+// Usage:
+//   ring.begin_frame() at the start of each frame, then for each pass:
+//   if (ring.begin(pContext))
+//   {
+//       ring.push(data, slice) for each draw...
+//       ring.end(pContext);
+//   }
+//   then bind each slice before its draw.
+//
+// A buffer can't be drawn from while it is mapped, so a pass maps it again
+// to add its slices. Only the first map of a frame discards, later ones on
+// the immediate context map with no overwrite and append after the slices
+// already bound, so the buffer is renamed once per frame. Drivers without
+// no overwrite maps of constant buffers, and deferred contexts, discard on
+// every map; slices bound before it stay valid in the renamed buffer.
+//
+// Needs ID3D11DeviceContext1 and constant buffer offsetting, supported()
+// returns false without them and callers keep using push_constant_buffer.
+//================================================================================
+class ConstantRing
+{
+public:
+	// Offsets must be multiples of 16 constants.
+	static constexpr u32 kSliceAlignment = 256;
+
+	// Largest the ring grows to, scenes needing more fall back to mapping per draw once it is full.
+	static constexpr u32 kMaxCapacity = 64 * 1024 * 1024;
+
+	ConstantRing();
+	~ConstantRing();
+
+	void init(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, const u32 kCapacity);
+
+	// Grow the buffer to hold kCapacity bytes of slices, up to kMaxCapacity. Never shrinks, not while mapped.
+	void reserve(ID3D11Device* pDevice, const u32 kCapacity);
+
+	bool supported() const { return m_pBuffer != nullptr; }
+
+	// The next begin discards the buffer and slices start from the front again.
+	void begin_frame() { m_discardNext = true; }
+
+	// Map the buffer to add slices, false if the ring is unsupported or the map failed.
+	bool begin(ID3D11DeviceContext* pContext);
+
+	// Copy kSize bytes into the next slice, false when the ring is full or not mapped.
+	bool push(const void* pData, const u32 kSize, ConstantSlice& rSliceOut);
+
+	template<typename ConstantBufferType>
+	bool push(const ConstantBufferType& rData, ConstantSlice& rSliceOut)
+	{
+		return push(&rData, sizeof(ConstantBufferType), rSliceOut);
+	}
+
+	// Unmap, slices can be bound from here on.
+	void end(ID3D11DeviceContext* pContext);
+
+	const RingAllocator& allocator() const { return m_allocator; }
+
+private:
+	ConstantRing(const ConstantRing&) = delete;
+	ConstantRing& operator=(const ConstantRing&) = delete;
+
+	bool create_buffer(ID3D11Device* pDevice, const u32 kCapacity);
+
+	ID3D11Buffer* m_pBuffer;
+	u8* m_pMapped;
+	RingAllocator m_allocator;
+	bool m_noOverwrite; // the driver can map constant buffers with no overwrite
+	bool m_discardNext;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////
+// Core header
+// Types, maths and debug helpers with no Windows or D3D dependency of their
+// own, so the CPU only modules (culling, transforms, queues, profilers...)
+// can be built and tested on any platform. CommonHeader.h adds the Windows,
+// D3D and UI headers on top of this for everything that renders.
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <functional>
+
+//////////////////////////////////////////////////////////////////////////
+// Maths related headers
+// SimpleMath wants the D3D viewport types, so it comes with d3d11.h on
+// Windows. Elsewhere PortableMath.h stands in with the same types.
+//////////////////////////////////////////////////////////////////////////
+#if defined(_WIN32)
+	#ifndef NOIME
+		#define NOIME
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+	#include <d3d11.h>
+	#include <DirectXMath.h>
+	#include "DirectXTK/SimpleMath.h"
+#else
+	#include "PortableMath.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Common game industry typedefs
+//  * Very compact when used in expressions.
+//  * Express the size in bytes.
+//////////////////////////////////////////////////////////////////////////
+
+// Unsigned
+using u8 = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+
+// Signed
+using s8 = int8_t;
+using s16 = int16_t;
+using s32 = int32_t;
+using s64 = int64_t;
+
+// Floating point
+using f32 = float;
+using f64 = double;
+
+// Memory
+using memtype_t = u8;
+constexpr u64 KB = 1024;
+constexpr u64 MB = 1024 * KB;
+
+// Vector maths.
+using v2 = DirectX::SimpleMath::Vector2;
+using v3 = DirectX::SimpleMath::Vector3;
+using v4 = DirectX::SimpleMath::Vector4;
+using m4x4 = DirectX::SimpleMath::Matrix;
+using m3x3 = DirectX::XMFLOAT3X3;
+using quat = DirectX::SimpleMath::Quaternion;
+
+//////////////////////////////////////////////////////////////////////////
+// Useful assertion macro
+//////////////////////////////////////////////////////////////////////////
+
+#if defined(_MSC_VER)
+	#define DEBUG_BREAK() __debugbreak()
+#else
+	#define DEBUG_BREAK() __builtin_trap()
+#endif
+
+#define ASSERT(x) if(!(x)){ DEBUG_BREAK(); }
+
+// ========================================================
+// Debug printing functions
+// ========================================================
+
+// Prints error to standard error stream.
+void errorF(const char * format, ...);
+
+// Printf to message box and abort
+void panicF(const char * format, ...);
+
+// Printf to console and debug output.
+void debugF(const char * format, ...);
+
+
+// ========================================================
+// Frequently used maths
+// ========================================================
+
+constexpr f32 kfPI = 3.1415926535897931f;
+constexpr f32 kfHalfPI = 0.5f * kfPI;
+constexpr f32 kfTwoPI = 2.0f * kfPI;
+
+// Angle in degrees to angle in radians
+constexpr f32 degToRad(const f32 degrees)
+{
+	return degrees * kfPI / 180.0f;
+}
+
+// Angle in radians to angle in degrees
+constexpr f32 radToDeg(const f32 radians)
+{
+	return radians * 180.0f / kfPI;
+}
+
+//================================================================================
+// Random
+// PCG32, small and fast with good statistics. The same seed gives the same
+// sequence on every platform, unlike rand(), so generated content repeats.
+//================================================================================
+struct Random
+{
+	u64 state;
+	u64 increment; // odd, picks one of 2^63 streams
+
+	explicit Random(const u64 kSeed = 0x853c49e6748fea9bull, const u64 kStream = 0xda3e39cb94b95bdbull)
+	{
+		seed(kSeed, kStream);
+	}
+
+	void seed(const u64 kSeed, const u64 kStream = 0xda3e39cb94b95bdbull)
+	{
+		state = 0;
+		increment = (kStream << 1) | 1;
+		next_u32();
+		state += kSeed;
+		next_u32();
+	}
+
+	u32 next_u32()
+	{
+		const u64 kOld = state;
+		state = kOld * 6364136223846793005ull + increment;
+		const u32 kXorShifted = (u32)(((kOld >> 18) ^ kOld) >> 27);
+		const u32 kRot = (u32)(kOld >> 59);
+		return (kXorShifted >> kRot) | (kXorShifted << ((32 - kRot) & 31));
+	}
+
+	// [0, 1), the top 24 bits so every value is exact.
+	f32 next_f32() { return (f32)(next_u32() >> 8) * (1.0f / 16777216.0f); }
+
+	// [min, max)
+	f32 range(const f32 kMin, const f32 kMax) { return kMin + (kMax - kMin) * next_f32(); }
+
+	// [0, kCount), multiply and shift rather than modulo, the bias is negligible for small counts.
+	u32 below(const u32 kCount) { return (u32)(((u64)next_u32() * kCount) >> 32); }
+};
+
+// Backs the randf helpers, reseed it for repeatable runs.
+inline Random& global_random()
+{
+	static Random s_random;
+	return s_random;
+}
+
+inline void seed_random(const u64 kSeed) { global_random().seed(kSeed); }
+
+// Random numbers [0, 1) and [-1, 1) for floats and vectors.
+inline f32 randf_norm() { return global_random().next_f32(); }
+inline f32 randf() { return randf_norm() * 2.0f - 1.0f; }
+inline v2 randv2() { return v2(randf(),randf()); }
+inline v3 randv3() { return v3(randf(), randf(), randf()); }
+inline v4 randv4() { return v4(randf(), randf(), randf(), randf()); }
+
+
+// Helper for packing float3x3 matrices.
+// These are tricky because HLSL packs them as 3 * float4 with alignment.
+inline void pack_upper_float3x3(const m4x4& m, v4* v)
+{
+	v[0].x = m._11;
+	v[0].y = m._12;
+	v[0].z = m._13;
+
+	v[1].x = m._21;
+	v[1].y = m._22;
+	v[1].z = m._23;
+
+	v[2].x = m._31;
+	v[2].y = m._32;
+	v[2].z = m._33;
+}
+
+// Helper for packing an affine transform as 3 * float4.
+// Each row is a column of the row vector matrix m, so the shader transforms a point with one dot per row.
+inline void pack_affine_float3x4(const m4x4& m, v4* v)
+{
+	v[0] = v4(m._11, m._21, m._31, m._41);
+	v[1] = v4(m._12, m._22, m._32, m._42);
+	v[2] = v4(m._13, m._23, m._33, m._43);
+}
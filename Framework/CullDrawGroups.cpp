@@ -0,0 +1,113 @@
+#include "CullDrawGroups.h"
+
+namespace
+{
+	// Same test as sphere_visible in CullingShaders.fx, and as cull_spheres, the plane equation in the same order.
+	bool sphere_visible(const CullConstants& constants, const v4& sphere)
+	{
+		const f32 kNegRadius = -sphere.w;
+		for (u32 view = 0; view < constants.viewCount; ++view)
+		{
+			const v4* pPlanes = &constants.planes[view * kNumFrustumPlanes];
+			bool inside = true;
+			for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+			{
+				const v4& plane = pPlanes[p];
+				const f32 d = plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w;
+				inside &= !(d < kNegRadius);
+			}
+			if (inside)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool same_args(const DrawIndexedIndirectArgs& a, const DrawIndexedIndirectArgs& b)
+	{
+		return a.indexCountPerInstance == b.indexCountPerInstance && a.instanceCount == b.instanceCount && a.startIndexLocation == b.startIndexLocation
+			&& a.baseVertexLocation == b.baseVertexLocation && a.startInstanceLocation == b.startInstanceLocation;
+	}
+}
+
+CullConstants make_cull_constants(const m4x4* pViewProj, const u32 kViews)
+{
+	ASSERT(kViews > 0 && kViews <= kMaxViews);
+	CullConstants constants = {};
+	for (u32 view = 0; view < kViews; ++view)
+	{
+		extract_frustum_planes(pViewProj[view], &constants.planes[view * kNumFrustumPlanes]);
+	}
+	constants.viewCount = kViews;
+	return constants;
+}
+
+void build_cull_slots(const CullDrawGroup* pGroups, const u32 kNumGroups, const u32* pSlotObjects, const u32 kNumSlots,
+	std::vector<CullSlot>& rSlotsOut, std::vector<DrawIndexedIndirectArgs>& rArgsOut)
+{
+	// Each slot carries its group, so a thread culling one object knows where to count it.
+	rSlotsOut.resize(kNumSlots);
+	rArgsOut.resize(kNumGroups);
+	for (u32 g = 0; g < kNumGroups; ++g)
+	{
+		const CullDrawGroup& group = pGroups[g];
+		ASSERT(group.firstSlot + group.numObjects <= kNumSlots);
+		for (u32 slot = group.firstSlot; slot < group.firstSlot + group.numObjects; ++slot)
+		{
+			rSlotsOut[slot] = { pSlotObjects[slot], g };
+		}
+
+		// SV_InstanceID doesn't include StartInstanceLocation, the draws pass firstSlot in their constants instead.
+		rArgsOut[g] = { group.indexCount, 0, group.firstIndex, group.baseVertex, 0 };
+	}
+}
+
+void cull_draw_groups_reference(const CullConstants& constants, const CullDrawGroup* pGroups, const u32 kNumGroups, const u32* pSlotObjects,
+	const v4* pBounds, u32* pVisibleOut, DrawIndexedIndirectArgs* pArgsOut)
+{
+	for (u32 g = 0; g < kNumGroups; ++g)
+	{
+		const CullDrawGroup& group = pGroups[g];
+		u32 count = 0;
+		for (u32 i = 0; i < group.numObjects; ++i)
+		{
+			const u32 kObject = pSlotObjects[group.firstSlot + i];
+			if (sphere_visible(constants, pBounds[kObject]))
+			{
+				pVisibleOut[group.firstSlot + count++] = kObject;
+			}
+		}
+
+		pArgsOut[g] = { group.indexCount, count * constants.viewCount, group.firstIndex, group.baseVertex, 0 };
+	}
+}
+
+bool cull_outputs_match(const CullDrawGroup* pGroups, const u32 kNumGroups, const u32 kViewCount,
+	const u32* pVisibleA, const DrawIndexedIndirectArgs* pArgsA, const u32* pVisibleB, const DrawIndexedIndirectArgs* pArgsB)
+{
+	ASSERT(kViewCount > 0);
+	std::vector<u32> a;
+	std::vector<u32> b;
+	for (u32 g = 0; g < kNumGroups; ++g)
+	{
+		if (!same_args(pArgsA[g], pArgsB[g]) || pArgsA[g].instanceCount % kViewCount != 0)
+		{
+			return false;
+		}
+		const u32 kCount = pArgsA[g].instanceCount / kViewCount;
+		if (kCount > pGroups[g].numObjects)
+		{
+			return false;
+		}
+		a.assign(pVisibleA + pGroups[g].firstSlot, pVisibleA + pGroups[g].firstSlot + kCount);
+		b.assign(pVisibleB + pGroups[g].firstSlot, pVisibleB + pGroups[g].firstSlot + kCount);
+		std::sort(a.begin(), a.end());
+		std::sort(b.begin(), b.end());
+		if (a != b)
+		{
+			return false;
+		}
+	}
+	return true;
+}
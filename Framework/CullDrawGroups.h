@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "Culling.h"
+#include "ViewLayout.h"
+#include <vector>
+
+// Threads per culling group, CULL_GROUP_SIZE in CullingShaders.fx.
+constexpr u32 kCullThreadGroupSize = 64;
+
+// Objects drawn by one indirect draw, they share a mesh and material.
+// Mirrors CullDrawGroup in CullingShaders.fx.
+struct CullDrawGroup
+{
+	u32 firstSlot;  // the group's objects are slots [firstSlot, firstSlot + numObjects) of the object list
+	u32 numObjects;
+	u32 indexCount; // the mesh's range, as passed to DrawIndexedInstanced
+	u32 firstIndex;
+	s32 baseVertex;
+	u32 padding[3];
+};
+
+// Arguments of DrawIndexedInstancedIndirect, in the order the device reads them.
+struct DrawIndexedIndirectArgs
+{
+	u32 indexCountPerInstance;
+	u32 instanceCount;
+	u32 startIndexLocation;
+	s32 baseVertexLocation;
+	u32 startInstanceLocation;
+};
+
+// ARGS_STRIDE and INSTANCE_COUNT_OFFSET in CullingShaders.fx.
+static_assert(sizeof(DrawIndexedIndirectArgs) == 20, "the cull shader strides the args by 20 bytes");
+static_assert(offsetof(DrawIndexedIndirectArgs, instanceCount) == 4, "the cull shader counts instances at byte 4");
+
+// One entry of the object list, the object and the draw group its slot belongs to.
+// Mirrors CullSlot in CullingShaders.fx.
+struct CullSlot
+{
+	u32 object;
+	u32 group;
+};
+
+// Mirrors CullCB in CullingShaders.fx.
+struct CullConstants
+{
+	v4  planes[kMaxViews * kNumFrustumPlanes]; // per view, as extract_frustum_planes
+	u32 viewCount;  // an object is visible when it touches any view, and drawn once per view
+	u32 numSlots;   // filled in by GpuCuller::dispatch
+	u32 padding[2];
+};
+
+// Constants culling against the frusta of kViews view projections.
+CullConstants make_cull_constants(const m4x4* pViewProj, const u32 kViews);
+
+// The slot list and the args before culling, no instances, as the GPU culler uploads them.
+// pSlotObjects lists the objects of every group, each group's slots together.
+void build_cull_slots(const CullDrawGroup* pGroups, const u32 kNumGroups, const u32* pSlotObjects, const u32 kNumSlots,
+	std::vector<CullSlot>& rSlotsOut, std::vector<DrawIndexedIndirectArgs>& rArgsOut);
+
+//================================================================================
+// CPU reference of CS_CullDrawGroups, the same visible sets and args.
+//
+// pBounds holds a sphere per object, xyz center and w radius, tested as the
+// shader and cull_spheres do so they round alike. For each group the visible
+// objects among its slots are written, in slot order, to the front of the same
+// slots of pVisibleOut, and its draw arguments to pArgsOut. Slots past a
+// group's visible count are left alone.
+//
+// The shader packs each group's visible objects in the order its thread
+// groups reach the group's instance count, which changes from run to run, so
+// its output is compared with cull_outputs_match, sorting within each group.
+//================================================================================
+void cull_draw_groups_reference(const CullConstants& constants, const CullDrawGroup* pGroups, const u32 kNumGroups, const u32* pSlotObjects,
+	const v4* pBounds, u32* pVisibleOut, DrawIndexedIndirectArgs* pArgsOut);
+
+// True when both outputs draw the same objects: the same args for every group, and the same
+// objects in each group's visible slots in any order.
+bool cull_outputs_match(const CullDrawGroup* pGroups, const u32 kNumGroups, const u32 kViewCount,
+	const u32* pVisibleA, const DrawIndexedIndirectArgs* pArgsA, const u32* pVisibleB, const DrawIndexedIndirectArgs* pArgsB);
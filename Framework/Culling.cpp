@@ -0,0 +1,365 @@
+#include "Culling.h"
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+// MSVC emits AVX intrinsics without /arch:AVX, GCC and Clang need the target enabled per function.
+#if defined(__GNUC__) && !defined(__AVX__)
+	#define AVX_TARGET __attribute__((target("avx")))
+#else
+	#define AVX_TARGET
+#endif
+
+void extract_frustum_planes(const m4x4& viewProj, v4* pPlanesOut)
+{
+	const m4x4& m = viewProj;
+
+	// Row vectors, so clip = p * M and each clip component is a column of M.
+	const v4 col0(m._11, m._21, m._31, m._41);
+	const v4 col1(m._12, m._22, m._32, m._42);
+	const v4 col2(m._13, m._23, m._33, m._43);
+	const v4 col3(m._14, m._24, m._34, m._44);
+
+	pPlanesOut[0] = col3 + col0; // left   -w <= x
+	pPlanesOut[1] = col3 - col0; // right   x <= w
+	pPlanesOut[2] = col3 + col1; // bottom -w <= y
+	pPlanesOut[3] = col3 - col1; // top     y <= w
+	pPlanesOut[4] = col2;        // near    0 <= z
+	pPlanesOut[5] = col3 - col2; // far     z <= w
+
+	// Normalise by the length of the normal only, so the plane equation gives a distance.
+	for (u32 i = 0; i < kNumFrustumPlanes; ++i)
+	{
+		v4& plane = pPlanesOut[i];
+		const f32 kLength = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (kLength > 0.f)
+		{
+			plane /= kLength;
+		}
+	}
+}
+
+//================================================================================
+// Bounding volume containers
+//================================================================================
+
+void SphereBoundsSoA::clear()
+{
+	centerX.clear(); centerY.clear(); centerZ.clear();
+	radius.clear();
+}
+
+void SphereBoundsSoA::reserve(const u32 kCount)
+{
+	centerX.reserve(kCount); centerY.reserve(kCount); centerZ.reserve(kCount);
+	radius.reserve(kCount);
+}
+
+u32 SphereBoundsSoA::add(const v3& center, const f32 kRadius)
+{
+	centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+	radius.push_back(kRadius);
+	return size() - 1;
+}
+
+void SphereBoundsSoA::set(const u32 i, const v3& center, const f32 kRadius)
+{
+	centerX[i] = center.x; centerY[i] = center.y; centerZ[i] = center.z;
+	radius[i] = kRadius;
+}
+
+void AabbBoundsSoA::clear()
+{
+	centerX.clear(); centerY.clear(); centerZ.clear();
+	extentX.clear(); extentY.clear(); extentZ.clear();
+}
+
+void AabbBoundsSoA::reserve(const u32 kCount)
+{
+	centerX.reserve(kCount); centerY.reserve(kCount); centerZ.reserve(kCount);
+	extentX.reserve(kCount); extentY.reserve(kCount); extentZ.reserve(kCount);
+}
+
+u32 AabbBoundsSoA::add(const v3& center, const v3& extents)
+{
+	centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+	extentX.push_back(extents.x); extentY.push_back(extents.y); extentZ.push_back(extents.z);
+	return size() - 1;
+}
+
+void AabbBoundsSoA::set(const u32 i, const v3& center, const v3& extents)
+{
+	centerX[i] = center.x; centerY[i] = center.y; centerZ[i] = center.z;
+	extentX[i] = extents.x; extentY[i] = extents.y; extentZ[i] = extents.z;
+}
+
+//================================================================================
+// Kernels
+// A volume is culled when it lies entirely behind any plane. All kernels
+// evaluate the plane equation in the same order so they agree exactly.
+//================================================================================
+
+// Append the lanes set in kMask without branching, every lane writes but only visible ones advance.
+template<u32 kLanes>
+static u32 compact_lanes(const u32 kMask, const u32 kBase, u32* pOut, u32 count)
+{
+	for (u32 lane = 0; lane < kLanes; ++lane)
+	{
+		pOut[count] = kBase + lane;
+		count += (kMask >> lane) & 1;
+	}
+	return count;
+}
+
+static u32 cull_spheres_scalar(const v4* pPlanes, const SphereBoundsSoA& bounds, const u32 kFirst, u32* pVisibleOut, u32 count)
+{
+	for (u32 i = kFirst; i < bounds.size(); ++i)
+	{
+		const f32 kNegRadius = -bounds.radius[i];
+		bool visible = true;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			const f32 d = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+			visible &= !(d < kNegRadius);
+		}
+		pVisibleOut[count] = i;
+		count += visible ? 1 : 0;
+	}
+	return count;
+}
+
+static u32 cull_aabbs_scalar(const v4* pPlanes, const AabbBoundsSoA& bounds, const u32 kFirst, u32* pVisibleOut, u32 count)
+{
+	for (u32 i = kFirst; i < bounds.size(); ++i)
+	{
+		bool visible = true;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			const f32 d = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+			const f32 r = fabsf(plane.x) * bounds.extentX[i] + fabsf(plane.y) * bounds.extentY[i] + fabsf(plane.z) * bounds.extentZ[i];
+			visible &= !(d < -r);
+		}
+		pVisibleOut[count] = i;
+		count += visible ? 1 : 0;
+	}
+	return count;
+}
+
+static u32 cull_spheres_sse(const v4* pPlanes, const SphereBoundsSoA& bounds, u32* pVisibleOut)
+{
+	const u32 kCount = bounds.size();
+	const u32 kGroups = kCount & ~3u;
+	const __m128 kZero = _mm_setzero_ps();
+
+	u32 count = 0;
+	for (u32 i = 0; i < kGroups; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+		const __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+		const __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+		const __m128 negR = _mm_sub_ps(kZero, _mm_loadu_ps(&bounds.radius[i]));
+
+		__m128 outside = kZero;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			__m128 d = _mm_mul_ps(_mm_set1_ps(plane.x), cx);
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.y), cy));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), cz));
+			d = _mm_add_ps(d, _mm_set1_ps(plane.w));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negR));
+		}
+
+		const u32 kVisible = ~(u32)_mm_movemask_ps(outside) & 0xF;
+		count = compact_lanes<4>(kVisible, i, pVisibleOut, count);
+	}
+
+	return cull_spheres_scalar(pPlanes, bounds, kGroups, pVisibleOut, count);
+}
+
+static u32 cull_aabbs_sse(const v4* pPlanes, const AabbBoundsSoA& bounds, u32* pVisibleOut)
+{
+	const u32 kCount = bounds.size();
+	const u32 kGroups = kCount & ~3u;
+	const __m128 kZero = _mm_setzero_ps();
+
+	u32 count = 0;
+	for (u32 i = 0; i < kGroups; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+		const __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+		const __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+		const __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+		const __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+		const __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+		__m128 outside = kZero;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			__m128 d = _mm_mul_ps(_mm_set1_ps(plane.x), cx);
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.y), cy));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), cz));
+			d = _mm_add_ps(d, _mm_set1_ps(plane.w));
+
+			__m128 r = _mm_mul_ps(_mm_set1_ps(fabsf(plane.x)), ex);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(fabsf(plane.y)), ey));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(fabsf(plane.z)), ez));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_sub_ps(kZero, r)));
+		}
+
+		const u32 kVisible = ~(u32)_mm_movemask_ps(outside) & 0xF;
+		count = compact_lanes<4>(kVisible, i, pVisibleOut, count);
+	}
+
+	return cull_aabbs_scalar(pPlanes, bounds, kGroups, pVisibleOut, count);
+}
+
+AVX_TARGET static u32 cull_spheres_avx(const v4* pPlanes, const SphereBoundsSoA& bounds, u32* pVisibleOut)
+{
+	const u32 kCount = bounds.size();
+	const u32 kGroups = kCount & ~7u;
+	const __m256 kZero = _mm256_setzero_ps();
+
+	u32 count = 0;
+	for (u32 i = 0; i < kGroups; i += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+		const __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+		const __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+		const __m256 negR = _mm256_sub_ps(kZero, _mm256_loadu_ps(&bounds.radius[i]));
+
+		__m256 outside = kZero;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			__m256 d = _mm256_mul_ps(_mm256_set1_ps(plane.x), cx);
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.y), cy));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.z), cz));
+			d = _mm256_add_ps(d, _mm256_set1_ps(plane.w));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, negR, _CMP_LT_OQ));
+		}
+
+		const u32 kVisible = ~(u32)_mm256_movemask_ps(outside) & 0xFF;
+		count = compact_lanes<8>(kVisible, i, pVisibleOut, count);
+	}
+
+	// Avoid the AVX to SSE transition penalty in the tail.
+	_mm256_zeroupper();
+	return cull_spheres_scalar(pPlanes, bounds, kGroups, pVisibleOut, count);
+}
+
+AVX_TARGET static u32 cull_aabbs_avx(const v4* pPlanes, const AabbBoundsSoA& bounds, u32* pVisibleOut)
+{
+	const u32 kCount = bounds.size();
+	const u32 kGroups = kCount & ~7u;
+	const __m256 kZero = _mm256_setzero_ps();
+
+	u32 count = 0;
+	for (u32 i = 0; i < kGroups; i += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+		const __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+		const __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+		const __m256 ex = _mm256_loadu_ps(&bounds.extentX[i]);
+		const __m256 ey = _mm256_loadu_ps(&bounds.extentY[i]);
+		const __m256 ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+		__m256 outside = kZero;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			__m256 d = _mm256_mul_ps(_mm256_set1_ps(plane.x), cx);
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.y), cy));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.z), cz));
+			d = _mm256_add_ps(d, _mm256_set1_ps(plane.w));
+
+			__m256 r = _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.x)), ex);
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.y)), ey));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.z)), ez));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, _mm256_sub_ps(kZero, r), _CMP_LT_OQ));
+		}
+
+		const u32 kVisible = ~(u32)_mm256_movemask_ps(outside) & 0xFF;
+		count = compact_lanes<8>(kVisible, i, pVisibleOut, count);
+	}
+
+	_mm256_zeroupper();
+	return cull_aabbs_scalar(pPlanes, bounds, kGroups, pVisibleOut, count);
+}
+
+//================================================================================
+// Dispatch
+//================================================================================
+
+static bool cpu_supports_avx()
+{
+#if defined(_MSC_VER)
+	// AVX needs both the instructions and the OS saving the ymm registers.
+	int info[4];
+	__cpuid(info, 1);
+	const bool kOsXSave = (info[2] & (1 << 27)) != 0;
+	const bool kAvx = (info[2] & (1 << 28)) != 0;
+	return kOsXSave && kAvx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+	return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+
+CullKernel best_cull_kernel()
+{
+	static const CullKernel kBest = cpu_supports_avx() ? CullKernel::kAVX : CullKernel::kSSE;
+	return kBest;
+}
+
+u32 cull_spheres(const v4* pPlanes, const SphereBoundsSoA& bounds, u32* pVisibleOut)
+{
+	return cull_spheres(best_cull_kernel(), pPlanes, bounds, pVisibleOut);
+}
+
+u32 cull_spheres(const CullKernel kernel, const v4* pPlanes, const SphereBoundsSoA& bounds, u32* pVisibleOut)
+{
+	switch (kernel)
+	{
+	case CullKernel::kAVX: return cull_spheres_avx(pPlanes, bounds, pVisibleOut);
+	case CullKernel::kSSE: return cull_spheres_sse(pPlanes, bounds, pVisibleOut);
+	default:               return cull_spheres_scalar(pPlanes, bounds, 0, pVisibleOut, 0);
+	}
+}
+
+u32 cull_aabbs(const v4* pPlanes, const AabbBoundsSoA& bounds, u32* pVisibleOut)
+{
+	return cull_aabbs(best_cull_kernel(), pPlanes, bounds, pVisibleOut);
+}
+
+u32 cull_aabbs(const CullKernel kernel, const v4* pPlanes, const AabbBoundsSoA& bounds, u32* pVisibleOut)
+{
+	switch (kernel)
+	{
+	case CullKernel::kAVX: return cull_aabbs_avx(pPlanes, bounds, pVisibleOut);
+	case CullKernel::kSSE: return cull_aabbs_sse(pPlanes, bounds, pVisibleOut);
+	default:               return cull_aabbs_scalar(pPlanes, bounds, 0, pVisibleOut, 0);
+	}
+}
+
+u32 merge_visible(const u32* pA, const u32 kCountA, const u32* pB, const u32 kCountB, u32* pOut)
+{
+	u32 a = 0;
+	u32 b = 0;
+	u32 count = 0;
+	while (a < kCountA && b < kCountB)
+	{
+		if (pA[a] < pB[b])        pOut[count++] = pA[a++];
+		else if (pB[b] < pA[a])   pOut[count++] = pB[b++];
+		else                    { pOut[count++] = pA[a++]; b++; }
+	}
+	while (a < kCountA) pOut[count++] = pA[a++];
+	while (b < kCountB) pOut[count++] = pB[b++];
+	return count;
+}
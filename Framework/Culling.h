@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+// Number of frustum planes, order is left, right, bottom, top, near, far.
+constexpr u32 kNumFrustumPlanes = 6;
+
+// Extract the frustum planes of a row vector view projection matrix (D3D clip space, 0 <= z <= w).
+// Planes point inwards and are normalised on their xyz so dot(plane, (p, 1)) is a distance.
+void extract_frustum_planes(const m4x4& viewProj, v4* pPlanesOut);
+
+//================================================================================
+// Bounding volumes in structure of arrays layout, one array per component so
+// the cull kernels can load several volumes per instruction.
+//================================================================================
+struct SphereBoundsSoA
+{
+	std::vector<f32> centerX;
+	std::vector<f32> centerY;
+	std::vector<f32> centerZ;
+	std::vector<f32> radius;
+
+	u32 size() const { return (u32)radius.size(); }
+	void clear();
+	void reserve(const u32 kCount);
+	u32 add(const v3& center, const f32 kRadius);
+	void set(const u32 i, const v3& center, const f32 kRadius);
+};
+
+// Axis aligned boxes as center and half extents.
+struct AabbBoundsSoA
+{
+	std::vector<f32> centerX;
+	std::vector<f32> centerY;
+	std::vector<f32> centerZ;
+	std::vector<f32> extentX;
+	std::vector<f32> extentY;
+	std::vector<f32> extentZ;
+
+	u32 size() const { return (u32)centerX.size(); }
+	void clear();
+	void reserve(const u32 kCount);
+	u32 add(const v3& center, const v3& extents);
+	void set(const u32 i, const v3& center, const v3& extents);
+};
+
+//================================================================================
+// Frustum culling
+// Each function writes the indices of the volumes that intersect the frustum
+// to pVisibleOut in ascending order and returns how many there are.
+// pVisibleOut must have room for every volume.
+//
+// The plain versions pick the widest kernel the CPU supports. The explicit
+// versions are there for testing and benchmarking against the scalar reference.
+//================================================================================
+enum class CullKernel
+{
+	kScalar,
+	kSSE,  // 4 volumes per iteration
+	kAVX,  // 8 volumes per iteration
+};
+
+// Widest kernel supported by this CPU and OS.
+CullKernel best_cull_kernel();
+
+u32 cull_spheres(const v4* pPlanes, const SphereBoundsSoA& bounds, u32* pVisibleOut);
+u32 cull_spheres(const CullKernel kernel, const v4* pPlanes, const SphereBoundsSoA& bounds, u32* pVisibleOut);
+
+u32 cull_aabbs(const v4* pPlanes, const AabbBoundsSoA& bounds, u32* pVisibleOut);
+u32 cull_aabbs(const CullKernel kernel, const v4* pPlanes, const AabbBoundsSoA& bounds, u32* pVisibleOut);
+
+// Merge two ascending index lists into their ascending union, returns the count.
+u32 merge_visible(const u32* pA, const u32 kCountA, const u32* pB, const u32 kCountB, u32* pOut);
@@ -0,0 +1,165 @@
+#include "D3D11GpuTimer.h"
+#include "Profiler.h"
+
+D3D11GpuTimer::D3D11GpuTimer()
+	: m_pContext(nullptr)
+	, m_numSlots(0)
+	, m_queriesPerSlot(0)
+	, m_pCalibrationDisjoint(nullptr)
+	, m_pCalibrationTimestamp(nullptr)
+{
+}
+
+D3D11GpuTimer::~D3D11GpuTimer()
+{
+	release();
+}
+
+void D3D11GpuTimer::release()
+{
+	for (ID3D11Query* pQuery : m_disjointQueries)
+	{
+		SAFE_RELEASE(pQuery);
+	}
+	for (ID3D11Query* pQuery : m_timestampQueries)
+	{
+		SAFE_RELEASE(pQuery);
+	}
+	m_disjointQueries.clear();
+	m_timestampQueries.clear();
+	SAFE_RELEASE(m_pCalibrationDisjoint);
+	SAFE_RELEASE(m_pCalibrationTimestamp);
+	m_pCalibrationDisjoint = nullptr;
+	m_pCalibrationTimestamp = nullptr;
+	m_numSlots = 0;
+	m_queriesPerSlot = 0;
+}
+
+bool D3D11GpuTimer::init(ID3D11Device* pDevice, ID3D11DeviceContext* pImmediateContext, const u32 kSlots, const u32 kQueriesPerSlot)
+{
+	ASSERT(kSlots > 0 && kQueriesPerSlot >= 2);
+	ASSERT(pImmediateContext->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE);
+	release();
+	m_pContext = pImmediateContext;
+
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	D3D11_QUERY_DESC timestampDesc = {};
+	timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+
+	m_disjointQueries.assign(kSlots, nullptr);
+	m_timestampQueries.assign(kSlots * kQueriesPerSlot, nullptr);
+	bool created = SUCCEEDED(pDevice->CreateQuery(&disjointDesc, &m_pCalibrationDisjoint))
+		&& SUCCEEDED(pDevice->CreateQuery(&timestampDesc, &m_pCalibrationTimestamp));
+	for (u32 i = 0; created && i < kSlots; ++i)
+	{
+		created = SUCCEEDED(pDevice->CreateQuery(&disjointDesc, &m_disjointQueries[i]));
+	}
+	for (u32 i = 0; created && i < kSlots * kQueriesPerSlot; ++i)
+	{
+		created = SUCCEEDED(pDevice->CreateQuery(&timestampDesc, &m_timestampQueries[i]));
+	}
+
+	if (!created)
+	{
+		debugF("GPU timer: failed to create timestamp queries, GPU profiling is off.\n");
+		release();
+		return false;
+	}
+
+	m_numSlots = kSlots;
+	m_queriesPerSlot = kQueriesPerSlot;
+	return true;
+}
+
+void D3D11GpuTimer::begin_slot(const u32 kSlot)
+{
+	ASSERT(kSlot < m_numSlots);
+	m_pContext->Begin(m_disjointQueries[kSlot]);
+}
+
+void D3D11GpuTimer::end_slot(const u32 kSlot)
+{
+	ASSERT(kSlot < m_numSlots);
+	m_pContext->End(m_disjointQueries[kSlot]);
+}
+
+void D3D11GpuTimer::timestamp(const u32 kSlot, const u32 kQuery)
+{
+	ASSERT(kSlot < m_numSlots && kQuery < m_queriesPerSlot);
+	// Timestamp queries have no Begin, End writes the clock.
+	m_pContext->End(m_timestampQueries[kSlot * m_queriesPerSlot + kQuery]);
+}
+
+bool D3D11GpuTimer::read_slot(const u32 kSlot, u64& rFrequency, bool& rDisjoint)
+{
+	ASSERT(kSlot < m_numSlots);
+	// DONOTFLUSH, the frame's work was submitted long ago and a flush here would only add CPU cost.
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT data;
+	if (m_pContext->GetData(m_disjointQueries[kSlot], &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+	{
+		return false;
+	}
+	rFrequency = data.Frequency;
+	rDisjoint = data.Disjoint != FALSE;
+	return true;
+}
+
+bool D3D11GpuTimer::read_timestamp(const u32 kSlot, const u32 kQuery, u64& rTicks)
+{
+	ASSERT(kSlot < m_numSlots && kQuery < m_queriesPerSlot);
+	UINT64 ticks = 0;
+	if (m_pContext->GetData(m_timestampQueries[kSlot * m_queriesPerSlot + kQuery], &ticks, sizeof(ticks), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+	{
+		return false;
+	}
+	rTicks = ticks;
+	return true;
+}
+
+bool D3D11GpuTimer::calibrate(u64& rGpuTicks, u64& rFrequency, s64& rCpuTicks)
+{
+	if (!m_pCalibrationTimestamp)
+	{
+		return false;
+	}
+
+	// Wait for the previous work to drain so the timestamp is written as soon as it's submitted.
+	m_pContext->Begin(m_pCalibrationDisjoint);
+	m_pContext->End(m_pCalibrationDisjoint);
+	m_pContext->Flush();
+	HRESULT hr;
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+	while ((hr = m_pContext->GetData(m_pCalibrationDisjoint, &disjoint, sizeof(disjoint), 0)) == S_FALSE)
+	{
+	}
+
+	m_pContext->Begin(m_pCalibrationDisjoint);
+	m_pContext->End(m_pCalibrationTimestamp);
+	m_pContext->End(m_pCalibrationDisjoint);
+	m_pContext->Flush();
+
+	// The CPU tick is taken the moment the timestamp reads back, late by however long the readback took.
+	UINT64 ticks = 0;
+	while ((hr = m_pContext->GetData(m_pCalibrationTimestamp, &ticks, sizeof(ticks), 0)) == S_FALSE)
+	{
+	}
+	const s64 kCpuTicks = profiler_ticks();
+	if (hr != S_OK)
+	{
+		return false;
+	}
+
+	while ((hr = m_pContext->GetData(m_pCalibrationDisjoint, &disjoint, sizeof(disjoint), 0)) == S_FALSE)
+	{
+	}
+	if (hr != S_OK || disjoint.Disjoint || disjoint.Frequency == 0)
+	{
+		return false;
+	}
+
+	rGpuTicks = ticks;
+	rFrequency = disjoint.Frequency;
+	rCpuTicks = kCpuTicks;
+	return true;
+}
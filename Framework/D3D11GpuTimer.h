@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "GpuProfiler.h"
+#include <vector>
+
+//================================================================================
+// D3D11 GPU Timer
+// The GPU profiler's queries on a D3D11 device, a TIMESTAMP_DISJOINT query per
+// slot around its TIMESTAMP queries.
+//
+// Queries are issued and read on the immediate context, deferred contexts
+// can't read them back, so scopes only belong around work the immediate
+// context issues or executes.
+//================================================================================
+class D3D11GpuTimer final : public GpuTimerBackend
+{
+public:
+	D3D11GpuTimer();
+	~D3D11GpuTimer();
+
+	// False if the queries couldn't be created, the timer mustn't be used then.
+	bool init(ID3D11Device* pDevice, ID3D11DeviceContext* pImmediateContext, const u32 kSlots, const u32 kQueriesPerSlot);
+
+	u32 slots() const override { return m_numSlots; }
+	u32 queries_per_slot() const override { return m_queriesPerSlot; }
+	void begin_slot(const u32 kSlot) override;
+	void end_slot(const u32 kSlot) override;
+	void timestamp(const u32 kSlot, const u32 kQuery) override;
+	bool read_slot(const u32 kSlot, u64& rFrequency, bool& rDisjoint) override;
+	bool read_timestamp(const u32 kSlot, const u32 kQuery, u64& rTicks) override;
+	bool calibrate(u64& rGpuTicks, u64& rFrequency, s64& rCpuTicks) override;
+
+private:
+	D3D11GpuTimer(const D3D11GpuTimer&) = delete;
+	D3D11GpuTimer& operator=(const D3D11GpuTimer&) = delete;
+
+	void release();
+
+	ID3D11DeviceContext* m_pContext;
+	u32 m_numSlots;
+	u32 m_queriesPerSlot;
+	std::vector<ID3D11Query*> m_disjointQueries; // one per slot
+	std::vector<ID3D11Query*> m_timestampQueries; // kQueriesPerSlot per slot, slot by slot
+	ID3D11Query* m_pCalibrationDisjoint;
+	ID3D11Query* m_pCalibrationTimestamp;
+};
@@ -0,0 +1,62 @@
+#include "DeferredContextBackend.h"
+
+DeferredContextBackend::DeferredContextBackend()
+	: m_pDevice(nullptr)
+	, m_pImmediate(nullptr)
+{
+}
+
+DeferredContextBackend::~DeferredContextBackend()
+{
+	for (ID3D11CommandList* pList : m_commandLists)
+	{
+		if (pList) pList->Release();
+	}
+	for (ID3D11DeviceContext* pContext : m_contexts)
+	{
+		pContext->Release();
+	}
+}
+
+void DeferredContextBackend::init(ID3D11Device* pDevice, ID3D11DeviceContext* pImmediate)
+{
+	m_pDevice = pDevice;
+	m_pImmediate = pImmediate;
+}
+
+void DeferredContextBackend::begin_frame(const u32 kNumChunks)
+{
+	// Contexts are kept between frames, only grow when a frame needs more chunks.
+	while (m_contexts.size() < kNumChunks)
+	{
+		ID3D11DeviceContext* pContext = nullptr;
+		if (FAILED(m_pDevice->CreateDeferredContext(0, &pContext)))
+		{
+			panicF("Failed to create deferred context");
+		}
+		m_contexts.push_back(pContext);
+		m_commandLists.push_back(nullptr);
+	}
+}
+
+void DeferredContextBackend::begin_chunk(const u32 kChunk)
+{
+	ASSERT(m_commandLists[kChunk] == nullptr);
+}
+
+void DeferredContextBackend::end_chunk(const u32 kChunk)
+{
+	// Deferred context state is reset after finishing, each chunk sets up its own.
+	if (FAILED(m_contexts[kChunk]->FinishCommandList(FALSE, &m_commandLists[kChunk])))
+	{
+		panicF("Failed to finish command list");
+	}
+}
+
+void DeferredContextBackend::execute_chunk(const u32 kChunk)
+{
+	// Restore the immediate context state so anything bound before recording is still valid.
+	m_pImmediate->ExecuteCommandList(m_commandLists[kChunk], TRUE);
+	m_commandLists[kChunk]->Release();
+	m_commandLists[kChunk] = nullptr;
+}
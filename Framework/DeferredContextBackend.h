@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "ParallelRecorder.h"
+#include <vector>
+
+//================================================================================
+// Deferred Context Backend
+// Records each chunk into its own deferred context and executes the
+// resulting command lists on the immediate context.
+//================================================================================
+class DeferredContextBackend final : public CommandRecordingBackend
+{
+public:
+	DeferredContextBackend();
+	~DeferredContextBackend();
+
+	void init(ID3D11Device* pDevice, ID3D11DeviceContext* pImmediate);
+
+	// Context a chunk should record into, valid between begin_chunk and end_chunk.
+	ID3D11DeviceContext* context(const u32 kChunk) const { return m_contexts[kChunk]; }
+
+	void begin_frame(const u32 kNumChunks) override;
+	void begin_chunk(const u32 kChunk) override;
+	void end_chunk(const u32 kChunk) override;
+	void execute_chunk(const u32 kChunk) override;
+
+private:
+	ID3D11Device* m_pDevice;
+	ID3D11DeviceContext* m_pImmediate;
+
+	std::vector<ID3D11DeviceContext*> m_contexts;
+	std::vector<ID3D11CommandList*> m_commandLists;
+};
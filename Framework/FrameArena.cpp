@@ -0,0 +1,223 @@
+#include "FrameArena.h"
+#include <atomic>
+#include <cstdlib>
+
+namespace
+{
+	// Where this thread is bumping through, only valid while generation matches the arena's.
+	struct ThreadCursor
+	{
+		u64 generation;
+		u8* pHead;
+		u8* pEnd;
+	};
+
+	thread_local ThreadCursor s_cursor = { 0, nullptr, nullptr };
+
+	// Generations are shared by every arena so a cursor can't match an arena it didn't come from.
+	std::atomic<u64> s_nextGeneration(1);
+
+	FrameArena* s_pCurrentArena = nullptr;
+
+	inline u8* align_pointer(u8* p, const size_t kAlignment)
+	{
+		return (u8*)(((uintptr_t)p + kAlignment - 1) & ~(uintptr_t)(kAlignment - 1));
+	}
+}
+
+FrameArena::FrameArena()
+	: m_frame(0)
+	, m_frameNumber(0)
+	, m_generation(s_nextGeneration++)
+	, m_blockSize(0)
+	, m_maxBlocks(0)
+	, m_highWater(0)
+	, m_highWaterBlocks(0)
+{
+	for (u32 i = 0; i < kNumFrames; ++i)
+	{
+		m_frames[i].blocksUsed = 0;
+		m_frames[i].largeUsed = 0;
+		m_stats[i] = {};
+	}
+}
+
+FrameArena::~FrameArena()
+{
+	for (Frame& rFrame : m_frames)
+	{
+		for (u8* pBlock : rFrame.blocks)
+		{
+			delete[] pBlock;
+		}
+		for (const LargeAllocation& large : rFrame.large)
+		{
+			free(large.p);
+		}
+		for (void* p : rFrame.heap)
+		{
+			free(p);
+		}
+	}
+}
+
+void FrameArena::init(const size_t kBlockSize, const u32 kMaxBlocks)
+{
+	ASSERT(kBlockSize > 0 && kMaxBlocks > 0);
+	m_blockSize = kBlockSize;
+	m_maxBlocks = kMaxBlocks;
+	for (Frame& rFrame : m_frames)
+	{
+		rFrame.blocks.reserve(kMaxBlocks);
+	}
+}
+
+void FrameArena::begin_frame()
+{
+	m_frame = (m_frame + 1) % kNumFrames;
+	m_frameNumber++;
+	reset_frame(m_frame);
+
+	// Every thread's cursor points into an older frame now.
+	m_generation = s_nextGeneration++;
+}
+
+void* FrameArena::allocate(const size_t kSize, const size_t kAlignment)
+{
+	ASSERT(kAlignment != 0 && (kAlignment & (kAlignment - 1)) == 0);
+
+	ThreadCursor& rCursor = s_cursor;
+	if (rCursor.generation == m_generation)
+	{
+		u8* p = align_pointer(rCursor.pHead, kAlignment);
+		if (p + kSize <= rCursor.pEnd)
+		{
+			rCursor.pHead = p + kSize;
+			return p;
+		}
+	}
+
+	return allocate_slow(kSize, kAlignment);
+}
+
+void* FrameArena::allocate_slow(const size_t kSize, const size_t kAlignment)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Frame& rFrame = m_frames[m_frame];
+	FrameArenaStats& rStats = m_stats[m_frame];
+
+	// Big allocations would waste most of a block, give them their own memory.
+	if (kSize + kAlignment > m_blockSize / 4)
+	{
+		rStats.oversized++;
+		return allocate_large(rFrame, kSize, kAlignment);
+	}
+
+	if (rFrame.blocksUsed == m_maxBlocks)
+	{
+		rStats.fallbacks++;
+		return allocate_heap(rFrame, kSize, kAlignment);
+	}
+
+	// Reuse a block from an earlier frame before making a new one.
+	if (rFrame.blocksUsed == rFrame.blocks.size())
+	{
+		rFrame.blocks.push_back(new u8[m_blockSize]);
+	}
+	u8* pBlock = rFrame.blocks[rFrame.blocksUsed++];
+
+	rStats.blocks++;
+	rStats.bytes += m_blockSize;
+	m_highWater = std::max(m_highWater, rStats.bytes);
+	m_highWaterBlocks = std::max(m_highWaterBlocks, rStats.blocks);
+
+	// The rest of the thread's old block is abandoned until the frame resets.
+	u8* p = align_pointer(pBlock, kAlignment);
+	s_cursor.generation = m_generation;
+	s_cursor.pHead = p + kSize;
+	s_cursor.pEnd = pBlock + m_blockSize;
+	return p;
+}
+
+void* FrameArena::allocate_large(Frame& rFrame, const size_t kSize, const size_t kAlignment)
+{
+	const size_t kNeeded = kSize + kAlignment;
+	FrameArenaStats& rStats = m_stats[m_frame];
+
+	// The smallest spare one that fits, so a frame asking for the same sizes gets the same memory back.
+	u32 best = (u32)rFrame.large.size();
+	for (u32 i = rFrame.largeUsed; i < rFrame.large.size(); ++i)
+	{
+		if (rFrame.large[i].size >= kNeeded && (best == rFrame.large.size() || rFrame.large[i].size < rFrame.large[best].size))
+		{
+			best = i;
+		}
+	}
+
+	if (best == rFrame.large.size())
+	{
+		u8* pRaw = (u8*)malloc(kNeeded);
+		if (!pRaw)
+		{
+			panicF("Frame arena: out of memory allocating %u bytes.", (u32)kSize);
+		}
+		rFrame.large.push_back({ pRaw, kNeeded });
+		rStats.heapAllocs++;
+	}
+
+	// In use ones stay at the front.
+	std::swap(rFrame.large[best], rFrame.large[rFrame.largeUsed]);
+	const LargeAllocation& large = rFrame.large[rFrame.largeUsed++];
+
+	rStats.bytes += large.size;
+	m_highWater = std::max(m_highWater, rStats.bytes);
+	return align_pointer(large.p, kAlignment);
+}
+
+void* FrameArena::allocate_heap(Frame& rFrame, const size_t kSize, const size_t kAlignment)
+{
+	u8* pRaw = (u8*)malloc(kSize + kAlignment);
+	if (!pRaw)
+	{
+		panicF("Frame arena: out of memory allocating %u bytes.", (u32)kSize);
+	}
+	rFrame.heap.push_back(pRaw);
+
+	FrameArenaStats& rStats = m_stats[m_frame];
+	rStats.heapAllocs++;
+	rStats.bytes += kSize + kAlignment;
+	m_highWater = std::max(m_highWater, rStats.bytes);
+	return align_pointer(pRaw, kAlignment);
+}
+
+void FrameArena::reset_frame(const u32 kFrame)
+{
+	// Blocks stay allocated for the frame to reuse, only the heap allocations go.
+	Frame& rFrame = m_frames[kFrame];
+	rFrame.blocksUsed = 0;
+
+	// Large allocations the frame didn't use last time round aren't needed any more.
+	for (u32 i = rFrame.largeUsed; i < rFrame.large.size(); ++i)
+	{
+		free(rFrame.large[i].p);
+	}
+	rFrame.large.resize(rFrame.largeUsed);
+	rFrame.largeUsed = 0;
+
+	for (void* p : rFrame.heap)
+	{
+		free(p);
+	}
+	rFrame.heap.clear();
+	m_stats[kFrame] = {};
+}
+
+void set_current_frame_arena(FrameArena* pArena)
+{
+	s_pCurrentArena = pArena;
+}
+
+FrameArena* current_frame_arena()
+{
+	return s_pCurrentArena;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <mutex>
+#include <vector>
+
+struct FrameArenaStats
+{
+	u32 blocks;         // blocks handed to threads this frame
+	u32 oversized;      // allocations too large for a block, given a large allocation of their own
+	u32 fallbacks;      // allocations that went to the heap because the block budget ran out
+	u32 heapAllocs;     // mallocs made this frame, zero once the large allocations have settled
+	size_t bytes;       // blocks, large allocations and heap bytes reserved this frame
+};
+
+//================================================================================
+// Frame Arena
+// Bump allocator for data that only lives for a frame or two.
+//
+// Each thread bumps through a block of its own, so allocation is a pointer add
+// with no locking; the lock is only taken to hand out the next block. Nothing
+// is freed individually, begin_frame() reclaims a whole frame at once.
+//
+// The arena is double buffered: memory allocated during frame N stays valid
+// through frame N + 1 and is reclaimed by the begin_frame() that starts N + 2.
+//
+// Allocations larger than a quarter of a block (per object lists sized to
+// the scene) get a large allocation of their own. These are kept with the
+// frame like blocks, so the same big arrays every frame reuse them rather
+// than going to the heap each time. One not used in a frame is freed when its
+// frame comes round again. Allocations made once the block budget is used up
+// come from the heap and are freed with the frame, so running out is a stats
+// problem rather than a crash.
+//
+// begin_frame() must not overlap with allocations on other threads.
+//================================================================================
+class FrameArena
+{
+public:
+	static constexpr u32 kNumFrames = 2;
+
+	FrameArena();
+	~FrameArena();
+
+	// kBlockSize bytes per block, at most kMaxBlocks blocks per frame.
+	void init(const size_t kBlockSize, const u32 kMaxBlocks);
+
+	// Start a new frame, reclaiming everything allocated two frames ago.
+	void begin_frame();
+
+	// Uninitialised memory valid until the frame after this one ends. kAlignment is a power of two.
+	void* allocate(const size_t kSize, const size_t kAlignment = 16);
+
+	template<typename T>
+	T* allocate_array(const size_t kCount)
+	{
+		return (T*)allocate(kCount * sizeof(T), alignof(T));
+	}
+
+	// Stats of the frame being allocated from.
+	const FrameArenaStats& stats() const { return m_stats[m_frame]; }
+	// Most bytes and blocks any frame has reserved, use these to size the arena.
+	size_t high_water() const { return m_highWater; }
+	u32 high_water_blocks() const { return m_highWaterBlocks; }
+	size_t block_size() const { return m_blockSize; }
+	u32 max_blocks() const { return m_maxBlocks; }
+	u64 frame_number() const { return m_frameNumber; }
+
+private:
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	struct LargeAllocation
+	{
+		u8* p;
+		size_t size;
+	};
+
+	struct Frame
+	{
+		std::vector<u8*> blocks; // kept between frames, the first blocksUsed are in use
+		u32 blocksUsed;
+		std::vector<LargeAllocation> large; // kept between frames, the first largeUsed are in use
+		u32 largeUsed;
+		std::vector<void*> heap; // fallback allocations, freed on reset
+	};
+
+	void* allocate_slow(const size_t kSize, const size_t kAlignment);
+	void* allocate_large(Frame& rFrame, const size_t kSize, const size_t kAlignment);
+	void* allocate_heap(Frame& rFrame, const size_t kSize, const size_t kAlignment);
+	void reset_frame(const u32 kFrame);
+
+	std::mutex m_mutex;
+	Frame m_frames[kNumFrames];
+	FrameArenaStats m_stats[kNumFrames];
+	u32 m_frame;
+	u64 m_frameNumber;
+	u64 m_generation; // unique across arenas, tells a thread its cursor is stale
+	size_t m_blockSize;
+	u32 m_maxBlocks;
+	size_t m_highWater;
+	u32 m_highWaterBlocks;
+};
+
+// Arena used by code with no arena passed in (e.g. mesh loading), may be null.
+void set_current_frame_arena(FrameArena* pArena);
+FrameArena* current_frame_arena();
+
+//================================================================================
+// Frame Allocator
+// STL allocator adaptor over a FrameArena. deallocate does nothing, so a
+// container using it must not outlive the frame after the one it allocated in.
+//================================================================================
+template<typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	explicit FrameAllocator(FrameArena& rArena)
+		: m_pArena(&rArena)
+	{
+	}
+
+	template<typename U>
+	FrameAllocator(const FrameAllocator<U>& rOther)
+		: m_pArena(rOther.arena())
+	{
+	}
+
+	T* allocate(const size_t kCount)
+	{
+		return m_pArena->allocate_array<T>(kCount);
+	}
+
+	void deallocate(T* /*p*/, const size_t /*kCount*/)
+	{
+	}
+
+	FrameArena* arena() const { return m_pArena; }
+
+private:
+	FrameArena* m_pArena;
+};
+
+template<typename T, typename U>
+inline bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+	return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+	return a.arena() != b.arena();
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,181 @@
+#include "FrameLifecycle.h"
+#include "Profiler.h"
+
+//================================================================================
+// Frame Lifecycle
+//================================================================================
+
+FrameLifecycle::FrameLifecycle()
+	: m_pHmd(nullptr)
+	, m_current()
+	, m_inFrame(false)
+	, m_skipped(0)
+	, m_history()
+	, m_numEnded(0)
+{
+}
+
+void FrameLifecycle::init(HmdInterface* pHmd)
+{
+	ASSERT(pHmd);
+	m_pHmd = pHmd;
+	m_current = {};
+	m_inFrame = false;
+	m_skipped = 0;
+	m_numEnded = 0;
+}
+
+HmdFrameStatus FrameLifecycle::begin_frame()
+{
+	PROFILE_SCOPE("Wait for compositor");
+	ASSERT(m_pHmd && !m_inFrame);
+
+	// The index only moves on once a frame is begun, a skipped frame is waited for again.
+	const s64 kFrameIndex = m_current.frameIndex + 1;
+	const f64 kWaitStart = m_pHmd->time_seconds();
+	const HmdFrameStatus kStatus = m_pHmd->wait_to_begin_frame(kFrameIndex);
+	if (kStatus != HmdFrameStatus::kRender)
+	{
+		// A lost session isn't a frame the compositor turned down.
+		m_skipped += kStatus == HmdFrameStatus::kSkip ? 1 : 0;
+		return kStatus;
+	}
+
+	if (!m_pHmd->begin_frame(kFrameIndex))
+	{
+		return HmdFrameStatus::kFailed;
+	}
+
+	m_current = {};
+	m_current.frameIndex = kFrameIndex;
+	m_current.waitStart = kWaitStart;
+	m_current.beginTime = m_pHmd->time_seconds();
+	m_current.predictedDisplayTime = m_pHmd->predicted_display_time(kFrameIndex);
+	m_inFrame = true;
+	return HmdFrameStatus::kRender;
+}
+
+bool FrameLifecycle::end_frame(const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers)
+{
+	ASSERT(m_inFrame);
+
+	PROFILE_SCOPE("Submit");
+	m_current.submitTime = m_pHmd->time_seconds();
+	const bool kSubmitted = m_pHmd->end_frame(m_current.frameIndex, ppLayers, kNumLayers);
+	m_current.endTime = m_pHmd->time_seconds();
+
+	m_history[m_numEnded % kHistorySize] = m_current;
+	m_numEnded++;
+	m_inFrame = false;
+	return kSubmitted;
+}
+
+const FrameRecord& FrameLifecycle::record(const u32 kFramesAgo) const
+{
+	ASSERT(kFramesAgo < history_size());
+	return m_history[(m_numEnded - 1 - kFramesAgo) % kHistorySize];
+}
+
+FrameLifecycleStats FrameLifecycle::stats() const
+{
+	FrameLifecycleStats stats = {};
+	stats.frames = history_size();
+	stats.skipped = m_skipped;
+	if (stats.frames == 0)
+	{
+		return stats;
+	}
+
+	// Predictions a refresh and a half apart skipped a vsync in between.
+	const f64 kMissedGap = m_pHmd->refresh_interval() * 1.5;
+	f64 waitTotal = 0.0;
+	f64 cpuTotal = 0.0;
+	f64 leadTotal = 0.0;
+	for (u32 i = 0; i < stats.frames; ++i)
+	{
+		const FrameRecord& frame = record(i);
+		const f64 kCpu = frame.submitTime - frame.beginTime;
+		waitTotal += frame.beginTime - frame.waitStart;
+		cpuTotal += kCpu;
+		leadTotal += frame.predictedDisplayTime - frame.beginTime;
+		stats.maxCpuMs = std::max(stats.maxCpuMs, (f32)(kCpu * 1000.0));
+		if (i + 1 < stats.frames && frame.predictedDisplayTime - record(i + 1).predictedDisplayTime > kMissedGap)
+		{
+			stats.missed++;
+		}
+	}
+
+	const f64 kToAverageMs = 1000.0 / stats.frames;
+	stats.averageWaitMs = (f32)(waitTotal * kToAverageMs);
+	stats.averageCpuMs = (f32)(cpuTotal * kToAverageMs);
+	stats.averageLeadMs = (f32)(leadTotal * kToAverageMs);
+	return stats;
+}
+
+//================================================================================
+// Simulated HMD
+//================================================================================
+
+SimulatedHmd::SimulatedHmd(const f64 kRefreshRate)
+	: m_interval(1.0 / kRefreshRate)
+	, m_time(0.0)
+	, m_latchTime(0.0)
+	, m_lastDisplayTime(0.0)
+	, m_predictedFrame(0)
+	, m_predictedTime(0.0)
+	, m_begunFrame(0)
+	, m_missed(0)
+	, m_visible(true)
+{
+}
+
+f64 SimulatedHmd::next_vsync(const f64 kTime) const
+{
+	// A little slack so a time computed as a vsync doesn't round up to the one after.
+	return std::ceil(kTime / m_interval - 1e-6) * m_interval;
+}
+
+HmdFrameStatus SimulatedHmd::wait_to_begin_frame(const s64 kFrameIndex)
+{
+	ASSERT(kFrameIndex > m_begunFrame);
+	if (!m_visible)
+	{
+		m_time = next_vsync(m_time) + m_interval;
+		return HmdFrameStatus::kSkip;
+	}
+
+	// Blocks until the compositor has taken the frame before.
+	m_time = std::max(m_time, m_latchTime);
+	return HmdFrameStatus::kRender;
+}
+
+bool SimulatedHmd::begin_frame(const s64 kFrameIndex)
+{
+	m_begunFrame = kFrameIndex;
+	return true;
+}
+
+f64 SimulatedHmd::predicted_display_time(const s64 kFrameIndex)
+{
+	// Fixed the first time it is asked for, as the runtime's is for a frame index.
+	if (kFrameIndex != m_predictedFrame)
+	{
+		m_predictedFrame = kFrameIndex;
+		// Taken at the first vsync after now, seen a refresh after that.
+		m_predictedTime = (std::floor(m_time / m_interval + 1e-6) + 1.0) * m_interval + m_interval;
+	}
+	return m_predictedTime;
+}
+
+bool SimulatedHmd::end_frame(const s64 kFrameIndex, const ovrLayerHeader_* const*, const u32)
+{
+	ASSERT(kFrameIndex == m_begunFrame);
+
+	m_latchTime = next_vsync(m_time);
+	m_lastDisplayTime = m_latchTime + m_interval;
+	if (m_lastDisplayTime > predicted_display_time(kFrameIndex) + m_interval * 0.5)
+	{
+		m_missed++;
+	}
+	return true;
+}
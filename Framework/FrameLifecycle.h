@@ -0,0 +1,160 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+// Layers are only handed through to the headset, LibOVR's ovrLayerHeader.
+struct ovrLayerHeader_;
+
+enum class HmdFrameStatus
+{
+	kRender, // the compositor wants this frame
+	kSkip,   // not visible, don't render, the wait has already throttled the loop
+	kFailed, // the session is lost
+};
+
+//================================================================================
+// HMD Interface
+// The calls the frame lifecycle makes on a headset, so a stand in can drive
+// the loop with no headset. Times are seconds on the headset's clock.
+//================================================================================
+class HmdInterface
+{
+public:
+	virtual ~HmdInterface() {}
+
+	// Block until the compositor is ready for kFrameIndex, this paces the loop.
+	virtual HmdFrameStatus wait_to_begin_frame(const s64 kFrameIndex) = 0;
+
+	// Rendering of kFrameIndex starts, after a successful wait.
+	virtual bool begin_frame(const s64 kFrameIndex) = 0;
+
+	// When the middle of kFrameIndex's scanout is expected to be seen, poses should be predicted to it.
+	virtual f64 predicted_display_time(const s64 kFrameIndex) = 0;
+
+	// Hand kFrameIndex's layers to the compositor.
+	virtual bool end_frame(const s64 kFrameIndex, const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers) = 0;
+
+	virtual f64 time_seconds() = 0;
+	virtual f64 refresh_interval() = 0;
+};
+
+// Timing of one frame through the lifecycle, seconds on the HMD clock.
+struct FrameRecord
+{
+	s64 frameIndex;
+	f64 waitStart;            // wait_to_begin_frame called
+	f64 beginTime;            // the wait returned and the frame began
+	f64 predictedDisplayTime;
+	f64 submitTime;           // end_frame called
+	f64 endTime;              // end_frame returned
+};
+
+struct FrameLifecycleStats
+{
+	u32 frames;         // in the history
+	u32 skipped;        // since init, frames the compositor didn't want
+	u32 missed;         // in the history, frames predicted more than one refresh after the frame before
+	f32 averageWaitMs;  // blocked waiting for the compositor
+	f32 averageCpuMs;   // begin to submit
+	f32 maxCpuMs;
+	f32 averageLeadMs;  // begin to predicted display, the latency poses are predicted across
+};
+
+//================================================================================
+// Frame Lifecycle
+// Owns the frame index and walks each frame through wait, begin and end.
+//
+// Frame indices start at 1 and go up by one per rendered frame, the same
+// index goes to the pose queries and the submission so the runtime's
+// prediction knows which frame it is predicting for. Waiting for the
+// compositor before anything else keeps the loop at the display rate, so
+// input and poses are sampled as late as they can be rather than a few
+// frames ahead of what is being shown.
+//
+// The last kHistorySize frames' timing is kept for stats and traces.
+//================================================================================
+class FrameLifecycle
+{
+public:
+	static constexpr u32 kHistorySize = 128;
+
+	FrameLifecycle();
+
+	void init(HmdInterface* pHmd);
+
+	// Wait for the compositor and begin the next frame. Returns kRender when the frame should be drawn.
+	HmdFrameStatus begin_frame();
+
+	// Submit the frame begun, with no layers to just let it go.
+	bool end_frame(const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers);
+
+	bool in_frame() const { return m_inFrame; }
+	s64 frame_index() const { return m_current.frameIndex; }
+	f64 predicted_display_time() const { return m_current.predictedDisplayTime; }
+	HmdInterface* hmd() const { return m_pHmd; }
+
+	// Frames ended so far and still in the history.
+	u32 history_size() const { return m_numEnded < kHistorySize ? m_numEnded : kHistorySize; }
+
+	// kFramesAgo 0 is the last frame ended.
+	const FrameRecord& record(const u32 kFramesAgo) const;
+
+	FrameLifecycleStats stats() const;
+
+private:
+	HmdInterface* m_pHmd;
+	FrameRecord m_current;
+	bool m_inFrame;
+	u32 m_skipped;
+
+	FrameRecord m_history[kHistorySize];
+	u32 m_numEnded;
+};
+
+//================================================================================
+// Simulated HMD
+// A stand in headset on a clock the caller moves, for exercising the lifecycle
+// without one.
+//
+// Vsyncs are every refresh interval. A frame submitted at time t is taken by
+// the compositor at the first vsync at or after t and seen one refresh later.
+// The next frame can't begin until the compositor has taken the last one, so
+// one frame is queued at most. The prediction for a frame assumes it is
+// submitted before the next vsync; frames that aren't are counted as missed.
+//================================================================================
+class SimulatedHmd final : public HmdInterface
+{
+public:
+	explicit SimulatedHmd(const f64 kRefreshRate = 90.0);
+
+	// The app spent kSeconds, moves the clock on.
+	void advance(const f64 kSeconds) { m_time += kSeconds; }
+
+	// Report kSkip from the waits, as a headset that was taken off.
+	void set_visible(const bool kVisible) { m_visible = kVisible; }
+
+	HmdFrameStatus wait_to_begin_frame(const s64 kFrameIndex) override;
+	bool begin_frame(const s64 kFrameIndex) override;
+	f64 predicted_display_time(const s64 kFrameIndex) override;
+	bool end_frame(const s64 kFrameIndex, const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers) override;
+	f64 time_seconds() override { return m_time; }
+	f64 refresh_interval() override { return m_interval; }
+
+	// When the last frame submitted is seen, and how many were seen later than predicted.
+	f64 last_display_time() const { return m_lastDisplayTime; }
+	u32 missed() const { return m_missed; }
+
+private:
+	f64 next_vsync(const f64 kTime) const;
+
+	f64 m_interval;
+	f64 m_time;
+	f64 m_latchTime;       // vsync taking the last frame submitted
+	f64 m_lastDisplayTime;
+	s64 m_predictedFrame;  // frame the prediction was made for, fixed once asked
+	f64 m_predictedTime;
+	s64 m_begunFrame;
+	u32 m_missed;
+	bool m_visible;
+};
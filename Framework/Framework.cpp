@@ -10,6 +10,16 @@
 #define DEBUG_DRAW_IMPLEMENTATION
 #include "Framework.h"
 #include "ShaderSet.h"
+#include "Culling.h"
+#include "FrameArena.h"
+#include "FrameLifecycle.h"
+#include "OvrHmd.h"
+#include "LogRing.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "D3D11GpuTimer.h"
+#include "PerfStats.h"
+#include "Benchmark.h"
 
 #include <cstdlib>
 #include <tuple>
@@ -23,6 +33,10 @@
 #include "OVR_CAPI_D3D.h"
 
 bool stereoToggle = false;
+
+// 16MB of blocks per frame before falling back to the heap.
+constexpr size_t kFrameArenaBlockSize = 64 * 1024;
+constexpr u32 kFrameArenaMaxBlocks = 256;
 #ifndef max
 #define max(a,b)            (((a) > (b)) ? (a) : (b))
 #endif
@@ -165,6 +179,7 @@ public:
 					bKeepGoing = false;
 				}
 			}
+			// Blocks on the compositor, so the loop doesn't run ahead of the headset.
 			onRender();
 		}
 	}
@@ -731,6 +746,7 @@ public:
 
 		// Map the vertex buffer:
 		D3D11_MAPPED_SUBRESOURCE mapInfo;
+		perf_count(PerfCounter::kMapCalls, 1);
 		if (FAILED(deviceContext->Map(glyphVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapInfo)))
 		{
 			panicF("Failed to map vertex buffer!");
@@ -790,6 +806,7 @@ public:
 
 		// Map the vertex buffer:
 		D3D11_MAPPED_SUBRESOURCE mapInfo;
+		perf_count(PerfCounter::kMapCalls, 1);
 		if (FAILED(deviceContext->Map(pointVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapInfo)))
 		{
 			panicF("Failed to map vertex buffer!");
@@ -848,6 +865,7 @@ public:
 
 		// Map the vertex buffer:
 		D3D11_MAPPED_SUBRESOURCE mapInfo;
+		perf_count(PerfCounter::kMapCalls, 1);
 		if (FAILED(deviceContext->Map(lineVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapInfo)))
 		{
 			panicF("Failed to map vertex buffer!");
@@ -1239,13 +1257,66 @@ static void inputUpdate(const Window & win)
 	mouse.rightButtonDown = testKeyPressed(VK_RBUTTON);
 }
 
+// ========================================================
+// Performance HUD, frame times and the last frame's counts.
+// ========================================================
+static void drawPerformanceHud(PerfStats& stats)
+{
+	if (!ImGui::Begin("Performance"))
+	{
+		ImGui::End();
+		return;
+	}
+
+	const FrameTimeHistogram& histogram = stats.histogram();
+	auto historyAt = [](void* pData, int index) -> float { return ((const PerfStats*)pData)->history((u32)index); };
+	char overlay[64];
+	const f32 kLastMs = stats.history_count() ? stats.history(stats.history_count() - 1) : 0.f;
+	snprintf(overlay, sizeof(overlay), "%.2f ms, refresh %.2f ms", kLastMs, stats.desc().refreshMs);
+	ImGui::PlotLines("Frame time", historyAt, &stats, (int)stats.history_count(), 0, overlay, 0.f, stats.desc().refreshMs * 2.f, ImVec2(0.f, 60.f));
+
+	// Up to twice the refresh, anything slower than that is a miss either way.
+	auto binAt = [](void* pData, int index) -> float { return (float)((const FrameTimeHistogram*)pData)->bin((u32)index); };
+	const u32 kPlotBins = std::min(histogram.bins(), (u32)(stats.desc().refreshMs * 2.f / histogram.bin_width_ms()) + 1);
+	ImGui::PlotHistogram("Histogram", binAt, (void*)&histogram, (int)kPlotBins, 0, nullptr, 0.f, FLT_MAX, ImVec2(0.f, 60.f));
+
+	ImGui::Text("p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", histogram.percentile(0.5f), histogram.percentile(0.95f),
+		histogram.percentile(0.99f), histogram.max_ms());
+	ImGui::Text("Missed %llu of %llu frames, %llu refreshes", (unsigned long long)stats.missed_frames(), (unsigned long long)stats.frames(),
+		(unsigned long long)stats.missed_refreshes());
+	for (u32 i = 0; i < kNumPerfCounters; ++i)
+	{
+		ImGui::Text("%s: %llu", perf_counter_name((PerfCounter)i), (unsigned long long)stats.last((PerfCounter)i));
+	}
+	if (ImGui::Button("Reset"))
+	{
+		stats.reset();
+	}
+	ImGui::End();
+}
+
 // ========================================================
 // Main entry point for the framework.. 
 // called directly from winmain.
 // ========================================================
 
-int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInstance, int nCmdShow)
+int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInstance, int nCmdShow, const char* pCommandLine)
 {
+	BenchmarkDesc benchmarkDesc;
+	parse_benchmark_args(pCommandLine, benchmarkDesc);
+
+	// Scoped markers from every thread, captured on request. Made first so it outlives the threads recording to it.
+	Profiler profiler;
+	profiler.init(ProfilerDesc());
+	set_current_profiler(&profiler);
+	PROFILE_THREAD("Main");
+
+	// Logging from the frame loop goes through here, formatted and written off the render thread.
+	LoggerDesc loggerDesc;
+	loggerDesc.pFilePath = "framework.log";
+	Logger logger;
+	logger.init(loggerDesc);
+	set_current_logger(&logger);
 
 	RenderWindowD3D11 renderWindow(hInstance, nCmdShow, pTitleString);
 	RenderInterfaceD3D11 renderInterface(renderWindow.m_pD3DDevice, renderWindow.m_pDeviceContext);
@@ -1259,6 +1330,47 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 	// Initialise the imgui library
 	ImGui_ImplDX11_Init(renderWindow.m_hWnd, renderWindow.m_pD3DDevice.Get(), renderWindow.m_pDeviceContext.Get());
 
+	// Transient per frame memory, also used as scratch while the app loads.
+	FrameArena frameArena;
+	frameArena.init(kFrameArenaBlockSize, kFrameArenaMaxBlocks);
+	set_current_frame_arena(&frameArena);
+
+	// Frames are paced by the headset's compositor.
+	OvrHmd ovrHmd;
+	ovrHmd.init(renderWindow.m_pOvrSession);
+	OvrPoseSource ovrPoses;
+	ovrPoses.init(renderWindow.m_pOvrSession);
+
+	// Frame times and counts for the performance HUD, dumped to stdout at exit.
+	PerfStatsDesc perfDesc;
+	perfDesc.refreshMs = (f32)(ovrHmd.refresh_interval() * 1000.0);
+	PerfStats perfStats;
+	perfStats.init(perfDesc);
+	set_current_perf_stats(&perfStats);
+
+	// A benchmark swaps the headset's clock and poses for repeatable stand ins, and runs as fast as it can.
+	Benchmark benchmark;
+	if (benchmarkDesc.enabled)
+	{
+		benchmark.init(benchmarkDesc, &profiler, &perfStats);
+		perfStats.set_refresh_ms(benchmark.frame_seconds() * 1000.f);
+	}
+	FrameLifecycle frameLifecycle;
+	frameLifecycle.init(benchmarkDesc.enabled ? benchmark.hmd() : &ovrHmd);
+
+	// Outside a benchmark, the camera's path can be recorded to replay in one.
+	CameraPath recordedCamera;
+	f32 recordedTime = 0.f;
+
+	// GPU timings, read back a few frames late. Four slots cover the frames the compositor queues.
+	D3D11GpuTimer gpuTimer;
+	GpuProfiler gpuProfiler;
+	const bool kGpuProfiling = gpuTimer.init(renderWindow.m_pD3DDevice.Get(), renderWindow.m_pDeviceContext.Get(), 4, 256);
+	if (kGpuProfiling)
+	{
+		gpuProfiler.init(&gpuTimer, &profiler);
+	}
+
 	SystemsInterface systems = {};
 	systems.pDebugDrawContext = ddContext;
 	systems.pD3DDevice = renderWindow.m_pD3DDevice.Get();
@@ -1269,6 +1381,12 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 	systems.pEyeRenderViewport[1] = renderWindow.m_pOvrEyeRenderViewport[1];
 	systems.pEyeRenderTexture = renderWindow.m_pOvrEyeRenderTexture;
 	systems.pCamera = &camera;
+	systems.pFrameArena = &frameArena;
+	systems.pFrameLifecycle = &frameLifecycle;
+	systems.pPoseSource = benchmarkDesc.enabled ? benchmark.poses() : &ovrPoses;
+	systems.benchmark = benchmarkDesc.enabled;
+	systems.pCommandLine = benchmarkDesc.commandLine.c_str();
+	systems.pGpuProfiler = kGpuProfiling ? &gpuProfiler : nullptr;
 	systems.width = Window::s_width;
 	systems.height = Window::s_height;
 
@@ -1295,8 +1413,62 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 	/////////////////////////////////////////////////////////////
 	// Lambda for handling rendering
 	/////////////////////////////////////////////////////////////
-	renderWindow.m_pRenderCallback = [&systems, &renderWindow, &renderInterface, &rApp]()
+	renderWindow.m_pRenderCallback = [&systems, &renderWindow, &renderInterface, &rApp, &profiler, &perfStats, &benchmark, &benchmarkDesc,
+		&recordedCamera, &recordedTime]()
 	{
+		// Between frames, where captures start and end.
+		profiler.begin_frame();
+
+		// A benchmark quits once its frames have run and the report is written.
+		if (systems.benchmark && !benchmark.begin_frame())
+		{
+			PostQuitMessage(0);
+			return;
+		}
+
+		PROFILE_SCOPE("Frame");
+
+		// Wait for the compositor before anything else, so input and poses are sampled as late as they can be.
+		const HmdFrameStatus kFrameStatus = systems.pFrameLifecycle->begin_frame();
+		if (kFrameStatus == HmdFrameStatus::kFailed)
+		{
+			// The log file should say so too, panicF doesn't return.
+			logF(LogLevel::kError, "Lost the HMD session after frame %lld", systems.pFrameLifecycle->frame_index());
+			if (current_logger())
+			{
+				current_logger()->flush();
+			}
+			panicF("Lost the HMD session.");
+		}
+		// A frame after a skip is timed from before the skip, it has nothing to say about rendering.
+		static bool s_timedFrame = false;
+		static bool s_skipping = false;
+		if (kFrameStatus == HmdFrameStatus::kSkip)
+		{
+			if (!s_skipping)
+			{
+				logF(LogLevel::kInfo, "HMD not visible, skipping frames after frame %lld", systems.pFrameLifecycle->frame_index());
+			}
+			s_skipping = true;
+			s_timedFrame = false;
+			return;
+		}
+		if (s_skipping)
+		{
+			logF(LogLevel::kInfo, "HMD visible again at frame %lld, %u skipped so far", systems.pFrameLifecycle->frame_index(),
+				systems.pFrameLifecycle->stats().skipped);
+			s_skipping = false;
+		}
+
+		// Reclaim the frame arena memory from two frames ago.
+		systems.pFrameArena->begin_frame();
+
+		// Reads back the GPU times of frames that have finished.
+		if (systems.pGpuProfiler)
+		{
+			systems.pGpuProfiler->begin_frame();
+		}
+
 		// Let Imgui prepare for a new frame.
 		ImGui_ImplDX11_NewFrame();
 
@@ -1308,16 +1480,18 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 
 		prevTime = t0s;
 
-		// Plot delta time.
-		/*
-		static float s_times[64];
-		static u32 s_timesIdx = 0;
-		s_times[s_timesIdx] = deltaTime.seconds;
-		s_timesIdx = (s_timesIdx + 1) % 64;
-		ImGui::PlotLines("dT", s_times, 64, s_timesIdx, 0, 0.f, 2.0f/60.0f, ImVec2(400.f, 200.f));
-		*/
+		// What the frame really took goes to the stats, a benchmark moves everything else on by a fixed step.
+		const f32 kFrameMs = deltaTime.seconds * 1000.f;
+		if (systems.benchmark)
+		{
+			deltaTime.seconds = benchmark.frame_seconds();
+			deltaTime.milliseconds = static_cast<std::int64_t>(deltaTime.seconds * 1000.0);
+		}
 
-		inputUpdate(renderWindow);
+		if (!systems.benchmark)
+		{
+			inputUpdate(renderWindow);
+		}
 
 		// size may change so update window size
 		systems.width = renderWindow.s_width;
@@ -1327,7 +1501,21 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 		//if (mouse.rightButtonDown) {
 		//	camera.checkMouseRotation();
 		//}
-		camera.checkKeyboardMovement();
+		if (systems.benchmark)
+		{
+			v3 target;
+			benchmark.camera(camera.eye, target);
+			camera.look_at(target);
+		}
+		else
+		{
+			camera.checkKeyboardMovement();
+		}
+		if (!benchmarkDesc.recordCameraPath.empty())
+		{
+			recordedTime += deltaTime.seconds;
+			recordedCamera.add({ recordedTime, camera.eye, camera.getTarget() });
+		}
 
 		//handle toggling stereo on & off
 		if (keys.vDown)
@@ -1376,7 +1564,10 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 		camera.updateMatrices();
 
 		// Let the application update.
-		rApp.on_update(systems);
+		{
+			PROFILE_SCOPE("Update");
+			rApp.on_update(systems);
+		}
 
 
 		m4x4 mvpMatrix = camera.vpMatrix.Transpose();
@@ -1385,13 +1576,51 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 		renderInterface.setCameraFrame(camera.up, camera.right, camera.eye);
 
 		// Let the application render.
-		rApp.on_render(systems);
+		{
+			PROFILE_SCOPE("Render");
+			rApp.on_render(systems);
+		}
+
+		// A frame the app didn't submit still has to end, or the next can't begin.
+		if (systems.pFrameLifecycle->in_frame())
+		{
+			systems.pFrameLifecycle->end_frame(nullptr, 0);
+		}
 
 		// Flush the debug draw queues:
-		dd::flush(systems.pDebugDrawContext);
+		{
+			PROFILE_SCOPE("Debug draw flush");
+			GpuProfileScope gpuScope(systems.pGpuProfiler, "Debug draw");
+			dd::flush(systems.pDebugDrawContext);
+		}
+
+		drawPerformanceHud(perfStats);
 
 		// Flush Imgui draw queues
-		ImGui::Render();
+		{
+			PROFILE_SCOPE("ImGui render");
+			GpuProfileScope gpuScope(systems.pGpuProfiler, "ImGui");
+			ImGui::Render();
+		}
+
+		if (systems.pGpuProfiler)
+		{
+			systems.pGpuProfiler->end_frame();
+		}
+
+		// Neither does the first frame, there is nothing before it to time from.
+		if (s_timedFrame)
+		{
+			perfStats.end_frame(kFrameMs);
+
+			// Rate limited by the logger, a run of slow frames logs a few and counts the rest.
+			if (kFrameMs > perfStats.desc().refreshMs * 1.5f)
+			{
+				logF(LogLevel::kWarning, "Frame %lld took %.2f ms, missed the %.2f ms refresh", systems.pFrameLifecycle->frame_index(), kFrameMs,
+					perfStats.desc().refreshMs);
+			}
+		}
+		s_timedFrame = true;
 
 #ifdef DEAD
 		const double t1s = getTimeSeconds();
@@ -1418,6 +1647,27 @@ int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInst
 	/////////////////////////////////////////////////////////////
 	ImGui_ImplDX11_Shutdown();
 
+	// Also for runs with no one watching the HUD.
+	const std::string perfSummary = perfStats.summary();
+	fputs(perfSummary.c_str(), stdout);
+	fflush(stdout);
+	debugF("%s", perfSummary.c_str());
+	set_current_perf_stats(nullptr);
+
+	if (!benchmarkDesc.recordCameraPath.empty())
+	{
+		if (recordedCamera.save(benchmarkDesc.recordCameraPath.c_str()))
+		{
+			debugF("Saved %u camera keys to %s\n", recordedCamera.size(), benchmarkDesc.recordCameraPath.c_str());
+		}
+		else
+		{
+			errorF("Failed to save the camera path to %s", benchmarkDesc.recordCameraPath.c_str());
+		}
+	}
+
+	set_current_frame_arena(nullptr);
+
 	dd::shutdown(ddContext);
 	return 0;
 }
@@ -1554,37 +1804,7 @@ void Camera::updateMatrices()
 	vpMatrix = viewMatrix * projMatrix;
 
 	// Compute and normalize the 6 frustum planes:
-	const float * const m = reinterpret_cast<float*>(&vpMatrix);
-	planes[0].x = m[3] - m[0];
-	planes[0].y = m[7] - m[4];
-	planes[0].z = m[11] - m[8];
-	planes[0].w = m[15] - m[12];
-	planes[0].Normalize();
-	planes[1].x = m[3] + m[0];
-	planes[1].y = m[7] + m[4];
-	planes[1].z = m[11] + m[8];
-	planes[1].w = m[15] + m[12];
-	planes[1].Normalize();
-	planes[2].x = m[3] + m[1];
-	planes[2].y = m[7] + m[5];
-	planes[2].z = m[11] + m[9];
-	planes[2].w = m[15] + m[13];
-	planes[2].Normalize();
-	planes[3].x = m[3] - m[1];
-	planes[3].y = m[7] - m[5];
-	planes[3].z = m[11] - m[9];
-	planes[3].w = m[15] - m[13];
-	planes[3].Normalize();
-	planes[4].x = m[3] - m[2];
-	planes[4].y = m[7] - m[6];
-	planes[4].z = m[11] - m[10];
-	planes[4].w = m[15] - m[14];
-	planes[4].Normalize();
-	planes[5].x = m[3] + m[2];
-	planes[5].y = m[7] + m[6];
-	planes[5].z = m[11] + m[10];
-	planes[5].w = m[15] + m[14];
-	planes[5].Normalize();
+	extract_frustum_planes(vpMatrix, planes);
 }
 
 void Camera::look_at(const v3& vTarget)
@@ -9,6 +9,11 @@
 #include <OVR_CAPI.h>
 #include "OculusTexture.h"
 
+class FrameArena;
+class FrameLifecycle;
+class PoseSource;
+class GpuProfiler;
+
 //================================================================================
 // Time releated functions
 //================================================================================
@@ -146,9 +151,15 @@ struct SystemsInterface
 
 	dd::ContextHandle pDebugDrawContext;
 	Camera* pCamera;
+	FrameArena* pFrameArena; // transient allocations, reset at the start of every frame
+	FrameLifecycle* pFrameLifecycle; // the frame begun before on_update, submit the eye layers through it
+	PoseSource* pPoseSource;         // eye poses predicted for the frame's display
+	GpuProfiler* pGpuProfiler;       // GPU scopes on the immediate context, null when timestamps are unavailable
 	u32 width;
 	u32 height;
 	bool stereo;
+	bool benchmark; // a repeatable benchmark run, nothing should depend on the wall clock or the user
+	const char* pCommandLine; // arguments the framework didn't read are for the app, never null
 };
 
 // ========================================================
@@ -169,12 +180,13 @@ private:
 // Macro to define entry point.
 // ========================================================
 
-int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInstance, int nCmdShow);
+// pCommandLine can ask for a benchmark run, see parse_benchmark_args.
+int framework_main(FrameworkApp& rApp, const char* pTitleString, HINSTANCE hInstance, int nCmdShow, const char* pCommandLine);
 
 #define FRAMEWORK_IMPLEMENT_MAIN(app, appTitle) \
-int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/, LPSTR /*lpCmdLine*/, int nCmdShow)\
+int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/, LPSTR lpCmdLine, int nCmdShow)\
 {\
-	return framework_main(app, appTitle, hInstance, nCmdShow); \
+	return framework_main(app, appTitle, hInstance, nCmdShow, lpCmdLine); \
 }
 
 //================================================================================
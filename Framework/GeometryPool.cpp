@@ -0,0 +1,118 @@
+#include "GeometryPool.h"
+#include "StateCache.h"
+
+//================================================================================
+// Geometry Pool
+//================================================================================
+
+GeometryPool::GeometryPool()
+	: m_pContext(nullptr)
+	, m_pVertexBuffer(nullptr)
+	, m_pIndexBuffer(nullptr)
+	, m_vertexStride(0)
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+	release();
+}
+
+void GeometryPool::init(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, const u32 kVertexStride, const u32 kMaxVertices, const u32 kMaxIndices)
+{
+	ASSERT(!m_pVertexBuffer && !m_pIndexBuffer);
+	ASSERT(kVertexStride > 0 && kMaxVertices > 0 && kMaxIndices > 0);
+
+	// Default usage so meshes can be written into their ranges after creation.
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = kVertexStride * kMaxVertices;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		HRESULT hr = pDevice->CreateBuffer(&desc, NULL, &m_pVertexBuffer);
+		ASSERT(!FAILED(hr) && m_pVertexBuffer);
+	}
+
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = sizeof(u16) * kMaxIndices;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+		HRESULT hr = pDevice->CreateBuffer(&desc, NULL, &m_pIndexBuffer);
+		ASSERT(!FAILED(hr) && m_pIndexBuffer);
+	}
+
+	m_pContext = pContext;
+	m_vertexStride = kVertexStride;
+	m_vertexAllocator.init(kMaxVertices);
+	m_indexAllocator.init(kMaxIndices);
+}
+
+void GeometryPool::release()
+{
+	SAFE_RELEASE(m_pVertexBuffer);
+	SAFE_RELEASE(m_pIndexBuffer);
+	m_pContext = nullptr;
+}
+
+bool GeometryPool::allocate(const void* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, GeometryRange& rRangeOut)
+{
+	ASSERT(m_pVertexBuffer && pVertices && pIndices);
+
+	const u32 kBaseVertex = m_vertexAllocator.allocate(kNumVerts);
+	if (kBaseVertex == RangeAllocator::kInvalidOffset)
+	{
+		return false;
+	}
+
+	const u32 kFirstIndex = m_indexAllocator.allocate(kNumIndices);
+	if (kFirstIndex == RangeAllocator::kInvalidOffset)
+	{
+		m_vertexAllocator.free(kBaseVertex, kNumVerts);
+		return false;
+	}
+
+	D3D11_BOX box = {};
+	box.bottom = 1;
+	box.back = 1;
+
+	box.left = kBaseVertex * m_vertexStride;
+	box.right = (kBaseVertex + kNumVerts) * m_vertexStride;
+	m_pContext->UpdateSubresource(m_pVertexBuffer, 0, &box, pVertices, 0, 0);
+
+	box.left = kFirstIndex * sizeof(u16);
+	box.right = (kFirstIndex + kNumIndices) * sizeof(u16);
+	m_pContext->UpdateSubresource(m_pIndexBuffer, 0, &box, pIndices, 0, 0);
+
+	rRangeOut.firstIndex = kFirstIndex;
+	rRangeOut.indexCount = kNumIndices;
+	rRangeOut.baseVertex = (s32)kBaseVertex;
+	rRangeOut.vertexCount = kNumVerts;
+	return true;
+}
+
+void GeometryPool::free(const GeometryRange& range)
+{
+	m_vertexAllocator.free((u32)range.baseVertex, range.vertexCount);
+	m_indexAllocator.free(range.firstIndex, range.indexCount);
+}
+
+void GeometryPool::bind(ID3D11DeviceContext* pContext) const
+{
+	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	ID3D11Buffer* buffers[] = { m_pVertexBuffer };
+	UINT strides[] = { m_vertexStride };
+	UINT offsets[] = { 0 };
+	pContext->IASetVertexBuffers(0, 1, buffers, strides, offsets);
+	pContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+}
+
+void GeometryPool::bind(StateCache& rState) const
+{
+	rState.set_topology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	rState.set_vertex_buffer(0, m_pVertexBuffer, m_vertexStride, 0);
+	rState.set_index_buffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "RangeAllocator.h"
+
+class StateCache;
+
+// Where a mesh lives in the pool, in the units the draw calls take.
+struct GeometryRange
+{
+	u32 firstIndex;
+	u32 indexCount;
+	s32 baseVertex;
+	u32 vertexCount;
+};
+
+//================================================================================
+// Geometry Pool
+// One vertex buffer and one index buffer shared by the static meshes.
+//
+// Each mesh is copied into its own range of both buffers, its indices stay
+// relative to its first vertex and draws pass that as the base vertex. Every
+// pooled mesh binds the same buffers so the state cache drops the input
+// assembler binds between them, a whole material batch costs one bind.
+//
+// Ranges can be freed in any order, the allocators coalesce what is returned.
+//================================================================================
+class GeometryPool
+{
+public:
+	GeometryPool();
+	~GeometryPool();
+
+	// Vertices are kVertexStride bytes, indices are 16 bit. Uploads go through pContext.
+	void init(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, const u32 kVertexStride, const u32 kMaxVertices, const u32 kMaxIndices);
+	void release();
+
+	// Copy a mesh into the pool, false when either buffer has no room for it.
+	bool allocate(const void* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, GeometryRange& rRangeOut);
+	void free(const GeometryRange& range);
+
+	void bind(ID3D11DeviceContext* pContext) const;
+	void bind(StateCache& rState) const;
+
+	u32 vertex_stride() const { return m_vertexStride; }
+	const RangeAllocator& vertex_allocator() const { return m_vertexAllocator; }
+	const RangeAllocator& index_allocator() const { return m_indexAllocator; }
+
+private:
+	ID3D11DeviceContext* m_pContext;
+	ID3D11Buffer* m_pVertexBuffer;
+	ID3D11Buffer* m_pIndexBuffer;
+	u32 m_vertexStride;
+	RangeAllocator m_vertexAllocator;
+	RangeAllocator m_indexAllocator;
+};
@@ -0,0 +1,162 @@
+#include "GpuCulling.h"
+#include "StateCache.h"
+
+namespace
+{
+	const char* kCullingShaders = "Assets/Shaders/CullingShaders.fx";
+}
+
+//================================================================================
+// GPU Culler
+//================================================================================
+
+GpuCuller::GpuCuller()
+	: m_pConstantBuffer(nullptr)
+	, m_pGroupBuffer(nullptr)
+	, m_pGroupSRV(nullptr)
+	, m_pSlotBuffer(nullptr)
+	, m_pSlotSRV(nullptr)
+	, m_pBoundsBuffer(nullptr)
+	, m_pBoundsSRV(nullptr)
+	, m_pVisibleBuffer(nullptr)
+	, m_pVisibleSRV(nullptr)
+	, m_pVisibleUAV(nullptr)
+	, m_pArgsBuffer(nullptr)
+	, m_pArgsUAV(nullptr)
+	, m_pArgsReset(nullptr)
+	, m_maxObjects(0)
+	, m_maxGroups(0)
+	, m_numGroups(0)
+	, m_numSlots(0)
+{
+}
+
+GpuCuller::~GpuCuller()
+{
+	release();
+}
+
+void GpuCuller::init(ID3D11Device* pDevice)
+{
+	ASSERT(!m_pConstantBuffer);
+	m_shader.init(pDevice, ShaderSetDesc::Create_CS(kCullingShaders, "CS_CullDrawGroups"));
+	m_pConstantBuffer = create_constant_buffer<CullConstants>(pDevice);
+}
+
+void GpuCuller::release()
+{
+	release_buffers();
+	SAFE_RELEASE(m_pConstantBuffer);
+	m_shader = ShaderSet();
+}
+
+void GpuCuller::release_buffers()
+{
+	SAFE_RELEASE(m_pGroupSRV);
+	SAFE_RELEASE(m_pGroupBuffer);
+	SAFE_RELEASE(m_pSlotSRV);
+	SAFE_RELEASE(m_pSlotBuffer);
+	SAFE_RELEASE(m_pBoundsSRV);
+	SAFE_RELEASE(m_pBoundsBuffer);
+	SAFE_RELEASE(m_pVisibleUAV);
+	SAFE_RELEASE(m_pVisibleSRV);
+	SAFE_RELEASE(m_pVisibleBuffer);
+	SAFE_RELEASE(m_pArgsUAV);
+	SAFE_RELEASE(m_pArgsBuffer);
+	SAFE_RELEASE(m_pArgsReset);
+	m_maxObjects = 0;
+	m_maxGroups = 0;
+	m_numGroups = 0;
+	m_numSlots = 0;
+}
+
+void GpuCuller::reserve(ID3D11Device* pDevice, const u32 kMaxObjects, const u32 kMaxGroups)
+{
+	ASSERT(m_pConstantBuffer);
+	ASSERT(kMaxObjects > 0 && kMaxGroups > 0);
+	// One thread per object, within the 65535 thread groups a dispatch dimension allows.
+	ASSERT(kMaxObjects <= D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION * kCullThreadGroupSize);
+	if (kMaxObjects <= m_maxObjects && kMaxGroups <= m_maxGroups)
+	{
+		return;
+	}
+	const u32 kObjects = std::max(kMaxObjects, m_maxObjects);
+	const u32 kGroups = std::max(kMaxGroups, m_maxGroups);
+	release_buffers();
+
+	// Inputs, groups and slots are static, bounds change as objects move.
+	m_pGroupBuffer = create_default_structured_buffer<CullDrawGroup>(pDevice, kGroups);
+	m_pGroupSRV = create_structured_buffer_view(pDevice, m_pGroupBuffer);
+	m_pSlotBuffer = create_default_structured_buffer<CullSlot>(pDevice, kObjects);
+	m_pSlotSRV = create_structured_buffer_view(pDevice, m_pSlotBuffer);
+	m_pBoundsBuffer = create_default_structured_buffer<v4>(pDevice, kObjects);
+	m_pBoundsSRV = create_structured_buffer_view(pDevice, m_pBoundsBuffer);
+
+	// Outputs, written by the shader and read by the draws.
+	m_pVisibleBuffer = create_unordered_structured_buffer<u32>(pDevice, kObjects);
+	m_pVisibleSRV = create_structured_buffer_view(pDevice, m_pVisibleBuffer);
+	m_pVisibleUAV = create_structured_buffer_uav(pDevice, m_pVisibleBuffer);
+	m_pArgsBuffer = create_indirect_args_buffer(pDevice, kGroups * sizeof(DrawIndexedIndirectArgs));
+	m_pArgsUAV = create_raw_buffer_uav(pDevice, m_pArgsBuffer, kGroups * sizeof(DrawIndexedIndirectArgs));
+	m_pArgsReset = create_indirect_args_buffer(pDevice, kGroups * sizeof(DrawIndexedIndirectArgs));
+
+	m_maxObjects = kObjects;
+	m_maxGroups = kGroups;
+}
+
+void GpuCuller::set_groups(ID3D11DeviceContext* pContext, const CullDrawGroup* pGroups, const u32 kNumGroups, const u32* pSlotObjects, const u32 kNumSlots)
+{
+	ASSERT(kNumGroups <= m_maxGroups && kNumSlots <= m_maxObjects);
+
+	std::vector<DrawIndexedIndirectArgs> args;
+	build_cull_slots(pGroups, kNumGroups, pSlotObjects, kNumSlots, m_slots, args);
+
+	if (kNumGroups > 0)
+	{
+		update_structured_buffer(pContext, m_pGroupBuffer, 0, kNumGroups, pGroups);
+		const D3D11_BOX kBox = { 0, 0, 0, kNumGroups * (u32)sizeof(DrawIndexedIndirectArgs), 1, 1 };
+		pContext->UpdateSubresource(m_pArgsReset, 0, &kBox, args.data(), 0, 0);
+	}
+	if (kNumSlots > 0)
+	{
+		update_structured_buffer(pContext, m_pSlotBuffer, 0, kNumSlots, m_slots.data());
+	}
+	m_numGroups = kNumGroups;
+	m_numSlots = kNumSlots;
+}
+
+void GpuCuller::update_bounds(ID3D11DeviceContext* pContext, const u32 kFirst, const u32 kCount, const v4* pBounds)
+{
+	ASSERT(kFirst + kCount <= m_maxObjects);
+	update_structured_buffer(pContext, m_pBoundsBuffer, kFirst, kCount, pBounds);
+}
+
+void GpuCuller::dispatch(StateCache& rState, const CullConstants& constants)
+{
+	if (m_numGroups == 0)
+	{
+		return;
+	}
+
+	CullConstants frameConstants = constants;
+	frameConstants.numSlots = m_numSlots;
+	push_constant_buffer(rState.context(), m_pConstantBuffer, frameConstants);
+
+	// The shader only adds to the instance counts, they start from zero every pass.
+	const D3D11_BOX kBox = { 0, 0, 0, m_numGroups * (u32)sizeof(DrawIndexedIndirectArgs), 1, 1 };
+	rState.context()->CopySubresourceRegion(m_pArgsBuffer, 0, 0, 0, 0, m_pArgsReset, 0, &kBox);
+
+	rState.set_compute_shader(m_shader.cs.Get());
+	rState.set_constant_buffers(ShaderStage::kCompute, 0, 1, &m_pConstantBuffer);
+	ID3D11ShaderResourceView* inputs[] = { m_pGroupSRV, m_pSlotSRV, m_pBoundsSRV };
+	rState.set_shader_resources(ShaderStage::kCompute, 0, 3, inputs);
+	ID3D11UnorderedAccessView* outputs[] = { m_pVisibleUAV, m_pArgsUAV };
+	rState.set_compute_unordered_access_views(0, 2, outputs);
+
+	// One thread per object, so a big group spreads over the whole GPU.
+	rState.dispatch((m_numSlots + kCullThreadGroupSize - 1) / kCullThreadGroupSize, 1, 1);
+
+	// The outputs are read as a shader resource and as draw arguments next.
+	ID3D11UnorderedAccessView* nullOutputs[] = { nullptr, nullptr };
+	rState.set_compute_unordered_access_views(0, 2, nullOutputs);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "CullDrawGroups.h"
+#include "ShaderSet.h"
+
+class StateCache;
+
+//================================================================================
+// GPU Culler
+// Frustum culls every object on the GPU and writes an indirect draw per group.
+//
+// The CPU describes the groups once and uploads bounds when objects move, then
+// each pass is one dispatch followed by a DrawIndexedInstancedIndirect per
+// group. A thread tests each object, and each thread group adds its visible
+// objects to their draw groups with one atomic per group it touches.
+//
+// The visible list is laid out like the object list, a group's visible objects
+// are packed at the front of its slots, in an order that depends on timing.
+// cull_draw_groups_reference gives the same sets and args on the CPU.
+// StartInstanceLocation stays 0, SV_InstanceID doesn't include it, so the draws
+// pass each group's firstSlot through their per draw constants instead.
+//================================================================================
+class GpuCuller
+{
+public:
+	GpuCuller();
+	~GpuCuller();
+
+	// Compiles the shader, once, buffers come from reserve.
+	void init(ID3D11Device* pDevice);
+	void release();
+
+	// Room for kMaxObjects objects in kMaxGroups groups. Buffers are only recreated to grow,
+	// after which the groups and bounds have to be set again.
+	void reserve(ID3D11Device* pDevice, const u32 kMaxObjects, const u32 kMaxGroups);
+
+	// Describe the draws, pSlotObjects lists the objects of every group, each group's slots together.
+	void set_groups(ID3D11DeviceContext* pContext, const CullDrawGroup* pGroups, const u32 kNumGroups, const u32* pSlotObjects, const u32 kNumSlots);
+
+	// Bounding spheres of objects [kFirst, kFirst + kCount), xyz center and w radius.
+	void update_bounds(ID3D11DeviceContext* pContext, const u32 kFirst, const u32 kCount, const v4* pBounds);
+
+	// Cull every object, leaves the visible list and args ready for drawing and no UAVs bound.
+	// The visible list must not be bound to any stage, its SRV would be dropped behind the cache.
+	void dispatch(StateCache& rState, const CullConstants& constants);
+
+	u32 groups() const { return m_numGroups; }
+	ID3D11ShaderResourceView* visible_view() const { return m_pVisibleSRV; }
+	ID3D11Buffer* args_buffer() const { return m_pArgsBuffer; }
+	static u32 args_offset(const u32 kGroup) { return kGroup * sizeof(DrawIndexedIndirectArgs); }
+
+private:
+	void release_buffers();
+
+	ShaderSet m_shader;
+	ID3D11Buffer* m_pConstantBuffer;
+
+	ID3D11Buffer* m_pGroupBuffer;
+	ID3D11ShaderResourceView* m_pGroupSRV;
+	ID3D11Buffer* m_pSlotBuffer;
+	ID3D11ShaderResourceView* m_pSlotSRV;
+	ID3D11Buffer* m_pBoundsBuffer;
+	ID3D11ShaderResourceView* m_pBoundsSRV;
+
+	ID3D11Buffer* m_pVisibleBuffer;
+	ID3D11ShaderResourceView* m_pVisibleSRV;
+	ID3D11UnorderedAccessView* m_pVisibleUAV;
+	ID3D11Buffer* m_pArgsBuffer;
+	ID3D11UnorderedAccessView* m_pArgsUAV;
+	ID3D11Buffer* m_pArgsReset; // the args with no instances, copied over m_pArgsBuffer before each dispatch
+
+	std::vector<CullSlot> m_slots;
+
+	u32 m_maxObjects;
+	u32 m_maxGroups;
+	u32 m_numGroups;
+	u32 m_numSlots;
+};
@@ -0,0 +1,302 @@
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+//================================================================================
+// GPU Profiler
+//================================================================================
+
+GpuProfiler::GpuProfiler()
+	: m_pBackend(nullptr)
+	, m_pTimeline(nullptr)
+	, m_pTrack(nullptr)
+	, m_frameNumber(0)
+	, m_nextResolve(1)
+	, m_inFrame(false)
+	, m_timing(false)
+	, m_frameScope(kInvalidScope)
+	, m_depth(0)
+	, m_calibrated(false)
+	, m_calibrationGpuTicks(0)
+	, m_calibrationFrequency(0)
+	, m_calibrationCpuTicks(0)
+	, m_lastFrame()
+	, m_stats()
+{
+}
+
+void GpuProfiler::init(GpuTimerBackend* pBackend, Profiler* pTimeline)
+{
+	ASSERT(pBackend && pBackend->slots() > 0 && pBackend->queries_per_slot() >= 2);
+	m_pBackend = pBackend;
+	m_pTimeline = pTimeline;
+	m_pTrack = pTimeline ? pTimeline->track("GPU") : nullptr;
+
+	// Every scope takes two queries, the frame's own scope is the first.
+	m_slots.resize(pBackend->slots());
+	for (Slot& rSlot : m_slots)
+	{
+		rSlot = {};
+		rSlot.scopes.reserve(pBackend->queries_per_slot() / 2);
+	}
+	m_frameNumber = 0;
+	m_nextResolve = 1;
+	m_inFrame = false;
+	m_timing = false;
+	m_lastFrame = {};
+	m_stats = {};
+	calibrate();
+}
+
+void GpuProfiler::calibrate()
+{
+	ASSERT(!m_inFrame);
+	m_calibrated = m_pBackend->calibrate(m_calibrationGpuTicks, m_calibrationFrequency, m_calibrationCpuTicks);
+}
+
+void GpuProfiler::begin_frame()
+{
+	ASSERT(m_pBackend && !m_inFrame);
+	resolve();
+
+	m_frameNumber++;
+	m_stats.frames++;
+	m_inFrame = true;
+	m_depth = 0;
+
+	// The slot's last frame is still on the GPU, going without this frame's times beats waiting for it.
+	const u32 kSlot = (u32)(m_frameNumber % m_slots.size());
+	Slot& rSlot = m_slots[kSlot];
+	m_timing = !rSlot.pending;
+	if (!m_timing)
+	{
+		m_stats.skipped++;
+		return;
+	}
+
+	rSlot.frameNumber = m_frameNumber;
+	rSlot.numQueries = 0;
+	rSlot.scopes.clear();
+	m_pBackend->begin_slot(kSlot);
+	m_frameScope = begin_scope("GPU frame");
+}
+
+void GpuProfiler::end_frame()
+{
+	ASSERT(m_inFrame);
+	m_inFrame = false;
+	if (!m_timing)
+	{
+		return;
+	}
+
+	end_scope(m_frameScope);
+	const u32 kSlot = (u32)(m_frameNumber % m_slots.size());
+	m_pBackend->end_slot(kSlot);
+	m_slots[kSlot].pending = true;
+}
+
+u32 GpuProfiler::begin_scope(const char* name)
+{
+	if (!m_inFrame || !m_timing)
+	{
+		return kInvalidScope;
+	}
+
+	const u32 kSlot = (u32)(m_frameNumber % m_slots.size());
+	Slot& rSlot = m_slots[kSlot];
+	if (rSlot.numQueries + 2 > m_pBackend->queries_per_slot())
+	{
+		m_stats.droppedScopes++;
+		return kInvalidScope;
+	}
+
+	// Both queries are taken now so a scope can always end.
+	const Scope kScope = { name, m_depth++, rSlot.numQueries, rSlot.numQueries + 1 };
+	rSlot.numQueries += 2;
+	rSlot.scopes.push_back(kScope);
+	m_pBackend->timestamp(kSlot, kScope.beginQuery);
+	return (u32)rSlot.scopes.size() - 1;
+}
+
+void GpuProfiler::end_scope(const u32 kScope)
+{
+	if (kScope == kInvalidScope || !m_timing)
+	{
+		return;
+	}
+
+	const u32 kSlot = (u32)(m_frameNumber % m_slots.size());
+	ASSERT(kScope < m_slots[kSlot].scopes.size());
+	m_depth--;
+	m_pBackend->timestamp(kSlot, m_slots[kSlot].scopes[kScope].endQuery);
+}
+
+void GpuProfiler::resolve()
+{
+	while (m_nextResolve <= m_frameNumber)
+	{
+		const u32 kSlot = (u32)(m_nextResolve % m_slots.size());
+		Slot& rSlot = m_slots[kSlot];
+
+		// A skipped frame left the slot with an older frame, which resolved before it.
+		if (!rSlot.pending || rSlot.frameNumber != m_nextResolve)
+		{
+			m_nextResolve++;
+			continue;
+		}
+
+		// The GPU finishes frames in order, nothing after this one is ready either.
+		if (!resolve_slot(rSlot, kSlot))
+		{
+			break;
+		}
+		rSlot.pending = false;
+		m_nextResolve++;
+	}
+}
+
+bool GpuProfiler::resolve_slot(Slot& rSlot, const u32 kSlot)
+{
+	u64 frequency = 0;
+	bool disjoint = false;
+	if (!m_pBackend->read_slot(kSlot, frequency, disjoint))
+	{
+		return false;
+	}
+
+	// The disjoint query ends after the timestamps, but nothing promises they read back together.
+	u64 frameStart = 0;
+	u64 frameEnd = 0;
+	if (!m_pBackend->read_timestamp(kSlot, rSlot.scopes[0].beginQuery, frameStart)
+		|| !m_pBackend->read_timestamp(kSlot, rSlot.scopes[0].endQuery, frameEnd))
+	{
+		return false;
+	}
+
+	// Frames begun since this one ended, the current one included.
+	const u32 kLatency = (u32)(m_frameNumber + 1 - rSlot.frameNumber);
+	m_stats.maxLatency = std::max(m_stats.maxLatency, kLatency);
+	if (disjoint || frequency == 0)
+	{
+		m_stats.disjoint++;
+		return true;
+	}
+
+	const f64 kTicksToMs = 1000.0 / (f64)frequency;
+	m_lastFrame.frameNumber = rSlot.frameNumber;
+	m_lastFrame.latency = kLatency;
+	m_lastFrame.frameMs = (f32)((f64)(frameEnd - frameStart) * kTicksToMs);
+	m_lastFrame.scopes.clear();
+
+	const bool kTimeline = m_pTrack && m_calibrated && m_pTimeline->recording();
+	for (const Scope& scope : rSlot.scopes)
+	{
+		u64 begin = 0;
+		u64 end = 0;
+		if (!m_pBackend->read_timestamp(kSlot, scope.beginQuery, begin) || !m_pBackend->read_timestamp(kSlot, scope.endQuery, end))
+		{
+			return false;
+		}
+		// A timestamp can come back earlier than the one before it on some drivers, clamp rather than wrap.
+		end = std::max(end, begin);
+		begin = std::max(begin, frameStart);
+		end = std::max(end, begin);
+		m_lastFrame.scopes.push_back({ scope.name, scope.depth, (f32)((f64)(begin - frameStart) * kTicksToMs), (f32)((f64)(end - begin) * kTicksToMs) });
+
+		if (kTimeline)
+		{
+			const s64 kCpuBegin = to_cpu_ticks(begin, frequency);
+			if (kCpuBegin >= m_pTimeline->recording_start())
+			{
+				m_pTrack->add(scope.name, kCpuBegin, to_cpu_ticks(end, frequency), scope.depth);
+			}
+		}
+	}
+
+	m_stats.resolved++;
+	return true;
+}
+
+s64 GpuProfiler::to_cpu_ticks(const u64 kGpuTicks, const u64 kFrequency) const
+{
+	// Timestamps and the calibration can disagree on frequency if the clock changed, the slot's is the one that applies.
+	const f64 kCpuTicksPerSecond = (f64)std::chrono::steady_clock::period::den / (f64)std::chrono::steady_clock::period::num;
+	const f64 kSeconds = ((f64)kGpuTicks - (f64)m_calibrationGpuTicks) / (f64)kFrequency;
+	return m_calibrationCpuTicks + (s64)(kSeconds * kCpuTicksPerSecond);
+}
+
+//================================================================================
+// Fake GPU Timer
+//================================================================================
+
+FakeGpuTimer::FakeGpuTimer(const u32 kSlots, const u32 kQueriesPerSlot, const u32 kLatency, const u64 kFrequency)
+	: m_slots(kSlots)
+	, m_queriesPerSlot(kQueriesPerSlot)
+	, m_latency(kLatency)
+	, m_frequency(kFrequency)
+	, m_time(0)
+	, m_frame(0)
+	, m_nextDisjoint(false)
+{
+	for (Slot& rSlot : m_slots)
+	{
+		rSlot.ticks.assign(kQueriesPerSlot, 0);
+		rSlot.readyAt = 0;
+		rSlot.ended = false;
+		rSlot.disjoint = false;
+	}
+}
+
+void FakeGpuTimer::begin_slot(const u32 kSlot)
+{
+	ASSERT(kSlot < m_slots.size());
+	m_slots[kSlot].ended = false;
+}
+
+void FakeGpuTimer::end_slot(const u32 kSlot)
+{
+	Slot& rSlot = m_slots[kSlot];
+	rSlot.ended = true;
+	rSlot.readyAt = m_frame + m_latency;
+	rSlot.disjoint = m_nextDisjoint;
+	m_nextDisjoint = false;
+}
+
+void FakeGpuTimer::timestamp(const u32 kSlot, const u32 kQuery)
+{
+	ASSERT(kQuery < m_queriesPerSlot);
+	m_slots[kSlot].ticks[kQuery] = m_time;
+}
+
+bool FakeGpuTimer::read_slot(const u32 kSlot, u64& rFrequency, bool& rDisjoint)
+{
+	const Slot& slot = m_slots[kSlot];
+	if (!slot.ended || m_frame < slot.readyAt)
+	{
+		return false;
+	}
+	rFrequency = m_frequency;
+	rDisjoint = slot.disjoint;
+	return true;
+}
+
+bool FakeGpuTimer::read_timestamp(const u32 kSlot, const u32 kQuery, u64& rTicks)
+{
+	const Slot& slot = m_slots[kSlot];
+	if (!slot.ended || m_frame < slot.readyAt)
+	{
+		return false;
+	}
+	rTicks = slot.ticks[kQuery];
+	return true;
+}
+
+bool FakeGpuTimer::calibrate(u64& rGpuTicks, u64& rFrequency, s64& rCpuTicks)
+{
+	rGpuTicks = m_time;
+	rFrequency = m_frequency;
+	rCpuTicks = profiler_ticks();
+	return true;
+}
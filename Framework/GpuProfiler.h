@@ -0,0 +1,229 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+class Profiler;
+class ProfileBuffer;
+
+//================================================================================
+// GPU Timer Backend
+// The timestamp queries the GPU profiler issues, so a stand in can run it with
+// no device. Queries are grouped in slots, one per frame in flight, each with
+// a disjoint query around its timestamps.
+// Reads never wait, they report false until the GPU has got that far.
+//================================================================================
+class GpuTimerBackend
+{
+public:
+	virtual ~GpuTimerBackend() {}
+
+	virtual u32 slots() const = 0;
+	virtual u32 queries_per_slot() const = 0;
+
+	// Bracket the slot's timestamps.
+	virtual void begin_slot(const u32 kSlot) = 0;
+	virtual void end_slot(const u32 kSlot) = 0;
+
+	// Write the GPU clock into kQuery once the work before it is done.
+	virtual void timestamp(const u32 kSlot, const u32 kQuery) = 0;
+
+	// The slot's clock frequency, and whether it was unreliable (e.g. the clock changed mid frame).
+	virtual bool read_slot(const u32 kSlot, u64& rFrequency, bool& rDisjoint) = 0;
+	virtual bool read_timestamp(const u32 kSlot, const u32 kQuery, u64& rTicks) = 0;
+
+	// A GPU tick and the steady clock tick of about the same moment, to put GPU times on the CPU's timeline.
+	// May wait for the GPU, only call it outside the frame loop.
+	virtual bool calibrate(u64& rGpuTicks, u64& rFrequency, s64& rCpuTicks) = 0;
+};
+
+// One timed scope of a resolved frame, relative to the start of the frame's GPU work.
+struct GpuScopeTiming
+{
+	const char* name;
+	u32 depth;
+	f32 startMs;
+	f32 durationMs;
+};
+
+struct GpuFrameTimings
+{
+	u64 frameNumber;  // 0 until a frame has resolved
+	u32 latency;      // frames begun between this one ending and its results being read
+	f32 frameMs;      // first to last timestamp
+	std::vector<GpuScopeTiming> scopes;
+};
+
+struct GpuProfilerStats
+{
+	u64 frames;         // frames begun
+	u64 resolved;       // frames read back with usable times
+	u64 disjoint;       // frames read back with unreliable times, thrown away
+	u64 skipped;        // frames not timed, their slot was still waiting on the GPU
+	u64 droppedScopes;  // scopes past a slot's queries
+	u32 maxLatency;
+};
+
+//================================================================================
+// GPU Profiler
+// Times scopes of GPU work with timestamp queries, read back frames later so
+// the CPU never waits on the GPU.
+//
+// Each frame takes the next of the backend's slots. Results are read at the
+// next begin_frame(), oldest first, and a frame whose slot is still in flight
+// when it comes round again isn't timed rather than stalling for it. The
+// newest resolved frame is last_frame().
+//
+// With a CPU profiler attached, resolved scopes are also added to a "GPU"
+// track of its captures, shifted onto the CPU clock by a calibration taken at
+// init. The calibration assumes the GPU was idle when it was taken, so GPU
+// events can be off by the length of whatever the GPU was still busy with.
+//================================================================================
+class GpuProfiler
+{
+public:
+	static constexpr u32 kInvalidScope = ~0u;
+
+	GpuProfiler();
+
+	void init(GpuTimerBackend* pBackend, Profiler* pTimeline = nullptr);
+
+	// Read back whatever has finished, then start timing a frame.
+	void begin_frame();
+	void end_frame();
+
+	// Scopes nest, end them in reverse order. Returns kInvalidScope when the frame isn't timed or is out of queries.
+	u32 begin_scope(const char* name);
+	void end_scope(const u32 kScope);
+
+	// Calibrate again, e.g. after the GPU clock changed. Waits for the GPU.
+	void calibrate();
+
+	const GpuFrameTimings& last_frame() const { return m_lastFrame; }
+	const GpuProfilerStats& stats() const { return m_stats; }
+
+private:
+	struct Scope
+	{
+		const char* name;
+		u32 depth;
+		u32 beginQuery;
+		u32 endQuery;
+	};
+
+	struct Slot
+	{
+		u64 frameNumber;
+		u32 numQueries;
+		bool pending; // ended and waiting on the GPU
+		std::vector<Scope> scopes;
+	};
+
+	// Read the oldest frames still in flight, stops at the first not ready.
+	void resolve();
+	bool resolve_slot(Slot& rSlot, const u32 kSlot);
+	s64 to_cpu_ticks(const u64 kGpuTicks, const u64 kFrequency) const;
+
+	GpuTimerBackend* m_pBackend;
+	Profiler* m_pTimeline;
+	ProfileBuffer* m_pTrack;
+
+	std::vector<Slot> m_slots;
+	u64 m_frameNumber;   // the frame begun last
+	u64 m_nextResolve;   // oldest frame not yet read back
+	bool m_inFrame;
+	bool m_timing;       // the frame in progress has a slot
+	u32 m_frameScope;
+	u32 m_depth;
+
+	bool m_calibrated;
+	u64 m_calibrationGpuTicks;
+	u64 m_calibrationFrequency;
+	s64 m_calibrationCpuTicks;
+
+	GpuFrameTimings m_lastFrame;
+	GpuProfilerStats m_stats;
+};
+
+//================================================================================
+// GPU Profile Scope
+// Times the GPU work issued between construction and destruction.
+//================================================================================
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler* pProfiler, const char* name)
+		: m_pProfiler(pProfiler)
+		, m_scope(pProfiler ? pProfiler->begin_scope(name) : GpuProfiler::kInvalidScope)
+	{
+	}
+
+	~GpuProfileScope()
+	{
+		if (m_pProfiler)
+		{
+			m_pProfiler->end_scope(m_scope);
+		}
+	}
+
+private:
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+	GpuProfiler* m_pProfiler;
+	u32 m_scope;
+};
+
+//================================================================================
+// Fake GPU Timer
+// A stand in GPU for exercising the profiler without a device.
+//
+// Timestamps read the fake clock when issued, move it on with advance() to
+// stand for GPU work. The GPU's frames are counted by next_frame(), called at
+// every frame boundary whether or not the profiler times that frame, and a
+// slot's results show up kLatency frames after it ended, as if the GPU ran
+// that many frames behind.
+//================================================================================
+class FakeGpuTimer final : public GpuTimerBackend
+{
+public:
+	FakeGpuTimer(const u32 kSlots, const u32 kQueriesPerSlot, const u32 kLatency, const u64 kFrequency = 1000000);
+
+	// GPU work took kTicks.
+	void advance(const u64 kTicks) { m_time += kTicks; }
+
+	// A new frame started, call before the profiler's begin_frame().
+	void next_frame() { m_frame++; }
+
+	// How many frames behind the GPU runs from now on.
+	void set_latency(const u32 kLatency) { m_latency = kLatency; }
+
+	// The next slot ended reports disjoint.
+	void make_next_disjoint() { m_nextDisjoint = true; }
+
+	u32 slots() const override { return (u32)m_slots.size(); }
+	u32 queries_per_slot() const override { return m_queriesPerSlot; }
+	void begin_slot(const u32 kSlot) override;
+	void end_slot(const u32 kSlot) override;
+	void timestamp(const u32 kSlot, const u32 kQuery) override;
+	bool read_slot(const u32 kSlot, u64& rFrequency, bool& rDisjoint) override;
+	bool read_timestamp(const u32 kSlot, const u32 kQuery, u64& rTicks) override;
+	bool calibrate(u64& rGpuTicks, u64& rFrequency, s64& rCpuTicks) override;
+
+private:
+	struct Slot
+	{
+		std::vector<u64> ticks;
+		u64 readyAt;   // frame the results show up at
+		bool ended;
+		bool disjoint;
+	};
+
+	std::vector<Slot> m_slots;
+	u32 m_queriesPerSlot;
+	u32 m_latency;
+	u64 m_frequency;
+	u64 m_time;
+	u64 m_frame;
+	bool m_nextDisjoint;
+};
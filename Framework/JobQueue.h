@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Profiler.h"
 #include <functional>
 #include <thread>
 #include <mutex>
@@ -29,10 +30,11 @@ public:
 		}
 	}
 
-	// Launch the worker thread.
-	void launch()
+	// Launch the worker thread, pName labels its track in profiles.
+	void launch(const char* pName = "Job worker")
 	{
 		ASSERT(!worker.joinable()); // Not already launched!
+		name = pName;
 		worker = std::thread(&JobQueue::queueLoop, this);
 	}
 
@@ -54,6 +56,7 @@ public:
 private:
 	void queueLoop()
 	{
+		PROFILE_THREAD(name);
 		for (;;)
 		{
 			Job job;
@@ -78,6 +81,7 @@ private:
 	}
 
 	bool terminating = false;
+	const char* name = nullptr;
 
 	std::thread worker;
 	std::queue<Job> queue;
@@ -0,0 +1,500 @@
+#include "LogRing.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// Which ring this thread pushes to, only valid while generation matches the logger's.
+	struct ThreadRing
+	{
+		u64 generation;
+		LogRing* pRing;
+	};
+
+	thread_local ThreadRing s_threadRing = { 0, nullptr };
+
+	// Generations are shared by every logger so a ring can't match a logger it didn't come from.
+	std::atomic<u64> s_nextGeneration(1);
+
+	Logger* s_pCurrentLogger = nullptr;
+
+	inline s64 now_ticks()
+	{
+		return (s64)std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+
+	inline u32 next_power_of_two(const u32 kValue)
+	{
+		u32 power = 1;
+		while (power < kValue)
+		{
+			power <<= 1;
+		}
+		return power;
+	}
+
+	inline bool is_flag(const char c)
+	{
+		return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0';
+	}
+
+	inline bool is_length(const char c)
+	{
+		return c == 'h' || c == 'l' || c == 'L' || c == 'j' || c == 'z' || c == 't';
+	}
+
+	const char* const kLevelPrefixes[] = { "Debug: ", "", "Warning: ", "Error: " };
+}
+
+//================================================================================
+// Formatting
+//================================================================================
+
+u32 format_log_record(const LogRecord& record, char* pBuffer, const u32 kSize)
+{
+	ASSERT(kSize > 0);
+	u32 length = 0;
+	u32 argIndex = 0;
+
+	// Each conversion goes through snprintf on its own, with the length modifier swapped for the
+	// packed argument's, so a %d given a u64 still prints rather than reading the wrong size.
+	auto append = [&](const char* pSpec, auto value)
+	{
+		if (length + 1 < kSize)
+		{
+			const int kWritten = snprintf(pBuffer + length, kSize - length, pSpec, value);
+			length = kWritten < 0 ? length : std::min(kSize - 1, length + (u32)kWritten);
+		}
+	};
+
+	const char* p = record.format;
+	while (*p && length + 1 < kSize)
+	{
+		if (*p != '%')
+		{
+			pBuffer[length++] = *p++;
+			continue;
+		}
+		if (p[1] == '%')
+		{
+			pBuffer[length++] = '%';
+			p += 2;
+			continue;
+		}
+
+		// %[flags][width][.precision][length]conversion, width and precision from the arguments aren't supported.
+		char spec[32];
+		u32 specLength = 0;
+		const char* pStart = p++;
+		spec[specLength++] = '%';
+		while (*p && specLength < 20 && (is_flag(*p) || (*p >= '0' && *p <= '9') || *p == '.'))
+		{
+			spec[specLength++] = *p++;
+		}
+		while (is_length(*p))
+		{
+			p++;
+		}
+		const char kConversion = *p;
+		if (kConversion == '\0')
+		{
+			break;
+		}
+		p++;
+
+		// Not a conversion we know, print it as written and leave the argument for the next.
+		if (!strchr("diuxXocfFeEgGaAsp", kConversion))
+		{
+			while (pStart < p && length + 1 < kSize)
+			{
+				pBuffer[length++] = *pStart++;
+			}
+			continue;
+		}
+
+		if (argIndex >= record.numArgs)
+		{
+			append("%s", "(missing)");
+			continue;
+		}
+		const LogArgType kType = record.types[argIndex];
+		const LogArg kArg = record.args[argIndex++];
+		const s64 kSigned = kType == LogArgType::kFloat ? (s64)kArg.f : kArg.i;
+		const u64 kUnsigned = kType == LogArgType::kFloat ? (u64)kArg.f : kArg.u;
+		const f64 kFloat = kType == LogArgType::kFloat ? kArg.f : kType == LogArgType::kSigned ? (f64)kArg.i : (f64)kArg.u;
+
+		switch (kConversion)
+		{
+		case 'd':
+		case 'i':
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+			spec[specLength++] = kConversion;
+			spec[specLength] = '\0';
+			append(spec, (long long)kSigned);
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+			spec[specLength++] = kConversion;
+			spec[specLength] = '\0';
+			append(spec, (unsigned long long)kUnsigned);
+			break;
+		case 'c':
+			spec[specLength++] = 'c';
+			spec[specLength] = '\0';
+			append(spec, (int)kSigned);
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			spec[specLength++] = kConversion;
+			spec[specLength] = '\0';
+			append(spec, kFloat);
+			break;
+		case 's':
+			spec[specLength++] = 's';
+			spec[specLength] = '\0';
+			append(spec, kType == LogArgType::kString && kArg.p ? (const char*)kArg.p : "(null)");
+			break;
+		case 'p':
+			append("%p", kArg.p);
+			break;
+		}
+	}
+
+	pBuffer[length] = '\0';
+	return length;
+}
+
+//================================================================================
+// Log Ring
+//================================================================================
+
+LogRing::LogRing(const u32 kCapacity)
+	: m_records(next_power_of_two(std::max(kCapacity, 2u)))
+	, m_mask((u32)m_records.size() - 1)
+	, m_head(0)
+	, m_padding()
+	, m_tail(0)
+	, m_dropped(0)
+	, m_suppressed(0)
+	, m_rateSlots()
+{
+}
+
+bool LogRing::push(const LogRecord& record)
+{
+	const u32 kHead = m_head.load(std::memory_order_relaxed);
+	if (kHead - m_tail.load(std::memory_order_acquire) > m_mask)
+	{
+		m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return false;
+	}
+	m_records[kHead & m_mask] = record;
+	m_head.store(kHead + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogRing::pop(LogRecord& rRecord)
+{
+	const u32 kTail = m_tail.load(std::memory_order_relaxed);
+	if (kTail == m_head.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	rRecord = m_records[kTail & m_mask];
+	m_tail.store(kTail + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogRing::allow(const char* kFormat, const s64 kTicks, const s64 kWindowTicks, const u32 kLimit, u32& rSuppressedOut)
+{
+	rSuppressedOut = 0;
+
+	// Formats are literals, their addresses are as good a key as their text. A format
+	// that finds no slot in a few probes isn't limited, the table only needs the noisy ones.
+	const u32 kHash = ((u32)((uintptr_t)kFormat >> 3) * 2654435761u) >> 27;
+	RateSlot* pSlot = nullptr;
+	for (u32 i = 0; i < kRateProbes; ++i)
+	{
+		RateSlot& rCandidate = m_rateSlots[(kHash + i) % kRateSlots];
+		if (rCandidate.format == kFormat || rCandidate.format == nullptr)
+		{
+			pSlot = &rCandidate;
+			break;
+		}
+	}
+	if (!pSlot)
+	{
+		return true;
+	}
+
+	if (pSlot->format == nullptr || kTicks - pSlot->windowStart >= kWindowTicks)
+	{
+		pSlot->format = kFormat;
+		pSlot->windowStart = kTicks;
+		pSlot->count = 0;
+	}
+	if (pSlot->count >= kLimit)
+	{
+		pSlot->suppressed++;
+		m_suppressed.store(m_suppressed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return false;
+	}
+	pSlot->count++;
+	rSuppressedOut = pSlot->suppressed;
+	pSlot->suppressed = 0;
+	return true;
+}
+
+//================================================================================
+// Logger
+//================================================================================
+
+Logger::Logger()
+	: m_generation(0)
+	, m_startTicks(0)
+	, m_ticksPerSecond(0)
+	, m_written(0)
+	, m_drainRequests(0)
+	, m_drainsDone(0)
+	, m_terminating(false)
+{
+}
+
+Logger::~Logger()
+{
+	shutdown();
+	if (s_pCurrentLogger == this)
+	{
+		s_pCurrentLogger = nullptr;
+	}
+}
+
+void Logger::init(const LoggerDesc& desc)
+{
+	ASSERT(!m_writer.joinable());
+	ASSERT(desc.ringCapacity > 0 && desc.flushIntervalMs > 0);
+
+	m_desc = desc;
+	m_generation = s_nextGeneration++;
+	m_startTicks = now_ticks();
+	m_ticksPerSecond = (s64)(std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num);
+	m_rings.clear();
+	m_written = 0;
+	m_drainRequests = 0;
+	m_drainsDone = 0;
+	m_terminating = false;
+
+	if (desc.pFilePath && !desc.sink)
+	{
+		m_file.open(desc.pFilePath, std::ios::out | std::ios::trunc);
+		if (!m_file)
+		{
+			errorF("Failed to open log file %s", desc.pFilePath);
+		}
+	}
+
+	m_writer = std::thread(&Logger::writer_loop, this);
+}
+
+void Logger::shutdown()
+{
+	if (!m_writer.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_writerMutex);
+		m_terminating = true;
+		m_wake.notify_one();
+	}
+	m_writer.join();
+
+	if (m_file.is_open())
+	{
+		m_file.close();
+	}
+}
+
+void Logger::flush()
+{
+	if (!m_writer.joinable())
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_writerMutex);
+	const u64 kRequest = ++m_drainRequests;
+	m_wake.notify_one();
+	m_drained.wait(lock, [this, kRequest]() { return m_drainsDone >= kRequest; });
+}
+
+void Logger::push(LogRecord& rRecord)
+{
+	ASSERT(m_generation != 0); // not initialised
+	LogRing* pRing = thread_ring();
+	rRecord.ticks = now_ticks();
+	if (m_desc.rateLimit > 0 && !pRing->allow(rRecord.format, rRecord.ticks, m_ticksPerSecond, m_desc.rateLimit, rRecord.suppressed))
+	{
+		return;
+	}
+	pRing->push(rRecord);
+}
+
+LogRing* Logger::thread_ring()
+{
+	if (s_threadRing.generation == m_generation)
+	{
+		return s_threadRing.pRing;
+	}
+
+	// A thread's first call, rings live as long as the logger so records outlive their thread.
+	std::lock_guard<std::mutex> lock(m_ringMutex);
+	m_rings.push_back(std::unique_ptr<LogRing>(new LogRing(m_desc.ringCapacity)));
+	s_threadRing.generation = m_generation;
+	s_threadRing.pRing = m_rings.back().get();
+	return s_threadRing.pRing;
+}
+
+void Logger::writer_loop()
+{
+	PROFILE_THREAD("Log writer");
+	std::unique_lock<std::mutex> lock(m_writerMutex);
+	for (;;)
+	{
+		m_wake.wait_for(lock, std::chrono::milliseconds(m_desc.flushIntervalMs),
+			[this]() { return m_terminating || m_drainRequests > m_drainsDone; });
+		const u64 kRequests = m_drainRequests;
+		const bool kTerminating = m_terminating;
+
+		// Requests made before here are covered, everything they logged is already in a ring.
+		lock.unlock();
+		drain();
+		lock.lock();
+
+		m_drainsDone = kRequests;
+		m_drained.notify_all();
+		if (kTerminating)
+		{
+			break;
+		}
+	}
+}
+
+void Logger::drain()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_ringMutex);
+		for (const std::unique_ptr<LogRing>& pRing : m_rings)
+		{
+			LogRecord record;
+			while (pRing->pop(record))
+			{
+				m_pending.push_back(record);
+			}
+		}
+	}
+	if (m_pending.empty())
+	{
+		return;
+	}
+
+	// Each thread's records are already in order, this interleaves the threads.
+	PROFILE_SCOPE("Write log");
+	std::stable_sort(m_pending.begin(), m_pending.end(),
+		[](const LogRecord& a, const LogRecord& b) { return a.ticks < b.ticks; });
+
+	char text[1024];
+	for (const LogRecord& record : m_pending)
+	{
+		format_log_record(record, text, sizeof(text));
+		write(record, text);
+	}
+	m_written.fetch_add(m_pending.size(), std::memory_order_relaxed);
+	m_pending.clear();
+
+	if (!m_desc.sink)
+	{
+		if (m_desc.console)
+		{
+			std::fflush(stdout);
+		}
+		if (m_file.is_open())
+		{
+			m_file.flush();
+		}
+	}
+}
+
+void Logger::write(const LogRecord& record, const char* pText)
+{
+	char line[1200];
+	const f64 kSeconds = (f64)(record.ticks - m_startTicks) / (f64)m_ticksPerSecond;
+	if (record.suppressed > 0)
+	{
+		snprintf(line, sizeof(line), "[%9.3f] %s%s (%u like it suppressed)\n", kSeconds, kLevelPrefixes[(u32)record.level], pText, record.suppressed);
+	}
+	else
+	{
+		snprintf(line, sizeof(line), "[%9.3f] %s%s\n", kSeconds, kLevelPrefixes[(u32)record.level], pText);
+	}
+
+	if (m_desc.sink)
+	{
+		m_desc.sink(record.level, line);
+		return;
+	}
+	if (m_desc.console)
+	{
+		std::fputs(line, stdout);
+	}
+#if defined(_WIN32)
+	if (m_desc.debugOutput)
+	{
+		OutputDebugStringA(line);
+	}
+#endif
+	if (m_file.is_open())
+	{
+		m_file << line;
+	}
+}
+
+LoggerStats Logger::stats() const
+{
+	LoggerStats stats = {};
+	std::lock_guard<std::mutex> lock(m_ringMutex);
+	for (const std::unique_ptr<LogRing>& pRing : m_rings)
+	{
+		stats.logged += pRing->pushed();
+		stats.dropped += pRing->dropped();
+		stats.suppressed += pRing->suppressed();
+	}
+	stats.written = m_written.load(std::memory_order_relaxed);
+	stats.threads = (u32)m_rings.size();
+	return stats;
+}
+
+void set_current_logger(Logger* pLogger)
+{
+	s_pCurrentLogger = pLogger;
+}
+
+Logger* current_logger()
+{
+	return s_pCurrentLogger;
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : u8
+{
+	kDebug,
+	kInfo,
+	kWarning,
+	kError,
+};
+
+constexpr u32 kMaxLogArgs = 6;
+
+enum class LogArgType : u8
+{
+	kSigned,
+	kUnsigned,
+	kFloat,
+	kString,  // the pointer only, the string must outlive the logger's next flush
+	kPointer,
+};
+
+union LogArg
+{
+	s64 i;
+	u64 u;
+	f64 f;
+	const void* p;
+};
+
+// One call's format and arguments, formatted later on the writer thread.
+struct LogRecord
+{
+	const char* format;      // must outlive the logger, in practice a string literal
+	s64 ticks;               // steady clock when logged
+	u32 suppressed;          // calls with this format the rate limit dropped on this thread since its last record
+	LogLevel level;
+	u8 numArgs;
+	LogArgType types[kMaxLogArgs];
+	LogArg args[kMaxLogArgs];
+};
+
+// printf the record into pBuffer, always terminated. Returns the length written.
+u32 format_log_record(const LogRecord& record, char* pBuffer, const u32 kSize);
+
+// Arguments keep their type so the formatter can convert them to what the format asks for.
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type pack_log_arg(LogRecord& rRecord, const u32 kIndex, const T& arg)
+{
+	rRecord.types[kIndex] = LogArgType::kSigned;
+	rRecord.args[kIndex].i = (s64)arg;
+}
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type pack_log_arg(LogRecord& rRecord, const u32 kIndex, const T& arg)
+{
+	rRecord.types[kIndex] = LogArgType::kUnsigned;
+	rRecord.args[kIndex].u = (u64)arg;
+}
+
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type pack_log_arg(LogRecord& rRecord, const u32 kIndex, const T& arg)
+{
+	rRecord.types[kIndex] = LogArgType::kFloat;
+	rRecord.args[kIndex].f = (f64)arg;
+}
+
+template<typename T>
+typename std::enable_if<std::is_enum<T>::value>::type pack_log_arg(LogRecord& rRecord, const u32 kIndex, const T& arg)
+{
+	rRecord.types[kIndex] = LogArgType::kSigned;
+	rRecord.args[kIndex].i = (s64)arg;
+}
+
+inline void pack_log_arg(LogRecord& rRecord, const u32 kIndex, const char* arg)
+{
+	rRecord.types[kIndex] = LogArgType::kString;
+	rRecord.args[kIndex].p = arg;
+}
+
+inline void pack_log_arg(LogRecord& rRecord, const u32 kIndex, const void* arg)
+{
+	rRecord.types[kIndex] = LogArgType::kPointer;
+	rRecord.args[kIndex].p = arg;
+}
+
+inline void pack_log_args(LogRecord&, const u32) {}
+
+template<typename T, typename... Rest>
+void pack_log_args(LogRecord& rRecord, const u32 kIndex, const T& arg, const Rest&... rest)
+{
+	pack_log_arg(rRecord, kIndex, arg);
+	pack_log_args(rRecord, kIndex + 1, rest...);
+}
+
+template<typename... Args>
+LogRecord make_log_record(const LogLevel kLevel, const char* format, const Args&... args)
+{
+	static_assert(sizeof...(Args) <= kMaxLogArgs, "Too many log arguments");
+	LogRecord record;
+	record.format = format;
+	record.ticks = 0;
+	record.suppressed = 0;
+	record.level = kLevel;
+	record.numArgs = (u8)sizeof...(Args);
+	pack_log_args(record, 0, args...);
+	return record;
+}
+
+//================================================================================
+// Log Ring
+// Single producer, single consumer queue of records. The owning thread pushes,
+// the logger's writer pops. A full ring drops the record rather than waiting,
+// the hot path never blocks on the writer.
+//
+// The producer also keeps the rate limit for the formats it logs, nothing else
+// touches that state.
+//================================================================================
+class LogRing
+{
+public:
+	// kCapacity is rounded up to a power of two.
+	explicit LogRing(const u32 kCapacity);
+
+	// Producer, false when the ring was full.
+	bool push(const LogRecord& record);
+
+	// Consumer, false when the ring is empty.
+	bool pop(LogRecord& rRecord);
+
+	// Producer. True when a record with kFormat may be logged at kTicks, false when the rate limit drops it.
+	// At most kLimit records per format per kWindowTicks, the first allowed after a drop carries the count dropped.
+	bool allow(const char* kFormat, const s64 kTicks, const s64 kWindowTicks, const u32 kLimit, u32& rSuppressedOut);
+
+	u64 pushed() const { return m_head.load(std::memory_order_relaxed); }
+	u64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+	u64 suppressed() const { return m_suppressed.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr u32 kRateSlots = 32;
+	static constexpr u32 kRateProbes = 4;
+
+	struct RateSlot
+	{
+		const char* format;
+		s64 windowStart;
+		u32 count;
+		u32 suppressed;
+	};
+
+	std::vector<LogRecord> m_records;
+	u32 m_mask;
+	std::atomic<u32> m_head; // next slot the producer writes
+	u8 m_padding[64];        // keeps the two indices off one cache line, alignas would need an aligned new
+	std::atomic<u32> m_tail; // next slot the consumer reads
+	std::atomic<u64> m_dropped;
+	std::atomic<u64> m_suppressed;
+	RateSlot m_rateSlots[kRateSlots];
+};
+
+struct LoggerDesc
+{
+	const char* pFilePath = nullptr; // also write to this file when set
+	bool console = true;             // stdout
+	bool debugOutput = true;         // the debugger's output window
+	LogLevel minLevel = LogLevel::kInfo;
+	u32 ringCapacity = 1024;         // records per thread
+	u32 flushIntervalMs = 10;        // writer wakes at least this often
+	u32 rateLimit = 8;               // records per format per thread per second, 0 for no limit
+
+	// Replaces the outputs above when set, called on the writer thread with each formatted line.
+	std::function<void(LogLevel, const char*)> sink;
+};
+
+struct LoggerStats
+{
+	u64 logged;     // records pushed to a ring
+	u64 written;    // records formatted and written
+	u64 dropped;    // records lost to a full ring
+	u64 suppressed; // calls dropped by the rate limit
+	u32 threads;    // rings handed out
+};
+
+//================================================================================
+// Logger
+// Logging cheap enough for the render loop.
+//
+// A call only checks the level and rate limit, then copies the format pointer
+// and its arguments into the calling thread's ring, no formatting, locking or
+// allocation after a thread's first call. A writer thread drains every ring,
+// orders the records by time, formats and writes them.
+//
+// Formats are kept by pointer and formatted later, so they and any %s
+// arguments have to stay alive, string literals are the intended use. Use
+// debugF for text built at run time.
+//================================================================================
+class Logger
+{
+public:
+	Logger();
+	~Logger();
+
+	void init(const LoggerDesc& desc);
+
+	// Write everything still queued and stop the writer.
+	void shutdown();
+
+	// Block until everything logged on this thread so far is written.
+	void flush();
+
+	template<typename... Args>
+	void log(const LogLevel kLevel, const char* format, const Args&... args)
+	{
+		if (kLevel < m_desc.minLevel)
+		{
+			return;
+		}
+
+		LogRecord record = make_log_record(kLevel, format, args...);
+		push(record);
+	}
+
+	LoggerStats stats() const;
+
+	const LoggerDesc& desc() const { return m_desc; }
+
+private:
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	void push(LogRecord& rRecord);
+	LogRing* thread_ring();
+	void writer_loop();
+	void drain();
+	void write(const LogRecord& record, const char* pText);
+
+	LoggerDesc m_desc;
+	u64 m_generation; // unique across inits, tells a thread its ring is stale
+	s64 m_startTicks;
+	s64 m_ticksPerSecond;
+	std::ofstream m_file;
+
+	mutable std::mutex m_ringMutex; // taken to hand a thread its ring, not to push
+	std::vector<std::unique_ptr<LogRing>> m_rings;
+
+	std::atomic<u64> m_written;
+
+	std::mutex m_writerMutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_drained;
+	u64 m_drainRequests;
+	u64 m_drainsDone;
+	bool m_terminating;
+	std::thread m_writer;
+	std::vector<LogRecord> m_pending; // writer thread only
+};
+
+// Logger used by logF, may be null, then calls are formatted and printed synchronously.
+void set_current_logger(Logger* pLogger);
+Logger* current_logger();
+
+// Log through the current logger. format must be a string literal, see Logger.
+template<typename... Args>
+void logF(const LogLevel kLevel, const char* format, const Args&... args)
+{
+	Logger* pLogger = current_logger();
+	if (pLogger)
+	{
+		pLogger->log(kLevel, format, args...);
+	}
+	else
+	{
+		char buffer[1024];
+		format_log_record(make_log_record(kLevel, format, args...), buffer, sizeof(buffer));
+		debugF("%s", buffer);
+	}
+}
@@ -1,12 +1,21 @@
 
 #include "Mesh.h"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tinyobjloader/tiny_obj_loader.h"
+#include "StateCache.h"
+#include "FrameArena.h"
+#include "MeshSimplify.h"
+#include "OcclusionCulling.h"
+#include <chrono>
 
 Mesh::Mesh()
 	: m_pVertexBuffer(nullptr)
 	, m_pIndexBuffer(nullptr)
+	, m_pPool(nullptr)
+	, m_range()
+	, m_vertices(0)
+	, m_indices(0)
+	, m_lods()
+	, m_numLods(0)
+	, m_boundsRadius(0.f)
 {
 
 }
@@ -15,14 +24,43 @@ Mesh::~Mesh()
 {
 	SAFE_RELEASE(m_pVertexBuffer);
 	SAFE_RELEASE(m_pIndexBuffer);
+	if (m_pPool)
+	{
+		m_pPool->free(m_range);
+	}
+}
+
+void Mesh::init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, GeometryPool* pPool)
+{
+	const MeshLod kLod = { 0, pIndices ? kNumIndices : 0, 0.f };
+	init_buffers(pDevice, pVertices, kNumVerts, pIndices, kNumIndices, &kLod, 1, pPool);
 }
 
-void Mesh::init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices)
+void Mesh::init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices,
+	const MeshLod* pLods, const u32 kNumLods, GeometryPool* pPool)
 {
-	ASSERT(!m_pVertexBuffer && !m_pIndexBuffer);
+	ASSERT(!m_pVertexBuffer && !m_pIndexBuffer && !m_pPool);
+	ASSERT(kNumLods > 0 && kNumLods <= kMaxMeshLods);
+	ASSERT(pLods[0].firstIndex == 0);
+
+	// Indexed meshes go in the pool when there's room, draws then offset into it.
+	m_range = { 0, kNumIndices, 0, kNumVerts };
+	if (pPool && pIndices)
+	{
+		ASSERT(pPool->vertex_stride() == sizeof(MeshVertex));
+		if (pPool->allocate(pVertices, kNumVerts, pIndices, kNumIndices, m_range))
+		{
+			m_pPool = pPool;
+		}
+		else
+		{
+			debugF("Geometry pool full, mesh of %u vertices %u indices gets its own buffers.\n", kNumVerts, kNumIndices);
+		}
+	}
 
 	m_pVertexBuffer = nullptr;
 	// Create a vertex buffer
+	if (!m_pPool)
 	{
 		D3D11_BUFFER_DESC desc = {};
 		desc.ByteWidth = sizeof(MeshVertex) * kNumVerts;
@@ -38,7 +76,7 @@ void Mesh::init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, cons
 
 	// Create an index buffer
 	m_pIndexBuffer = nullptr;
-	if (pIndices)
+	if (pIndices && !m_pPool)
 	{
 		D3D11_BUFFER_DESC desc = {};
 		desc.ByteWidth = sizeof(u16) * kNumIndices;
@@ -53,11 +91,25 @@ void Mesh::init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, cons
 	}
 
 	m_vertices = kNumVerts;
-	m_indices = kNumIndices;
+	m_indices = pLods[0].indexCount;
+	m_numLods = kNumLods;
+	for (u32 i = 0; i < kNumLods; ++i)
+	{
+		ASSERT(pLods[i].firstIndex + pLods[i].indexCount <= kNumIndices);
+		m_lods[i] = pLods[i];
+	}
+
+	compute_mesh_bounds(pVertices, kNumVerts, m_boundsCenter, m_boundsExtents, m_boundsRadius);
 }
 
 void Mesh::bind(ID3D11DeviceContext* pContext) const
 {
+	if (m_pPool)
+	{
+		m_pPool->bind(pContext);
+		return;
+	}
+
 	pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	ID3D11Buffer* buffers[] = { m_pVertexBuffer };
@@ -71,11 +123,12 @@ void Mesh::bind(ID3D11DeviceContext* pContext) const
 	}
 }
 
-void Mesh::draw(ID3D11DeviceContext* pContext) const
+void Mesh::draw(ID3D11DeviceContext* pContext, const u32 kLod) const
 {
-	if (m_pIndexBuffer)
+	if (m_pPool || m_pIndexBuffer)
 	{
-		pContext->DrawIndexed(m_indices, 0, 0);
+		const MeshLod& lod = m_lods[kLod];
+		pContext->DrawIndexed(lod.indexCount, m_range.firstIndex + lod.firstIndex, m_range.baseVertex);
 	}
 	else
 	{
@@ -83,10 +136,48 @@ void Mesh::draw(ID3D11DeviceContext* pContext) const
 	}
 }
 
-//stereo instanced draw
-void Mesh::drawIndexedInstanced(ID3D11DeviceContext* pContext) const
+//instanced draw, used for stereo and batched submission
+void Mesh::drawIndexedInstanced(ID3D11DeviceContext* pContext, const u32 kInstances, const u32 kLod) const
+{
+	const MeshLod& lod = m_lods[kLod];
+	pContext->DrawIndexedInstanced((UINT)lod.indexCount, kInstances, m_range.firstIndex + lod.firstIndex, m_range.baseVertex, 0);
+}
+
+void Mesh::bind(StateCache& rState) const
+{
+	// Every pooled mesh binds the same buffers, the cache drops all but the first.
+	if (m_pPool)
+	{
+		m_pPool->bind(rState);
+		return;
+	}
+
+	rState.set_topology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	rState.set_vertex_buffer(0, m_pVertexBuffer, sizeof(MeshVertex), 0);
+
+	if (m_pIndexBuffer)
+	{
+		rState.set_index_buffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	}
+}
+
+void Mesh::draw(StateCache& rState, const u32 kLod) const
+{
+	if (m_pPool || m_pIndexBuffer)
+	{
+		const MeshLod& lod = m_lods[kLod];
+		rState.draw_indexed(lod.indexCount, m_range.firstIndex + lod.firstIndex, m_range.baseVertex);
+	}
+	else
+	{
+		rState.draw(m_vertices, 0);
+	}
+}
+
+void Mesh::drawIndexedInstanced(StateCache& rState, const u32 kInstances, const u32 kLod) const
 {
-	pContext->DrawIndexedInstanced((UINT)m_indices, 2, 0, 0, 0);
+	const MeshLod& lod = m_lods[kLod];
+	rState.draw_indexed_instanced(lod.indexCount, kInstances, m_range.firstIndex + lod.firstIndex, m_range.baseVertex, 0);
 }
 
 // Computes tangents using Lengyel's method for an indexed triangle list.
@@ -98,7 +189,9 @@ void compute_tangents_lengyel(MeshVertex* pVertices, u32 kVertices, const u16* p
 	const u32 kTris = kIndices / 3;
 
 	// Tangents are accumulated so we need some space to work in.
-	v3* buffer = new v3[kVertices * 2];
+	// It's only needed for this call, so take it from the frame arena when there is one.
+	FrameArena* pArena = current_frame_arena();
+	v3* buffer = pArena ? pArena->allocate_array<v3>(kVertices * 2) : new v3[kVertices * 2];
 	memset(buffer, 0, sizeof(v3) * kVertices * 2);
 	
 	// offsets into the buffer;
@@ -163,101 +256,25 @@ void compute_tangents_lengyel(MeshVertex* pVertices, u32 kVertices, const u16* p
 		pVertices[i].tangent.w = XMVectorGetX(bitangent) < 0.f ? -1.0f : 1.0f; // sign
 	}
 
-	// cleanup the temp buffer
-	delete[] buffer;
+	// cleanup the temp buffer, arena memory goes with its frame
+	if (!pArena)
+	{
+		delete[] buffer;
+	}
 }
 
-void create_mesh_cube(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize)
+void create_mesh_cube(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize, GeometryPool* pPool)
 {
-	// define the vertices
-	const f32 s = kHalfSize;
-	const u32 c = 0xFF808080;
-
-	const u32 colours[6] = {
-		0xFF800000,	  // front
-		0xFF008000,	  // right
-		0xFF000080,	  // back
-		0xFF808000,	  // left
-		0xFF800080,	  // top
-		0xFF008080	  // bottom
-	};
-
-	const v3 normals[6] =
-	{
-		v3(0, 0, 1),	// front
-		v3(1, 0, 0),	// right
-		v3(0, 0, -1),	// back
-		v3(-1, 0, 0),	// left
-		v3(0, 1, 0),	// top
-		v3(0, -1, 0)	// bottom
-	};
-
-	const v2 texCoords[4] = {
-		v2(0, 0),
-		v2(1, 0),
-		v2(1, 1),
-		v2(0, 1)
-	};
-
-	MeshVertex verts[] = {
-		//front
-		MeshVertex(v3(-s, -s, s), colours[0], normals[0], texCoords[0]),
-		MeshVertex(v3(s, -s, s), colours[0], normals[0], texCoords[1]),
-		MeshVertex(v3(s, s, s), colours[0], normals[0], texCoords[2]),
-		MeshVertex(v3(-s, s, s), colours[0], normals[0], texCoords[3]),
-
-		//right
-		MeshVertex(v3(s, s, s), colours[1], normals[1], texCoords[0]),
-		MeshVertex(v3(s, s, -s), colours[1], normals[1], texCoords[1]),
-		MeshVertex(v3(s, -s, -s), colours[1], normals[1], texCoords[2]),
-		MeshVertex(v3(s, -s, s), colours[1], normals[1], texCoords[3]),
-
-		//back
-		MeshVertex(v3(-s, -s, -s), colours[2], normals[2], texCoords[0]),
-		MeshVertex(v3(s, -s, -s), colours[2], normals[2], texCoords[1]),
-		MeshVertex(v3(s, s, -s), colours[2], normals[2], texCoords[2]),
-		MeshVertex(v3(-s, s, -s), colours[2], normals[2], texCoords[3]),
-
-		//left
-		MeshVertex(v3(-s, -s, -s), colours[3], normals[3], texCoords[0]),
-		MeshVertex(v3(-s, -s, s), colours[3], normals[3], texCoords[1]),
-		MeshVertex(v3(-s, s, s), colours[3], normals[3], texCoords[2]),
-		MeshVertex(v3(-s, s, -s), colours[3], normals[3], texCoords[3]),
-
-		//top
-		MeshVertex(v3(s, s, s), colours[4], normals[4], texCoords[0]),
-		MeshVertex(v3(-s, s, s), colours[4], normals[4], texCoords[1]),
-		MeshVertex(v3(-s, s, -s), colours[4], normals[4], texCoords[2]),
-		MeshVertex(v3(s, s, -s), colours[4], normals[4], texCoords[3]),
-
-		//bottom
-		MeshVertex(v3(-s, -s, -s), colours[5], normals[5], texCoords[0]),
-		MeshVertex(v3(s, -s, -s), colours[5], normals[5], texCoords[1]),
-		MeshVertex(v3(s, -s, s), colours[5], normals[5], texCoords[2]),
-		MeshVertex(v3(-s, -s, s), colours[5], normals[5], texCoords[3]),
-
-	};
-
-	const u32 kVertices = sizeof(verts) / sizeof(verts[0]);
-
-	// and indices
-	const u16 indices[] = {
-		0,  1,  2,  0,  2,  3,   // front
-		4,  5,  6,  4,  6,  7,   // right
-		8,  9,  10, 8,  10, 11,  // back
-		12, 13, 14, 12, 14, 15,  // left
-		16, 17, 18, 16, 18, 19,  // top
-		20, 21, 22, 20, 22, 23   // bottom
-	};
-
-	const u32 kIndices = sizeof(indices) / sizeof(indices[0]);
+	std::vector<MeshVertex> verts;
+	std::vector<u16> indices;
+	build_cube_geometry(kHalfSize, verts, indices);
 
-	compute_tangents_lengyel(verts, kVertices, indices, kIndices);
+	compute_tangents_lengyel(&verts[0], (u32)verts.size(), &indices[0], (u32)indices.size());
 
-	rMeshOut.init_buffers(pDevice, verts, kVertices, indices, kIndices);
+	rMeshOut.init_buffers(pDevice, &verts[0], (u32)verts.size(), &indices[0], (u32)indices.size(), pPool);
 }
 
-void create_mesh_quad_xy(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize)
+void create_mesh_quad_xy(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize, GeometryPool* pPool)
 {
 	// define the vertices
 	const f32 s = kHalfSize;
@@ -298,89 +315,44 @@ void create_mesh_quad_xy(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfS
 
 	compute_tangents_lengyel(verts, kVertices, indices, kIndices);
 
-	rMeshOut.init_buffers(pDevice, verts, kVertices, indices, kIndices);
+	rMeshOut.init_buffers(pDevice, verts, kVertices, indices, kIndices, pPool);
 }
 
-void create_mesh_from_obj(ID3D11Device* pDevice, Mesh& rMeshOut, const char* pFilename, const f32 kScale)
+void create_mesh_from_obj(ID3D11Device* pDevice, Mesh& rMeshOut, const char* pFilename, const f32 kScale, GeometryPool* pPool, OccluderMesh* pOccluderOut)
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-
+	// Every shape goes into the one mesh.
 	std::vector<MeshVertex> meshVertices;
-
-	std::string err;
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, pFilename);
-
-	if (!err.empty()) { // `err` may contain warning message.
-		debugF("load_obj_mesh( %s ) : %s", pFilename, err.c_str());
-	}
-
-	if (!ret) {
+	std::vector<u16> indices;
+	if (!load_obj_geometry(pFilename, kScale, meshVertices, indices))
+	{
 		panicF("Error Loading OBJ %s", pFilename);
 	}
+	if (indices.empty())
+	{
+		panicF("%s: no faces", pFilename);
+	}
 
-	// Loop over shapes
-	for (size_t s = 0; s < shapes.size(); s++) {
-
-		meshVertices.clear();
+	// compute the tangents, welded vertices sum them over every triangle sharing them
+	compute_tangents_lengyel(&meshVertices[0], meshVertices.size(), &indices[0], indices.size());
 
-		// Loop over faces(polygon)
-		size_t index_offset = 0;
-		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) 
-		{
-			u32 fv = shapes[s].mesh.num_face_vertices[f];
-
-			// Flip the winding order here to match DX
-			const u32 reorder[] = { 0, 2, 1 };
-
-			// Loop over vertices in the face.
-			for (u32 v = 0; v < fv; v++) {
-
-				// access to vertex
-				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + reorder[v]];
-				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-				tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-				tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-				tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-				tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-				tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
-
-				// Optional: vertex colors
-				// tinyobj::real_t red = attrib.colors[3*idx.vertex_index+0];
-				// tinyobj::real_t green = attrib.colors[3*idx.vertex_index+1];
-				// tinyobj::real_t blue = attrib.colors[3*idx.vertex_index+2];
-
-
-				// Flip Z in both position and normal to match DX coordinate system.
-				// Export Obj from Blender with (-Z forward) should produce correct results.
-				v3 pos = v3(vx, vy, -vz) * kScale;
-				v3 normal(nx, ny, -nz);
-				normal.Normalize();
-
-				// Flip UV y to match DX texture flipping.
-				v2 uv(tx,-ty);
-
-				meshVertices.push_back(MeshVertex(pos, 0xFFFFFFFF, normal, uv));
-			}
-			index_offset += fv;
-
-			// per-face material
-			shapes[s].mesh.material_ids[f];
-		}
+	// Coarser levels index the same vertices, they go after the full mesh in one index buffer.
+	const auto kLodStart = std::chrono::high_resolution_clock::now();
+	MeshLod lods[kMaxMeshLods];
+	std::vector<u16> lodIndices;
+	const u32 kNumLods = build_lod_chain(&meshVertices[0], (u32)meshVertices.size(), &indices[0], (u32)indices.size(), lods, lodIndices);
+	const f32 kLodMs = std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - kLodStart).count();
 
-		// Make a sequential index buffer so we can use the tangent calculation function
-		std::vector<u16> m_indices(meshVertices.size());
-		for (u32 i = 0; i < meshVertices.size(); ++i)
-		{
-			m_indices[i] = i;
-		}
+	debugF("%s: %u levels of detail in %.1f ms\n", pFilename, kNumLods, kLodMs);
+	for (u32 i = 0; i < kNumLods; ++i)
+	{
+		debugF("  lod %u: %u triangles, error %.4f\n", i, lods[i].indexCount / 3, lods[i].error);
+	}
 
-		// compute the tangents,
-		compute_tangents_lengyel(&meshVertices[0], meshVertices.size(), &m_indices[0], m_indices.size());
+	rMeshOut.init_buffers(pDevice, &meshVertices[0], meshVertices.size(), &lodIndices[0], (u32)lodIndices.size(), lods, kNumLods, pPool);
 
-		rMeshOut.init_buffers(pDevice, &meshVertices[0], meshVertices.size(), &m_indices[0], m_indices.size());
+	// Occluders must never be larger than what they stand for, so they get the full mesh, not a simplified one.
+	if (pOccluderOut)
+	{
+		build_occluder_mesh(&meshVertices[0], (u32)meshVertices.size(), &indices[0], (u32)indices.size(), *pOccluderOut);
 	}
 }
@@ -1,15 +1,24 @@
 #pragma once
 
 #include "CommonHeader.h"
+#include "MeshData.h"
 #include "VertexFormats.h"
+#include "GeometryPool.h"
 
 
-using MeshVertex = Vertex_Pos3fColour4ubNormal3fTangent3fTex2f; // vertex type
+class StateCache;
+struct OccluderMesh;
 
 //================================================================================
 // Mesh Class
 // Wraps an index and vertex buffer.
 // Provides methods for loading a simple model.
+//
+// Given a geometry pool an indexed mesh lives in a range of the pool's shared
+// buffers instead of its own, falling back to its own when the pool is full.
+//
+// Levels of detail share the vertices, each is a run of the index buffer and
+// level 0 is the full mesh. Draws default to level 0.
 //================================================================================
 class Mesh
 {
@@ -17,33 +26,64 @@ public:
 	Mesh();
 	~Mesh();
 
-	void init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices);
+	void init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, GeometryPool* pPool = nullptr);
+
+	// pIndices holds every level, pLods says where each one is. Level 0 must be first.
+	void init_buffers(ID3D11Device* pDevice, const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices,
+		const MeshLod* pLods, const u32 kNumLods, GeometryPool* pPool = nullptr);
+
 	void bind(ID3D11DeviceContext* pContext) const;
-	void draw(ID3D11DeviceContext* pContext) const;
-	void drawIndexedInstanced(ID3D11DeviceContext* pContext) const;
+	void draw(ID3D11DeviceContext* pContext, const u32 kLod = 0) const;
+	void drawIndexedInstanced(ID3D11DeviceContext* pContext, const u32 kInstances, const u32 kLod = 0) const;
+
+	// Same again through a state cache, redundant binds are dropped.
+	void bind(StateCache& rState) const;
+	void draw(StateCache& rState, const u32 kLod = 0) const;
+	void drawIndexedInstanced(StateCache& rState, const u32 kInstances, const u32 kLod = 0) const;
 
 	// Accessors.
 	const ID3D11Buffer* vertex_buffer() const { return m_pVertexBuffer; }
 	const ID3D11Buffer* index_buffer() const { return m_pIndexBuffer; }
 
+	// Pool the mesh was placed in, or null when it has its own buffers.
+	const GeometryPool* pool() const { return m_pPool; }
+	const GeometryRange& range() const { return m_range; }
+
 	u32 vertices() const { return m_vertices; }
-	u32 indices() const { return m_indices; }
+	u32 indices() const { return m_indices; } // of level 0
+
+	const MeshLod* lods() const { return m_lods; }
+	u32 num_lods() const { return m_numLods; }
+
+	// Local space bounds.
+	const v3& bounds_center() const { return m_boundsCenter; }
+	const v3& bounds_extents() const { return m_boundsExtents; }
+	f32 bounds_radius() const { return m_boundsRadius; }
 
 private:
 	ID3D11Buffer* m_pVertexBuffer;
 	ID3D11Buffer* m_pIndexBuffer;
+	GeometryPool* m_pPool;
+	GeometryRange m_range; // where the mesh is in its pool, or its own buffers from 0
 	u32 m_vertices;
 	u32 m_indices;
+	MeshLod m_lods[kMaxMeshLods];
+	u32 m_numLods;
+
+	v3 m_boundsCenter;
+	v3 m_boundsExtents;
+	f32 m_boundsRadius;
 };
 
 //================================================================================
 // Helpers for creating mesh data
 //================================================================================
 
-void create_mesh_cube(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize);
+void create_mesh_cube(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize, GeometryPool* pPool = nullptr);
 
-void create_mesh_quad_xy(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize);
+void create_mesh_quad_xy(ID3D11Device* pDevice, Mesh& rMeshOut, const f32 kHalfSize, GeometryPool* pPool = nullptr);
 
-void create_mesh_from_obj(ID3D11Device* pDevice, Mesh& rMeshOut, const char* pFilename, const f32 kScale);
+// pOccluderOut, when given, gets the full mesh as occluder geometry for software occlusion culling.
+void create_mesh_from_obj(ID3D11Device* pDevice, Mesh& rMeshOut, const char* pFilename, const f32 kScale, GeometryPool* pPool = nullptr, OccluderMesh* pOccluderOut = nullptr);
 
 
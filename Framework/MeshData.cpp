@@ -0,0 +1,236 @@
+#include "MeshData.h"
+#include <chrono>
+#include <unordered_map>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tinyobjloader/tiny_obj_loader.h"
+
+namespace
+{
+	// A face corner's position, normal and texcoord indices into the OBJ's attributes.
+	// Corners with the same three make the same vertex, so they weld without comparing any floats.
+	struct ObjCornerKey
+	{
+		s32 indices[3];
+
+		bool operator==(const ObjCornerKey& other) const { return memcmp(indices, other.indices, sizeof(indices)) == 0; }
+	};
+
+	struct ObjCornerKeyHash
+	{
+		size_t operator()(const ObjCornerKey& key) const
+		{
+			size_t hash = 2166136261u;
+			for (s32 index : key.indices)
+			{
+				hash = (hash ^ (u32)index) * 16777619u;
+			}
+			return hash;
+		}
+	};
+}
+
+bool load_obj_geometry(const char* pFilename, const f32 kScale, std::vector<MeshVertex>& rVerticesOut, std::vector<u16>& rIndicesOut)
+{
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+
+	std::string err;
+	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, pFilename);
+
+	if (!err.empty()) { // `err` may contain warning message.
+		debugF("load_obj_mesh( %s ) : %s", pFilename, err.c_str());
+	}
+
+	rVerticesOut.clear();
+	rIndicesOut.clear();
+	if (!ret) {
+		return false;
+	}
+
+	// Shapes index the same attributes, so one weld map covers them all and corners shared between shapes weld too.
+	const auto kWeldStart = std::chrono::high_resolution_clock::now();
+	size_t numCorners = 0;
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		numCorners += shape.mesh.indices.size();
+	}
+	std::unordered_map<ObjCornerKey, u16, ObjCornerKeyHash> cornerVertices;
+	cornerVertices.reserve(numCorners);
+	rIndicesOut.reserve(numCorners);
+
+	// Loop over shapes
+	for (size_t s = 0; s < shapes.size(); s++) {
+
+		// Loop over faces(polygon), triangulated by the loader
+		size_t index_offset = 0;
+		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
+		{
+			u32 fv = shapes[s].mesh.num_face_vertices[f];
+			ASSERT(fv == 3);
+
+			// Flip the winding order here to match DX
+			const u32 reorder[] = { 0, 2, 1 };
+
+			// Loop over vertices in the face.
+			for (u32 v = 0; v < fv; v++) {
+
+				// A corner seen before reuses its vertex.
+				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + reorder[v]];
+				const ObjCornerKey kKey = { { idx.vertex_index, idx.normal_index, idx.texcoord_index } };
+				auto it = cornerVertices.find(kKey);
+				if (it != cornerVertices.end())
+				{
+					rIndicesOut.push_back(it->second);
+					continue;
+				}
+				if (rVerticesOut.size() > 0xFFFF)
+				{
+					panicF("%s: more than 65536 vertices, too many for 16 bit indices", pFilename);
+				}
+				cornerVertices.emplace(kKey, (u16)rVerticesOut.size());
+				rIndicesOut.push_back((u16)rVerticesOut.size());
+
+				// access to vertex, normals and texcoords are optional in an OBJ
+				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
+				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
+				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
+				v3 normal = v3::Zero;
+				if (idx.normal_index >= 0)
+				{
+					normal = v3(attrib.normals[3 * idx.normal_index + 0], attrib.normals[3 * idx.normal_index + 1], attrib.normals[3 * idx.normal_index + 2]);
+				}
+				v2 uv(0.f, 0.f);
+				if (idx.texcoord_index >= 0)
+				{
+					uv = v2(attrib.texcoords[2 * idx.texcoord_index + 0], attrib.texcoords[2 * idx.texcoord_index + 1]);
+				}
+
+				// Flip Z in both position and normal to match DX coordinate system.
+				// Export Obj from Blender with (-Z forward) should produce correct results.
+				v3 pos = v3(vx, vy, -vz) * kScale;
+				normal.z = -normal.z;
+				normal.Normalize();
+
+				// Flip UV y to match DX texture flipping.
+				uv.y = -uv.y;
+
+				rVerticesOut.push_back(MeshVertex(pos, 0xFFFFFFFF, normal, uv));
+			}
+			index_offset += fv;
+		}
+	}
+
+	const f32 kWeldMs = std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - kWeldStart).count();
+	debugF("%s: welded %u corners to %u vertices in %.1f ms\n", pFilename, (u32)rIndicesOut.size(), (u32)rVerticesOut.size(), kWeldMs);
+	return true;
+}
+
+void build_cube_geometry(const f32 kHalfSize, std::vector<MeshVertex>& rVerticesOut, std::vector<u16>& rIndicesOut)
+{
+	// define the vertices
+	const f32 s = kHalfSize;
+
+	const u32 colours[6] = {
+		0xFF800000,	  // front
+		0xFF008000,	  // right
+		0xFF000080,	  // back
+		0xFF808000,	  // left
+		0xFF800080,	  // top
+		0xFF008080	  // bottom
+	};
+
+	const v3 normals[6] =
+	{
+		v3(0, 0, 1),	// front
+		v3(1, 0, 0),	// right
+		v3(0, 0, -1),	// back
+		v3(-1, 0, 0),	// left
+		v3(0, 1, 0),	// top
+		v3(0, -1, 0)	// bottom
+	};
+
+	const v2 texCoords[4] = {
+		v2(0, 0),
+		v2(1, 0),
+		v2(1, 1),
+		v2(0, 1)
+	};
+
+	rVerticesOut = {
+		//front
+		MeshVertex(v3(-s, -s, s), colours[0], normals[0], texCoords[0]),
+		MeshVertex(v3(s, -s, s), colours[0], normals[0], texCoords[1]),
+		MeshVertex(v3(s, s, s), colours[0], normals[0], texCoords[2]),
+		MeshVertex(v3(-s, s, s), colours[0], normals[0], texCoords[3]),
+
+		//right
+		MeshVertex(v3(s, s, s), colours[1], normals[1], texCoords[0]),
+		MeshVertex(v3(s, s, -s), colours[1], normals[1], texCoords[1]),
+		MeshVertex(v3(s, -s, -s), colours[1], normals[1], texCoords[2]),
+		MeshVertex(v3(s, -s, s), colours[1], normals[1], texCoords[3]),
+
+		//back
+		MeshVertex(v3(-s, -s, -s), colours[2], normals[2], texCoords[0]),
+		MeshVertex(v3(s, -s, -s), colours[2], normals[2], texCoords[1]),
+		MeshVertex(v3(s, s, -s), colours[2], normals[2], texCoords[2]),
+		MeshVertex(v3(-s, s, -s), colours[2], normals[2], texCoords[3]),
+
+		//left
+		MeshVertex(v3(-s, -s, -s), colours[3], normals[3], texCoords[0]),
+		MeshVertex(v3(-s, -s, s), colours[3], normals[3], texCoords[1]),
+		MeshVertex(v3(-s, s, s), colours[3], normals[3], texCoords[2]),
+		MeshVertex(v3(-s, s, -s), colours[3], normals[3], texCoords[3]),
+
+		//top
+		MeshVertex(v3(s, s, s), colours[4], normals[4], texCoords[0]),
+		MeshVertex(v3(-s, s, s), colours[4], normals[4], texCoords[1]),
+		MeshVertex(v3(-s, s, -s), colours[4], normals[4], texCoords[2]),
+		MeshVertex(v3(s, s, -s), colours[4], normals[4], texCoords[3]),
+
+		//bottom
+		MeshVertex(v3(-s, -s, -s), colours[5], normals[5], texCoords[0]),
+		MeshVertex(v3(s, -s, -s), colours[5], normals[5], texCoords[1]),
+		MeshVertex(v3(s, -s, s), colours[5], normals[5], texCoords[2]),
+		MeshVertex(v3(-s, -s, s), colours[5], normals[5], texCoords[3]),
+	};
+
+	// and indices
+	rIndicesOut = {
+		0,  1,  2,  0,  2,  3,   // front
+		4,  5,  6,  4,  6,  7,   // right
+		8,  9,  10, 8,  10, 11,  // back
+		12, 13, 14, 12, 14, 15,  // left
+		16, 17, 18, 16, 18, 19,  // top
+		20, 21, 22, 20, 22, 23   // bottom
+	};
+}
+
+void compute_mesh_bounds(const MeshVertex* pVertices, const u32 kNumVerts, v3& rCenterOut, v3& rExtentsOut, f32& rRadiusOut)
+{
+	if (kNumVerts == 0)
+	{
+		rCenterOut = v3::Zero;
+		rExtentsOut = v3::Zero;
+		rRadiusOut = 0.f;
+		return;
+	}
+
+	v3 vMin = pVertices[0].pos;
+	v3 vMax = pVertices[0].pos;
+	for (u32 i = 1; i < kNumVerts; ++i)
+	{
+		vMin = v3::Min(vMin, pVertices[i].pos);
+		vMax = v3::Max(vMax, pVertices[i].pos);
+	}
+	rCenterOut = (vMin + vMax) * 0.5f;
+	rExtentsOut = (vMax - vMin) * 0.5f;
+
+	f32 radiusSq = 0.f;
+	for (u32 i = 0; i < kNumVerts; ++i)
+	{
+		radiusSq = std::max(radiusSq, (v3(pVertices[i].pos) - rCenterOut).LengthSquared());
+	}
+	rRadiusOut = sqrtf(radiusSq);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "VertexTypes.h"
+#include <vector>
+
+//================================================================================
+// Mesh Data
+// The CPU side of a mesh, shared by the D3D Mesh and by the modules that only
+// process geometry (simplification, occlusion culling).
+//================================================================================
+
+using MeshVertex = Vertex_Pos3fColour4ubNormal3fTangent3fTex2f; // vertex type
+
+constexpr u32 kMaxMeshLods = 4;
+
+// One level of detail, a run of the mesh's indices drawn with its vertices.
+struct MeshLod
+{
+	u32 firstIndex; // relative to the mesh's first index
+	u32 indexCount;
+	f32 error;      // furthest the surface moved from level 0, in mesh units
+};
+
+// Load an OBJ's triangles as one indexed mesh, every shape in it merged into the one vertex
+// and index stream. Face corners with the same position, normal and texcoord share a vertex.
+// Positions are scaled by kScale and flipped into D3D's coordinate system, tangents are left
+// for compute_tangents_lengyel. Returns false when the file can't be read, panics when it
+// needs more vertices than 16 bit indices can reach.
+bool load_obj_geometry(const char* pFilename, const f32 kScale, std::vector<MeshVertex>& rVerticesOut, std::vector<u16>& rIndicesOut);
+
+// A cube of kHalfSize about the origin, four vertices a face so each face has its own normal and uvs.
+// Tangents are left for compute_tangents_lengyel.
+void build_cube_geometry(const f32 kHalfSize, std::vector<MeshVertex>& rVerticesOut, std::vector<u16>& rIndicesOut);
+
+// Local space bounds for culling, a box around the vertices and a sphere around its center.
+void compute_mesh_bounds(const MeshVertex* pVertices, const u32 kNumVerts, v3& rCenterOut, v3& rExtentsOut, f32& rRadiusOut);
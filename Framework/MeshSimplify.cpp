@@ -0,0 +1,848 @@
+#include "MeshSimplify.h"
+
+#include <cfloat>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+	// Symmetric 4x4 matrix, the upper triangle row by row. Doubles as the sums run over many planes.
+	struct Quadric
+	{
+		f64 a[10];
+
+		void add_plane(const f64 nx, const f64 ny, const f64 nz, const f64 d)
+		{
+			a[0] += nx * nx; a[1] += nx * ny; a[2] += nx * nz; a[3] += nx * d;
+			a[4] += ny * ny; a[5] += ny * nz; a[6] += ny * d;
+			a[7] += nz * nz; a[8] += nz * d;
+			a[9] += d * d;
+		}
+
+		void add(const Quadric& q)
+		{
+			for (u32 i = 0; i < 10; ++i)
+			{
+				a[i] += q.a[i];
+			}
+		}
+
+		// Sum of squared distances of p to the planes.
+		f64 error(const v3& p) const
+		{
+			const f64 x = p.x, y = p.y, z = p.z;
+			return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+				+ a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+				+ a[7] * z * z + 2.0 * a[8] * z
+				+ a[9];
+		}
+	};
+
+	// Welding keys compare the float bits, only exact copies weld (negative zero is made positive first).
+	struct WeldKey
+	{
+		u32 bits[8]; // position, uv, normal
+
+		bool operator==(const WeldKey& other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+
+	struct WeldKeyHash
+	{
+		size_t operator()(const WeldKey& key) const
+		{
+			size_t hash = 2166136261u;
+			for (u32 bits : key.bits)
+			{
+				hash = (hash ^ bits) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	const u32 kWeldPosition = 3;
+	const u32 kWeldUv = 5;
+	const u32 kWeldAll = 8;
+
+	// Key of the first kFloats of the position, uv and normal.
+	WeldKey weld_key(const MeshVertex& vertex, const u32 kFloats)
+	{
+		const f32 values[8] = {
+			vertex.pos.x + 0.f, vertex.pos.y + 0.f, vertex.pos.z + 0.f,
+			vertex.tex.x + 0.f, vertex.tex.y + 0.f,
+			vertex.normal.x + 0.f, vertex.normal.y + 0.f, vertex.normal.z + 0.f };
+
+		WeldKey key = {};
+		memcpy(key.bits, values, sizeof(f32) * kFloats);
+		return key;
+	}
+
+	// Collapse of position 'from' onto its neighbour 'to'.
+	struct Collapse
+	{
+		f64 cost;
+		u32 from;
+		u32 to;
+
+		bool operator>(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	using CollapseQueue = std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>;
+
+	enum class EdgeKind : u8
+	{
+		kInterior,    // two triangles sharing the vertices at both ends
+		kSeam,        // two triangles with different uvs at an end
+		kOpen,        // one triangle
+		kNonManifold, // more than two
+	};
+
+	// A vertex at a collapsing position and the vertex at the far end its corners move to.
+	struct WedgePair
+	{
+		u32 from;
+		u32 to;
+	};
+
+	const u32 kNoWedge = 0xFFFFFFFF;
+
+	// Cost of a collapse that isn't allowed.
+	const f64 kNoCollapse = DBL_MAX;
+
+	// Working state of one simplification. Triangles hold positions for the connectivity and
+	// vertices for the output, collapses rewrite both.
+	class Simplifier
+	{
+	public:
+		Simplifier(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices)
+			: m_pVertices(pVertices)
+			, m_constrained(0)
+			, m_liveTris(0)
+			, m_maxError(0.0)
+			, m_slide(0.0)
+		{
+			weld(kNumVerts, pIndices, kNumIndices);
+			find_locked();
+			build_quadrics();
+		}
+
+		f32 run(const u32 kTargetIndices, std::vector<u16>& rIndicesOut, SimplifyStats* pStats)
+		{
+			u32 collapses = 0;
+			u32 rejected = 0;
+			u32 slides = 0;
+
+			CollapseQueue queue;
+			for (u32 t = 0; t < m_triPositions.size() / 3; ++t)
+			{
+				push_triangle_edges(queue, t);
+			}
+
+			while (m_liveTris * 3 > kTargetIndices && !queue.empty())
+			{
+				const Collapse collapse = queue.top();
+				queue.pop();
+				if (m_removed[collapse.from] || m_removed[collapse.to])
+				{
+					continue;
+				}
+
+				// Costs mostly grow as quadrics merge, so a stale entry is requeued at its current cost.
+				const f64 kCost = collapse_cost(collapse.from, collapse.to);
+				if (kCost == kNoCollapse)
+				{
+					rejected++;
+					continue;
+				}
+				if (kCost > collapse.cost)
+				{
+					queue.push({ kCost, collapse.from, collapse.to });
+					continue;
+				}
+				const bool kSlides = m_slide > 0.0;
+
+				if (!can_collapse(collapse.from, collapse.to))
+				{
+					rejected++;
+					continue;
+				}
+
+				apply(collapse.from, collapse.to);
+				m_maxError = std::max(m_maxError, kCost);
+				collapses++;
+				slides += kSlides ? 1 : 0;
+
+				for (u32 t : m_positionTris[collapse.to])
+				{
+					if (m_liveTri[t])
+					{
+						push_triangle_edges(queue, t);
+					}
+				}
+			}
+
+			rIndicesOut.clear();
+			rIndicesOut.reserve(m_liveTris * 3);
+			for (u32 t = 0; t < m_liveTri.size(); ++t)
+			{
+				if (m_liveTri[t])
+				{
+					rIndicesOut.push_back((u16)m_triVertices[t * 3 + 0]);
+					rIndicesOut.push_back((u16)m_triVertices[t * 3 + 1]);
+					rIndicesOut.push_back((u16)m_triVertices[t * 3 + 2]);
+				}
+			}
+
+			if (pStats)
+			{
+				pStats->positions = (u32)m_positions.size();
+				pStats->locked = 0;
+				for (u8 locked : m_locked)
+				{
+					pStats->locked += locked;
+				}
+				pStats->constrained = m_constrained;
+				pStats->collapses = collapses;
+				pStats->rejected = rejected;
+				pStats->slides = slides;
+			}
+
+			return (f32)sqrt(std::max(m_maxError, 0.0));
+		}
+
+	private:
+		void weld(const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices)
+		{
+			std::unordered_map<WeldKey, u32, WeldKeyHash> positionIds;
+			std::unordered_map<WeldKey, u32, WeldKeyHash> wedgeIds;
+			std::unordered_map<WeldKey, u32, WeldKeyHash> vertexIds;
+			positionIds.reserve(kNumVerts);
+			wedgeIds.reserve(kNumVerts);
+			vertexIds.reserve(kNumVerts);
+
+			// Each vertex maps to its welded vertex, the first with the same key stands for the rest.
+			// Welded vertices group into wedges on position and uv, and wedges into positions.
+			std::vector<u32> vertexWelded(kNumVerts);
+			std::vector<u32> weldedVertex;
+			std::vector<u32> weldedWedge;
+			std::vector<u32> wedgePosition;
+			for (u32 i = 0; i < kNumVerts; ++i)
+			{
+				auto welded = vertexIds.insert({ weld_key(m_pVertices[i], kWeldAll), (u32)weldedVertex.size() });
+				if (welded.second)
+				{
+					auto wedge = wedgeIds.insert({ weld_key(m_pVertices[i], kWeldUv), (u32)m_wedgeVertices.size() });
+					if (wedge.second)
+					{
+						auto position = positionIds.insert({ weld_key(m_pVertices[i], kWeldPosition), (u32)m_positions.size() });
+						if (position.second)
+						{
+							m_positions.push_back(m_pVertices[i].pos);
+						}
+						m_wedgeVertices.emplace_back();
+						wedgePosition.push_back(position.first->second);
+					}
+					m_wedgeVertices[wedge.first->second].push_back(i);
+					weldedVertex.push_back(i);
+					weldedWedge.push_back(wedge.first->second);
+				}
+				vertexWelded[i] = welded.first->second;
+			}
+
+			// Triangles that are already degenerate once welded are dropped.
+			for (u32 i = 0; i + 2 < kNumIndices; i += 3)
+			{
+				u32 positions[3];
+				u32 wedges[3];
+				u32 vertices[3];
+				for (u32 c = 0; c < 3; ++c)
+				{
+					const u32 kWelded = vertexWelded[pIndices[i + c]];
+					wedges[c] = weldedWedge[kWelded];
+					positions[c] = wedgePosition[wedges[c]];
+					vertices[c] = weldedVertex[kWelded];
+				}
+				if (positions[0] == positions[1] || positions[1] == positions[2] || positions[0] == positions[2])
+				{
+					continue;
+				}
+				m_triPositions.insert(m_triPositions.end(), positions, positions + 3);
+				m_triWedges.insert(m_triWedges.end(), wedges, wedges + 3);
+				m_triVertices.insert(m_triVertices.end(), vertices, vertices + 3);
+			}
+
+			const u32 kNumTris = (u32)m_triPositions.size() / 3;
+			m_liveTri.assign(kNumTris, 1);
+			m_liveTris = kNumTris;
+			m_removed.assign(m_positions.size(), 0);
+			m_positionTris.resize(m_positions.size());
+			for (u32 t = 0; t < kNumTris; ++t)
+			{
+				for (u32 c = 0; c < 3; ++c)
+				{
+					m_positionTris[m_triPositions[t * 3 + c]].push_back(t);
+				}
+			}
+		}
+
+		// What runs along the edge between two positions, from the live triangles on it.
+		EdgeKind edge_kind(const u32 a, const u32 b) const
+		{
+			u32 count = 0;
+			u32 firstA = 0;
+			u32 firstB = 0;
+			bool seam = false;
+			for (u32 t : m_positionTris[a])
+			{
+				if (!m_liveTri[t])
+				{
+					continue;
+				}
+				u32 cornerA = 3;
+				u32 cornerB = 3;
+				for (u32 c = 0; c < 3; ++c)
+				{
+					cornerA = m_triPositions[t * 3 + c] == a ? c : cornerA;
+					cornerB = m_triPositions[t * 3 + c] == b ? c : cornerB;
+				}
+				if (cornerB == 3)
+				{
+					continue;
+				}
+
+				// Across a seam the two triangles have different uvs at one end or both.
+				const u32 kWedgeA = m_triWedges[t * 3 + cornerA];
+				const u32 kWedgeB = m_triWedges[t * 3 + cornerB];
+				if (count++ == 0)
+				{
+					firstA = kWedgeA;
+					firstB = kWedgeB;
+				}
+				else
+				{
+					seam |= kWedgeA != firstA || kWedgeB != firstB;
+				}
+			}
+			return count == 1 ? EdgeKind::kOpen : count == 2 ? (seam ? EdgeKind::kSeam : EdgeKind::kInterior) : EdgeKind::kNonManifold;
+		}
+
+		// Positions around kPosition on a live triangle, into m_scratch.
+		void gather_neighbours(const u32 kPosition)
+		{
+			m_scratch.clear();
+			for (u32 t : m_positionTris[kPosition])
+			{
+				if (!m_liveTri[t])
+				{
+					continue;
+				}
+				for (u32 c = 0; c < 3; ++c)
+				{
+					const u32 p = m_triPositions[t * 3 + c];
+					if (p != kPosition && std::find(m_scratch.begin(), m_scratch.end(), p) == m_scratch.end())
+					{
+						m_scratch.push_back(p);
+					}
+				}
+			}
+		}
+
+		// A position on an open edge has two of them, one each way along it, and may only slide
+		// along one of them. rAlongOut gets the two far ends. False when the position can't move
+		// at all: where more than two open edges meet or one ends, or on a non-manifold edge.
+		// Seams don't hold a position, moving off one is costed by how far the uvs slide.
+		bool find_constraint(const u32 kPosition, u32& rCountOut, u32* pAlongOut)
+		{
+			gather_neighbours(kPosition);
+			rCountOut = 0;
+			for (u32 p : m_scratch)
+			{
+				const EdgeKind kKind = edge_kind(kPosition, p);
+				if (kKind == EdgeKind::kNonManifold)
+				{
+					return false;
+				}
+				if (kKind != EdgeKind::kOpen)
+				{
+					continue;
+				}
+				if (rCountOut == 2)
+				{
+					return false;
+				}
+				pAlongOut[rCountOut++] = p;
+			}
+			return rCountOut == 0 || rCountOut == 2;
+		}
+
+		// Positions that can never move, and those that can only move along an open edge.
+		void find_locked()
+		{
+			m_locked.assign(m_positions.size(), 0);
+			m_constrained = 0;
+			for (u32 p = 0; p < m_positions.size(); ++p)
+			{
+				u32 count = 0;
+				u32 along[2];
+				m_locked[p] = find_constraint(p, count, along) ? 0 : 1;
+				m_constrained += !m_locked[p] && count > 0 ? 1 : 0;
+			}
+		}
+
+		// Each position starts with the planes of the triangles around it.
+		void build_quadrics()
+		{
+			m_quadrics.assign(m_positions.size(), Quadric());
+			for (u32 t = 0; t < m_triPositions.size() / 3; ++t)
+			{
+				const v3& p0 = m_positions[m_triPositions[t * 3 + 0]];
+				const v3& p1 = m_positions[m_triPositions[t * 3 + 1]];
+				const v3& p2 = m_positions[m_triPositions[t * 3 + 2]];
+				v3 normal = (p1 - p0).Cross(p2 - p0);
+				const f32 kLength = normal.Length();
+				if (kLength <= 0.f)
+				{
+					continue;
+				}
+				normal /= kLength;
+
+				const f64 kD = -(f64)normal.Dot(p0);
+				for (u32 c = 0; c < 3; ++c)
+				{
+					m_quadrics[m_triPositions[t * 3 + c]].add_plane(normal.x, normal.y, normal.z, kD);
+				}
+
+				// Seams and open edges also get the plane through them square to the triangle, so
+				// sliding along a straight one is free and cutting a corner off a bent one costs
+				// how far the line moved.
+				for (u32 c = 0; c < 3; ++c)
+				{
+					const u32 a = m_triPositions[t * 3 + c];
+					const u32 b = m_triPositions[t * 3 + (c + 1) % 3];
+					const EdgeKind kKind = edge_kind(a, b);
+					if (kKind != EdgeKind::kSeam && kKind != EdgeKind::kOpen)
+					{
+						continue;
+					}
+					v3 side = (m_positions[b] - m_positions[a]).Cross(normal);
+					const f32 kSideLength = side.Length();
+					if (kSideLength <= 0.f)
+					{
+						continue;
+					}
+					side /= kSideLength;
+					const f64 kSideD = -(f64)side.Dot(m_positions[a]);
+					m_quadrics[a].add_plane(side.x, side.y, side.z, kSideD);
+					m_quadrics[b].add_plane(side.x, side.y, side.z, kSideD);
+				}
+			}
+		}
+
+		static u64 edge_key(const u32 a, const u32 b)
+		{
+			return a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+		}
+
+		// Quadric error of the moved position plus what its uvs slide, kNoCollapse when the wedges
+		// can't be mapped at all. Leaves the mapping in m_wedgeMap for apply.
+		f64 collapse_cost(const u32 kFrom, const u32 kTo)
+		{
+			const f64 kSlide = map_wedges(kFrom, kTo);
+			if (kSlide == kNoCollapse)
+			{
+				return kNoCollapse;
+			}
+			Quadric q = m_quadrics[kFrom];
+			q.add(m_quadrics[kTo]);
+			return q.error(m_positions[kTo]) + kSlide;
+		}
+
+		// Queue both directions of each edge of a live triangle, where the collapse is allowed at all.
+		void push_triangle_edges(CollapseQueue& rQueue, const u32 kTri)
+		{
+			for (u32 c = 0; c < 3; ++c)
+			{
+				const u32 a = m_triPositions[kTri * 3 + c];
+				const u32 b = m_triPositions[kTri * 3 + (c + 1) % 3];
+				const f64 kCostA = m_locked[a] ? kNoCollapse : collapse_cost(a, b);
+				if (kCostA != kNoCollapse)
+				{
+					rQueue.push({ kCostA, a, b });
+				}
+				const f64 kCostB = m_locked[b] ? kNoCollapse : collapse_cost(b, a);
+				if (kCostB != kNoCollapse)
+				{
+					rQueue.push({ kCostB, b, a });
+				}
+			}
+		}
+
+		// Squared distance the texture of triangle kTri slides over its surface when its corner at
+		// kCorner moves to kTo and takes the uv 'uv': the uv the triangle's own mapping puts at kTo
+		// against the one it gets, scaled from uv units to surface units. kNoCollapse when the
+		// triangle has no uv mapping to measure by.
+		f64 slide_cost(const u32 kTri, const u32 kCorner, const u32 kTo, const v2& uv) const
+		{
+			const u32* pTri = &m_triVertices[kTri * 3];
+			const MeshVertex& corner0 = m_pVertices[pTri[kCorner]];
+			const MeshVertex& corner1 = m_pVertices[pTri[(kCorner + 1) % 3]];
+			const MeshVertex& corner2 = m_pVertices[pTri[(kCorner + 2) % 3]];
+			const v3 kE1 = v3(corner1.pos) - v3(corner0.pos);
+			const v3 kE2 = v3(corner2.pos) - v3(corner0.pos);
+			const v2 kT1 = v2(corner1.tex) - v2(corner0.tex);
+			const v2 kT2 = v2(corner2.tex) - v2(corner0.tex);
+
+			const f64 kArea = kE1.Cross(kE2).Length();
+			const f64 kUvArea = fabs((f64)kT1.x * kT2.y - (f64)kT1.y * kT2.x);
+			if (kArea <= 0.0 || kUvArea <= 1e-6 * kArea)
+			{
+				return kNoCollapse;
+			}
+
+			// kTo in the triangle's own edge coordinates, the nearest point of its plane.
+			const v3 kD = m_positions[kTo] - v3(corner0.pos);
+			const f64 g11 = kE1.Dot(kE1), g12 = kE1.Dot(kE2), g22 = kE2.Dot(kE2);
+			const f64 r1 = kD.Dot(kE1), r2 = kD.Dot(kE2);
+			const f64 kDet = g11 * g22 - g12 * g12;
+			const f64 s = (r1 * g22 - r2 * g12) / kDet;
+			const f64 t = (r2 * g11 - r1 * g12) / kDet;
+
+			const f64 du = corner0.tex.x + s * kT1.x + t * kT2.x - uv.x;
+			const f64 dv = corner0.tex.y + s * kT1.y + t * kT2.y - uv.y;
+			return (du * du + dv * dv) * kArea / kUvArea;
+		}
+
+		// Each wedge at kFrom takes a wedge at kTo into m_wedgeMap, and returns the squared
+		// distance the texture slides doing so. A wedge on a triangle of the edge takes the
+		// wedge that triangle has at kTo, on the same side of any seam, which slides nothing.
+		// One with no such triangle, across a seam from kTo, takes the wedge at kTo whose uv its
+		// own triangles' mapping comes closest to, costed by the furthest any of them slides.
+		// kNoCollapse when the edge triangles disagree or a triangle has no mapping.
+		f64 map_wedges(const u32 kFrom, const u32 kTo)
+		{
+			m_wedgeMap.clear();
+			m_slide = 0.0;
+			for (u32 t : m_positionTris[kFrom])
+			{
+				if (!m_liveTri[t])
+				{
+					continue;
+				}
+				u32 cornerFrom = 3;
+				u32 cornerTo = 3;
+				for (u32 c = 0; c < 3; ++c)
+				{
+					cornerFrom = m_triPositions[t * 3 + c] == kFrom ? c : cornerFrom;
+					cornerTo = m_triPositions[t * 3 + c] == kTo ? c : cornerTo;
+				}
+				if (cornerTo == 3)
+				{
+					continue;
+				}
+				const u32 kFromWedge = m_triWedges[t * 3 + cornerFrom];
+				const u32 kToWedge = m_triWedges[t * 3 + cornerTo];
+				const u32 kMapped = find_wedge(kFromWedge);
+				if (kMapped == kNoWedge)
+				{
+					m_wedgeMap.push_back({ kFromWedge, kToWedge });
+				}
+				else if (kMapped != kToWedge)
+				{
+					return kNoCollapse;
+				}
+			}
+
+			// The rest choose from the wedges at kTo.
+			m_scratch.clear();
+			for (u32 t : m_positionTris[kTo])
+			{
+				for (u32 c = 0; c < 3 && m_liveTri[t]; ++c)
+				{
+					const u32 kWedge = m_triWedges[t * 3 + c];
+					if (m_triPositions[t * 3 + c] == kTo && std::find(m_scratch.begin(), m_scratch.end(), kWedge) == m_scratch.end())
+					{
+						m_scratch.push_back(kWedge);
+					}
+				}
+			}
+
+			for (u32 t : m_positionTris[kFrom])
+			{
+				if (!m_liveTri[t])
+				{
+					continue;
+				}
+				u32 corner = 0;
+				while (m_triPositions[t * 3 + corner] != kFrom)
+				{
+					corner++;
+				}
+				const u32 kFromWedge = m_triWedges[t * 3 + corner];
+				if (find_wedge(kFromWedge) != kNoWedge)
+				{
+					continue;
+				}
+
+				u32 best = kNoWedge;
+				f64 bestSlide = kNoCollapse;
+				for (u32 candidate : m_scratch)
+				{
+					const v2 kUv(m_pVertices[m_wedgeVertices[candidate][0]].tex);
+					f64 candidateSlide = 0.0;
+					for (u32 other : m_positionTris[kFrom])
+					{
+						const u32 kOtherCorner = m_liveTri[other] ? wedge_corner(other, kFromWedge) : 3;
+						if (kOtherCorner != 3)
+						{
+							candidateSlide = std::max(candidateSlide, slide_cost(other, kOtherCorner, kTo, kUv));
+						}
+					}
+					if (candidateSlide < bestSlide)
+					{
+						best = candidate;
+						bestSlide = candidateSlide;
+					}
+				}
+				if (best == kNoWedge)
+				{
+					return kNoCollapse;
+				}
+				m_wedgeMap.push_back({ kFromWedge, best });
+				m_slide = std::max(m_slide, bestSlide);
+			}
+			return m_slide;
+		}
+
+		// The corner of triangle kTri using kWedge, 3 when none does.
+		u32 wedge_corner(const u32 kTri, const u32 kWedge) const
+		{
+			for (u32 c = 0; c < 3; ++c)
+			{
+				if (m_triWedges[kTri * 3 + c] == kWedge)
+				{
+					return c;
+				}
+			}
+			return 3;
+		}
+
+		u32 find_wedge(const u32 kFromWedge) const
+		{
+			for (const WedgePair& pair : m_wedgeMap)
+			{
+				if (pair.from == kFromWedge)
+				{
+					return pair.to;
+				}
+			}
+			return kNoWedge;
+		}
+
+		// The wedge's vertex shaded most like kNormal, so a corner of a flat shaded face keeps facing
+		// the way the face does.
+		u32 closest_vertex(const u32 kWedge, const v3& normal) const
+		{
+			u32 closest = m_wedgeVertices[kWedge][0];
+			f32 closestDot = -FLT_MAX;
+			for (u32 vertex : m_wedgeVertices[kWedge])
+			{
+				const f32 kDot = normal.Dot(m_pVertices[vertex].normal);
+				if (kDot > closestDot)
+				{
+					closest = vertex;
+					closestDot = kDot;
+				}
+			}
+			return closest;
+		}
+
+		// Refuse collapses that would leave an open edge, flip a triangle or join the surface to itself.
+		bool can_collapse(const u32 kFrom, const u32 kTo)
+		{
+			u32 constraints = 0;
+			u32 along[2];
+			if (!find_constraint(kFrom, constraints, along) || (constraints == 2 && along[0] != kTo && along[1] != kTo))
+			{
+				return false;
+			}
+
+			// Neighbours shared by both ends must be exactly the far corners of the triangles on the edge.
+			gather_neighbours(kFrom);
+			u32 sharedTris = 0;
+			for (u32 t : m_positionTris[kFrom])
+			{
+				if (m_liveTri[t] && (m_triPositions[t * 3 + 0] == kTo || m_triPositions[t * 3 + 1] == kTo || m_triPositions[t * 3 + 2] == kTo))
+				{
+					sharedTris++;
+				}
+			}
+
+			u32 sharedNeighbours = 0;
+			for (u32 p : m_scratch)
+			{
+				if (p == kTo)
+				{
+					continue;
+				}
+				for (u32 t : m_positionTris[kTo])
+				{
+					if (m_liveTri[t] && (m_triPositions[t * 3 + 0] == p || m_triPositions[t * 3 + 1] == p || m_triPositions[t * 3 + 2] == p))
+					{
+						sharedNeighbours++;
+						break;
+					}
+				}
+			}
+			if (sharedNeighbours != sharedTris)
+			{
+				return false;
+			}
+
+			// Triangles that stay must keep facing the same way.
+			const v3& to = m_positions[kTo];
+			for (u32 t : m_positionTris[kFrom])
+			{
+				if (!m_liveTri[t])
+				{
+					continue;
+				}
+				const u32* pTri = &m_triPositions[t * 3];
+				if (pTri[0] == kTo || pTri[1] == kTo || pTri[2] == kTo)
+				{
+					continue;
+				}
+
+				v3 before[3];
+				v3 after[3];
+				for (u32 c = 0; c < 3; ++c)
+				{
+					before[c] = m_positions[pTri[c]];
+					after[c] = pTri[c] == kFrom ? to : before[c];
+				}
+				const v3 kNormalBefore = (before[1] - before[0]).Cross(before[2] - before[0]);
+				const v3 kNormalAfter = (after[1] - after[0]).Cross(after[2] - after[0]);
+				const f32 kLengths = kNormalBefore.Length() * kNormalAfter.Length();
+				if (kLengths <= 0.f || kNormalBefore.Dot(kNormalAfter) < 0.2f * kLengths)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void apply(const u32 kFrom, const u32 kTo)
+		{
+			for (u32 t : m_positionTris[kFrom])
+			{
+				if (!m_liveTri[t])
+				{
+					continue;
+				}
+
+				u32* pTri = &m_triPositions[t * 3];
+				if (pTri[0] == kTo || pTri[1] == kTo || pTri[2] == kTo)
+				{
+					m_liveTri[t] = 0;
+					m_liveTris--;
+					continue;
+				}
+
+				// Each corner takes the wedge collapse_cost mapped it to, and the vertex there with the
+				// nearest normal.
+				for (u32 c = 0; c < 3; ++c)
+				{
+					if (pTri[c] == kFrom)
+					{
+						const u32 kWedge = find_wedge(m_triWedges[t * 3 + c]);
+						pTri[c] = kTo;
+						m_triWedges[t * 3 + c] = kWedge;
+						m_triVertices[t * 3 + c] = closest_vertex(kWedge, v3(m_pVertices[m_triVertices[t * 3 + c]].normal));
+					}
+				}
+				m_positionTris[kTo].push_back(t);
+			}
+
+			m_quadrics[kTo].add(m_quadrics[kFrom]);
+			m_removed[kFrom] = 1;
+			m_positionTris[kFrom].clear();
+		}
+
+		const MeshVertex* m_pVertices;
+
+		// Per wedge, the vertices at one position with one uv, differing in normal.
+		std::vector<std::vector<u32>> m_wedgeVertices;
+
+		// Per welded position.
+		std::vector<v3> m_positions;
+		std::vector<u8> m_locked;
+		u32 m_constrained;
+		std::vector<u8> m_removed;
+		std::vector<Quadric> m_quadrics;
+		std::vector<std::vector<u32>> m_positionTris; // may still list triangles that have since died
+
+		// Per triangle.
+		std::vector<u32> m_triPositions;
+		std::vector<u32> m_triWedges;
+		std::vector<u32> m_triVertices;
+		std::vector<u8> m_liveTri;
+		u32 m_liveTris;
+
+		f64 m_maxError;
+		std::vector<u32> m_scratch;
+		std::vector<WedgePair> m_wedgeMap; // of the collapse collapse_cost last costed
+		f64 m_slide;                       // the furthest a wedge in it slides its texture, squared
+	};
+}
+
+f32 simplify_mesh(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, const u32 kTargetIndices,
+	std::vector<u16>& rIndicesOut, SimplifyStats* pStats)
+{
+	Simplifier simplifier(pVertices, kNumVerts, pIndices, kNumIndices);
+	return simplifier.run(kTargetIndices, rIndicesOut, pStats);
+}
+
+u32 build_lod_chain(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices,
+	MeshLod* pLodsOut, std::vector<u16>& rIndicesOut)
+{
+	rIndicesOut.assign(pIndices, pIndices + kNumIndices);
+	pLodsOut[0] = { 0, kNumIndices, 0.f };
+
+	// Each level starts from the one before, its error adds to theirs as the quadrics start over.
+	std::vector<u16> level;
+	u32 numLods = 1;
+	while (numLods < kMaxMeshLods)
+	{
+		const MeshLod& previous = pLodsOut[numLods - 1];
+		const u32 kTarget = (previous.indexCount / 6) * 3;
+		const f32 kError = simplify_mesh(pVertices, kNumVerts, &rIndicesOut[previous.firstIndex], previous.indexCount, kTarget, level);
+
+		// A level that only loses a few triangles costs memory and buys nothing.
+		if (level.empty() || level.size() * 4 > previous.indexCount * 3)
+		{
+			break;
+		}
+
+		pLodsOut[numLods] = { (u32)rIndicesOut.size(), (u32)level.size(), previous.error + kError };
+		rIndicesOut.insert(rIndicesOut.end(), level.begin(), level.end());
+		numLods++;
+	}
+	return numLods;
+}
+
+f32 lod_pixels_per_unit(const m4x4& proj, const f32 kViewportWidth, const f32 kViewportHeight)
+{
+	// Clip x over w is x * _11 / z for a row vector projection, half the viewport spans one ndc unit.
+	return std::max(fabsf(proj._11) * kViewportWidth, fabsf(proj._22) * kViewportHeight) * 0.5f;
+}
+
+u32 select_lod(const MeshLod* pLods, const u32 kNumLods, const f32 kDistance, const f32 kPixelsPerUnit, const f32 kMaxPixelError)
+{
+	// Errors grow with the level, so the first from the coarse end that fits is the coarsest.
+	for (u32 i = kNumLods; i-- > 1;)
+	{
+		if (pLods[i].error * kPixelsPerUnit <= kMaxPixelError * kDistance)
+		{
+			return i;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "MeshData.h"
+#include <vector>
+
+struct SimplifyStats
+{
+	u32 positions;   // distinct positions, vertices welded on position, normal and uv
+	u32 constrained; // positions on an open edge, only moved along it
+	u32 locked;      // positions where more than two open edges meet or one ends, or on a non-manifold edge, never moved
+	u32 collapses;
+	u32 slides;      // collapses that moved a corner across a uv seam, sliding its texture
+	u32 rejected;    // collapses that would have left an open edge, flipped a face or pinched the surface
+};
+
+//================================================================================
+// Mesh Simplification
+// Quadric error metric simplification by half edge collapse.
+//
+// A collapse moves one position onto a neighbouring one, so the output only
+// ever uses the input's vertices and the simplified index list can share the
+// original vertex buffer. Tangents come through untouched.
+//
+// Vertices are welded on position, normal and uv to find the connectivity.
+// A position on a uv seam has a wedge, a vertex per uv, for each side of it.
+// Collapsing it moves every wedge together: a corner on a triangle of the
+// collapsing edge takes the wedge that triangle has at the far end, so moving
+// along a seam keeps the uvs on either side their own. A corner across a seam
+// from the far end has no such wedge, it takes the one whose uv its triangles'
+// own mapping comes closest to, and the collapse costs the squared distance
+// the texture slides over the surface on top of the quadric error, so seams
+// only move where that is as cheap as the geometry around them. Normals take
+// the far end's vertex closest to the corner's own.
+//
+// Seams and open edges add the plane through the edge square to the surface
+// to the quadrics, so bending the line costs what it moves. A position on an
+// open edge only moves along it, and where more than two meet or one ends
+// nothing does.
+//
+// Collapses are taken cheapest first until the index count reaches the
+// target or nothing more can go. The error returned is the square root of the
+// largest cost accepted, roughly the furthest any surface or its texture
+// moved, in the units of the positions.
+//================================================================================
+f32 simplify_mesh(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, const u32 kTargetIndices,
+	std::vector<u16>& rIndicesOut, SimplifyStats* pStats = nullptr);
+
+// Levels of roughly half the triangles of the level before, appended to rIndicesOut after pIndices itself.
+// Stops early when a level would barely shrink. Returns the number of levels written to pLodsOut.
+u32 build_lod_chain(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices,
+	MeshLod* pLodsOut, std::vector<u16>& rIndicesOut);
+
+// Screen pixels covered by one object unit one unit in front of the eye, the larger of the two axes.
+// Use the largest over the eyes so both eyes pick the same level.
+f32 lod_pixels_per_unit(const m4x4& proj, const f32 kViewportWidth, const f32 kViewportHeight);
+
+// Coarsest level whose error projects to at most kMaxPixelError pixels kDistance in front of the eye.
+u32 select_lod(const MeshLod* pLods, const u32 kNumLods, const f32 kDistance, const f32 kPixelsPerUnit, const f32 kMaxPixelError);
@@ -0,0 +1,591 @@
+#include "OcclusionCulling.h"
+
+#include <cfloat>
+#include <unordered_map>
+#include <immintrin.h>
+
+// MSVC emits AVX intrinsics without /arch:AVX, GCC and Clang need the target enabled per function.
+#if defined(__GNUC__) && !defined(__AVX__)
+	#define AVX_TARGET __attribute__((target("avx")))
+#else
+	#define AVX_TARGET
+#endif
+
+namespace
+{
+	// Spans are walked in steps of the widest kernel, so every kernel covers the same pixels.
+	constexpr u32 kSpanStep = 8;
+
+	struct PositionKey
+	{
+		u32 bits[3];
+
+		bool operator==(const PositionKey& other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			size_t hash = 2166136261u;
+			for (u32 bits : key.bits)
+			{
+				hash = (hash ^ bits) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	// Row vector transform, clip = (p, 1) * m.
+	v4 transform_point(const v3& p, const m4x4& m)
+	{
+		return v4(
+			p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+			p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+			p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+			p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44);
+	}
+
+	//================================================================================
+	// Triangle kernels
+	// Fill rows [kFirstY, kLastY] of a triangle, kCount pixels of each from pixel
+	// kX on, kCount a multiple of kSpanStep. pDepth is pixel (kX, kFirstY).
+	// The y terms are worked out per row in scalar, the same way in every kernel.
+	//================================================================================
+
+	void raster_triangle_scalar(const OccluderTriangle& tri, const u32 kX, const u32 kCount, const u32 kFirstY, const u32 kLastY, const u32 kStride, f32* pDepth)
+	{
+		for (u32 y = kFirstY; y <= kLastY; ++y, pDepth += kStride)
+		{
+			const f32 fy = (f32)y + 0.5f;
+			const f32 r0 = tri.edgeB[0] * fy + tri.edgeC[0];
+			const f32 r1 = tri.edgeB[1] * fy + tri.edgeC[1];
+			const f32 r2 = tri.edgeB[2] * fy + tri.edgeC[2];
+			const f32 zr = tri.depthB * fy + tri.depthC;
+
+			for (u32 i = 0; i < kCount; ++i)
+			{
+				const f32 fx = (f32)kX + ((f32)i + 0.5f);
+				const f32 e0 = tri.edgeA[0] * fx + r0;
+				const f32 e1 = tri.edgeA[1] * fx + r1;
+				const f32 e2 = tri.edgeA[2] * fx + r2;
+				if (e0 >= 0.f && e1 >= 0.f && e2 >= 0.f)
+				{
+					f32 z = tri.depthA * fx + zr;
+					z = z > 0.f ? z : 0.f;
+					pDepth[i] = pDepth[i] < z ? pDepth[i] : z;
+				}
+			}
+		}
+	}
+
+	void raster_triangle_sse(const OccluderTriangle& tri, const u32 kX, const u32 kCount, const u32 kFirstY, const u32 kLastY, const u32 kStride, f32* pDepth)
+	{
+		const __m128 kZero = _mm_setzero_ps();
+		const __m128 kLaneCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 a0 = _mm_set1_ps(tri.edgeA[0]);
+		const __m128 a1 = _mm_set1_ps(tri.edgeA[1]);
+		const __m128 a2 = _mm_set1_ps(tri.edgeA[2]);
+		const __m128 za = _mm_set1_ps(tri.depthA);
+
+		for (u32 y = kFirstY; y <= kLastY; ++y, pDepth += kStride)
+		{
+			const f32 fy = (f32)y + 0.5f;
+			const __m128 r0 = _mm_set1_ps(tri.edgeB[0] * fy + tri.edgeC[0]);
+			const __m128 r1 = _mm_set1_ps(tri.edgeB[1] * fy + tri.edgeC[1]);
+			const __m128 r2 = _mm_set1_ps(tri.edgeB[2] * fy + tri.edgeC[2]);
+			const __m128 zr = _mm_set1_ps(tri.depthB * fy + tri.depthC);
+
+			for (u32 i = 0; i < kCount; i += 4)
+			{
+				const __m128 fx = _mm_add_ps(_mm_set1_ps((f32)kX), _mm_add_ps(_mm_set1_ps((f32)i), kLaneCenters));
+				const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, fx), r0);
+				const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, fx), r1);
+				const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, fx), r2);
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, kZero), _mm_cmpge_ps(e1, kZero)), _mm_cmpge_ps(e2, kZero));
+				if (_mm_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				const __m128 z = _mm_max_ps(_mm_add_ps(_mm_mul_ps(za, fx), zr), kZero);
+				const __m128 depth = _mm_loadu_ps(pDepth + i);
+				const __m128 nearest = _mm_min_ps(depth, z);
+				_mm_storeu_ps(pDepth + i, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, depth)));
+			}
+		}
+	}
+
+	AVX_TARGET void raster_triangle_avx(const OccluderTriangle& tri, const u32 kX, const u32 kCount, const u32 kFirstY, const u32 kLastY, const u32 kStride, f32* pDepth)
+	{
+		const __m256 kZero = _mm256_setzero_ps();
+		const __m256 kLaneCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+		const __m256 a0 = _mm256_set1_ps(tri.edgeA[0]);
+		const __m256 a1 = _mm256_set1_ps(tri.edgeA[1]);
+		const __m256 a2 = _mm256_set1_ps(tri.edgeA[2]);
+		const __m256 za = _mm256_set1_ps(tri.depthA);
+
+		for (u32 y = kFirstY; y <= kLastY; ++y, pDepth += kStride)
+		{
+			const f32 fy = (f32)y + 0.5f;
+			const __m256 r0 = _mm256_set1_ps(tri.edgeB[0] * fy + tri.edgeC[0]);
+			const __m256 r1 = _mm256_set1_ps(tri.edgeB[1] * fy + tri.edgeC[1]);
+			const __m256 r2 = _mm256_set1_ps(tri.edgeB[2] * fy + tri.edgeC[2]);
+			const __m256 zr = _mm256_set1_ps(tri.depthB * fy + tri.depthC);
+
+			for (u32 i = 0; i < kCount; i += 8)
+			{
+				const __m256 fx = _mm256_add_ps(_mm256_set1_ps((f32)kX), _mm256_add_ps(_mm256_set1_ps((f32)i), kLaneCenters));
+				const __m256 e0 = _mm256_add_ps(_mm256_mul_ps(a0, fx), r0);
+				const __m256 e1 = _mm256_add_ps(_mm256_mul_ps(a1, fx), r1);
+				const __m256 e2 = _mm256_add_ps(_mm256_mul_ps(a2, fx), r2);
+				const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, kZero, _CMP_GE_OQ), _mm256_cmp_ps(e1, kZero, _CMP_GE_OQ)),
+					_mm256_cmp_ps(e2, kZero, _CMP_GE_OQ));
+				if (_mm256_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				const __m256 z = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(za, fx), zr), kZero);
+				const __m256 depth = _mm256_loadu_ps(pDepth + i);
+				const __m256 nearest = _mm256_min_ps(depth, z);
+				_mm256_storeu_ps(pDepth + i, _mm256_or_ps(_mm256_and_ps(inside, nearest), _mm256_andnot_ps(inside, depth)));
+			}
+		}
+
+		// Avoid the AVX to SSE transition penalty in the caller.
+		_mm256_zeroupper();
+	}
+}
+
+void build_occluder_mesh(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, OccluderMesh& rMeshOut)
+{
+	rMeshOut.positions.clear();
+	rMeshOut.indices.clear();
+
+	// Seams only split the shading, an occluder needs each position once. Negative zero is made positive first.
+	std::unordered_map<PositionKey, u16, PositionKeyHash> positionIds;
+	positionIds.reserve(kNumVerts);
+	std::vector<u16> vertexPosition(kNumVerts);
+	for (u32 i = 0; i < kNumVerts; ++i)
+	{
+		const f32 values[3] = { pVertices[i].pos.x + 0.f, pVertices[i].pos.y + 0.f, pVertices[i].pos.z + 0.f };
+		PositionKey key;
+		memcpy(key.bits, values, sizeof(key.bits));
+
+		auto position = positionIds.insert({ key, (u16)rMeshOut.positions.size() });
+		if (position.second)
+		{
+			rMeshOut.positions.push_back(pVertices[i].pos);
+		}
+		vertexPosition[i] = position.first->second;
+	}
+
+	rMeshOut.indices.reserve(kNumIndices);
+	for (u32 i = 0; i + 2 < kNumIndices; i += 3)
+	{
+		const u16 a = vertexPosition[pIndices[i + 0]];
+		const u16 b = vertexPosition[pIndices[i + 1]];
+		const u16 c = vertexPosition[pIndices[i + 2]];
+		if (a != b && b != c && a != c)
+		{
+			rMeshOut.indices.push_back(a);
+			rMeshOut.indices.push_back(b);
+			rMeshOut.indices.push_back(c);
+		}
+	}
+}
+
+//================================================================================
+// Occlusion Buffer
+//================================================================================
+
+OcclusionBuffer::OcclusionBuffer()
+	: m_width(0)
+	, m_height(0)
+	, m_tilesX(0)
+	, m_tilesY(0)
+	, m_blocksX(0)
+	, m_clipped(0)
+{
+}
+
+void OcclusionBuffer::init(const u32 kWidth, const u32 kHeight)
+{
+	ASSERT(kWidth > 0 && kWidth % kOcclusionTileWidth == 0);
+	ASSERT(kHeight > 0 && kHeight % kOcclusionTileHeight == 0);
+	static_assert(kOcclusionTileWidth % kSpanStep == 0, "Tiles must be whole spans");
+	static_assert(kOcclusionTileWidth % kOcclusionBlockSize == 0 && kOcclusionTileHeight % kOcclusionBlockSize == 0, "Tiles must be whole blocks");
+
+	m_width = kWidth;
+	m_height = kHeight;
+	m_tilesX = kWidth / kOcclusionTileWidth;
+	m_tilesY = kHeight / kOcclusionTileHeight;
+	m_blocksX = kWidth / kOcclusionBlockSize;
+
+	// Nothing drawn is as far as it gets, so an empty buffer hides nothing.
+	m_depth.assign(kWidth * kHeight, 1.f);
+	m_blockDepth.assign(m_blocksX * (kHeight / kOcclusionBlockSize), 1.f);
+	m_bins.resize(tiles());
+	m_viewProj = m4x4::Identity;
+}
+
+void OcclusionBuffer::begin(const m4x4& viewProj)
+{
+	m_viewProj = viewProj;
+	m_triangles.clear();
+	for (std::vector<u32>& bin : m_bins)
+	{
+		bin.clear();
+	}
+	m_clipped = 0;
+}
+
+void OcclusionBuffer::add_occluder(const OccluderMesh& mesh, const m4x4& matWorld)
+{
+	const m4x4 kWorldViewProj = matWorld * m_viewProj;
+	m_clip.resize(mesh.positions.size());
+	for (u32 i = 0; i < mesh.positions.size(); ++i)
+	{
+		m_clip[i] = transform_point(mesh.positions[i], kWorldViewProj);
+	}
+
+	for (u32 i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const v4& a = m_clip[mesh.indices[i + 0]];
+		const v4& b = m_clip[mesh.indices[i + 1]];
+		const v4& c = m_clip[mesh.indices[i + 2]];
+
+		// Entirely outside one side of the frustum, the far plane aside as depth clamps there anyway.
+		if ((a.x < -a.w && b.x < -b.w && c.x < -c.w) || (a.x > a.w && b.x > b.w && c.x > c.w)
+			|| (a.y < -a.w && b.y < -b.w && c.y < -c.w) || (a.y > a.w && b.y > b.w && c.y > c.w)
+			|| (a.z < 0.f && b.z < 0.f && c.z < 0.f))
+		{
+			continue;
+		}
+
+		if (a.z >= 0.f && b.z >= 0.f && c.z >= 0.f)
+		{
+			add_triangle(a, b, c);
+			continue;
+		}
+
+		// Clip to the near plane, z >= 0, leaving a triangle or a quad to fan out.
+		const v4 kCorners[3] = { a, b, c };
+		v4 polygon[4];
+		u32 numPolygon = 0;
+		for (u32 v = 0; v < 3; ++v)
+		{
+			const v4& current = kCorners[v];
+			const v4& next = kCorners[(v + 1) % 3];
+			if (current.z >= 0.f)
+			{
+				polygon[numPolygon++] = current;
+			}
+			if ((current.z >= 0.f) != (next.z >= 0.f))
+			{
+				const f32 t = current.z / (current.z - next.z);
+				polygon[numPolygon++] = current + (next - current) * t;
+			}
+		}
+
+		m_clipped++;
+		for (u32 v = 2; v < numPolygon; ++v)
+		{
+			add_triangle(polygon[0], polygon[v - 1], polygon[v]);
+		}
+	}
+}
+
+void OcclusionBuffer::add_triangle(const v4& a, const v4& b, const v4& c)
+{
+	if (a.w <= 0.f || b.w <= 0.f || c.w <= 0.f)
+	{
+		return;
+	}
+
+	// Pixel space, y down, pixel centers at half pixels.
+	const v4* kClip[3] = { &a, &b, &c };
+	f32 x[3], y[3], z[3];
+	for (u32 i = 0; i < 3; ++i)
+	{
+		const v4& v = *kClip[i];
+		x[i] = (v.x / v.w * 0.5f + 0.5f) * (f32)m_width;
+		y[i] = (0.5f - v.y / v.w * 0.5f) * (f32)m_height;
+		z[i] = v.z / v.w;
+	}
+
+	// Either winding is drawn, turn clockwise triangles round so inside is always positive.
+	f32 area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area < 0.f)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+	if (!(area > 0.f))
+	{
+		return;
+	}
+
+	OccluderTriangle tri;
+	tri.minX = std::max((s32)ceilf(std::min(std::min(x[0], x[1]), x[2]) - 0.5f), 0);
+	tri.maxX = std::min((s32)floorf(std::max(std::max(x[0], x[1]), x[2]) - 0.5f), (s32)m_width - 1);
+	tri.minY = std::max((s32)ceilf(std::min(std::min(y[0], y[1]), y[2]) - 0.5f), 0);
+	tri.maxY = std::min((s32)floorf(std::max(std::max(y[0], y[1]), y[2]) - 0.5f), (s32)m_height - 1);
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+	{
+		return;
+	}
+
+	for (u32 i = 0; i < 3; ++i)
+	{
+		const u32 j = (i + 1) % 3;
+		tri.edgeA[i] = y[i] - y[j];
+		tri.edgeB[i] = x[j] - x[i];
+		tri.edgeC[i] = x[i] * y[j] - x[j] * y[i];
+	}
+
+	tri.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	tri.depthB = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+	tri.depthC = z[0] - tri.depthA * x[0] - tri.depthB * y[0];
+
+	const u32 kIndex = (u32)m_triangles.size();
+	m_triangles.push_back(tri);
+
+	for (u32 ty = tri.minY / kOcclusionTileHeight; ty <= tri.maxY / kOcclusionTileHeight; ++ty)
+	{
+		for (u32 tx = tri.minX / kOcclusionTileWidth; tx <= tri.maxX / kOcclusionTileWidth; ++tx)
+		{
+			m_bins[ty * m_tilesX + tx].push_back(kIndex);
+		}
+	}
+}
+
+void OcclusionBuffer::rasterize_tile(const CullKernel kernel, const u32 kTile)
+{
+	ASSERT(kTile < tiles());
+	const u32 kTileX = (kTile % m_tilesX) * kOcclusionTileWidth;
+	const u32 kTileY = (kTile / m_tilesX) * kOcclusionTileHeight;
+
+	for (u32 y = kTileY; y < kTileY + kOcclusionTileHeight; ++y)
+	{
+		std::fill_n(&m_depth[y * m_width + kTileX], kOcclusionTileWidth, 1.f);
+	}
+
+	for (const u32 kIndex : m_bins[kTile])
+	{
+		const OccluderTriangle& tri = m_triangles[kIndex];
+		const u32 kFirstX = std::max((u32)tri.minX, kTileX) & ~(kSpanStep - 1);
+		const u32 kLastX = std::min((u32)tri.maxX, kTileX + kOcclusionTileWidth - 1);
+		const u32 kCount = (kLastX - kFirstX + kSpanStep) & ~(kSpanStep - 1);
+		const u32 kFirstY = std::max((u32)tri.minY, kTileY);
+		const u32 kLastY = std::min((u32)tri.maxY, kTileY + kOcclusionTileHeight - 1);
+		f32* pDepth = &m_depth[kFirstY * m_width + kFirstX];
+
+		switch (kernel)
+		{
+		case CullKernel::kAVX: raster_triangle_avx(tri, kFirstX, kCount, kFirstY, kLastY, m_width, pDepth); break;
+		case CullKernel::kSSE: raster_triangle_sse(tri, kFirstX, kCount, kFirstY, kLastY, m_width, pDepth); break;
+		default:               raster_triangle_scalar(tri, kFirstX, kCount, kFirstY, kLastY, m_width, pDepth); break;
+		}
+	}
+
+	build_blocks(kTile);
+}
+
+void OcclusionBuffer::rasterize(const CullKernel kernel)
+{
+	for (u32 i = 0; i < tiles(); ++i)
+	{
+		rasterize_tile(kernel, i);
+	}
+}
+
+void OcclusionBuffer::build_blocks(const u32 kTile)
+{
+	const u32 kTileX = (kTile % m_tilesX) * kOcclusionTileWidth;
+	const u32 kTileY = (kTile / m_tilesX) * kOcclusionTileHeight;
+
+	for (u32 by = kTileY; by < kTileY + kOcclusionTileHeight; by += kOcclusionBlockSize)
+	{
+		for (u32 bx = kTileX; bx < kTileX + kOcclusionTileWidth; bx += kOcclusionBlockSize)
+		{
+			f32 farthest = 0.f;
+			for (u32 y = by; y < by + kOcclusionBlockSize; ++y)
+			{
+				const f32* pRow = &m_depth[y * m_width + bx];
+				for (u32 x = 0; x < kOcclusionBlockSize; ++x)
+				{
+					farthest = std::max(farthest, pRow[x]);
+				}
+			}
+			m_blockDepth[(by / kOcclusionBlockSize) * m_blocksX + bx / kOcclusionBlockSize] = farthest;
+		}
+	}
+}
+
+bool OcclusionBuffer::is_occluded(const v3& center, const v3& extents) const
+{
+	f32 minX = FLT_MAX, minY = FLT_MAX, nearest = FLT_MAX;
+	f32 maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (u32 i = 0; i < 8; ++i)
+	{
+		const v3 kCorner(
+			center.x + ((i & 1) ? extents.x : -extents.x),
+			center.y + ((i & 2) ? extents.y : -extents.y),
+			center.z + ((i & 4) ? extents.z : -extents.z));
+		const v4 kClip = transform_point(kCorner, m_viewProj);
+		if (kClip.z < 0.f || kClip.w <= 0.f)
+		{
+			return false;
+		}
+
+		const f32 x = (kClip.x / kClip.w * 0.5f + 0.5f) * (f32)m_width;
+		const f32 y = (0.5f - kClip.y / kClip.w * 0.5f) * (f32)m_height;
+		minX = std::min(minX, x); maxX = std::max(maxX, x);
+		minY = std::min(minY, y); maxY = std::max(maxY, y);
+		nearest = std::min(nearest, kClip.z / kClip.w);
+	}
+
+	// Entirely off the buffer is the frustum's business. Otherwise only the part on it can be seen.
+	if (maxX < 0.f || maxY < 0.f || minX >= (f32)m_width || minY >= (f32)m_height)
+	{
+		return false;
+	}
+
+	// Every pixel the box touches, so every block, must be nearer than the box.
+	const u32 kFirstBlockX = (u32)std::max(minX, 0.f) / kOcclusionBlockSize;
+	const u32 kLastBlockX = (u32)std::min(maxX, (f32)m_width - 1.f) / kOcclusionBlockSize;
+	const u32 kFirstBlockY = (u32)std::max(minY, 0.f) / kOcclusionBlockSize;
+	const u32 kLastBlockY = (u32)std::min(maxY, (f32)m_height - 1.f) / kOcclusionBlockSize;
+	for (u32 by = kFirstBlockY; by <= kLastBlockY; ++by)
+	{
+		for (u32 bx = kFirstBlockX; bx <= kLastBlockX; ++bx)
+		{
+			if (!(nearest > m_blockDepth[by * m_blocksX + bx]))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//================================================================================
+// Occlusion Culler
+//================================================================================
+
+OcclusionCuller::OcclusionCuller()
+	: m_numWorkers(0)
+	, m_numViews(0)
+	, m_stats{}
+{
+}
+
+void OcclusionCuller::init(const u32 kWorkers, const u32 kWidth, const u32 kHeight)
+{
+	ASSERT(!m_pWorkers); // Not already launched!
+
+	m_numWorkers = kWorkers;
+	if (kWorkers > 0)
+	{
+		m_pWorkers.reset(new JobQueue[kWorkers]);
+		for (u32 i = 0; i < kWorkers; ++i)
+		{
+			m_pWorkers[i].launch("Occlusion worker");
+		}
+	}
+
+	for (OcclusionBuffer& buffer : m_buffers)
+	{
+		buffer.init(kWidth, kHeight);
+	}
+}
+
+void OcclusionCuller::run_jobs(const u32 kCount, const std::function<void(const u32)>& fn)
+{
+	if (m_numWorkers == 0)
+	{
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			fn(i);
+		}
+		return;
+	}
+
+	// A contiguous run per worker, neighbouring tiles tend to share triangles and cache lines.
+	for (u32 w = 0; w < m_numWorkers; ++w)
+	{
+		const u32 kFirst = kCount * w / m_numWorkers;
+		const u32 kEnd = kCount * (w + 1) / m_numWorkers;
+		if (kFirst < kEnd)
+		{
+			m_pWorkers[w].pushJob([&fn, kFirst, kEnd]()
+			{
+				PROFILE_SCOPE("Occlusion job");
+				for (u32 i = kFirst; i < kEnd; ++i)
+				{
+					fn(i);
+				}
+			});
+		}
+	}
+	for (u32 w = 0; w < m_numWorkers; ++w)
+	{
+		m_pWorkers[w].waitAll();
+	}
+}
+
+void OcclusionCuller::render(const CullKernel kernel, const m4x4* pViewProj, const u32 kViews, const OccluderInstance* pOccluders, const u32 kNumOccluders)
+{
+	ASSERT(kViews > 0 && kViews <= kMaxViews);
+	m_numViews = kViews;
+	m_stats = {};
+
+	// Binning writes a view's triangle list and bins, so one job per view.
+	run_jobs(kViews, [this, pViewProj, pOccluders, kNumOccluders](const u32 kView)
+	{
+		OcclusionBuffer& buffer = m_buffers[kView];
+		buffer.begin(pViewProj[kView]);
+		for (u32 i = 0; i < kNumOccluders; ++i)
+		{
+			buffer.add_occluder(*pOccluders[i].pMesh, pOccluders[i].matWorld);
+		}
+	});
+
+	const u32 kTiles = m_buffers[0].tiles();
+	run_jobs(kViews * kTiles, [this, kernel, kTiles](const u32 kJob)
+	{
+		m_buffers[kJob / kTiles].rasterize_tile(kernel, kJob % kTiles);
+	});
+
+	m_stats.occluders = kNumOccluders;
+	for (u32 i = 0; i < kViews; ++i)
+	{
+		m_stats.triangles += (u32)m_buffers[i].triangles().size();
+		m_stats.clipped += m_buffers[i].clipped();
+	}
+}
+
+bool OcclusionCuller::is_occluded(const v3& center, const v3& extents) const
+{
+	ASSERT(m_numViews > 0);
+	for (u32 i = 0; i < m_numViews; ++i)
+	{
+		if (!m_buffers[i].is_occluded(center, extents))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool OcclusionCuller::test(const v3& center, const v3& extents)
+{
+	const bool kOccluded = is_occluded(center, extents);
+	m_stats.tested++;
+	m_stats.occluded += kOccluded ? 1 : 0;
+	return kOccluded;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "Culling.h"
+#include "ViewLayout.h"
+#include "JobQueue.h"
+#include "MeshData.h"
+#include <memory>
+#include <vector>
+
+// Pixels per rasterizer tile, tiles are filled independently. Widths are a multiple of the widest kernel.
+constexpr u32 kOcclusionTileWidth = 32;
+constexpr u32 kOcclusionTileHeight = 16;
+
+// Pixels per side of a hierarchical depth block, each holds the farthest depth under it.
+constexpr u32 kOcclusionBlockSize = 8;
+
+// Occluder geometry kept on the CPU, positions welded so each is transformed once.
+struct OccluderMesh
+{
+	std::vector<v3> positions;
+	std::vector<u16> indices;
+
+	bool empty() const { return indices.empty(); }
+};
+
+void build_occluder_mesh(const MeshVertex* pVertices, const u32 kNumVerts, const u16* pIndices, const u32 kNumIndices, OccluderMesh& rMeshOut);
+
+// An occluder placed in the world.
+struct OccluderInstance
+{
+	const OccluderMesh* pMesh;
+	m4x4 matWorld;
+};
+
+// A triangle in the pixel space of one buffer, edges and depth as planes over the pixel centers.
+struct OccluderTriangle
+{
+	f32 edgeA[3];   // edge i is inside where edgeA[i] * x + (edgeB[i] * y + edgeC[i]) >= 0
+	f32 edgeB[3];
+	f32 edgeC[3];
+	f32 depthA;     // depth is depthA * x + (depthB * y + depthC)
+	f32 depthB;
+	f32 depthC;
+	s32 minX, minY; // pixels whose centers may be covered, inclusive and inside the buffer
+	s32 maxX, maxY;
+};
+
+struct OcclusionStats
+{
+	u32 occluders;
+	u32 triangles;  // binned after clipping
+	u32 clipped;    // crossed the near plane
+	u32 tested;
+	u32 occluded;
+};
+
+//================================================================================
+// Occlusion Buffer
+// A small software depth buffer for one view, with a hierarchical depth level
+// of 8x8 blocks for testing.
+//
+// Occluders are transformed, clipped to the near plane and binned into tiles
+// on one thread, then each tile is rasterized and its blocks rebuilt on its
+// own, so tiles can go to different threads. Depth is D3D's z over w, nearest
+// wins, and a pixel is covered when its center is inside a triangle. Both
+// windings are drawn so open occluders work from either side.
+//
+// Every kernel evaluates the same expressions in the same order, so the SIMD
+// kernels give exactly the scalar reference's depth.
+//================================================================================
+class OcclusionBuffer
+{
+public:
+	OcclusionBuffer();
+
+	// Width a multiple of kOcclusionTileWidth, height a multiple of kOcclusionTileHeight.
+	void init(const u32 kWidth, const u32 kHeight);
+
+	// Start a frame for a row vector view projection, drops last frame's occluders.
+	void begin(const m4x4& viewProj);
+
+	// Transform, clip and bin an occluder's triangles. Call from one thread at a time.
+	void add_occluder(const OccluderMesh& mesh, const m4x4& matWorld);
+
+	// Clear and fill one tile and rebuild its blocks. Tiles don't share anything, call from any thread.
+	void rasterize_tile(const CullKernel kernel, const u32 kTile);
+
+	// Every tile on the calling thread.
+	void rasterize(const CullKernel kernel);
+
+	// True when a world space box is certainly behind the occluders.
+	// Boxes crossing the near plane or leaving the buffer are never occluded.
+	bool is_occluded(const v3& center, const v3& extents) const;
+
+	u32 width() const { return m_width; }
+	u32 height() const { return m_height; }
+	u32 tiles() const { return m_tilesX * m_tilesY; }
+	const f32* depth() const { return m_depth.data(); }
+	const f32* block_depth() const { return m_blockDepth.data(); }
+	const std::vector<OccluderTriangle>& triangles() const { return m_triangles; }
+	u32 clipped() const { return m_clipped; }
+
+private:
+	void add_triangle(const v4& a, const v4& b, const v4& c);
+	void build_blocks(const u32 kTile);
+
+	m4x4 m_viewProj;
+	u32 m_width;
+	u32 m_height;
+	u32 m_tilesX;
+	u32 m_tilesY;
+	u32 m_blocksX;
+
+	std::vector<f32> m_depth;      // row major, a pixel per entry
+	std::vector<f32> m_blockDepth; // row major, a block per entry
+
+	std::vector<OccluderTriangle> m_triangles;
+	std::vector<std::vector<u32>> m_bins; // triangles touching each tile
+	std::vector<v4> m_clip;               // scratch for the occluder being added
+	u32 m_clipped;
+};
+
+//================================================================================
+// Occlusion Culler
+// Renders the occluders into a buffer per view on a set of JobQueue workers
+// and tests boxes against all of them.
+//
+// Each view's occluders are binned by one job, then the tiles of every view
+// are split between the workers. A box is occluded only when it is hidden in
+// every view, so both eyes of a stereo pair share one result.
+//================================================================================
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+
+	// Launch kWorkers threads, with none everything runs on the calling thread.
+	void init(const u32 kWorkers, const u32 kWidth, const u32 kHeight);
+
+	u32 workers() const { return m_numWorkers; }
+
+	// Fill a buffer per view with the occluders, returns once every tile is done.
+	void render(const CullKernel kernel, const m4x4* pViewProj, const u32 kViews, const OccluderInstance* pOccluders, const u32 kNumOccluders);
+
+	// Hidden in every view rendered.
+	bool is_occluded(const v3& center, const v3& extents) const;
+
+	// Counts the result so the stats cover the frame's tests.
+	bool test(const v3& center, const v3& extents);
+
+	const OcclusionBuffer& buffer(const u32 kView) const { return m_buffers[kView]; }
+	const OcclusionStats& stats() const { return m_stats; }
+
+private:
+	// Runs fn(0) to fn(kCount - 1) over the workers and waits for them.
+	void run_jobs(const u32 kCount, const std::function<void(const u32)>& fn);
+
+	std::unique_ptr<JobQueue[]> m_pWorkers;
+	u32 m_numWorkers;
+
+	OcclusionBuffer m_buffers[kMaxViews];
+	u32 m_numViews;
+	OcclusionStats m_stats;
+};
@@ -0,0 +1,93 @@
+#include "OvrHmd.h"
+#include "Profiler.h"
+#include <chrono>
+#include <thread>
+
+OvrHmd::OvrHmd()
+	: m_session(nullptr)
+	, m_interval(1.0 / 90.0)
+{
+}
+
+void OvrHmd::init(ovrSession session)
+{
+	m_session = session;
+	const ovrHmdDesc kDesc = ovr_GetHmdDesc(session);
+	if (kDesc.DisplayRefreshRate > 0.f)
+	{
+		m_interval = 1.0 / kDesc.DisplayRefreshRate;
+	}
+}
+
+HmdFrameStatus OvrHmd::wait_to_begin_frame(const s64 kFrameIndex)
+{
+	ovrSessionStatus status;
+	if (OVR_FAILURE(ovr_GetSessionStatus(m_session, &status)) || status.DisplayLost)
+	{
+		return HmdFrameStatus::kFailed;
+	}
+
+	// Nothing is shown while the headset is off or another app has it, sleep a refresh rather than spin.
+	if (!status.IsVisible)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<f64>(m_interval));
+		return HmdFrameStatus::kSkip;
+	}
+
+	return OVR_SUCCESS(ovr_WaitToBeginFrame(m_session, kFrameIndex)) ? HmdFrameStatus::kRender : HmdFrameStatus::kFailed;
+}
+
+bool OvrHmd::begin_frame(const s64 kFrameIndex)
+{
+	return OVR_SUCCESS(ovr_BeginFrame(m_session, kFrameIndex));
+}
+
+f64 OvrHmd::predicted_display_time(const s64 kFrameIndex)
+{
+	return ovr_GetPredictedDisplayTime(m_session, kFrameIndex);
+}
+
+bool OvrHmd::end_frame(const s64 kFrameIndex, const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers)
+{
+	// ovrSuccess_NotVisible is a success, the frame just wasn't shown.
+	return OVR_SUCCESS(ovr_EndFrame(m_session, kFrameIndex, nullptr, ppLayers, kNumLayers));
+}
+
+f64 OvrHmd::time_seconds()
+{
+	return ovr_GetTimeInSeconds();
+}
+
+//================================================================================
+// OVR Pose Source
+//================================================================================
+
+OvrPoseSource::OvrPoseSource()
+	: m_session(nullptr)
+{
+}
+
+void OvrPoseSource::init(ovrSession session)
+{
+	m_session = session;
+}
+
+PoseSample OvrPoseSource::sample(const s64 kFrameIndex, const f64 kDisplayTime)
+{
+	PROFILE_SCOPE("Pose fetch");
+	// The eye offsets can change at runtime, fetch them with every sample.
+	const ovrHmdDesc kDesc = ovr_GetHmdDesc(m_session);
+	ovrPosef hmdToEyePose[2];
+	for (u32 eye = 0; eye < 2; ++eye)
+	{
+		hmdToEyePose[eye] = ovr_GetRenderDesc(m_session, (ovrEyeType)eye, kDesc.DefaultEyeFov[eye]).HmdToEyePose;
+	}
+
+	ovrPosef eyePoses[2];
+	PoseSample pose;
+	ovr_GetEyePoses(m_session, kFrameIndex, ovrTrue, hmdToEyePose, eyePoses, &pose.sampleTime);
+	pose.eyes[0] = eye_pose_from_ovr(eyePoses[0]);
+	pose.eyes[1] = eye_pose_from_ovr(eyePoses[1]);
+	pose.displayTime = kDisplayTime;
+	return pose;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "FrameLifecycle.h"
+#include "PoseSource.h"
+#include <OVR_CAPI.h>
+
+//================================================================================
+// OVR HMD
+// The frame lifecycle's calls on a LibOVR session, using the runtime's own
+// pacing with ovr_WaitToBeginFrame, ovr_BeginFrame and ovr_EndFrame.
+//================================================================================
+class OvrHmd final : public HmdInterface
+{
+public:
+	OvrHmd();
+
+	void init(ovrSession session);
+
+	HmdFrameStatus wait_to_begin_frame(const s64 kFrameIndex) override;
+	bool begin_frame(const s64 kFrameIndex) override;
+	f64 predicted_display_time(const s64 kFrameIndex) override;
+	bool end_frame(const s64 kFrameIndex, const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers) override;
+	f64 time_seconds() override;
+	f64 refresh_interval() override { return m_interval; }
+
+private:
+	ovrSession m_session;
+	f64 m_interval;
+};
+
+inline EyePose eye_pose_from_ovr(const ovrPosef& pose)
+{
+	return { quat(pose.Orientation.x, pose.Orientation.y, pose.Orientation.z, pose.Orientation.w), v3(pose.Position.x, pose.Position.y, pose.Position.z) };
+}
+
+inline ovrPosef ovr_pose_from_eye(const EyePose& pose)
+{
+	ovrPosef result;
+	result.Orientation = { pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w };
+	result.Position = { pose.position.x, pose.position.y, pose.position.z };
+	return result;
+}
+
+//================================================================================
+// OVR Pose Source
+// Eye poses from ovr_GetEyePoses, which predicts them for the frame index's
+// display time. Each sample restarts the runtime's latency timer, so the one
+// the layer is submitted with is the one measured.
+//================================================================================
+class OvrPoseSource final : public PoseSource
+{
+public:
+	OvrPoseSource();
+
+	void init(ovrSession session);
+
+	PoseSample sample(const s64 kFrameIndex, const f64 kDisplayTime) override;
+
+private:
+	ovrSession m_session;
+};
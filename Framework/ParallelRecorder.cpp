@@ -0,0 +1,107 @@
+#include "ParallelRecorder.h"
+
+u32 partition_chunks(const u32 kItems, const u32 kSegmentSize, const u32 kMaxChunks, const u32 kMinItems, std::vector<RecordChunk>& rChunksOut)
+{
+	ASSERT(kSegmentSize > 0);
+	rChunksOut.clear();
+
+	const u32 kNumSegments = (kItems + kSegmentSize - 1) / kSegmentSize;
+	if (kNumSegments == 0)
+	{
+		return 0;
+	}
+
+	const u32 kChunksPerSegment = std::max(kMaxChunks / kNumSegments, 1u);
+
+	for (u32 segment = 0; segment < kNumSegments; ++segment)
+	{
+		const u32 kFirst = segment * kSegmentSize;
+		const u32 kCount = std::min(kSegmentSize, kItems - kFirst);
+
+		// Spread the remainder over the first chunks so sizes differ by at most one.
+		const u32 kChunks = std::max(std::min(kChunksPerSegment, kCount / std::max(kMinItems, 1u)), 1u);
+		const u32 kBase = kCount / kChunks;
+		const u32 kRemainder = kCount % kChunks;
+
+		u32 first = kFirst;
+		for (u32 i = 0; i < kChunks; ++i)
+		{
+			const u32 kSize = kBase + (i < kRemainder ? 1 : 0);
+			rChunksOut.push_back({ first, kSize });
+			first += kSize;
+		}
+	}
+
+	return (u32)rChunksOut.size();
+}
+
+//================================================================================
+// Parallel Recorder
+//================================================================================
+
+ParallelRecorder::ParallelRecorder()
+	: m_numWorkers(0)
+{
+}
+
+void ParallelRecorder::init(const u32 kWorkers)
+{
+	ASSERT(!m_pWorkers); // Not already launched!
+
+	m_numWorkers = kWorkers;
+	if (kWorkers > 0)
+	{
+		m_pWorkers.reset(new JobQueue[kWorkers]);
+		for (u32 i = 0; i < kWorkers; ++i)
+		{
+			m_pWorkers[i].launch("Record worker");
+		}
+	}
+}
+
+void ParallelRecorder::record(CommandRecordingBackend& rBackend, const u32 kItems, const u32 kSegmentSize, const u32 kMaxChunks, const u32 kMinItems, const RecordFn& rRecord,
+	const std::function<void()>& rBeforeExecute)
+{
+	const u32 kNumChunks = partition_chunks(kItems, kSegmentSize, kMaxChunks, kMinItems, m_chunks);
+	rBackend.begin_frame(kNumChunks);
+
+	auto recordChunk = [this, &rBackend, &rRecord](const u32 kChunk)
+	{
+		PROFILE_SCOPE("Record chunk");
+		rBackend.begin_chunk(kChunk);
+		rRecord(kChunk, m_chunks[kChunk]);
+		rBackend.end_chunk(kChunk);
+	};
+
+	if (m_numWorkers == 0)
+	{
+		for (u32 i = 0; i < kNumChunks; ++i)
+		{
+			recordChunk(i);
+		}
+	}
+	else
+	{
+		// Round robin, each worker records its chunks in order.
+		for (u32 i = 0; i < kNumChunks; ++i)
+		{
+			m_pWorkers[i % m_numWorkers].pushJob([recordChunk, i]() { recordChunk(i); });
+		}
+		for (u32 i = 0; i < m_numWorkers; ++i)
+		{
+			m_pWorkers[i].waitAll();
+		}
+	}
+
+	if (rBeforeExecute)
+	{
+		rBeforeExecute();
+	}
+
+	// Execution order is chunk order whichever worker finished first.
+	PROFILE_SCOPE("Execute chunks");
+	for (u32 i = 0; i < kNumChunks; ++i)
+	{
+		rBackend.execute_chunk(i);
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "JobQueue.h"
+#include <memory>
+#include <vector>
+
+// A contiguous range of items recorded as one command list.
+struct RecordChunk
+{
+	u32 first;
+	u32 count;
+};
+
+// Split kItems into contiguous chunks in item order.
+// Items are grouped into segments of kSegmentSize (e.g. one per eye) and chunks never cross a
+// segment boundary. Each segment gets an equal share of kMaxChunks, at least one chunk, and no
+// chunk is smaller than kMinItems unless its segment is.
+// Returns the number of chunks written to rChunksOut.
+u32 partition_chunks(const u32 kItems, const u32 kSegmentSize, const u32 kMaxChunks, const u32 kMinItems, std::vector<RecordChunk>& rChunksOut);
+
+//================================================================================
+// Command Recording Backend
+// Owns whatever a chunk records into.
+// begin_frame and execute_chunk are called on the submitting thread,
+// begin_chunk and end_chunk on the worker recording that chunk.
+//================================================================================
+class CommandRecordingBackend
+{
+public:
+	virtual ~CommandRecordingBackend() {}
+
+	virtual void begin_frame(const u32 kNumChunks) = 0;
+	virtual void begin_chunk(const u32 kChunk) = 0;
+	virtual void end_chunk(const u32 kChunk) = 0;
+	virtual void execute_chunk(const u32 kChunk) = 0;
+};
+
+//================================================================================
+// Parallel Recorder
+// Partitions a draw list into chunks, records the chunks on a set of JobQueue
+// workers and then executes them in chunk order on the calling thread, so the
+// result matches recording the list serially.
+//================================================================================
+class ParallelRecorder
+{
+public:
+	// Records items [first, first + count) of a chunk, called on a worker.
+	typedef std::function<void(const u32 kChunk, const RecordChunk& rChunk)> RecordFn;
+
+	ParallelRecorder();
+
+	// Launch kWorkers threads, with none every chunk is recorded on the calling thread.
+	void init(const u32 kWorkers);
+
+	u32 workers() const { return m_numWorkers; }
+
+	// Partition, record and execute, returns once all chunks have been executed.
+	// rBeforeExecute runs on the calling thread between the last chunk recording and the first executing,
+	// anything it writes on the immediate context is seen by every chunk, e.g. late latched constants.
+	void record(CommandRecordingBackend& rBackend, const u32 kItems, const u32 kSegmentSize, const u32 kMaxChunks, const u32 kMinItems, const RecordFn& rRecord,
+		const std::function<void()>& rBeforeExecute = nullptr);
+
+	u32 chunks() const { return (u32)m_chunks.size(); }
+	const RecordChunk& chunk(const u32 i) const { return m_chunks[i]; }
+
+private:
+	std::unique_ptr<JobQueue[]> m_pWorkers;
+	u32 m_numWorkers;
+
+	std::vector<RecordChunk> m_chunks;
+};
+
+//================================================================================
+// Null Recording Backend
+// Records nothing, it only tracks which chunks were recorded and the order
+// they were executed in so the scheduling can be checked without a device.
+//================================================================================
+class NullRecordingBackend final : public CommandRecordingBackend
+{
+public:
+	void begin_frame(const u32 kNumChunks) override
+	{
+		recorded.assign(kNumChunks, 0);
+		executed.clear();
+	}
+
+	void begin_chunk(const u32 kChunk) override { ASSERT(recorded[kChunk] == 0); recorded[kChunk] = 1; }
+	void end_chunk(const u32 kChunk) override { ASSERT(recorded[kChunk] == 1); recorded[kChunk] = 2; }
+	void execute_chunk(const u32 kChunk) override { ASSERT(recorded[kChunk] == 2); executed.push_back(kChunk); }
+
+	// Per chunk, 1 while recording and 2 once finished. Each chunk writes only its own entry.
+	std::vector<u8> recorded;
+	std::vector<u32> executed;
+};
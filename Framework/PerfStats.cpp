@@ -0,0 +1,212 @@
+#include "PerfStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	PerfStats* s_pCurrentPerfStats = nullptr;
+}
+
+const char* perf_counter_name(const PerfCounter counter)
+{
+	switch (counter)
+	{
+	case PerfCounter::kDrawCalls: return "Draw calls";
+	case PerfCounter::kMapCalls: return "Map calls";
+	case PerfCounter::kTriangles: return "Triangles";
+	case PerfCounter::kVisibleObjects: return "Visible objects";
+	case PerfCounter::kCulledObjects: return "Culled objects";
+	case PerfCounter::kTransformUpdates: return "Transform updates";
+	default: return "Unknown";
+	}
+}
+
+//================================================================================
+// Frame Time Histogram
+//================================================================================
+
+FrameTimeHistogram::FrameTimeHistogram()
+	: m_binWidthMs(1.f)
+	, m_count(0)
+	, m_totalMs(0.0)
+	, m_maxMs(0.f)
+{
+}
+
+void FrameTimeHistogram::init(const f32 kMaxMs, const u32 kBins)
+{
+	ASSERT(kMaxMs > 0.f && kBins > 0);
+	m_bins.assign(kBins + 1, 0);
+	m_binWidthMs = kMaxMs / (f32)kBins;
+	reset();
+}
+
+void FrameTimeHistogram::reset()
+{
+	std::fill(m_bins.begin(), m_bins.end(), 0);
+	m_count = 0;
+	m_totalMs = 0.0;
+	m_maxMs = 0.f;
+}
+
+void FrameTimeHistogram::add(const f32 kMs)
+{
+	ASSERT(!m_bins.empty());
+	const f32 kClamped = std::max(kMs, 0.f);
+	const u32 kLast = (u32)m_bins.size() - 1;
+	const f32 kBin = kClamped / m_binWidthMs;
+	m_bins[kBin < (f32)kLast ? (u32)kBin : kLast]++;
+	m_count++;
+	m_totalMs += kClamped;
+	m_maxMs = std::max(m_maxMs, kClamped);
+}
+
+f32 FrameTimeHistogram::percentile(const f32 kFraction) const
+{
+	if (m_count == 0)
+	{
+		return 0.f;
+	}
+
+	// The time with kFraction of the times at or below it, counting from one. 0.99f is a
+	// little over 0.99, so it is rounded back to the decimal it was written as first,
+	// or the 99th of 100 times would be the 100th.
+	const f64 kDecimalFraction = std::round((f64)kFraction * 1e6) / 1e6;
+	const u64 kRank = std::max<u64>(1, (u64)std::ceil(kDecimalFraction * (f64)m_count));
+	u64 seen = 0;
+	for (u32 i = 0; i < m_bins.size(); ++i)
+	{
+		seen += m_bins[i];
+		if (seen >= kRank)
+		{
+			// Nothing is above the maximum, so it bounds the bin the maximum is in, and is all the overflow bin has.
+			return i + 1 < m_bins.size() ? std::min((f32)(i + 1) * m_binWidthMs, m_maxMs) : m_maxMs;
+		}
+	}
+	return m_maxMs;
+}
+
+//================================================================================
+// Perf Stats
+//================================================================================
+
+PerfStats::PerfStats()
+	: m_historyNext(0)
+	, m_historyCount(0)
+	, m_frames(0)
+	, m_missedFrames(0)
+	, m_missedRefreshes(0)
+{
+	for (u32 i = 0; i < kNumPerfCounters; ++i)
+	{
+		m_pending[i].store(0, std::memory_order_relaxed);
+		m_last[i] = 0;
+		m_total[i] = 0;
+	}
+}
+
+PerfStats::~PerfStats()
+{
+	if (s_pCurrentPerfStats == this)
+	{
+		s_pCurrentPerfStats = nullptr;
+	}
+}
+
+void PerfStats::init(const PerfStatsDesc& desc)
+{
+	ASSERT(desc.refreshMs > 0.f && desc.historyFrames > 0);
+	m_desc = desc;
+	m_histogram.init(desc.histogramMaxMs, desc.histogramBins);
+	m_history.assign(desc.historyFrames, 0.f);
+	reset();
+}
+
+void PerfStats::reset()
+{
+	for (u32 i = 0; i < kNumPerfCounters; ++i)
+	{
+		m_pending[i].store(0, std::memory_order_relaxed);
+		m_last[i] = 0;
+		m_total[i] = 0;
+	}
+	m_histogram.reset();
+	std::fill(m_history.begin(), m_history.end(), 0.f);
+	m_historyNext = 0;
+	m_historyCount = 0;
+	m_frames = 0;
+	m_missedFrames = 0;
+	m_missedRefreshes = 0;
+}
+
+void PerfStats::end_frame(const f32 kFrameMs)
+{
+	ASSERT(!m_history.empty());
+
+	// A count added while this runs lands in one frame or the next, never neither.
+	for (u32 i = 0; i < kNumPerfCounters; ++i)
+	{
+		m_last[i] = m_pending[i].exchange(0, std::memory_order_relaxed);
+		m_total[i] += m_last[i];
+	}
+
+	m_frames++;
+	m_histogram.add(kFrameMs);
+	m_history[m_historyNext] = kFrameMs;
+	m_historyNext = (m_historyNext + 1) % (u32)m_history.size();
+	m_historyCount = std::min(m_historyCount + 1, (u32)m_history.size());
+
+	const f32 kRefreshes = kFrameMs / m_desc.refreshMs;
+	if (kRefreshes > 1.5f)
+	{
+		m_missedFrames++;
+		m_missedRefreshes += (u64)(kRefreshes + 0.5f) - 1;
+	}
+}
+
+f32 PerfStats::history(const u32 kIndex) const
+{
+	ASSERT(kIndex < m_historyCount);
+	const u32 kSize = (u32)m_history.size();
+	return m_history[(m_historyNext + kSize - m_historyCount + kIndex) % kSize];
+}
+
+std::string PerfStats::summary() const
+{
+	char line[256];
+	std::string text;
+	snprintf(line, sizeof(line), "Frames: %llu, mean %.2f ms, max %.2f ms\n", (unsigned long long)m_frames, m_histogram.mean_ms(), m_histogram.max_ms());
+	text += line;
+	snprintf(line, sizeof(line), "Frame time: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms\n", m_histogram.percentile(0.5f),
+		m_histogram.percentile(0.95f), m_histogram.percentile(0.99f));
+	text += line;
+	snprintf(line, sizeof(line), "Missed: %llu frames, %llu refreshes at %.2f ms\n", (unsigned long long)m_missedFrames,
+		(unsigned long long)m_missedRefreshes, m_desc.refreshMs);
+	text += line;
+	for (u32 i = 0; i < kNumPerfCounters; ++i)
+	{
+		snprintf(line, sizeof(line), "%s: %.1f per frame, %llu total\n", perf_counter_name((PerfCounter)i),
+			m_frames ? (f64)m_total[i] / (f64)m_frames : 0.0, (unsigned long long)m_total[i]);
+		text += line;
+	}
+	return text;
+}
+
+void set_current_perf_stats(PerfStats* pStats)
+{
+	s_pCurrentPerfStats = pStats;
+}
+
+PerfStats* current_perf_stats()
+{
+	return s_pCurrentPerfStats;
+}
+
+void perf_count(const PerfCounter counter, const u64 kValue)
+{
+	if (s_pCurrentPerfStats)
+	{
+		s_pCurrentPerfStats->add(counter, kValue);
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Per frame counts reported to the stats collector.
+enum class PerfCounter : u32
+{
+	kDrawCalls,
+	kMapCalls,
+	kTriangles,      // submitted by draws the CPU knows the size of, indirect draws aren't counted
+	kVisibleObjects,
+	kCulledObjects,
+	kTransformUpdates, // transforms recomputed because they or a parent moved
+	kCount
+};
+
+constexpr u32 kNumPerfCounters = (u32)PerfCounter::kCount;
+
+const char* perf_counter_name(const PerfCounter counter);
+
+//================================================================================
+// Frame Time Histogram
+// Fixed width bins from 0 to a maximum, one more for everything above it.
+// Sized at init, adding a time never allocates. Percentiles are accurate to
+// a bin width, the exact maximum is kept for times past the last bin.
+//================================================================================
+class FrameTimeHistogram
+{
+public:
+	FrameTimeHistogram();
+
+	void init(const f32 kMaxMs, const u32 kBins);
+	void reset();
+
+	void add(const f32 kMs);
+
+	// Upper edge of the bin the kFraction'th time falls in, 0 with no times.
+	f32 percentile(const f32 kFraction) const;
+
+	u64 count() const { return m_count; }
+	f32 mean_ms() const { return m_count ? (f32)(m_totalMs / (f64)m_count) : 0.f; }
+	f32 max_ms() const { return m_maxMs; }
+
+	// The last bin holds the times past kMaxMs.
+	u32 bins() const { return (u32)m_bins.size(); }
+	u64 bin(const u32 kIndex) const { return m_bins[kIndex]; }
+	f32 bin_width_ms() const { return m_binWidthMs; }
+
+private:
+	std::vector<u64> m_bins;
+	f32 m_binWidthMs;
+	u64 m_count;
+	f64 m_totalMs;
+	f32 m_maxMs;
+};
+
+struct PerfStatsDesc
+{
+	f32 refreshMs = 1000.f / 90.f; // the display's refresh interval, frames longer than it missed one
+	f32 histogramMaxMs = 50.f;
+	u32 histogramBins = 500;
+	u32 historyFrames = 256;       // frame times kept for plotting
+};
+
+//================================================================================
+// Perf Stats
+// Frame times and per frame counters for the performance HUD, or for a dump
+// when there is no HUD to show them.
+//
+// Counters are atomics any thread can add to without a lock, e.g. while
+// recording in parallel. end_frame() is called once per frame on the main
+// thread, it moves the counters into the frame's totals and feeds the frame
+// time to the histogram and the history ring. Nothing allocates after init.
+//
+// A frame missed the refresh when it took more than half an interval longer
+// than one, i.e. the compositor showed at least one refresh without it.
+//================================================================================
+class PerfStats
+{
+public:
+	PerfStats();
+	~PerfStats();
+
+	void init(const PerfStatsDesc& desc);
+
+	// Throw away everything collected, the desc is kept.
+	void reset();
+
+	void set_refresh_ms(const f32 kRefreshMs) { m_desc.refreshMs = kRefreshMs; }
+
+	void add(const PerfCounter counter, const u64 kValue)
+	{
+		m_pending[(u32)counter].fetch_add(kValue, std::memory_order_relaxed);
+	}
+
+	void end_frame(const f32 kFrameMs);
+
+	const PerfStatsDesc& desc() const { return m_desc; }
+	const FrameTimeHistogram& histogram() const { return m_histogram; }
+
+	// Newest last, history(0) is the oldest frame kept.
+	u32 history_count() const { return m_historyCount; }
+	f32 history(const u32 kIndex) const;
+
+	u64 frames() const { return m_frames; }
+	u64 missed_frames() const { return m_missedFrames; }
+	u64 missed_refreshes() const { return m_missedRefreshes; }
+
+	// Counts of the last frame ended, and summed over every frame.
+	u64 last(const PerfCounter counter) const { return m_last[(u32)counter]; }
+	u64 total(const PerfCounter counter) const { return m_total[(u32)counter]; }
+
+	// A few lines of text for stdout or a log, e.g. at exit when running headless.
+	std::string summary() const;
+
+private:
+	PerfStats(const PerfStats&) = delete;
+	PerfStats& operator=(const PerfStats&) = delete;
+
+	PerfStatsDesc m_desc;
+	std::atomic<u64> m_pending[kNumPerfCounters];
+	u64 m_last[kNumPerfCounters];
+	u64 m_total[kNumPerfCounters];
+
+	FrameTimeHistogram m_histogram;
+	std::vector<f32> m_history;
+	u32 m_historyNext;
+	u32 m_historyCount;
+
+	u64 m_frames;
+	u64 m_missedFrames;
+	u64 m_missedRefreshes;
+};
+
+// Stats the perf_count calls go to, may be null.
+void set_current_perf_stats(PerfStats* pStats);
+PerfStats* current_perf_stats();
+
+// Add to a counter of the current stats, if there are any.
+void perf_count(const PerfCounter counter, const u64 kValue);
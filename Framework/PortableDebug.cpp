@@ -0,0 +1,39 @@
+#include "CoreHeader.h"
+
+//================================================================================
+// Debug print functions for builds without the Windows framework, the tests
+// and benchmarks. Framework.cpp has the app's versions, these go to stderr
+// instead of the debugger and a message box.
+//================================================================================
+
+void errorF(const char * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	va_end(args);
+
+	// Default newline and flush (like std::endl)
+	std::fputc('\n', stderr);
+	std::fflush(stderr);
+}
+
+void panicF(const char * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	va_end(args);
+
+	std::fputc('\n', stderr);
+	std::fflush(stderr);
+	std::abort();
+}
+
+void debugF(const char * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	va_end(args);
+}
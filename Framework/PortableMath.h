@@ -0,0 +1,404 @@
+#pragma once
+
+//================================================================================
+// Portable Math
+// Stands in for DirectXMath and SimpleMath where the Windows SDK isn't
+// available, so the CPU only modules build and test on other platforms.
+//
+// Only the part of the SimpleMath interface those modules use is here, with
+// the same layouts and the same conventions as this repo's SimpleMath:
+// row vectors, and left handed projections (SIMPLE_MATHS_LEFT_HANDED).
+// Anything added has to give the same answer as the DirectXMath version.
+//================================================================================
+
+#include <cmath>
+#include <cstring>
+
+namespace DirectX
+{
+	struct XMFLOAT2
+	{
+		float x, y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+	};
+
+	struct XMFLOAT3X3
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13;
+				float _21, _22, _23;
+				float _31, _32, _33;
+			};
+			float m[3][3];
+		};
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: _11(m00), _12(m01), _13(m02), _14(m03)
+			, _21(m10), _22(m11), _23(m12), _24(m13)
+			, _31(m20), _32(m21), _33(m22), _34(m23)
+			, _41(m30), _42(m31), _43(m32), _44(m33)
+		{
+		}
+	};
+
+	namespace SimpleMath
+	{
+		struct Quaternion;
+		struct Matrix;
+
+		struct Vector2 : public XMFLOAT2
+		{
+			Vector2() : XMFLOAT2(0.f, 0.f) {}
+			explicit Vector2(float x) : XMFLOAT2(x, x) {}
+			Vector2(float _x, float _y) : XMFLOAT2(_x, _y) {}
+			Vector2(const XMFLOAT2& v) : XMFLOAT2(v) {}
+
+			bool operator==(const Vector2& v) const { return x == v.x && y == v.y; }
+			bool operator!=(const Vector2& v) const { return !(*this == v); }
+
+			Vector2& operator+=(const Vector2& v) { x += v.x; y += v.y; return *this; }
+			Vector2& operator-=(const Vector2& v) { x -= v.x; y -= v.y; return *this; }
+			Vector2& operator*=(float s) { x *= s; y *= s; return *this; }
+			Vector2& operator/=(float s) { x /= s; y /= s; return *this; }
+			Vector2 operator-() const { return Vector2(-x, -y); }
+
+			float Length() const { return std::sqrt(LengthSquared()); }
+			float LengthSquared() const { return x * x + y * y; }
+			float Dot(const Vector2& v) const { return x * v.x + y * v.y; }
+		};
+
+		inline Vector2 operator+(const Vector2& a, const Vector2& b) { return Vector2(a.x + b.x, a.y + b.y); }
+		inline Vector2 operator-(const Vector2& a, const Vector2& b) { return Vector2(a.x - b.x, a.y - b.y); }
+		inline Vector2 operator*(const Vector2& a, const Vector2& b) { return Vector2(a.x * b.x, a.y * b.y); }
+		inline Vector2 operator*(const Vector2& v, float s) { return Vector2(v.x * s, v.y * s); }
+		inline Vector2 operator*(float s, const Vector2& v) { return v * s; }
+		inline Vector2 operator/(const Vector2& v, float s) { return Vector2(v.x / s, v.y / s); }
+
+		struct Vector3 : public XMFLOAT3
+		{
+			Vector3() : XMFLOAT3(0.f, 0.f, 0.f) {}
+			explicit Vector3(float x) : XMFLOAT3(x, x, x) {}
+			Vector3(float _x, float _y, float _z) : XMFLOAT3(_x, _y, _z) {}
+			Vector3(const XMFLOAT3& v) : XMFLOAT3(v) {}
+
+			bool operator==(const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+			bool operator!=(const Vector3& v) const { return !(*this == v); }
+
+			Vector3& operator+=(const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+			Vector3& operator-=(const Vector3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+			Vector3& operator*=(const Vector3& v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
+			Vector3& operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+			Vector3& operator/=(float s) { x /= s; y /= s; z /= s; return *this; }
+			Vector3 operator-() const { return Vector3(-x, -y, -z); }
+
+			float Length() const { return std::sqrt(LengthSquared()); }
+			float LengthSquared() const { return x * x + y * y + z * z; }
+			float Dot(const Vector3& v) const { return x * v.x + y * v.y + z * v.z; }
+			Vector3 Cross(const Vector3& v) const { return Vector3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+
+			// Zero length stays zero, as XMVector3Normalize does for a zero vector.
+			void Normalize()
+			{
+				const float kLength = Length();
+				if (kLength > 0.f)
+				{
+					*this /= kLength;
+				}
+			}
+
+			static Vector3 Min(const Vector3& a, const Vector3& b) { return Vector3(std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z)); }
+			static Vector3 Max(const Vector3& a, const Vector3& b) { return Vector3(std::fmax(a.x, b.x), std::fmax(a.y, b.y), std::fmax(a.z, b.z)); }
+			static Vector3 Lerp(const Vector3& a, const Vector3& b, float t);
+			static float Distance(const Vector3& a, const Vector3& b);
+			static Vector3 Transform(const Vector3& v, const Quaternion& q);
+			static Vector3 Transform(const Vector3& v, const Matrix& m);
+
+			static const Vector3 Zero;
+			static const Vector3 One;
+			static const Vector3 UnitX;
+			static const Vector3 UnitY;
+			static const Vector3 UnitZ;
+		};
+
+		inline Vector3 operator+(const Vector3& a, const Vector3& b) { return Vector3(a.x + b.x, a.y + b.y, a.z + b.z); }
+		inline Vector3 operator-(const Vector3& a, const Vector3& b) { return Vector3(a.x - b.x, a.y - b.y, a.z - b.z); }
+		inline Vector3 operator*(const Vector3& a, const Vector3& b) { return Vector3(a.x * b.x, a.y * b.y, a.z * b.z); }
+		inline Vector3 operator*(const Vector3& v, float s) { return Vector3(v.x * s, v.y * s, v.z * s); }
+		inline Vector3 operator*(float s, const Vector3& v) { return v * s; }
+		inline Vector3 operator/(const Vector3& v, float s) { return Vector3(v.x / s, v.y / s, v.z / s); }
+
+		inline Vector3 Vector3::Lerp(const Vector3& a, const Vector3& b, float t) { return a + (b - a) * t; }
+		inline float Vector3::Distance(const Vector3& a, const Vector3& b) { return (b - a).Length(); }
+
+		struct Vector4 : public XMFLOAT4
+		{
+			Vector4() : XMFLOAT4(0.f, 0.f, 0.f, 0.f) {}
+			explicit Vector4(float x) : XMFLOAT4(x, x, x, x) {}
+			Vector4(float _x, float _y, float _z, float _w) : XMFLOAT4(_x, _y, _z, _w) {}
+			Vector4(const XMFLOAT4& v) : XMFLOAT4(v) {}
+
+			bool operator==(const Vector4& v) const { return x == v.x && y == v.y && z == v.z && w == v.w; }
+			bool operator!=(const Vector4& v) const { return !(*this == v); }
+
+			Vector4& operator+=(const Vector4& v) { x += v.x; y += v.y; z += v.z; w += v.w; return *this; }
+			Vector4& operator-=(const Vector4& v) { x -= v.x; y -= v.y; z -= v.z; w -= v.w; return *this; }
+			Vector4& operator*=(float s) { x *= s; y *= s; z *= s; w *= s; return *this; }
+			Vector4& operator/=(float s) { x /= s; y /= s; z /= s; w /= s; return *this; }
+			Vector4 operator-() const { return Vector4(-x, -y, -z, -w); }
+
+			float Length() const { return std::sqrt(LengthSquared()); }
+			float LengthSquared() const { return x * x + y * y + z * z + w * w; }
+			float Dot(const Vector4& v) const { return x * v.x + y * v.y + z * v.z + w * v.w; }
+
+			static Vector4 Transform(const Vector4& v, const Matrix& m);
+		};
+
+		inline Vector4 operator+(const Vector4& a, const Vector4& b) { return Vector4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); }
+		inline Vector4 operator-(const Vector4& a, const Vector4& b) { return Vector4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w); }
+		inline Vector4 operator*(const Vector4& v, float s) { return Vector4(v.x * s, v.y * s, v.z * s, v.w * s); }
+		inline Vector4 operator*(float s, const Vector4& v) { return v * s; }
+		inline Vector4 operator/(const Vector4& v, float s) { return Vector4(v.x / s, v.y / s, v.z / s, v.w / s); }
+
+		// XMQuaternion conventions, q1 * q2 rotates by q1 then by q2.
+		struct Quaternion : public XMFLOAT4
+		{
+			Quaternion() : XMFLOAT4(0.f, 0.f, 0.f, 1.f) {}
+			Quaternion(float _x, float _y, float _z, float _w) : XMFLOAT4(_x, _y, _z, _w) {}
+			Quaternion(const Vector3& v, float scalar) : XMFLOAT4(v.x, v.y, v.z, scalar) {}
+			Quaternion(const XMFLOAT4& q) : XMFLOAT4(q) {}
+
+			bool operator==(const Quaternion& q) const { return x == q.x && y == q.y && z == q.z && w == q.w; }
+			bool operator!=(const Quaternion& q) const { return !(*this == q); }
+
+			float Length() const { return std::sqrt(x * x + y * y + z * z + w * w); }
+
+			void Normalize()
+			{
+				const float kLength = Length();
+				if (kLength > 0.f)
+				{
+					x /= kLength; y /= kLength; z /= kLength; w /= kLength;
+				}
+			}
+
+			// Normalizes the axis, as XMQuaternionRotationAxis does.
+			static Quaternion CreateFromAxisAngle(const Vector3& axis, float angle)
+			{
+				Vector3 n = axis;
+				n.Normalize();
+				const float kSin = std::sin(0.5f * angle);
+				return Quaternion(n.x * kSin, n.y * kSin, n.z * kSin, std::cos(0.5f * angle));
+			}
+
+			// Roll about Z, then pitch about X, then yaw about Y.
+			static Quaternion CreateFromYawPitchRoll(float yaw, float pitch, float roll);
+
+			static const Quaternion Identity;
+		};
+
+		inline Quaternion operator*(const Quaternion& q1, const Quaternion& q2)
+		{
+			return Quaternion(
+				q2.w * q1.x + q2.x * q1.w + q2.y * q1.z - q2.z * q1.y,
+				q2.w * q1.y - q2.x * q1.z + q2.y * q1.w + q2.z * q1.x,
+				q2.w * q1.z + q2.x * q1.y - q2.y * q1.x + q2.z * q1.w,
+				q2.w * q1.w - q2.x * q1.x - q2.y * q1.y - q2.z * q1.z);
+		}
+
+		inline Quaternion Quaternion::CreateFromYawPitchRoll(float yaw, float pitch, float roll)
+		{
+			return CreateFromAxisAngle(Vector3(0.f, 0.f, 1.f), roll) * CreateFromAxisAngle(Vector3(1.f, 0.f, 0.f), pitch) * CreateFromAxisAngle(Vector3(0.f, 1.f, 0.f), yaw);
+		}
+
+		struct Matrix : public XMFLOAT4X4
+		{
+			Matrix() : XMFLOAT4X4(1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f) {}
+			Matrix(float m00, float m01, float m02, float m03,
+				float m10, float m11, float m12, float m13,
+				float m20, float m21, float m22, float m23,
+				float m30, float m31, float m32, float m33)
+				: XMFLOAT4X4(m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23, m30, m31, m32, m33) {}
+			Matrix(const XMFLOAT4X4& m) : XMFLOAT4X4(m) {}
+
+			bool operator==(const Matrix& m) const { return memcmp(this, &m, sizeof(Matrix)) == 0; }
+			bool operator!=(const Matrix& m) const { return !(*this == m); }
+
+			Matrix& operator*=(const Matrix& m);
+
+			Vector3 Translation() const { return Vector3(_41, _42, _43); }
+			void Translation(const Vector3& v) { _41 = v.x; _42 = v.y; _43 = v.z; }
+
+			Matrix Transpose() const
+			{
+				return Matrix(_11, _21, _31, _41, _12, _22, _32, _42, _13, _23, _33, _43, _14, _24, _34, _44);
+			}
+
+			static Matrix CreateTranslation(const Vector3& position) { return CreateTranslation(position.x, position.y, position.z); }
+			static Matrix CreateTranslation(float x, float y, float z)
+			{
+				Matrix m;
+				m._41 = x; m._42 = y; m._43 = z;
+				return m;
+			}
+
+			static Matrix CreateScale(const Vector3& scales) { return CreateScale(scales.x, scales.y, scales.z); }
+			static Matrix CreateScale(float xs, float ys, float zs)
+			{
+				Matrix m;
+				m._11 = xs; m._22 = ys; m._33 = zs;
+				return m;
+			}
+			static Matrix CreateScale(float scale) { return CreateScale(scale, scale, scale); }
+
+			static Matrix CreateRotationY(float radians)
+			{
+				const float kSin = std::sin(radians), kCos = std::cos(radians);
+				Matrix m;
+				m._11 = kCos; m._13 = -kSin;
+				m._31 = kSin; m._33 = kCos;
+				return m;
+			}
+
+			static Matrix CreateFromQuaternion(const Quaternion& q)
+			{
+				const float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+				const float xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+				const float xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+				const float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+				return Matrix(
+					1.f - (yy + zz), xy + wz, xz - wy, 0.f,
+					xy - wz, 1.f - (xx + zz), yz + wx, 0.f,
+					xz + wy, yz - wx, 1.f - (xx + yy), 0.f,
+					0.f, 0.f, 0.f, 1.f);
+			}
+
+			// XMMatrixPerspectiveOffCenterLH
+			static Matrix CreatePerspectiveOffCenter(float left, float right, float bottom, float top, float nearPlane, float farPlane)
+			{
+				const float kWidth = 1.f / (right - left);
+				const float kHeight = 1.f / (top - bottom);
+				const float kRange = farPlane / (farPlane - nearPlane);
+				return Matrix(
+					2.f * nearPlane * kWidth, 0.f, 0.f, 0.f,
+					0.f, 2.f * nearPlane * kHeight, 0.f, 0.f,
+					-(left + right) * kWidth, -(top + bottom) * kHeight, kRange, 1.f,
+					0.f, 0.f, -kRange * nearPlane, 0.f);
+			}
+
+			// XMMatrixPerspectiveFovLH
+			static Matrix CreatePerspectiveFieldOfView(float fov, float aspectRatio, float nearPlane, float farPlane)
+			{
+				const float kHeight = std::cos(0.5f * fov) / std::sin(0.5f * fov);
+				const float kRange = farPlane / (farPlane - nearPlane);
+				return Matrix(
+					kHeight / aspectRatio, 0.f, 0.f, 0.f,
+					0.f, kHeight, 0.f, 0.f,
+					0.f, 0.f, kRange, 1.f,
+					0.f, 0.f, -kRange * nearPlane, 0.f);
+			}
+
+			// XMMatrixLookAtLH
+			static Matrix CreateLookAt(const Vector3& eye, const Vector3& target, const Vector3& up)
+			{
+				Vector3 zAxis = target - eye;
+				zAxis.Normalize();
+				Vector3 xAxis = up.Cross(zAxis);
+				xAxis.Normalize();
+				const Vector3 yAxis = zAxis.Cross(xAxis);
+				return Matrix(
+					xAxis.x, yAxis.x, zAxis.x, 0.f,
+					xAxis.y, yAxis.y, zAxis.y, 0.f,
+					xAxis.z, yAxis.z, zAxis.z, 0.f,
+					-xAxis.Dot(eye), -yAxis.Dot(eye), -zAxis.Dot(eye), 1.f);
+			}
+
+			static const Matrix Identity;
+		};
+
+		inline Matrix operator*(const Matrix& a, const Matrix& b)
+		{
+			Matrix r;
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int col = 0; col < 4; ++col)
+				{
+					r.m[row][col] = a.m[row][0] * b.m[0][col] + a.m[row][1] * b.m[1][col] + a.m[row][2] * b.m[2][col] + a.m[row][3] * b.m[3][col];
+				}
+			}
+			return r;
+		}
+
+		inline Matrix& Matrix::operator*=(const Matrix& m)
+		{
+			*this = *this * m;
+			return *this;
+		}
+
+		// XMVector3Rotate
+		inline Vector3 Vector3::Transform(const Vector3& v, const Quaternion& q)
+		{
+			const Vector3 kAxis(q.x, q.y, q.z);
+			const Vector3 kT = kAxis.Cross(v) * 2.f;
+			return v + kT * q.w + kAxis.Cross(kT);
+		}
+
+		// XMVector3TransformCoord, w is divided out.
+		inline Vector3 Vector3::Transform(const Vector3& v, const Matrix& m)
+		{
+			const float kX = v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41;
+			const float kY = v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42;
+			const float kZ = v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43;
+			const float kW = v.x * m._14 + v.y * m._24 + v.z * m._34 + m._44;
+			return Vector3(kX / kW, kY / kW, kZ / kW);
+		}
+
+		inline Vector4 Vector4::Transform(const Vector4& v, const Matrix& m)
+		{
+			return Vector4(
+				v.x * m._11 + v.y * m._21 + v.z * m._31 + v.w * m._41,
+				v.x * m._12 + v.y * m._22 + v.z * m._32 + v.w * m._42,
+				v.x * m._13 + v.y * m._23 + v.z * m._33 + v.w * m._43,
+				v.x * m._14 + v.y * m._24 + v.z * m._34 + v.w * m._44);
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#include "PoseSource.h"
+#include "FrameLifecycle.h"
+
+namespace
+{
+	constexpr f64 kTwoPi = 6.283185307179586;
+}
+
+SyntheticPoseSource::SyntheticPoseSource(HmdInterface* pClock, const f32 kAmplitude, const f32 kFrequency)
+	: m_pClock(pClock)
+	, m_amplitude(kAmplitude)
+	, m_frequency(kFrequency)
+{
+	ASSERT(pClock);
+}
+
+f64 SyntheticPoseSource::yaw(const f64 kTime) const
+{
+	return m_amplitude * sin(kTwoPi * m_frequency * kTime);
+}
+
+PoseSample SyntheticPoseSource::pose_at_yaw(const f64 kYaw) const
+{
+	// The eyes turn about the middle of the head, the right eye is at +x before turning.
+	PoseSample pose;
+	const quat kOrientation = quat::CreateFromAxisAngle(v3::UnitY, (f32)kYaw);
+	const v3 kHead(0.f, kHeadHeight, 0.f);
+	for (u32 eye = 0; eye < 2; ++eye)
+	{
+		const v3 kOffset((eye == 0 ? -0.5f : 0.5f) * kEyeSeparation, 0.f, 0.f);
+		pose.eyes[eye].orientation = kOrientation;
+		pose.eyes[eye].position = kHead + v3::Transform(kOffset, kOrientation);
+	}
+	pose.sampleTime = 0.0;
+	pose.displayTime = 0.0;
+	return pose;
+}
+
+PoseSample SyntheticPoseSource::sample(const s64, const f64 kDisplayTime)
+{
+	// Constant rate extrapolation from now, a tracker doesn't know what the head does next.
+	const f64 kNow = m_pClock->time_seconds();
+	const f64 kRate = m_amplitude * kTwoPi * m_frequency * cos(kTwoPi * m_frequency * kNow);
+	PoseSample pose = pose_at_yaw(yaw(kNow) + kRate * (kDisplayTime - kNow));
+	pose.sampleTime = kNow;
+	pose.displayTime = kDisplayTime;
+	return pose;
+}
+
+PoseSample SyntheticPoseSource::true_pose(const f64 kTime) const
+{
+	PoseSample pose = pose_at_yaw(yaw(kTime));
+	pose.sampleTime = kTime;
+	pose.displayTime = kTime;
+	return pose;
+}
+
+f32 SyntheticPoseSource::max_angular_speed() const
+{
+	return m_amplitude * (f32)kTwoPi * m_frequency;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreHeader.h"
+
+class HmdInterface;
+
+// Where one eye is in tracking space, the same convention as an ovrPosef.
+struct EyePose
+{
+	quat orientation;
+	v3 position;
+};
+
+// Both eyes predicted for a display time, and when the prediction was made.
+struct PoseSample
+{
+	EyePose eyes[2];
+	f64 sampleTime;  // seconds on the HMD clock, goes to the layer's SensorSampleTime
+	f64 displayTime; // the time predicted for
+};
+
+//================================================================================
+// Pose Source
+// Predicts the eyes for a frame's display time. Sampling again later in the
+// frame gives a newer prediction over a shorter gap, which is what late
+// latching relies on.
+//================================================================================
+class PoseSource
+{
+public:
+	virtual ~PoseSource() {}
+
+	virtual PoseSample sample(const s64 kFrameIndex, const f64 kDisplayTime) = 0;
+};
+
+//================================================================================
+// Synthetic Pose Source
+// A head shaking side to side with no headset, timed by an HMD's clock.
+//
+// The yaw follows a sine. Predictions extrapolate the yaw and its rate at the
+// sample time out to the display time, like a tracker would, so the error of
+// a prediction grows with the gap it covers and true_pose() shows how far
+// off each sample was.
+//================================================================================
+class SyntheticPoseSource final : public PoseSource
+{
+public:
+	// kAmplitude radians either side, kFrequency shakes per second.
+	SyntheticPoseSource(HmdInterface* pClock, const f32 kAmplitude = 0.5f, const f32 kFrequency = 0.5f);
+
+	PoseSample sample(const s64 kFrameIndex, const f64 kDisplayTime) override;
+
+	// Where the eyes really are at kTime.
+	PoseSample true_pose(const f64 kTime) const;
+
+	// Fastest the head turns, radians per second.
+	f32 max_angular_speed() const;
+
+	static constexpr f32 kHeadHeight = 1.6f;
+	static constexpr f32 kEyeSeparation = 0.064f;
+
+private:
+	f64 yaw(const f64 kTime) const;
+	PoseSample pose_at_yaw(const f64 kYaw) const;
+
+	HmdInterface* m_pClock;
+	f32 m_amplitude;
+	f32 m_frequency;
+};
@@ -0,0 +1,351 @@
+#include "Profiler.h"
+#include "LogRing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	// Which buffer this thread records to, only valid while generation matches the profiler's.
+	struct ThreadBuffer
+	{
+		u64 generation;
+		ProfileBuffer* pBuffer;
+	};
+
+	thread_local ThreadBuffer s_threadBuffer = { 0, nullptr };
+
+	// Generations are shared by every profiler so a buffer can't match a profiler it didn't come from.
+	std::atomic<u64> s_nextGeneration(1);
+
+	Profiler* s_pCurrentProfiler = nullptr;
+
+	// Names are literals, only quotes and backslashes need escaping.
+	void write_json_string(std::ofstream& rFile, const char* pText)
+	{
+		rFile << '"';
+		for (const char* p = pText; *p; ++p)
+		{
+			if (*p == '"' || *p == '\\')
+			{
+				rFile << '\\';
+			}
+			rFile << *p;
+		}
+		rFile << '"';
+	}
+}
+
+s64 profiler_ticks()
+{
+	return (s64)std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+f64 profiler_ticks_to_ms(const s64 kTicks)
+{
+	return (f64)kTicks * 1000.0 * (f64)std::chrono::steady_clock::period::num / (f64)std::chrono::steady_clock::period::den;
+}
+
+//================================================================================
+// Profile Buffer
+//================================================================================
+
+ProfileBuffer::ProfileBuffer(const u32 kCapacity, const u32 kIndex)
+	: m_events(kCapacity)
+	, m_count(0)
+	, m_dropped(0)
+	, m_depth(0)
+	, m_index(kIndex)
+{
+	snprintf(m_name, sizeof(m_name), "Thread %u", kIndex);
+}
+
+void ProfileBuffer::reset()
+{
+	m_count.store(0, std::memory_order_relaxed);
+	m_dropped.store(0, std::memory_order_relaxed);
+}
+
+void ProfileBuffer::set_name(const char* pName)
+{
+	snprintf(m_name, sizeof(m_name), "%s", pName);
+}
+
+//================================================================================
+// Profiler
+//================================================================================
+
+Profiler::Profiler()
+	: m_generation(0)
+	, m_recording(false)
+	, m_recordingStart(0)
+	, m_captureFrames(0)
+	, m_capturedFrames(0)
+	, m_capturePending(false)
+{
+}
+
+Profiler::~Profiler()
+{
+	if (s_pCurrentProfiler == this)
+	{
+		s_pCurrentProfiler = nullptr;
+	}
+}
+
+void Profiler::init(const ProfilerDesc& desc)
+{
+	ASSERT(desc.eventsPerThread > 0);
+	m_desc = desc;
+	m_generation = s_nextGeneration++;
+	m_recording = false;
+	m_buffers.clear();
+	m_captureFrames = 0;
+	m_capturedFrames = 0;
+	m_capturePending = false;
+}
+
+void Profiler::begin_frame()
+{
+	if (recording() && m_captureFrames > 0 && ++m_capturedFrames >= m_captureFrames)
+	{
+		stop_recording();
+		m_captureFrames = 0;
+		if (!m_capturePath.empty())
+		{
+			// Logged from the frame loop, the path stays put until the next capture is asked for.
+			if (write_chrome_trace(m_capturePath.c_str()))
+			{
+				logF(LogLevel::kInfo, "Wrote %u frames of profile to %s", m_capturedFrames, m_capturePath.c_str());
+			}
+			else
+			{
+				logF(LogLevel::kError, "Failed to write profile to %s", m_capturePath.c_str());
+			}
+		}
+	}
+
+	if (m_capturePending)
+	{
+		m_capturePending = false;
+		m_capturedFrames = 0;
+		start_recording();
+	}
+}
+
+void Profiler::request_capture(const u32 kFrames, const char* pPath)
+{
+	ASSERT(kFrames > 0);
+	if (recording())
+	{
+		return;
+	}
+	m_captureFrames = kFrames;
+	m_capturePath = pPath ? pPath : "";
+	m_capturePending = true;
+}
+
+void Profiler::start_recording()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_bufferMutex);
+		for (const std::unique_ptr<ProfileBuffer>& pBuffer : m_buffers)
+		{
+			pBuffer->reset();
+		}
+	}
+	m_recordingStart = profiler_ticks();
+	m_recording.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stop_recording()
+{
+	m_recording.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::set_thread_name(const char* pName)
+{
+	thread_buffer()->set_name(pName);
+}
+
+ProfileBuffer* Profiler::thread_buffer()
+{
+	if (s_threadBuffer.generation == m_generation)
+	{
+		return s_threadBuffer.pBuffer;
+	}
+
+	// A thread's first scope, buffers live as long as the profiler so events outlive their thread.
+	ASSERT(m_generation != 0); // not initialised
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	m_buffers.push_back(std::unique_ptr<ProfileBuffer>(new ProfileBuffer(m_desc.eventsPerThread, (u32)m_buffers.size())));
+	s_threadBuffer.generation = m_generation;
+	s_threadBuffer.pBuffer = m_buffers.back().get();
+	return s_threadBuffer.pBuffer;
+}
+
+ProfileBuffer* Profiler::track(const char* pName)
+{
+	ASSERT(m_generation != 0); // not initialised
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	m_buffers.push_back(std::unique_ptr<ProfileBuffer>(new ProfileBuffer(m_desc.eventsPerThread, (u32)m_buffers.size())));
+	m_buffers.back()->set_name(pName);
+	return m_buffers.back().get();
+}
+
+bool Profiler::write_chrome_trace(const char* pPath) const
+{
+	ASSERT(!recording());
+	std::ofstream file(pPath, std::ios::out | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	// Microseconds from the start of recording, complete ("X") events nest by time on each track.
+	const f64 kTicksToUs = 1e6 * (f64)std::chrono::steady_clock::period::num / (f64)std::chrono::steady_clock::period::den;
+	char number[64];
+	bool first = true;
+	auto separator = [&file, &first]()
+	{
+		file << (first ? "\n" : ",\n");
+		first = false;
+	};
+
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (const std::unique_ptr<ProfileBuffer>& pBuffer : m_buffers)
+	{
+		separator();
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pBuffer->index() << ",\"args\":{\"name\":";
+		write_json_string(file, pBuffer->name());
+		file << "}}";
+		separator();
+		file << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pBuffer->index()
+			<< ",\"args\":{\"sort_index\":" << pBuffer->index() << "}}";
+
+		const u32 kCount = pBuffer->count();
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			const ProfileEvent& event = pBuffer->event(i);
+			separator();
+			file << "{\"name\":";
+			write_json_string(file, event.name);
+			snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", (f64)(event.start - m_recordingStart) * kTicksToUs,
+				(f64)(event.end - event.start) * kTicksToUs);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << pBuffer->index() << ",\"ts\":" << number
+				<< ",\"args\":{\"depth\":" << event.depth << "}}";
+		}
+	}
+	file << "\n]}\n";
+	return (bool)file;
+}
+
+std::vector<ProfilePhase> Profiler::phases() const
+{
+	ASSERT(!recording());
+	std::vector<ProfilePhase> phases;
+
+	// A handful of names, a linear search is fine. Names are compared by text, the same literal can have many addresses.
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	for (const std::unique_ptr<ProfileBuffer>& pBuffer : m_buffers)
+	{
+		const u32 kCount = pBuffer->count();
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			const ProfileEvent& event = pBuffer->event(i);
+			auto it = std::find_if(phases.begin(), phases.end(), [&event](const ProfilePhase& phase)
+			{
+				return phase.name == event.name || strcmp(phase.name, event.name) == 0;
+			});
+			if (it == phases.end())
+			{
+				phases.push_back({ event.name, 0, 0, 0 });
+				it = phases.end() - 1;
+			}
+			const s64 kTicks = event.end - event.start;
+			it->calls++;
+			it->totalTicks += kTicks;
+			it->maxTicks = std::max(it->maxTicks, kTicks);
+		}
+	}
+	return phases;
+}
+
+ProfilerStats Profiler::stats() const
+{
+	ProfilerStats stats = {};
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	for (const std::unique_ptr<ProfileBuffer>& pBuffer : m_buffers)
+	{
+		stats.events += pBuffer->count();
+		stats.dropped += pBuffer->dropped();
+	}
+	stats.threads = (u32)m_buffers.size();
+	stats.frames = m_capturedFrames;
+	stats.recording = recording();
+	return stats;
+}
+
+void set_current_profiler(Profiler* pProfiler)
+{
+	s_pCurrentProfiler = pProfiler;
+}
+
+Profiler* current_profiler()
+{
+	return s_pCurrentProfiler;
+}
+
+void profile_thread_name(const char* pName)
+{
+	if (s_pCurrentProfiler)
+	{
+		s_pCurrentProfiler->set_thread_name(pName);
+	}
+}
+
+//================================================================================
+// Benchmark
+//================================================================================
+
+ProfilerOverhead measure_profiler_overhead(const u32 kScopes)
+{
+	ASSERT(kScopes > 0);
+	ProfilerOverhead overhead = {};
+
+	// On a thread of its own, so the caller's thread keeps its buffer with the current profiler.
+	std::thread benchmark([&overhead, kScopes]()
+	{
+		ProfilerDesc desc;
+		desc.eventsPerThread = kScopes;
+		Profiler profiler;
+		profiler.init(desc);
+		profiler.thread_buffer();
+
+		const auto kIdleStart = std::chrono::high_resolution_clock::now();
+		for (u32 i = 0; i < kScopes; ++i)
+		{
+			ProfileScope scope(&profiler, "Idle");
+		}
+		const auto kIdleEnd = std::chrono::high_resolution_clock::now();
+
+		profiler.start_recording();
+		const auto kRecordStart = std::chrono::high_resolution_clock::now();
+		for (u32 i = 0; i < kScopes; ++i)
+		{
+			ProfileScope scope(&profiler, "Recording");
+		}
+		const auto kRecordEnd = std::chrono::high_resolution_clock::now();
+		profiler.stop_recording();
+
+		overhead.idleNs = std::chrono::duration<f64, std::nano>(kIdleEnd - kIdleStart).count() / kScopes;
+		overhead.recordingNs = std::chrono::duration<f64, std::nano>(kRecordEnd - kRecordStart).count() / kScopes;
+	});
+	benchmark.join();
+
+	return overhead;
+}
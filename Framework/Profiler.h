@@ -0,0 +1,233 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile every PROFILE_ macro out, the profiler itself still builds but records nothing.
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 1
+#endif
+
+// One closed scope, on the steady clock.
+struct ProfileEvent
+{
+	const char* name; // must outlive the capture, in practice a string literal
+	s64 start;
+	s64 end;
+	u32 depth;        // scopes open on the thread when this one opened
+};
+
+s64 profiler_ticks();
+f64 profiler_ticks_to_ms(const s64 kTicks);
+
+// Time spent under one scope name, summed over every thread.
+struct ProfilePhase
+{
+	const char* name;
+	u64 calls;
+	s64 totalTicks;
+	s64 maxTicks; // longest single call
+};
+
+//================================================================================
+// Profile Buffer
+// One thread's events for the current capture. Only the owning thread writes,
+// the count is published so a reader between frames sees whole events.
+//================================================================================
+class ProfileBuffer
+{
+public:
+	ProfileBuffer(const u32 kCapacity, const u32 kIndex);
+
+	u32 enter() { return m_depth++; }
+
+	void record(const char* name, const s64 kStart, const s64 kEnd, const u32 kDepth)
+	{
+		m_depth--;
+		add(name, kStart, kEnd, kDepth);
+	}
+
+	// An event timed elsewhere, for tracks not timed by scopes.
+	void add(const char* name, const s64 kStart, const s64 kEnd, const u32 kDepth)
+	{
+		const u32 kCount = m_count.load(std::memory_order_relaxed);
+		if (kCount >= m_events.size())
+		{
+			m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+		m_events[kCount] = { name, kStart, kEnd, kDepth };
+		m_count.store(kCount + 1, std::memory_order_release);
+	}
+
+	void reset();
+
+	u32 count() const { return m_count.load(std::memory_order_acquire); }
+	u32 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+	const ProfileEvent& event(const u32 kIndex) const { return m_events[kIndex]; }
+	u32 index() const { return m_index; }
+
+	void set_name(const char* pName);
+	const char* name() const { return m_name; }
+
+private:
+	std::vector<ProfileEvent> m_events;
+	std::atomic<u32> m_count;
+	std::atomic<u32> m_dropped;
+	u32 m_depth;
+	u32 m_index; // the thread's track in a trace
+	char m_name[32];
+};
+
+struct ProfilerDesc
+{
+	u32 eventsPerThread = 64 * 1024; // per capture, more are dropped and counted
+};
+
+struct ProfilerStats
+{
+	u32 threads;
+	u64 events;   // recorded in the current or last capture
+	u64 dropped;  // events that didn't fit a thread's buffer
+	u32 frames;   // frames captured so far
+	bool recording;
+};
+
+//================================================================================
+// Profiler
+// Hierarchical scoped markers, exported as Chrome trace event JSON for
+// chrome://tracing or Perfetto.
+//
+// Scopes cost one flag check while nothing is being captured. During a
+// capture a scope reads the clock twice and writes one event to its thread's
+// buffer, no locking or allocation once the thread has a buffer. Buffers are
+// sized up front and don't wrap, a capture that overflows one drops the rest
+// of that thread's events.
+//
+// Captures start and finish in begin_frame(), which has to be called between
+// frames on the main thread while no other thread is inside a scope.
+//================================================================================
+class Profiler
+{
+public:
+	Profiler();
+	~Profiler();
+
+	void init(const ProfilerDesc& desc);
+
+	// Frame boundary. Starts a requested capture, or finishes one that has its frames and writes it out.
+	void begin_frame();
+
+	// Capture the next kFrames frames, then write them as a Chrome trace to pPath.
+	void request_capture(const u32 kFrames, const char* pPath);
+
+	// Record or stop recording directly, begin_frame() does both for captures.
+	void start_recording();
+	void stop_recording();
+	bool recording() const { return m_recording.load(std::memory_order_relaxed); }
+
+	// Name the calling thread's track.
+	void set_thread_name(const char* pName);
+
+	// The calling thread's buffer, made on its first call.
+	ProfileBuffer* thread_buffer();
+
+	// A named track not tied to a thread, e.g. the GPU's, events are add()ed to it from one thread at a time.
+	ProfileBuffer* track(const char* pName);
+
+	// When recording last started, events before it belong to no capture.
+	s64 recording_start() const { return m_recordingStart; }
+
+	// Write everything recorded since recording last started. Not while recording.
+	bool write_chrome_trace(const char* pPath) const;
+
+	// Totals per scope name of everything recorded, in the order the names were first seen. Not while recording.
+	std::vector<ProfilePhase> phases() const;
+
+	ProfilerStats stats() const;
+
+private:
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	ProfilerDesc m_desc;
+	u64 m_generation; // unique across inits, tells a thread its buffer is stale
+	std::atomic<bool> m_recording;
+	s64 m_recordingStart;
+
+	mutable std::mutex m_bufferMutex; // taken to hand a thread its buffer, not to record
+	std::vector<std::unique_ptr<ProfileBuffer>> m_buffers;
+
+	u32 m_captureFrames;   // frames the pending or running capture wants, 0 for none
+	u32 m_capturedFrames;
+	bool m_capturePending;
+	std::string m_capturePath;
+};
+
+// Profiler used by the PROFILE_ macros, may be null.
+void set_current_profiler(Profiler* pProfiler);
+Profiler* current_profiler();
+
+//================================================================================
+// Profile Scope
+// Records the time from construction to destruction, if the profiler was
+// recording when it opened.
+//================================================================================
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler* pProfiler, const char* name)
+		: m_pBuffer(nullptr)
+	{
+		if (pProfiler && pProfiler->recording())
+		{
+			m_pBuffer = pProfiler->thread_buffer();
+			m_name = name;
+			m_depth = m_pBuffer->enter();
+			m_start = profiler_ticks();
+		}
+	}
+
+	~ProfileScope()
+	{
+		if (m_pBuffer)
+		{
+			m_pBuffer->record(m_name, m_start, profiler_ticks(), m_depth);
+		}
+	}
+
+private:
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+	ProfileBuffer* m_pBuffer;
+	const char* m_name;
+	s64 m_start;
+	u32 m_depth;
+};
+
+// Name the calling thread's track in the current profiler, if there is one.
+void profile_thread_name(const char* pName);
+
+#if ENABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(current_profiler(), name)
+#define PROFILE_THREAD(name) profile_thread_name(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+struct ProfilerOverhead
+{
+	f64 idleNs;      // per scope while not recording
+	f64 recordingNs; // per scope while recording
+};
+
+// Time kScopes empty scopes on a profiler of its own, idle and recording.
+ProfilerOverhead measure_profiler_overhead(const u32 kScopes);
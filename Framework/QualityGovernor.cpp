@@ -0,0 +1,157 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+
+namespace
+{
+	// Each level a little cheaper than the last. Pixels go first as they cost the
+	// most, shading goes late as it is the most visible.
+	const QualityLevel kDefaultLevels[] =
+	{
+		{ 1.0f, 0.f, ShaderTier::kNormalMapped },
+		{ 0.9f, 0.f, ShaderTier::kNormalMapped },
+		{ 0.8f, 0.f, ShaderTier::kNormalMapped },
+		{ 0.8f, 1.f, ShaderTier::kNormalMapped },
+		{ 0.7f, 1.f, ShaderTier::kNormalMapped },
+		{ 0.7f, 1.f, ShaderTier::kVertexNormal },
+		{ 0.6f, 2.f, ShaderTier::kVertexNormal },
+	};
+}
+
+QualityGovernor::QualityGovernor()
+	: m_level(0)
+	, m_overFrames(0)
+	, m_raiseFrames(0)
+	, m_historyNext(0)
+	, m_historyCount(0)
+	, m_stats()
+{
+}
+
+void QualityGovernor::init(const QualityGovernorDesc& desc)
+{
+	init(desc, kDefaultLevels, sizeof(kDefaultLevels) / sizeof(kDefaultLevels[0]));
+}
+
+void QualityGovernor::init(const QualityGovernorDesc& desc, const QualityLevel* pLevels, const u32 kNumLevels)
+{
+	ASSERT(kNumLevels > 0);
+	ASSERT(desc.dropFrames > 0 && desc.raiseFrames > 0 && desc.raiseFrames <= desc.maxRaiseFrames);
+	ASSERT(desc.raiseThreshold < desc.dropThreshold);
+
+	m_desc = desc;
+	m_levels.assign(pLevels, pLevels + kNumLevels);
+	m_cpuHistory.resize(desc.maxRaiseFrames);
+	m_gpuHistory.resize(desc.maxRaiseFrames);
+	m_sorted.reserve(desc.maxRaiseFrames);
+	reset();
+}
+
+void QualityGovernor::reset()
+{
+	m_level = 0;
+	m_overFrames = 0;
+	m_raiseFrames = m_desc.raiseFrames;
+	m_historyNext = 0;
+	m_historyCount = 0;
+	m_stats = {};
+	m_stats.raiseFrames = m_raiseFrames;
+	m_stats.lastChange = QualityDecision::kHold;
+}
+
+QualityDecision QualityGovernor::update(const FrameTiming& timing)
+{
+	ASSERT(!m_levels.empty());
+	m_stats.frames++;
+
+	m_cpuHistory[m_historyNext] = timing.cpuMs;
+	m_gpuHistory[m_historyNext] = timing.gpuMs;
+	m_historyNext = (m_historyNext + 1) % m_desc.maxRaiseFrames;
+	m_historyCount = std::min(m_historyCount + 1, m_desc.maxRaiseFrames);
+
+	const bool kCpuOver = timing.cpuMs > m_desc.budgetMs;
+	const bool kGpuOver = timing.gpuMs > m_desc.budgetMs;
+	if (kCpuOver || kGpuOver)
+	{
+		m_stats.overBudgetFrames++;
+	}
+	m_overFrames = timing.gpuMs > m_desc.budgetMs * m_desc.dropThreshold ? m_overFrames + 1 : 0;
+
+	// Only the newest raise wait's worth counts, older frames could be from before a failed raise grew it.
+	const u32 kWindow = std::min(m_historyCount, m_raiseFrames);
+	m_stats.cpuPercentileMs = percentile(m_cpuHistory, kWindow);
+	m_stats.gpuPercentileMs = percentile(m_gpuHistory, kWindow);
+
+	if (m_overFrames >= m_desc.dropFrames && m_level + 1 < num_levels())
+	{
+		change_level(m_level + 1, QualityDecision::kDrop);
+		return QualityDecision::kDrop;
+	}
+
+	if (kCpuOver && !kGpuOver)
+	{
+		m_stats.cpuBoundFrames++;
+		return QualityDecision::kCpuBound;
+	}
+
+	// Raising while frames are missed on the CPU would only hide what is wrong.
+	if (m_level > 0 && kWindow >= m_raiseFrames
+		&& m_stats.gpuPercentileMs < m_desc.budgetMs * m_desc.raiseThreshold
+		&& m_stats.cpuPercentileMs <= m_desc.budgetMs)
+	{
+		change_level(m_level - 1, QualityDecision::kRaise);
+		return QualityDecision::kRaise;
+	}
+
+	return QualityDecision::kHold;
+}
+
+void QualityGovernor::change_level(const u32 kLevel, const QualityDecision decision)
+{
+	if (decision == QualityDecision::kDrop)
+	{
+		if (m_stats.lastChange == QualityDecision::kRaise && m_stats.frames - m_stats.lastChangeFrame <= m_raiseFrames)
+		{
+			// The level above couldn't hold, wait longer before trying it again.
+			m_stats.failedRaises++;
+			m_raiseFrames = std::min(m_raiseFrames * 2, m_desc.maxRaiseFrames);
+		}
+		else
+		{
+			// The load changed under a level that was holding, what was learnt about the levels above is stale.
+			m_raiseFrames = m_desc.raiseFrames;
+		}
+		m_stats.drops++;
+	}
+	else
+	{
+		m_stats.raises++;
+	}
+
+	m_level = kLevel;
+	m_overFrames = 0;
+	m_historyCount = 0;
+
+	m_stats.level = kLevel;
+	m_stats.raiseFrames = m_raiseFrames;
+	m_stats.lastChangeFrame = m_stats.frames;
+	m_stats.lastChange = decision;
+}
+
+f32 QualityGovernor::percentile(const std::vector<f32>& history, const u32 kCount)
+{
+	if (kCount == 0)
+	{
+		return 0.f;
+	}
+
+	m_sorted.clear();
+	const u32 kSize = (u32)history.size();
+	for (u32 i = 0; i < kCount; ++i)
+	{
+		m_sorted.push_back(history[(m_historyNext + kSize - kCount + i) % kSize]);
+	}
+
+	const u32 kIndex = (u32)(m_desc.raisePercentile * (f32)(kCount - 1));
+	std::nth_element(m_sorted.begin(), m_sorted.begin() + kIndex, m_sorted.end());
+	return m_sorted[kIndex];
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+// Mesh pixel shading, cheapest first.
+enum class ShaderTier
+{
+	kVertexNormal, // lit with the interpolated normal, the normal map isn't sampled
+	kNormalMapped,
+};
+
+constexpr u32 kNumShaderTiers = 2;
+
+// One step of the quality ladder, every knob the governor turns.
+struct QualityLevel
+{
+	f32 viewportScale; // eye viewport width and height, as a fraction of the allocated eye texture
+	f32 lodBias;       // levels of detail coarser, each doubles the pixel error allowed
+	ShaderTier shaderTier;
+};
+
+// Milliseconds the app spent on one frame, measured however the caller likes.
+struct FrameTiming
+{
+	f32 cpuMs;
+	f32 gpuMs;
+};
+
+enum class QualityDecision
+{
+	kHold,
+	kDrop,     // GPU time over the drop threshold for long enough, one level cheaper
+	kRaise,    // GPU time under the raise threshold for long enough, one level better
+	kCpuBound, // over budget on the CPU only, the knobs can't help so nothing changes
+};
+
+struct QualityGovernorDesc
+{
+	f32 budgetMs = 1000.f / 90.f; // frame budget, 90 Hz
+	f32 dropThreshold = 0.9f;     // fraction of the budget, GPU frames above it count towards a drop
+	f32 raiseThreshold = 0.7f;    // fraction of the budget the percentile must stay under to raise
+	f32 raisePercentile = 0.9f;   // of the GPU times since the last change
+	u32 dropFrames = 4;           // consecutive frames over before dropping
+	u32 raiseFrames = 90;         // frames at a level before a raise is considered
+	u32 maxRaiseFrames = 1440;    // the raise wait doubles up to this each time a raise drops straight back
+};
+
+struct QualityGovernorStats
+{
+	u32 frames;
+	u32 level;            // 0 is the best level
+	u32 drops;
+	u32 raises;
+	u32 failedRaises;     // raises dropped again within one raise wait
+	u32 overBudgetFrames; // CPU or GPU over the budget
+	u32 cpuBoundFrames;   // CPU over the budget while the GPU wasn't
+	u32 raiseFrames;      // current wait before raising
+	u32 lastChangeFrame;
+	QualityDecision lastChange;
+	f32 cpuPercentileMs;  // raise percentile of the frames since the last change
+	f32 gpuPercentileMs;
+};
+
+//================================================================================
+// Quality Governor
+// Trades image quality for frame time when the GPU runs out of headroom.
+//
+// The knobs live on a ladder of levels, best first, each one cheaper on the
+// GPU than the one before. A run of GPU frames over the drop threshold steps
+// one level down. Stepping back up needs a whole raise wait at the level with
+// the GPU percentile under the lower raise threshold, and the gap between the
+// two thresholds is the hysteresis. A raise that drops straight back doubles
+// the wait, so a level that can't hold doesn't flicker in and out. Frames only
+// count towards a decision after the last change, they say nothing about the
+// new level otherwise.
+//
+// None of the knobs save CPU time, so a frame over budget on the CPU alone
+// never drops a level, it holds instead.
+//
+// update() is the whole control loop, it reads nothing but its arguments, so
+// replaying a recorded trace of frame times gives the same decisions on any
+// machine, with or without a headset.
+//================================================================================
+class QualityGovernor
+{
+public:
+	QualityGovernor();
+
+	// The default ladder, from full quality down to roughly a third of the pixels at the cheapest shading.
+	void init(const QualityGovernorDesc& desc);
+
+	// pLevels best first, copied.
+	void init(const QualityGovernorDesc& desc, const QualityLevel* pLevels, const u32 kNumLevels);
+
+	// Start over at the best level with no history.
+	void reset();
+
+	// Feed one frame, returns what the governor did about it.
+	QualityDecision update(const FrameTiming& timing);
+
+	const QualityLevel& level() const { return m_levels[m_level]; }
+	u32 level_index() const { return m_level; }
+	u32 num_levels() const { return (u32)m_levels.size(); }
+	const QualityGovernorDesc& desc() const { return m_desc; }
+	const QualityGovernorStats& stats() const { return m_stats; }
+
+private:
+	void change_level(const u32 kLevel, const QualityDecision decision);
+
+	// Raise percentile of the newest kCount entries of a history ring.
+	f32 percentile(const std::vector<f32>& history, const u32 kCount);
+
+	QualityGovernorDesc m_desc;
+	std::vector<QualityLevel> m_levels;
+	u32 m_level;
+	u32 m_overFrames;      // consecutive GPU frames over the drop threshold
+	u32 m_raiseFrames;     // wait before raising
+
+	// Rings of the times since the last change, room for the longest raise wait.
+	std::vector<f32> m_cpuHistory;
+	std::vector<f32> m_gpuHistory;
+	u32 m_historyNext;
+	u32 m_historyCount;
+	std::vector<f32> m_sorted; // scratch for the percentile
+
+	QualityGovernorStats m_stats;
+};
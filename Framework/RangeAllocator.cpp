@@ -0,0 +1,124 @@
+#include "RangeAllocator.h"
+
+RangeAllocator::RangeAllocator()
+	: m_capacity(0)
+	, m_used(0)
+	, m_allocations(0)
+	, m_failures(0)
+{
+}
+
+void RangeAllocator::init(const u32 kCapacity)
+{
+	m_capacity = kCapacity;
+	m_used = 0;
+	m_allocations = 0;
+	m_failures = 0;
+	m_free.clear();
+	if (kCapacity > 0)
+	{
+		m_free.push_back({ 0, kCapacity });
+	}
+}
+
+u32 RangeAllocator::allocate(const u32 kSize)
+{
+	// Best fit, the smallest range that holds it leaves the big ones for big meshes.
+	u32 best = (u32)m_free.size();
+	for (u32 i = 0; i < m_free.size(); ++i)
+	{
+		if (m_free[i].size >= kSize && (best == m_free.size() || m_free[i].size < m_free[best].size))
+		{
+			best = i;
+			if (m_free[i].size == kSize)
+			{
+				break;
+			}
+		}
+	}
+
+	if (kSize == 0 || best == m_free.size())
+	{
+		m_failures++;
+		return kInvalidOffset;
+	}
+
+	// Take it from the front of the range, an exact fit removes the range.
+	FreeRange& rRange = m_free[best];
+	const u32 kOffset = rRange.offset;
+	rRange.offset += kSize;
+	rRange.size -= kSize;
+	if (rRange.size == 0)
+	{
+		m_free.erase(m_free.begin() + best);
+	}
+
+	m_used += kSize;
+	m_allocations++;
+	return kOffset;
+}
+
+void RangeAllocator::free(const u32 kOffset, const u32 kSize)
+{
+	ASSERT(kSize > 0 && kOffset + kSize <= m_capacity);
+	ASSERT(m_allocations > 0 && m_used >= kSize);
+
+	// First free range after the allocation.
+	u32 next = 0;
+	while (next < m_free.size() && m_free[next].offset < kOffset)
+	{
+		++next;
+	}
+	ASSERT(next == m_free.size() || kOffset + kSize <= m_free[next].offset);
+	ASSERT(next == 0 || m_free[next - 1].offset + m_free[next - 1].size <= kOffset);
+
+	const bool kJoinsPrev = next > 0 && m_free[next - 1].offset + m_free[next - 1].size == kOffset;
+	const bool kJoinsNext = next < m_free.size() && kOffset + kSize == m_free[next].offset;
+
+	if (kJoinsPrev && kJoinsNext)
+	{
+		m_free[next - 1].size += kSize + m_free[next].size;
+		m_free.erase(m_free.begin() + next);
+	}
+	else if (kJoinsPrev)
+	{
+		m_free[next - 1].size += kSize;
+	}
+	else if (kJoinsNext)
+	{
+		m_free[next].offset = kOffset;
+		m_free[next].size += kSize;
+	}
+	else
+	{
+		m_free.insert(m_free.begin() + next, { kOffset, kSize });
+	}
+
+	m_used -= kSize;
+	m_allocations--;
+}
+
+u32 RangeAllocator::largest_free() const
+{
+	u32 largest = 0;
+	for (const FreeRange& range : m_free)
+	{
+		largest = std::max(largest, range.size);
+	}
+	return largest;
+}
+
+RangeAllocatorStats RangeAllocator::stats() const
+{
+	RangeAllocatorStats stats;
+	stats.capacity = m_capacity;
+	stats.used = m_used;
+	stats.allocations = m_allocations;
+	stats.freeRanges = (u32)m_free.size();
+	stats.largestFree = largest_free();
+	stats.failures = m_failures;
+
+	const u32 kFree = m_capacity - m_used;
+	stats.fragmentation = kFree > 0 ? 1.f - (f32)stats.largestFree / (f32)kFree : 0.f;
+	return stats;
+}
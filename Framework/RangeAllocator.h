@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+struct RangeAllocatorStats
+{
+	u32 capacity;
+	u32 used;
+	u32 allocations;  // live allocations
+	u32 freeRanges;
+	u32 largestFree;
+	u32 failures;     // allocations that found no free range large enough
+	f32 fragmentation; // 1 - largest free range / free space, 0 when the free space is one range
+};
+
+//================================================================================
+// Range Allocator
+// Best fit suballocation of a fixed size range that can be freed in any order.
+// Free ranges are kept sorted by offset and merged with their neighbours when
+// an allocation is handed back. Holds no memory itself, offsets and sizes are
+// in whatever unit the caller uses (vertices, indices) so it can be checked
+// without a device.
+//================================================================================
+class RangeAllocator
+{
+public:
+	static constexpr u32 kInvalidOffset = 0xFFFFFFFF;
+
+	RangeAllocator();
+
+	void init(const u32 kCapacity);
+
+	// Offset of kSize units, kInvalidOffset when no free range is large enough.
+	u32 allocate(const u32 kSize);
+
+	// Give back an allocation, kOffset and kSize as it was made.
+	void free(const u32 kOffset, const u32 kSize);
+
+	u32 capacity() const { return m_capacity; }
+	u32 used() const { return m_used; }
+	u32 allocations() const { return m_allocations; }
+	u32 free_ranges() const { return (u32)m_free.size(); }
+	u32 largest_free() const;
+
+	RangeAllocatorStats stats() const;
+
+private:
+	struct FreeRange
+	{
+		u32 offset;
+		u32 size;
+	};
+
+	std::vector<FreeRange> m_free; // sorted by offset, never touching each other
+	u32 m_capacity;
+	u32 m_used;
+	u32 m_allocations;
+	u32 m_failures;
+};
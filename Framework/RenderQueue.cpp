@@ -0,0 +1,152 @@
+#include "RenderQueue.h"
+
+RenderQueue::RenderQueue()
+	: m_depthNear(0.f)
+	, m_depthScale(0.f)
+	, m_stats{}
+{
+	set_depth_range(0.1f, 100.f);
+}
+
+void RenderQueue::reset()
+{
+	m_packets.clear();
+	m_sorted.clear();
+	m_stats = {};
+}
+
+void RenderQueue::set_depth_range(const f32 kNear, const f32 kFar)
+{
+	ASSERT(kFar > kNear);
+	m_depthNear = kNear;
+	m_depthScale = (f32)((1u << kDepthBits) - 1) / (kFar - kNear);
+}
+
+void RenderQueue::push(const DrawPacket& rPacket, const f32 kViewDepth)
+{
+	SortEntry entry;
+	entry.key = make_key(
+		shader_id(rPacket.pShader),
+		material_id(rPacket.pDiffuse, rPacket.pNormal),
+		mesh_id(rPacket.pMesh),
+		quantize_depth(kViewDepth));
+	entry.index = (u32)m_packets.size();
+
+	m_packets.push_back(rPacket);
+	m_sorted.push_back(entry);
+}
+
+void RenderQueue::sort()
+{
+	const u32 kCount = (u32)m_sorted.size();
+	m_scratch.resize(kCount);
+	if (kCount == 0)
+	{
+		return;
+	}
+
+	SortEntry* pResult = radix_sort_u64(m_sorted.data(), m_scratch.data(), kCount);
+	if (pResult != m_sorted.data())
+	{
+		m_sorted.swap(m_scratch);
+	}
+}
+
+void RenderQueue::submit(RenderQueueBackend& rBackend)
+{
+	submit_range(rBackend, 0, (u32)m_sorted.size(), m_stats);
+}
+
+void RenderQueue::submit_range(RenderQueueBackend& rBackend, const u32 kFirst, const u32 kCount, RenderQueueStats& rStats) const
+{
+	ASSERT(kFirst + kCount <= m_sorted.size());
+	rBackend.begin_submit(*this, kFirst, kCount);
+
+	const ShaderSet* pShader = nullptr;
+	const Texture* pDiffuse = nullptr;
+	const Texture* pNormal = nullptr;
+	const Mesh* pMesh = nullptr;
+
+	for (u32 i = kFirst; i < kFirst + kCount; ++i)
+	{
+		const DrawPacket& packet = m_packets[m_sorted[i].index];
+
+		if (packet.pShader != pShader)
+		{
+			pShader = packet.pShader;
+			rBackend.bind_shader(pShader);
+			rStats.shaderChanges++;
+		}
+
+		if (packet.pDiffuse != pDiffuse || packet.pNormal != pNormal)
+		{
+			pDiffuse = packet.pDiffuse;
+			pNormal = packet.pNormal;
+			rBackend.bind_material(pDiffuse, pNormal);
+			rStats.materialChanges++;
+		}
+
+		if (packet.pMesh != pMesh)
+		{
+			pMesh = packet.pMesh;
+			rBackend.bind_mesh(pMesh);
+			rStats.meshChanges++;
+		}
+
+		rBackend.draw(packet);
+		rStats.packets++;
+	}
+}
+
+u64 RenderQueue::make_key(const u32 kShader, const u32 kMaterial, const u32 kMesh, const u32 kDepth)
+{
+	ASSERT(kShader < (1u << kShaderBits));
+	ASSERT(kMaterial < (1u << kMaterialBits));
+	ASSERT(kMesh < (1u << kMeshBits));
+	ASSERT(kDepth < (1u << kDepthBits));
+
+	return ((u64)kShader << (kMaterialBits + kMeshBits + kDepthBits))
+		| ((u64)kMaterial << (kMeshBits + kDepthBits))
+		| ((u64)kMesh << kDepthBits)
+		| (u64)kDepth;
+}
+
+u32 RenderQueue::quantize_depth(const f32 kViewDepth) const
+{
+	const f32 kMax = (f32)((1u << kDepthBits) - 1);
+	const f32 scaled = (kViewDepth - m_depthNear) * m_depthScale;
+	return (u32)std::min(std::max(scaled, 0.f), kMax);
+}
+
+u32 RenderQueue::shader_id(const ShaderSet* pShader)
+{
+	for (u32 i = 0; i < m_shaders.size(); ++i)
+	{
+		if (m_shaders[i] == pShader)
+			return i;
+	}
+	m_shaders.push_back(pShader);
+	return (u32)m_shaders.size() - 1;
+}
+
+u32 RenderQueue::material_id(const Texture* pDiffuse, const Texture* pNormal)
+{
+	for (u32 i = 0; i < m_materials.size(); ++i)
+	{
+		if (m_materials[i].first == pDiffuse && m_materials[i].second == pNormal)
+			return i;
+	}
+	m_materials.push_back(std::make_pair(pDiffuse, pNormal));
+	return (u32)m_materials.size() - 1;
+}
+
+u32 RenderQueue::mesh_id(const Mesh* pMesh)
+{
+	for (u32 i = 0; i < m_meshes.size(); ++i)
+	{
+		if (m_meshes[i] == pMesh)
+			return i;
+	}
+	m_meshes.push_back(pMesh);
+	return (u32)m_meshes.size() - 1;
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+struct ShaderSet;
+class Mesh;
+class Texture;
+class RenderQueue;
+
+//================================================================================
+// Draw Packet
+// Everything needed to draw one object with the mesh shaders.
+//================================================================================
+struct DrawPacket
+{
+	const ShaderSet* pShader;
+	const Mesh* pMesh;
+	const Texture* pDiffuse;
+	const Texture* pNormal;
+	m4x4 matWorld;
+	u32 tileFactor;
+	u32 lod; // level of detail of pMesh to draw
+};
+
+//================================================================================
+// Render Queue Backend
+// Receives the sorted stream from a RenderQueue.
+// Bind calls are only made when the state actually changes.
+//================================================================================
+class RenderQueueBackend
+{
+public:
+	virtual ~RenderQueueBackend() {}
+
+	// Called once before the packets of a submit, with the sorted range about to be drawn.
+	// Lets a backend prepare per draw data for the whole range up front.
+	virtual void begin_submit(const RenderQueue& /*rQueue*/, const u32 /*kFirst*/, const u32 /*kCount*/) {}
+
+	virtual void bind_shader(const ShaderSet* pShader) = 0;
+	virtual void bind_material(const Texture* pDiffuse, const Texture* pNormal) = 0;
+	virtual void bind_mesh(const Mesh* pMesh) = 0;
+	virtual void draw(const DrawPacket& rPacket) = 0;
+};
+
+struct RenderQueueStats
+{
+	u32 packets;
+	u32 shaderChanges;
+	u32 materialChanges;
+	u32 meshChanges;
+};
+
+//================================================================================
+// Render Queue
+// Collects draw packets for a frame, orders them by a packed 64 bit key and
+// submits them to a backend.
+//
+// Key layout (most significant first):
+//   [63..56] shader   (8 bits)
+//   [55..40] material (16 bits)
+//   [39..24] mesh     (16 bits)
+//   [23..0]  depth    (24 bits, front to back)
+//================================================================================
+class RenderQueue
+{
+public:
+	static constexpr u32 kShaderBits = 8;
+	static constexpr u32 kMaterialBits = 16;
+	static constexpr u32 kMeshBits = 16;
+	static constexpr u32 kDepthBits = 24;
+
+	RenderQueue();
+
+	// Clear the packets for a new frame, object ids are kept between frames.
+	void reset();
+
+	// Range of view depths which maps onto the depth bits of the key.
+	void set_depth_range(const f32 kNear, const f32 kFar);
+
+	// Add a packet, viewDepth is the distance along the view direction.
+	void push(const DrawPacket& rPacket, const f32 kViewDepth);
+
+	// Order packets by key.
+	void sort();
+
+	// Walk the sorted packets, binding state only when it changes.
+	void submit(RenderQueueBackend& rBackend);
+
+	// Walk sorted packets [kFirst, kFirst + kCount), the first packet binds all of its state.
+	// Does not touch the queue so ranges can be submitted from several threads at once.
+	void submit_range(RenderQueueBackend& rBackend, const u32 kFirst, const u32 kCount, RenderQueueStats& rStats) const;
+
+	u32 size() const { return (u32)m_packets.size(); }
+	const DrawPacket& sorted_packet(const u32 i) const { return m_packets[m_sorted[i].index]; }
+	u64 sorted_key(const u32 i) const { return m_sorted[i].key; }
+	const RenderQueueStats& stats() const { return m_stats; }
+
+	static u64 make_key(const u32 kShader, const u32 kMaterial, const u32 kMesh, const u32 kDepth);
+
+private:
+	struct SortEntry
+	{
+		u64 key;
+		u32 index;
+	};
+
+	u32 quantize_depth(const f32 kViewDepth) const;
+	u32 shader_id(const ShaderSet* pShader);
+	u32 material_id(const Texture* pDiffuse, const Texture* pNormal);
+	u32 mesh_id(const Mesh* pMesh);
+
+	std::vector<DrawPacket> m_packets;
+	std::vector<SortEntry> m_sorted;
+	std::vector<SortEntry> m_scratch;
+
+	// Small tables of the objects seen so far, index is the id.
+	std::vector<const ShaderSet*> m_shaders;
+	std::vector<std::pair<const Texture*, const Texture*>> m_materials;
+	std::vector<const Mesh*> m_meshes;
+
+	f32 m_depthNear;
+	f32 m_depthScale;
+
+	RenderQueueStats m_stats;
+};
+
+// Radix sort of entries on a 64 bit key, stable, 8 bits per pass.
+// Passes where every key shares the same digit are skipped.
+// Returns the buffer that holds the result (either pEntries or pScratch).
+template<typename Entry>
+Entry* radix_sort_u64(Entry* pEntries, Entry* pScratch, const u32 kCount)
+{
+	Entry* pSrc = pEntries;
+	Entry* pDst = pScratch;
+
+	for (u32 shift = 0; shift < 64; shift += 8)
+	{
+		u32 histogram[256] = {};
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			histogram[(pSrc[i].key >> shift) & 0xFF]++;
+		}
+
+		// All keys fall in one bucket, nothing to reorder.
+		if (kCount == 0 || histogram[(pSrc[0].key >> shift) & 0xFF] == kCount)
+		{
+			continue;
+		}
+
+		u32 offset = 0;
+		for (u32 i = 0; i < 256; ++i)
+		{
+			const u32 count = histogram[i];
+			histogram[i] = offset;
+			offset += count;
+		}
+
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			pDst[histogram[(pSrc[i].key >> shift) & 0xFF]++] = pSrc[i];
+		}
+
+		std::swap(pSrc, pDst);
+	}
+
+	return pSrc;
+}
+
+//================================================================================
+// Recording Backend
+// Stores the submitted command stream rather than talking to a device,
+// so ordering and state changes can be checked without a GPU.
+//================================================================================
+class RecordingQueueBackend final : public RenderQueueBackend
+{
+public:
+	enum CommandType
+	{
+		kBindShader,
+		kBindMaterial,
+		kBindMesh,
+		kDraw
+	};
+
+	struct Command
+	{
+		CommandType type;
+		const void* pFirst;
+		const void* pSecond;
+	};
+
+	void bind_shader(const ShaderSet* pShader) override { commands.push_back({ kBindShader, pShader, nullptr }); }
+	void bind_material(const Texture* pDiffuse, const Texture* pNormal) override { commands.push_back({ kBindMaterial, pDiffuse, pNormal }); }
+	void bind_mesh(const Mesh* pMesh) override { commands.push_back({ kBindMesh, pMesh, nullptr }); }
+	void draw(const DrawPacket& rPacket) override { commands.push_back({ kDraw, rPacket.pMesh, nullptr }); }
+
+	u32 count(const CommandType type) const
+	{
+		return (u32)std::count_if(commands.begin(), commands.end(), [type](const Command& c) { return c.type == type; });
+	}
+
+	std::vector<Command> commands;
+};
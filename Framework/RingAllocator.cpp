@@ -0,0 +1,44 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator()
+	: m_capacity(0)
+	, m_alignment(1)
+	, m_head(0)
+	, m_allocations(0)
+	, m_failures(0)
+	, m_highWater(0)
+{
+}
+
+void RingAllocator::init(const u32 kCapacity, const u32 kAlignment)
+{
+	ASSERT(kAlignment != 0 && (kAlignment & (kAlignment - 1)) == 0);
+	m_capacity = kCapacity;
+	m_alignment = kAlignment;
+	m_highWater = 0;
+	reset();
+}
+
+void RingAllocator::reset()
+{
+	m_head = 0;
+	m_allocations = 0;
+	m_failures = 0;
+}
+
+u32 RingAllocator::allocate(const u32 kSize)
+{
+	// The head is always aligned, so only the size needs rounding.
+	const u32 kAligned = aligned_size(kSize);
+	if (kSize == 0 || kAligned > m_capacity - m_head)
+	{
+		m_failures++;
+		return kInvalidOffset;
+	}
+
+	const u32 kOffset = m_head;
+	m_head += kAligned;
+	m_allocations++;
+	m_highWater = std::max(m_highWater, m_head);
+	return kOffset;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreHeader.h"
+
+//================================================================================
+// Ring Allocator
+// Linear suballocation of a fixed size range, reset once the range has been
+// handed back (for a mapped buffer, when it is discarded). Holds no memory
+// itself so the offsets can be checked without a device.
+//================================================================================
+class RingAllocator
+{
+public:
+	static constexpr u32 kInvalidOffset = 0xFFFFFFFF;
+
+	RingAllocator();
+
+	void init(const u32 kCapacity, const u32 kAlignment);
+
+	// Start over from the beginning of the range.
+	void reset();
+
+	// Offset of kSize bytes rounded up to the alignment, kInvalidOffset when it does not fit.
+	u32 allocate(const u32 kSize);
+
+	// Size an allocation of kSize bytes actually takes.
+	u32 aligned_size(const u32 kSize) const { return align_up(kSize, m_alignment); }
+
+	u32 capacity() const { return m_capacity; }
+	u32 alignment() const { return m_alignment; }
+	u32 used() const { return m_head; }
+	u32 allocations() const { return m_allocations; }
+	u32 failures() const { return m_failures; }
+	u32 high_water() const { return m_highWater; }
+
+	static u32 align_up(const u32 kValue, const u32 kAlignment)
+	{
+		ASSERT(kAlignment != 0 && (kAlignment & (kAlignment - 1)) == 0);
+		return (kValue + kAlignment - 1) & ~(kAlignment - 1);
+	}
+
+private:
+	u32 m_capacity;
+	u32 m_alignment;
+	u32 m_head;
+	u32 m_allocations;
+	u32 m_failures;
+	u32 m_highWater;
+};
+
+// Size of a shader constant, the unit *SetConstantBuffers1 takes offsets and sizes in.
+constexpr u32 kShaderConstantSize = 16;
+
+// The constants an allocation of kSize bytes at kOffset covers, its size rounded up to the allocator's alignment.
+inline void constant_range(const RingAllocator& allocator, const u32 kOffset, const u32 kSize, u32& rFirstConstant, u32& rNumConstants)
+{
+	ASSERT(kOffset % kShaderConstantSize == 0);
+	rFirstConstant = kOffset / kShaderConstantSize;
+	rNumConstants = allocator.aligned_size(kSize) / kShaderConstantSize;
+}
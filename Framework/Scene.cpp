@@ -0,0 +1,165 @@
+#include "Scene.h"
+#include "MeshSimplify.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+
+constexpr u32 Scene::kNoObject;
+
+void Scene::set_meshes(const SceneMesh* pMeshes, const u32 kNumMeshes)
+{
+	m_meshes.assign(pMeshes, pMeshes + kNumMeshes);
+}
+
+void Scene::set_textures(const Texture* const* ppTextures, const u32 kNumTextures)
+{
+	m_textures.assign(ppTextures, ppTextures + kNumTextures);
+}
+
+void Scene::clear()
+{
+	m_objects.clear();
+	m_transforms.clear();
+	m_transformObject.clear();
+	m_animated.clear();
+	m_bounds.clear();
+	m_changedObjects.clear();
+	m_lods.clear();
+}
+
+u32 Scene::add_object(const u32 kMesh, const u32 kTexture, const u32 kTransform, const u32 kTileFactor)
+{
+	ASSERT(kTransform == m_transforms.size() - 1);
+	ASSERT(kMesh < m_meshes.size() && kTexture + 1 < m_textures.size());
+
+	// Transforms made for parents only have no object.
+	m_transformObject.resize(m_transforms.size(), kNoObject);
+	m_transformObject[kTransform] = (u32)m_objects.size();
+	m_objects.push_back({ kMesh, kTexture, kTransform, kTileFactor });
+	m_bounds.add(v3::Zero, m_meshes[kMesh].boundsRadius);
+	m_lods.push_back(0);
+	return (u32)m_objects.size() - 1;
+}
+
+void Scene::add_generated(SceneGeneratorDesc& rDesc, const SceneObject* pTypes, const u32 kNumTypes)
+{
+	f32 maxRadius = 0.f;
+	for (u32 i = 0; i < kNumTypes; ++i)
+	{
+		maxRadius = std::max(maxRadius, m_meshes[pTypes[i].mesh].boundsRadius);
+	}
+	rDesc.spacing = 2.f * maxRadius;
+
+	std::vector<GeneratedObject> generated;
+	generate_scene(rDesc, kNumTypes, generated);
+	m_objects.reserve(m_objects.size() + generated.size());
+	m_transforms.reserve(m_transforms.size() + (u32)generated.size());
+	m_bounds.reserve(m_bounds.size() + (u32)generated.size());
+	for (const GeneratedObject& object : generated)
+	{
+		// Meshes sit on the floor's height, like the props.
+		const SceneObject& type = pTypes[object.type];
+		const u32 kTransform = m_transforms.create(TransformSystem::kNoParent, object.position + v3(0.f, -0.5f, 0.f),
+			quat::CreateFromAxisAngle(v3::UnitY, object.yaw), v3::One);
+		add_object(type.mesh, type.texture, kTransform, type.tileFactor);
+		if (object.spin != 0.f)
+		{
+			m_animated.push_back({ kTransform, object.yaw, object.spin });
+		}
+	}
+}
+
+void Scene::animate(const f64 kTime)
+{
+	if (m_animated.empty())
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("Animate");
+	for (const AnimatedObject& animated : m_animated)
+	{
+		const f32 kAngle = animated.yaw + (f32)fmod((f64)animated.spin * kTime, (f64)kfTwoPI);
+		m_transforms.set_rotation(animated.transform, quat::CreateFromAxisAngle(v3::UnitY, kAngle));
+	}
+}
+
+u32 Scene::update_transforms()
+{
+	PROFILE_SCOPE("Transforms");
+	m_changedObjects.clear();
+	const u32 kUpdates = m_transforms.update();
+	if (kUpdates == 0)
+	{
+		return 0;
+	}
+
+	// Objects are created in transform order, so the changed objects come out ascending.
+	m_transformObject.resize(m_transforms.size(), kNoObject);
+	for (const u32 kTransform : m_transforms.changed())
+	{
+		const u32 kObject = m_transformObject[kTransform];
+		if (kObject == kNoObject)
+		{
+			continue;
+		}
+
+		// World matrices only rotate and translate, so the radius carries over unchanged.
+		const SceneMesh& mesh = m_meshes[m_objects[kObject].mesh];
+		m_bounds.set(kObject, v3::Transform(mesh.boundsCenter, m_transforms.world(kTransform)), mesh.boundsRadius);
+		m_changedObjects.push_back(kObject);
+	}
+	return kUpdates;
+}
+
+u32 Scene::cull(const v4* pPlanes, u32* pVisibleOut) const
+{
+	PROFILE_SCOPE("Frustum cull");
+	return cull_spheres(pPlanes, m_bounds, pVisibleOut);
+}
+
+void Scene::select_lods(const v3& eyeCenter, const f32 kNearClip, const f32 kPixelsPerUnit, const f32 kMaxPixelError)
+{
+	PROFILE_SCOPE("Select LODs");
+	memset(m_lodCounts, 0, sizeof(m_lodCounts));
+	for (u32 i = 0; i < m_objects.size(); ++i)
+	{
+		// Straight line distance rather than depth, so turning the head doesn't switch levels.
+		const SceneMesh& mesh = m_meshes[m_objects[i].mesh];
+		const v3 kCenter(m_bounds.centerX[i], m_bounds.centerY[i], m_bounds.centerZ[i]);
+		const f32 kDistance = std::max(v3::Distance(eyeCenter, kCenter) - m_bounds.radius[i], kNearClip);
+		m_lods[i] = select_lod(mesh.lods, mesh.numLods, kDistance, kPixelsPerUnit, kMaxPixelError);
+		m_lodCounts[m_lods[i]]++;
+	}
+}
+
+void Scene::reset_lods()
+{
+	std::fill(m_lods.begin(), m_lods.end(), 0u);
+	memset(m_lodCounts, 0, sizeof(m_lodCounts));
+	m_lodCounts[0] = (u32)m_objects.size();
+}
+
+u32 Scene::build_queue(RenderQueue& rQueue, const ShaderSet* pShader, const m4x4& viewProj, const u32* pVisible, const u32 kNumVisible) const
+{
+	PROFILE_SCOPE("Build queue");
+	rQueue.reset();
+
+	u32 triangles = 0;
+	for (u32 i = 0; i < kNumVisible; ++i)
+	{
+		const u32 kObject = pVisible[i];
+		const SceneObject& object = m_objects[kObject];
+		const SceneMesh& mesh = m_meshes[object.mesh];
+		const u32 kLod = m_lods[kObject];
+		const DrawPacket kPacket = { pShader, mesh.pMesh, m_textures[object.texture], m_textures[object.texture + 1],
+			m_transforms.world(object.transform), object.tileFactor, kLod };
+
+		// Clip w is the distance of the object's origin along the view direction.
+		const v3 kOrigin = kPacket.matWorld.Translation();
+		rQueue.push(kPacket, v4::Transform(v4(kOrigin.x, kOrigin.y, kOrigin.z, 1.f), viewProj).w);
+		triangles += mesh.lods[kLod].indexCount / 3;
+	}
+
+	rQueue.sort();
+	return triangles;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "Culling.h"
+#include "MeshData.h"
+#include "SceneGenerator.h"
+#include "TransformSystem.h"
+#include <vector>
+
+struct ShaderSet;
+class Mesh;
+class Texture;
+class RenderQueue;
+
+// What the scene needs of a mesh: its local bounds and levels of detail.
+// pMesh is only handed on to the render queue, it is never dereferenced here.
+struct SceneMesh
+{
+	const Mesh* pMesh;
+	v3 boundsCenter;
+	f32 boundsRadius;
+	MeshLod lods[kMaxMeshLods];
+	u32 numLods;
+};
+
+// An object placed in the scene.
+struct SceneObject
+{
+	u32 mesh;       // into the scene's meshes
+	u32 texture;    // diffuse map into the scene's textures, its normal map is the next one
+	u32 transform;  // world matrix is transforms().world(transform)
+	u32 tileFactor;
+};
+
+// A generated object turning about +Y at a steady rate.
+struct AnimatedObject
+{
+	u32 transform;
+	f32 yaw;   // radians at time 0
+	f32 spin;  // radians per second
+};
+
+//================================================================================
+// Scene
+// The objects drawn each frame and the CPU steps every frame takes with them,
+// shared by the app and the headless frame benchmark so both measure the same
+// work. In frame order:
+//
+//   animate            spin the generated objects by the display clock
+//   update_transforms  recompute what moved and the bounds of its objects
+//   cull               the objects inside a set of frustum planes
+//   select_lods        a level of detail per object, for both eyes at once
+//   build_queue        queue the visible objects and sort them
+//
+// Meshes and textures belong to the caller, the scene keeps their addresses
+// and what it needs to know about them.
+//================================================================================
+class Scene
+{
+public:
+	static constexpr u32 kNoObject = 0xFFFFFFFF;
+
+	// What objects index, must be set before objects are added.
+	void set_meshes(const SceneMesh* pMeshes, const u32 kNumMeshes);
+	void set_textures(const Texture* const* ppTextures, const u32 kNumTextures);
+
+	// Drop every object and transform.
+	void clear();
+
+	// Transforms are created here, one with no object can still parent others.
+	TransformSystem& transforms() { return m_transforms; }
+	const TransformSystem& transforms() const { return m_transforms; }
+
+	// Add an object on the newest transform, returns the object's index.
+	// Its bounds are placed by the next update_transforms, every transform starts out dirty.
+	u32 add_object(const u32 kMesh, const u32 kTexture, const u32 kTransform, const u32 kTileFactor);
+
+	// Generate a scene of the kNumTypes types in pTypes and add its objects, each standing on the floor
+	// and spinning when the generator says so. The types' transforms are ignored. Lots are as wide as the largest type, so nothing
+	// overlaps on the grid or in the city, rDesc's spacing is set to match.
+	void add_generated(SceneGeneratorDesc& rDesc, const SceneObject* pTypes, const u32 kNumTypes);
+
+	// Turn the animated objects to where they are at kTime seconds.
+	void animate(const f64 kTime);
+
+	// Recompute the transforms that moved and the bounds of their objects, returns the number of
+	// world matrices updated. changed_objects() lists the objects that moved, ascending.
+	u32 update_transforms();
+
+	// Objects inside the planes into pVisibleOut, which needs room for every object. Returns the count.
+	u32 cull(const v4* pPlanes, u32* pVisibleOut) const;
+
+	// Each object's level of detail from how close its bounds come to kEyeCenter, never nearer than
+	// kNearClip. Both eyes share the distance and take the larger pixel scale, so they always pick
+	// the same level. reset_lods draws everything at full detail instead.
+	void select_lods(const v3& eyeCenter, const f32 kNearClip, const f32 kPixelsPerUnit, const f32 kMaxPixelError);
+	void reset_lods();
+
+	// Queue the visible objects with their levels of detail, nearest first within a state, and sort.
+	// Returns the triangles queued.
+	u32 build_queue(RenderQueue& rQueue, const ShaderSet* pShader, const m4x4& viewProj, const u32* pVisible, const u32 kNumVisible) const;
+
+	u32 size() const { return (u32)m_objects.size(); }
+	const SceneObject& object(const u32 i) const { return m_objects[i]; }
+	const SceneMesh& mesh(const u32 i) const { return m_meshes[i]; }
+	const SphereBoundsSoA& bounds() const { return m_bounds; }
+	u32 lod(const u32 i) const { return m_lods[i]; }
+	const u32* lod_counts() const { return m_lodCounts; }
+	u32 animated() const { return (u32)m_animated.size(); }
+	const std::vector<u32>& changed_objects() const { return m_changedObjects; }
+
+private:
+	std::vector<SceneMesh> m_meshes;
+	std::vector<const Texture*> m_textures;
+
+	std::vector<SceneObject> m_objects;
+	TransformSystem m_transforms;
+	std::vector<u32> m_transformObject;     // object using each transform, or kNoObject
+	std::vector<AnimatedObject> m_animated; // generated objects that spin, the rest of the scene never moves
+	SphereBoundsSoA m_bounds;
+	std::vector<u32> m_changedObjects;
+
+	std::vector<u32> m_lods; // level of detail each object draws with this frame
+	u32 m_lodCounts[kMaxMeshLods] = {};
+};
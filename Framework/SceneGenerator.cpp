@@ -0,0 +1,175 @@
+#include "SceneGenerator.h"
+#include "Benchmark.h"
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+	// Side of the smallest square holding kCount cells.
+	u32 square_side(const u32 kCount)
+	{
+		u32 side = (u32)sqrtf((f32)kCount);
+		while (side * side < kCount)
+		{
+			side++;
+		}
+		return std::max(side, 1u);
+	}
+
+	void place_grid(const SceneGeneratorDesc& desc, std::vector<GeneratedObject>& rObjects)
+	{
+		const u32 kSide = square_side(desc.count);
+		const f32 kOffset = 0.5f * (f32)(kSide - 1) * desc.spacing;
+		for (u32 i = 0; i < desc.count; ++i)
+		{
+			rObjects[i].position = v3((f32)(i % kSide) * desc.spacing - kOffset, 0.f, (f32)(i / kSide) * desc.spacing - kOffset);
+		}
+	}
+
+	void place_clusters(const SceneGeneratorDesc& desc, Random& rRandom, std::vector<GeneratedObject>& rObjects)
+	{
+		// Centers over the same area the grid would cover, clusters can overlap into denser clumps.
+		const u32 kClusters = std::max(desc.clusters, 1u);
+		const f32 kHalfExtent = 0.5f * (f32)square_side(desc.count) * desc.spacing;
+		const f32 kRadius = desc.clusterRadius > 0.f ? desc.clusterRadius : desc.spacing * sqrtf((f32)desc.count / ((f32)kClusters * kfPI));
+
+		std::vector<v3> centers(kClusters);
+		for (v3& center : centers)
+		{
+			center = v3(rRandom.range(-kHalfExtent, kHalfExtent), 0.f, rRandom.range(-kHalfExtent, kHalfExtent));
+		}
+
+		// Uniform over each cluster's disc.
+		for (GeneratedObject& object : rObjects)
+		{
+			const v3& kCenter = centers[rRandom.below(kClusters)];
+			const f32 kDistance = kRadius * sqrtf(rRandom.next_f32());
+			const f32 kAngle = rRandom.range(0.f, kfTwoPI);
+			object.position = kCenter + v3(cosf(kAngle) * kDistance, 0.f, sinf(kAngle) * kDistance);
+		}
+	}
+
+	void place_city(const SceneGeneratorDesc& desc, Random& rRandom, std::vector<GeneratedObject>& rObjects)
+	{
+		// Blocks fill a square, lots fill each block row by row.
+		const u32 kBlockSize = std::max(desc.blockSize, 1u);
+		const u32 kLotsPerBlock = kBlockSize * kBlockSize;
+		const u32 kBlocksPerSide = square_side((desc.count + kLotsPerBlock - 1) / kLotsPerBlock);
+		const f32 kBlockPitch = (f32)kBlockSize * desc.spacing + desc.streetWidth;
+		const f32 kOffset = 0.5f * ((f32)kBlocksPerSide * kBlockPitch - desc.streetWidth - desc.spacing);
+
+		for (u32 i = 0; i < desc.count; ++i)
+		{
+			const u32 kBlock = i / kLotsPerBlock;
+			const u32 kLot = i % kLotsPerBlock;
+			const f32 kX = (f32)(kBlock % kBlocksPerSide) * kBlockPitch + (f32)(kLot % kBlockSize) * desc.spacing;
+			const f32 kZ = (f32)(kBlock / kBlocksPerSide) * kBlockPitch + (f32)(kLot / kBlockSize) * desc.spacing;
+			rObjects[i].position = v3(kX - kOffset, 0.f, kZ - kOffset);
+
+			// Buildings line up with the streets.
+			rObjects[i].yaw = (f32)rRandom.below(4) * kfHalfPI;
+		}
+	}
+}
+
+const char* scene_layout_name(const SceneLayout layout)
+{
+	switch (layout)
+	{
+	case SceneLayout::kGrid: return "grid";
+	case SceneLayout::kClusters: return "clusters";
+	case SceneLayout::kCity: return "city";
+	default: return "unknown";
+	}
+}
+
+bool parse_scene_args(const char* pCommandLine, SceneGeneratorDesc& rDesc)
+{
+	const std::vector<std::string> kArgs = split_command_line(pCommandLine);
+	for (size_t i = 0; i + 1 < kArgs.size(); ++i)
+	{
+		const std::string& arg = kArgs[i];
+		if (arg == "-scene")
+		{
+			const std::string& kLayout = kArgs[++i];
+			bool known = false;
+			for (u32 layout = 0; layout < (u32)SceneLayout::kCount; ++layout)
+			{
+				if (kLayout == scene_layout_name((SceneLayout)layout))
+				{
+					rDesc.layout = (SceneLayout)layout;
+					rDesc.enabled = true;
+					known = true;
+				}
+			}
+			if (!known)
+			{
+				debugF("Unknown scene layout %s\n", kLayout.c_str());
+			}
+		}
+		else if (arg == "-instances")
+		{
+			rDesc.count = (u32)strtoul(kArgs[++i].c_str(), nullptr, 10);
+			rDesc.enabled = true;
+		}
+		else if (arg == "-animated")
+		{
+			rDesc.animatedFraction = std::min(std::max((f32)atof(kArgs[++i].c_str()), 0.f), 1.f);
+			rDesc.enabled = true;
+		}
+		else if (arg == "-seed")
+		{
+			rDesc.seed = strtoull(kArgs[++i].c_str(), nullptr, 10);
+			rDesc.enabled = true;
+		}
+	}
+
+	if (rDesc.count == 0)
+	{
+		rDesc.count = 1;
+	}
+	return rDesc.enabled;
+}
+
+void generate_scene(const SceneGeneratorDesc& desc, const u32 kNumTypes, std::vector<GeneratedObject>& rObjects)
+{
+	ASSERT(kNumTypes > 0 && desc.spacing > 0.f);
+	Random random(desc.seed);
+
+	// Types, turns and motion first, so a layout's draws don't shift them between layouts with the same seed.
+	std::vector<GeneratedObject> objects(desc.count);
+	for (GeneratedObject& object : objects)
+	{
+		object.type = random.below(kNumTypes);
+		object.yaw = random.range(0.f, kfTwoPI);
+		object.spin = 0.f;
+		if (random.next_f32() < desc.animatedFraction)
+		{
+			const f32 kSpeed = random.range(0.25f, 1.f) * kfPI;
+			object.spin = random.below(2) ? kSpeed : -kSpeed;
+		}
+	}
+
+	switch (desc.layout)
+	{
+	case SceneLayout::kClusters: place_clusters(desc, random, objects); break;
+	case SceneLayout::kCity: place_city(desc, random, objects); break;
+	default: place_grid(desc, objects); break;
+	}
+
+	// Counting sort by type, keeping each type's objects in layout order.
+	std::vector<u32> first(kNumTypes + 1, 0);
+	for (const GeneratedObject& object : objects)
+	{
+		first[object.type + 1]++;
+	}
+	for (u32 type = 0; type < kNumTypes; ++type)
+	{
+		first[type + 1] += first[type];
+	}
+	rObjects.resize(desc.count);
+	for (const GeneratedObject& object : objects)
+	{
+		rObjects[first[object.type]++] = object;
+	}
+}
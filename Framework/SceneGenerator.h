@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+enum class SceneLayout : u32
+{
+	kGrid,      // one square grid
+	kClusters,  // random clumps of different density
+	kCity,      // square blocks of lots with streets between
+	kCount
+};
+
+const char* scene_layout_name(const SceneLayout layout);
+
+struct SceneGeneratorDesc
+{
+	bool enabled = false;             // false keeps the hand placed scene
+	SceneLayout layout = SceneLayout::kGrid;
+	u32 count = 10000;
+	u64 seed = 1;
+	f32 spacing = 2.f;                // metres between neighbouring objects, at least the largest object's width
+	u32 clusters = 32;
+	f32 clusterRadius = 0.f;          // 0 sizes clusters so they are about as dense as the grid
+	u32 blockSize = 8;                // lots along a city block's side
+	f32 streetWidth = 6.f;            // metres
+	f32 animatedFraction = 0.1f;      // of the objects, the rest never move
+};
+
+// Where an object goes, on the ground plane about the origin.
+struct GeneratedObject
+{
+	u32 type;      // below the number of types asked for
+	v3 position;
+	f32 yaw;       // radians about +Y at time 0
+	f32 spin;      // radians per second about +Y, 0 for a static object
+};
+
+// Reads -scene grid|clusters|city, -instances N, -animated fraction and -seed N, any of them enables the generated scene.
+// Arguments it doesn't know are left for other parsers. Returns rDesc.enabled.
+bool parse_scene_args(const char* pCommandLine, SceneGeneratorDesc& rDesc);
+
+//================================================================================
+// Scene Generator
+// Places desc.count objects of kNumTypes types for scaling tests, from a few
+// thousand up to millions.
+//
+// Everything comes from one seeded PRNG, so the same desc gives the same
+// scene on every run and every machine. Objects come out sorted by type so
+// objects sharing a mesh stay together. The layout is only positions and
+// turns, what each type looks like is up to the caller.
+//================================================================================
+void generate_scene(const SceneGeneratorDesc& desc, const u32 kNumTypes, std::vector<GeneratedObject>& rObjects);
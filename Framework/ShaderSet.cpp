@@ -1,5 +1,6 @@
 #include "CommonHeader.h"
 #include "ShaderSet.h"
+#include "StateCache.h"
 
 #include <d3dcompiler.h>
 
@@ -45,7 +46,7 @@ ShaderSet::ShaderSet()
 void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const InputLayoutDesc & layout)
 {
 	ComPtr<ID3DBlob> blobs[ShaderStage::kMaxStages];
-	static const char* profiles[ShaderStage::kMaxStages] = { "vs_4_0", "hs_4_0" ,"ds_4_0" ,"gs_4_0" ,"ps_4_0" ,"cs_4_0" };
+	static const char* profiles[ShaderStage::kMaxStages] = { "vs_5_0", "hs_5_0" ,"ds_5_0" ,"gs_5_0" ,"ps_5_0" ,"cs_5_0" };
 
 	// Compile each stage we set an entry point for.
 	for (u32 i = 0; i < ShaderStage::kMaxStages; ++i)
@@ -65,7 +66,7 @@ void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const Inpu
 	// Create the vertex shader:
 	if (blobs[ShaderStage::kVertex])
 	{
-		hr = device->CreateVertexShader(blobs[ShaderStage::kVertex]->GetBufferPointer(), blobs[ShaderStage::kVertex]->GetBufferSize(), nullptr, vs.GetAddressOf());
+		hr = device->CreateVertexShader(blobs[ShaderStage::kVertex]->GetBufferPointer(), blobs[ShaderStage::kVertex]->GetBufferSize(), nullptr, vs.ReleaseAndGetAddressOf());
 		if (FAILED(hr))
 		{
 			panicF("Failed to create vertex shader");
@@ -75,7 +76,7 @@ void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const Inpu
 	// Create the hull shader:
 	if (blobs[ShaderStage::kHull])
 	{
-		hr = device->CreateHullShader(blobs[ShaderStage::kHull]->GetBufferPointer(), blobs[ShaderStage::kHull]->GetBufferSize(), nullptr, hs.GetAddressOf());
+		hr = device->CreateHullShader(blobs[ShaderStage::kHull]->GetBufferPointer(), blobs[ShaderStage::kHull]->GetBufferSize(), nullptr, hs.ReleaseAndGetAddressOf());
 		if (FAILED(hr))
 		{
 			panicF("Failed to create hull shader");
@@ -85,7 +86,7 @@ void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const Inpu
 	// Create the domain shader:
 	if (blobs[ShaderStage::kDomain])
 	{
-		hr = device->CreateDomainShader(blobs[ShaderStage::kDomain]->GetBufferPointer(), blobs[ShaderStage::kDomain]->GetBufferSize(), nullptr, ds.GetAddressOf());
+		hr = device->CreateDomainShader(blobs[ShaderStage::kDomain]->GetBufferPointer(), blobs[ShaderStage::kDomain]->GetBufferSize(), nullptr, ds.ReleaseAndGetAddressOf());
 		if (FAILED(hr))
 		{
 			panicF("Failed to create hull shader");
@@ -95,7 +96,7 @@ void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const Inpu
 	// Create the geometry shader:
 	if (blobs[ShaderStage::kGeometry])
 	{
-		hr = device->CreateGeometryShader(blobs[ShaderStage::kGeometry]->GetBufferPointer(), blobs[ShaderStage::kGeometry]->GetBufferSize(), nullptr, gs.GetAddressOf());
+		hr = device->CreateGeometryShader(blobs[ShaderStage::kGeometry]->GetBufferPointer(), blobs[ShaderStage::kGeometry]->GetBufferSize(), nullptr, gs.ReleaseAndGetAddressOf());
 		if (FAILED(hr))
 		{
 			panicF("Failed to create geometry shader");
@@ -105,7 +106,7 @@ void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const Inpu
 	// Create the pixel shader:
 	if (blobs[ShaderStage::kPixel])
 	{
-		hr = device->CreatePixelShader(blobs[ShaderStage::kPixel]->GetBufferPointer(), blobs[ShaderStage::kPixel]->GetBufferSize(), nullptr, ps.GetAddressOf());
+		hr = device->CreatePixelShader(blobs[ShaderStage::kPixel]->GetBufferPointer(), blobs[ShaderStage::kPixel]->GetBufferSize(), nullptr, ps.ReleaseAndGetAddressOf());
 		if (FAILED(hr))
 		{
 			panicF("Failed to create pixel shader");
@@ -115,21 +116,24 @@ void ShaderSet::init(ID3D11Device* device, const ShaderSetDesc& desc, const Inpu
 	// Create the compute shader:
 	if (blobs[ShaderStage::kCompute])
 	{
-		hr = device->CreateComputeShader(blobs[ShaderStage::kCompute]->GetBufferPointer(), blobs[ShaderStage::kCompute]->GetBufferSize(), nullptr, cs.GetAddressOf());
+		hr = device->CreateComputeShader(blobs[ShaderStage::kCompute]->GetBufferPointer(), blobs[ShaderStage::kCompute]->GetBufferSize(), nullptr, cs.ReleaseAndGetAddressOf());
 		if (FAILED(hr))
 		{
-			panicF("Failed to create pixel shader");
+			panicF("Failed to create compute shader");
 		}
 	}
 
-	// Create vertex input layout:
-	hr = device->CreateInputLayout(std::get<0>(layout), std::get<1>(layout),
-		blobs[ShaderStage::kVertex]->GetBufferPointer(),
-		blobs[ShaderStage::kVertex]->GetBufferSize(),
-		inputLayout.GetAddressOf());
-	if (FAILED(hr))
+	// Create vertex input layout, only the vertex shader takes one:
+	if (blobs[ShaderStage::kVertex])
 	{
-		panicF("Failed to create vertex layout!");
+		hr = device->CreateInputLayout(std::get<0>(layout), std::get<1>(layout),
+			blobs[ShaderStage::kVertex]->GetBufferPointer(),
+			blobs[ShaderStage::kVertex]->GetBufferSize(),
+			inputLayout.ReleaseAndGetAddressOf());
+		if (FAILED(hr))
+		{
+			panicF("Failed to create vertex layout!");
+		}
 	}
 }
 
@@ -205,3 +209,14 @@ void ShaderSet::bind(ID3D11DeviceContext* pContext) const
 
 }
 
+void ShaderSet::bind(StateCache& rState) const
+{
+	// Unused stages are still set to null, the cache drops them if already clear.
+	rState.set_input_layout(vs ? inputLayout.Get() : NULL);
+	rState.set_vertex_shader(vs.Get());
+	rState.set_hull_shader(hs.Get());
+	rState.set_domain_shader(ds.Get());
+	rState.set_geometry_shader(gs.Get());
+	rState.set_pixel_shader(ps.Get());
+	rState.set_compute_shader(cs.Get());
+}
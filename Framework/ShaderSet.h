@@ -1,5 +1,7 @@
 #pragma once
 
+#include "PerfStats.h"
+
 // ========================================================
 // Shader stage enum
 // ========================================================
@@ -37,15 +39,27 @@ struct ShaderSetDesc
 		desc.entryPoints[ShaderStage::kPixel] = psEntry;
 		return desc;
 	}
+
+	static ShaderSetDesc Create_CS(const char* fName, const char* csEntry)
+	{
+		ShaderSetDesc desc = {};
+		desc.filename = fName;
+		desc.entryPoints[ShaderStage::kCompute] = csEntry;
+		return desc;
+	}
 };
 
+class StateCache;
+
 struct ShaderSet
 {
 	using InputLayoutDesc = std::tuple<const D3D11_INPUT_ELEMENT_DESC *, int>;
 	ShaderSet();
-	void init(ID3D11Device* device, const ShaderSetDesc& desc, const InputLayoutDesc & layout);
+	// Compute only sets have no vertex shader and need no layout.
+	void init(ID3D11Device* device, const ShaderSetDesc& desc, const InputLayoutDesc & layout = InputLayoutDesc(nullptr, 0));
 
 	void bind(ID3D11DeviceContext* pContext) const;
+	void bind(StateCache& rState) const;
 
 	ComPtr<ID3D11InputLayout>  inputLayout;
 	ComPtr<ID3D11VertexShader> vs;
@@ -85,6 +99,7 @@ template<typename ConstantBufferType>
 void push_constant_buffer(ID3D11DeviceContext* pContext, ID3D11Buffer* pBuffer, const ConstantBufferType& rData)
 {
 	D3D11_MAPPED_SUBRESOURCE subresource;
+	perf_count(PerfCounter::kMapCalls, 1);
 	if (!FAILED(pContext->Map(pBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource)))
 	{
 		memcpy(subresource.pData, &rData, sizeof(ConstantBufferType));
@@ -112,6 +127,37 @@ ID3D11Buffer* create_structured_buffer(ID3D11Device* pDevice, u32 elements)
 	return pBuffer;
 }
 
+// template to create a structure buffer that stays on the GPU, written in place with update_structured_buffer.
+template<typename StructureElementType>
+ID3D11Buffer* create_default_structured_buffer(ID3D11Device* pDevice, u32 elements)
+{
+	ID3D11Buffer* pBuffer = nullptr;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = sizeof(StructureElementType) * elements;
+	desc.StructureByteStride = sizeof(StructureElementType);
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+
+	HRESULT hr = pDevice->CreateBuffer(&desc, NULL, &pBuffer);
+	ASSERT(!FAILED(hr) && pBuffer);
+
+	return pBuffer;
+}
+
+// template to update elements [first, first + count) of a default usage structure buffer.
+template<typename StructureElementType>
+void update_structured_buffer(ID3D11DeviceContext* pContext, ID3D11Buffer* pBuffer, u32 first, u32 count, const StructureElementType* pData)
+{
+	D3D11_BOX box = {};
+	box.left = first * sizeof(StructureElementType);
+	box.right = (first + count) * sizeof(StructureElementType);
+	box.bottom = 1;
+	box.back = 1;
+	pContext->UpdateSubresource(pBuffer, 0, &box, pData, 0, 0);
+}
+
 inline ID3D11ShaderResourceView* create_structured_buffer_view(ID3D11Device* pDevice, ID3D11Buffer* pBuffer)
 {
 	ID3D11ShaderResourceView* pView = nullptr;
@@ -120,6 +166,67 @@ inline ID3D11ShaderResourceView* create_structured_buffer_view(ID3D11Device* pDe
 	return pView;
 }
 
+// template to create a structure buffer written by compute shaders and read by any stage.
+template<typename StructureElementType>
+ID3D11Buffer* create_unordered_structured_buffer(ID3D11Device* pDevice, u32 elements)
+{
+	ID3D11Buffer* pBuffer = nullptr;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = sizeof(StructureElementType) * elements;
+	desc.StructureByteStride = sizeof(StructureElementType);
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+
+	HRESULT hr = pDevice->CreateBuffer(&desc, NULL, &pBuffer);
+	ASSERT(!FAILED(hr) && pBuffer);
+
+	return pBuffer;
+}
+
+inline ID3D11UnorderedAccessView* create_structured_buffer_uav(ID3D11Device* pDevice, ID3D11Buffer* pBuffer)
+{
+	ID3D11UnorderedAccessView* pView = nullptr;
+	HRESULT hr = pDevice->CreateUnorderedAccessView(pBuffer, NULL, &pView);
+	ASSERT(!FAILED(hr) && pView);
+	return pView;
+}
+
+// helper to create a buffer of kBytes of draw arguments, written by compute shaders through a raw view.
+inline ID3D11Buffer* create_indirect_args_buffer(ID3D11Device* pDevice, u32 kBytes)
+{
+	ID3D11Buffer* pBuffer = nullptr;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = kBytes;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
+	HRESULT hr = pDevice->CreateBuffer(&desc, NULL, &pBuffer);
+	ASSERT(!FAILED(hr) && pBuffer);
+
+	return pBuffer;
+}
+
+// helper to view a buffer as a RWByteAddressBuffer, it must allow raw views.
+inline ID3D11UnorderedAccessView* create_raw_buffer_uav(ID3D11Device* pDevice, ID3D11Buffer* pBuffer, u32 kBytes)
+{
+	ID3D11UnorderedAccessView* pView = nullptr;
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC desc = {};
+	desc.Format = DXGI_FORMAT_R32_TYPELESS;
+	desc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	desc.Buffer.FirstElement = 0;
+	desc.Buffer.NumElements = kBytes / 4;
+	desc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+
+	HRESULT hr = pDevice->CreateUnorderedAccessView(pBuffer, &desc, &pView);
+	ASSERT(!FAILED(hr) && pView);
+	return pView;
+}
+
 // helper to create a sampler state
 inline ID3D11SamplerState* create_basic_sampler(ID3D11Device* pDevice, D3D11_TEXTURE_ADDRESS_MODE mode)
 {
@@ -0,0 +1,381 @@
+#include "StateCache.h"
+
+// Value that never matches a real object, used for state we know nothing about.
+template<typename T>
+static T* unknown_state()
+{
+	return reinterpret_cast<T*>(~uintptr_t(0));
+}
+
+StateCache::StateCache()
+	: m_pContext(nullptr)
+	, m_stats{}
+{
+	invalidate();
+}
+
+void StateCache::init(ID3D11DeviceContext* pContext)
+{
+	m_pContext = pContext;
+	m_pContext1.Reset();
+	if (pContext)
+	{
+		// Only for offset binding, everything else goes through the base interface.
+		pContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)m_pContext1.GetAddressOf());
+	}
+	invalidate();
+}
+
+void StateCache::invalidate()
+{
+	m_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	m_pInputLayout = unknown_state<ID3D11InputLayout>();
+	for (u32 i = 0; i < kMaxVertexBuffers; ++i)
+	{
+		m_vertexBuffers[i] = unknown_state<ID3D11Buffer>();
+		m_vertexStrides[i] = 0;
+		m_vertexOffsets[i] = 0;
+	}
+	m_pIndexBuffer = unknown_state<ID3D11Buffer>();
+	m_indexFormat = DXGI_FORMAT_UNKNOWN;
+	m_indexOffset = 0;
+
+	m_pVS = unknown_state<ID3D11VertexShader>();
+	m_pHS = unknown_state<ID3D11HullShader>();
+	m_pDS = unknown_state<ID3D11DomainShader>();
+	m_pGS = unknown_state<ID3D11GeometryShader>();
+	m_pPS = unknown_state<ID3D11PixelShader>();
+	m_pCS = unknown_state<ID3D11ComputeShader>();
+
+	for (u32 stage = 0; stage < ShaderStage::kMaxStages; ++stage)
+	{
+		for (u32 i = 0; i < kMaxShaderResources; ++i)
+		{
+			m_srvs[stage][i] = unknown_state<ID3D11ShaderResourceView>();
+			m_pendingSrvs[stage][i] = unknown_state<ID3D11ShaderResourceView>();
+		}
+		m_srvDirtyMin[stage] = kMaxShaderResources;
+		m_srvDirtyMax[stage] = 0;
+
+		for (u32 i = 0; i < kMaxSamplers; ++i)
+		{
+			m_samplers[stage][i] = unknown_state<ID3D11SamplerState>();
+		}
+		for (u32 i = 0; i < kMaxConstantBuffers; ++i)
+		{
+			m_constantBuffers[stage][i] = unknown_state<ID3D11Buffer>();
+			m_constantFirst[stage][i] = 0;
+			m_constantCount[stage][i] = 0;
+		}
+	}
+}
+
+//================================================================================
+// Input assembler
+//================================================================================
+
+void StateCache::set_topology(const D3D11_PRIMITIVE_TOPOLOGY kTopology)
+{
+	if (m_topology == kTopology)
+	{
+		m_stats.skipped++;
+		return;
+	}
+	m_topology = kTopology;
+	m_pContext->IASetPrimitiveTopology(kTopology);
+	m_stats.issued++;
+}
+
+void StateCache::set_input_layout(ID3D11InputLayout* pLayout)
+{
+	if (changed(m_pInputLayout, pLayout))
+	{
+		m_pContext->IASetInputLayout(pLayout);
+	}
+}
+
+void StateCache::set_vertex_buffer(const u32 kSlot, ID3D11Buffer* pBuffer, const u32 kStride, const u32 kOffset)
+{
+	ASSERT(kSlot < kMaxVertexBuffers);
+	if (m_vertexBuffers[kSlot] == pBuffer && m_vertexStrides[kSlot] == kStride && m_vertexOffsets[kSlot] == kOffset)
+	{
+		m_stats.skipped++;
+		return;
+	}
+	m_vertexBuffers[kSlot] = pBuffer;
+	m_vertexStrides[kSlot] = kStride;
+	m_vertexOffsets[kSlot] = kOffset;
+
+	UINT stride = kStride;
+	UINT offset = kOffset;
+	m_pContext->IASetVertexBuffers(kSlot, 1, &pBuffer, &stride, &offset);
+	m_stats.issued++;
+}
+
+void StateCache::set_index_buffer(ID3D11Buffer* pBuffer, const DXGI_FORMAT kFormat, const u32 kOffset)
+{
+	if (m_pIndexBuffer == pBuffer && m_indexFormat == kFormat && m_indexOffset == kOffset)
+	{
+		m_stats.skipped++;
+		return;
+	}
+	m_pIndexBuffer = pBuffer;
+	m_indexFormat = kFormat;
+	m_indexOffset = kOffset;
+
+	m_pContext->IASetIndexBuffer(pBuffer, kFormat, kOffset);
+	m_stats.issued++;
+}
+
+//================================================================================
+// Shaders
+//================================================================================
+
+void StateCache::set_vertex_shader(ID3D11VertexShader* pShader)
+{
+	if (changed(m_pVS, pShader))
+	{
+		m_pContext->VSSetShader(pShader, NULL, 0);
+	}
+}
+
+void StateCache::set_hull_shader(ID3D11HullShader* pShader)
+{
+	if (changed(m_pHS, pShader))
+	{
+		m_pContext->HSSetShader(pShader, NULL, 0);
+	}
+}
+
+void StateCache::set_domain_shader(ID3D11DomainShader* pShader)
+{
+	if (changed(m_pDS, pShader))
+	{
+		m_pContext->DSSetShader(pShader, NULL, 0);
+	}
+}
+
+void StateCache::set_geometry_shader(ID3D11GeometryShader* pShader)
+{
+	if (changed(m_pGS, pShader))
+	{
+		m_pContext->GSSetShader(pShader, NULL, 0);
+	}
+}
+
+void StateCache::set_pixel_shader(ID3D11PixelShader* pShader)
+{
+	if (changed(m_pPS, pShader))
+	{
+		m_pContext->PSSetShader(pShader, NULL, 0);
+	}
+}
+
+void StateCache::set_compute_shader(ID3D11ComputeShader* pShader)
+{
+	if (changed(m_pCS, pShader))
+	{
+		m_pContext->CSSetShader(pShader, NULL, 0);
+	}
+}
+
+//================================================================================
+// Resources
+//================================================================================
+
+void StateCache::set_shader_resources(const ShaderStage::ShaderStageEnum kStage, const u32 kStartSlot, const u32 kCount, ID3D11ShaderResourceView* const* ppViews)
+{
+	ASSERT(kStartSlot + kCount <= kMaxShaderResources);
+
+	for (u32 i = 0; i < kCount; ++i)
+	{
+		const u32 slot = kStartSlot + i;
+		m_pendingSrvs[kStage][slot] = ppViews[i];
+
+		if (m_srvs[kStage][slot] == ppViews[i])
+		{
+			m_stats.skipped++;
+			continue;
+		}
+
+		m_srvDirtyMin[kStage] = std::min(m_srvDirtyMin[kStage], slot);
+		m_srvDirtyMax[kStage] = std::max(m_srvDirtyMax[kStage], slot + 1);
+	}
+}
+
+void StateCache::set_samplers(const ShaderStage::ShaderStageEnum kStage, const u32 kStartSlot, const u32 kCount, ID3D11SamplerState* const* ppSamplers)
+{
+	ASSERT(kStartSlot + kCount <= kMaxSamplers);
+
+	ID3D11SamplerState** pShadow = &m_samplers[kStage][kStartSlot];
+	if (std::equal(ppSamplers, ppSamplers + kCount, pShadow))
+	{
+		m_stats.skipped++;
+		return;
+	}
+	std::copy(ppSamplers, ppSamplers + kCount, pShadow);
+
+	switch (kStage)
+	{
+	case ShaderStage::kVertex:   m_pContext->VSSetSamplers(kStartSlot, kCount, ppSamplers); break;
+	case ShaderStage::kHull:     m_pContext->HSSetSamplers(kStartSlot, kCount, ppSamplers); break;
+	case ShaderStage::kDomain:   m_pContext->DSSetSamplers(kStartSlot, kCount, ppSamplers); break;
+	case ShaderStage::kGeometry: m_pContext->GSSetSamplers(kStartSlot, kCount, ppSamplers); break;
+	case ShaderStage::kPixel:    m_pContext->PSSetSamplers(kStartSlot, kCount, ppSamplers); break;
+	case ShaderStage::kCompute:  m_pContext->CSSetSamplers(kStartSlot, kCount, ppSamplers); break;
+	default: break;
+	}
+	m_stats.issued++;
+}
+
+void StateCache::set_constant_buffers(const ShaderStage::ShaderStageEnum kStage, const u32 kStartSlot, const u32 kCount, ID3D11Buffer* const* ppBuffers)
+{
+	ASSERT(kStartSlot + kCount <= kMaxConstantBuffers);
+
+	ID3D11Buffer** pShadow = &m_constantBuffers[kStage][kStartSlot];
+	const bool kWholeBuffers = std::all_of(&m_constantCount[kStage][kStartSlot], &m_constantCount[kStage][kStartSlot] + kCount, [](u32 count) { return count == 0; });
+	if (kWholeBuffers && std::equal(ppBuffers, ppBuffers + kCount, pShadow))
+	{
+		m_stats.skipped++;
+		return;
+	}
+	std::copy(ppBuffers, ppBuffers + kCount, pShadow);
+	std::fill(&m_constantFirst[kStage][kStartSlot], &m_constantFirst[kStage][kStartSlot] + kCount, 0);
+	std::fill(&m_constantCount[kStage][kStartSlot], &m_constantCount[kStage][kStartSlot] + kCount, 0);
+
+	switch (kStage)
+	{
+	case ShaderStage::kVertex:   m_pContext->VSSetConstantBuffers(kStartSlot, kCount, ppBuffers); break;
+	case ShaderStage::kHull:     m_pContext->HSSetConstantBuffers(kStartSlot, kCount, ppBuffers); break;
+	case ShaderStage::kDomain:   m_pContext->DSSetConstantBuffers(kStartSlot, kCount, ppBuffers); break;
+	case ShaderStage::kGeometry: m_pContext->GSSetConstantBuffers(kStartSlot, kCount, ppBuffers); break;
+	case ShaderStage::kPixel:    m_pContext->PSSetConstantBuffers(kStartSlot, kCount, ppBuffers); break;
+	case ShaderStage::kCompute:  m_pContext->CSSetConstantBuffers(kStartSlot, kCount, ppBuffers); break;
+	default: break;
+	}
+	m_stats.issued++;
+}
+
+void StateCache::set_constant_buffer_range(const ShaderStage::ShaderStageEnum kStage, const u32 kSlot, ID3D11Buffer* pBuffer, const u32 kFirstConstant, const u32 kNumConstants)
+{
+	ASSERT(kSlot < kMaxConstantBuffers);
+	ASSERT(m_pContext1);
+	ASSERT(kNumConstants > 0);
+
+	if (m_constantBuffers[kStage][kSlot] == pBuffer && m_constantFirst[kStage][kSlot] == kFirstConstant && m_constantCount[kStage][kSlot] == kNumConstants)
+	{
+		m_stats.skipped++;
+		return;
+	}
+	m_constantBuffers[kStage][kSlot] = pBuffer;
+	m_constantFirst[kStage][kSlot] = kFirstConstant;
+	m_constantCount[kStage][kSlot] = kNumConstants;
+
+	ID3D11DeviceContext1* pContext = m_pContext1.Get();
+	const UINT first = kFirstConstant;
+	const UINT count = kNumConstants;
+	switch (kStage)
+	{
+	case ShaderStage::kVertex:   pContext->VSSetConstantBuffers1(kSlot, 1, &pBuffer, &first, &count); break;
+	case ShaderStage::kHull:     pContext->HSSetConstantBuffers1(kSlot, 1, &pBuffer, &first, &count); break;
+	case ShaderStage::kDomain:   pContext->DSSetConstantBuffers1(kSlot, 1, &pBuffer, &first, &count); break;
+	case ShaderStage::kGeometry: pContext->GSSetConstantBuffers1(kSlot, 1, &pBuffer, &first, &count); break;
+	case ShaderStage::kPixel:    pContext->PSSetConstantBuffers1(kSlot, 1, &pBuffer, &first, &count); break;
+	case ShaderStage::kCompute:  pContext->CSSetConstantBuffers1(kSlot, 1, &pBuffer, &first, &count); break;
+	default: break;
+	}
+	m_stats.issued++;
+}
+
+void StateCache::set_compute_unordered_access_views(const u32 kStartSlot, const u32 kCount, ID3D11UnorderedAccessView* const* ppViews)
+{
+	m_pContext->CSSetUnorderedAccessViews(kStartSlot, kCount, ppViews, nullptr);
+	m_stats.issued++;
+}
+
+void StateCache::flush()
+{
+	for (u32 stage = 0; stage < ShaderStage::kMaxStages; ++stage)
+	{
+		const u32 kMax = m_srvDirtyMax[stage];
+		u32 first = m_srvDirtyMin[stage];
+
+		// One call per run of staged slots, unchanged slots inside a run are simply rebound.
+		// Slots never set since the last invalidate split runs, we know nothing about them.
+		while (first < kMax)
+		{
+			if (m_pendingSrvs[stage][first] == unknown_state<ID3D11ShaderResourceView>())
+			{
+				++first;
+				continue;
+			}
+
+			u32 last = first + 1;
+			while (last < kMax && m_pendingSrvs[stage][last] != unknown_state<ID3D11ShaderResourceView>())
+			{
+				++last;
+			}
+
+			ID3D11ShaderResourceView* const* ppViews = &m_pendingSrvs[stage][first];
+			const u32 kCount = last - first;
+			switch (stage)
+			{
+			case ShaderStage::kVertex:   m_pContext->VSSetShaderResources(first, kCount, ppViews); break;
+			case ShaderStage::kHull:     m_pContext->HSSetShaderResources(first, kCount, ppViews); break;
+			case ShaderStage::kDomain:   m_pContext->DSSetShaderResources(first, kCount, ppViews); break;
+			case ShaderStage::kGeometry: m_pContext->GSSetShaderResources(first, kCount, ppViews); break;
+			case ShaderStage::kPixel:    m_pContext->PSSetShaderResources(first, kCount, ppViews); break;
+			case ShaderStage::kCompute:  m_pContext->CSSetShaderResources(first, kCount, ppViews); break;
+			default: break;
+			}
+			m_stats.issued++;
+
+			std::copy(ppViews, ppViews + kCount, &m_srvs[stage][first]);
+			first = last;
+		}
+
+		m_srvDirtyMin[stage] = kMaxShaderResources;
+		m_srvDirtyMax[stage] = 0;
+	}
+}
+
+//================================================================================
+// Draws
+//================================================================================
+
+void StateCache::draw(const u32 kVertexCount, const u32 kStartVertex)
+{
+	flush();
+	m_pContext->Draw(kVertexCount, kStartVertex);
+	m_stats.draws++;
+	m_stats.triangles += kVertexCount / 3;
+}
+
+void StateCache::draw_indexed(const u32 kIndexCount, const u32 kStartIndex, const s32 kBaseVertex)
+{
+	flush();
+	m_pContext->DrawIndexed(kIndexCount, kStartIndex, kBaseVertex);
+	m_stats.draws++;
+	m_stats.triangles += kIndexCount / 3;
+}
+
+void StateCache::draw_indexed_instanced(const u32 kIndexCount, const u32 kInstanceCount, const u32 kStartIndex, const s32 kBaseVertex, const u32 kStartInstance)
+{
+	flush();
+	m_pContext->DrawIndexedInstanced(kIndexCount, kInstanceCount, kStartIndex, kBaseVertex, kStartInstance);
+	m_stats.draws++;
+	m_stats.triangles += (u64)(kIndexCount / 3) * kInstanceCount;
+}
+
+void StateCache::draw_indexed_instanced_indirect(ID3D11Buffer* pArgs, const u32 kArgsOffset)
+{
+	flush();
+	m_pContext->DrawIndexedInstancedIndirect(pArgs, kArgsOffset);
+	m_stats.draws++;
+}
+
+void StateCache::dispatch(const u32 kGroupsX, const u32 kGroupsY, const u32 kGroupsZ)
+{
+	flush();
+	m_pContext->Dispatch(kGroupsX, kGroupsY, kGroupsZ);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CommonHeader.h"
+#include "ShaderSet.h"
+
+struct StateCacheStats
+{
+	u32 issued;  // calls that reached the device context
+	u32 skipped; // binds dropped because the state was already set
+	u32 draws;
+	u64 triangles; // assuming triangle lists, indirect draws add none
+};
+
+//================================================================================
+// State Cache
+// Wraps a device context and shadows the bound pipeline state so redundant
+// binds can be dropped. Shader resources are staged and flushed before each
+// draw so adjacent slots go to the context in a single call.
+//
+// The shadow state is only valid while all binds go through the cache,
+// call invalidate() once other code has used the context directly.
+//================================================================================
+class StateCache
+{
+public:
+	static constexpr u32 kMaxVertexBuffers = 4;
+	static constexpr u32 kMaxShaderResources = 16;
+	static constexpr u32 kMaxSamplers = 8;
+	static constexpr u32 kMaxConstantBuffers = 8;
+
+	StateCache();
+
+	void init(ID3D11DeviceContext* pContext);
+
+	ID3D11DeviceContext* context() const { return m_pContext; }
+
+	// True when the context can bind part of a constant buffer.
+	bool supports_constant_offsets() const { return m_pContext1 != nullptr; }
+
+	// Forget all shadowed state, the next bind of everything is issued.
+	void invalidate();
+
+	// Input assembler
+	void set_topology(const D3D11_PRIMITIVE_TOPOLOGY kTopology);
+	void set_input_layout(ID3D11InputLayout* pLayout);
+	void set_vertex_buffer(const u32 kSlot, ID3D11Buffer* pBuffer, const u32 kStride, const u32 kOffset);
+	void set_index_buffer(ID3D11Buffer* pBuffer, const DXGI_FORMAT kFormat, const u32 kOffset);
+
+	// Shaders
+	void set_vertex_shader(ID3D11VertexShader* pShader);
+	void set_hull_shader(ID3D11HullShader* pShader);
+	void set_domain_shader(ID3D11DomainShader* pShader);
+	void set_geometry_shader(ID3D11GeometryShader* pShader);
+	void set_pixel_shader(ID3D11PixelShader* pShader);
+	void set_compute_shader(ID3D11ComputeShader* pShader);
+
+	// Resources, shader resources are staged until the next draw or flush.
+	void set_shader_resources(const ShaderStage::ShaderStageEnum kStage, const u32 kStartSlot, const u32 kCount, ID3D11ShaderResourceView* const* ppViews);
+	void set_samplers(const ShaderStage::ShaderStageEnum kStage, const u32 kStartSlot, const u32 kCount, ID3D11SamplerState* const* ppSamplers);
+	void set_constant_buffers(const ShaderStage::ShaderStageEnum kStage, const u32 kStartSlot, const u32 kCount, ID3D11Buffer* const* ppBuffers);
+
+	// Bind a range of a constant buffer, offsets are in 16 byte constants. Needs supports_constant_offsets().
+	void set_constant_buffer_range(const ShaderStage::ShaderStageEnum kStage, const u32 kSlot, ID3D11Buffer* pBuffer, const u32 kFirstConstant, const u32 kNumConstants);
+
+	// Compute shader UAVs, not shadowed so always issued. Binding a resource as a UAV unbinds its
+	// shader resource views behind the cache's back, set those slots to null through the cache first.
+	void set_compute_unordered_access_views(const u32 kStartSlot, const u32 kCount, ID3D11UnorderedAccessView* const* ppViews);
+
+	// Issue any staged shader resources.
+	void flush();
+
+	// Draws flush first.
+	void draw(const u32 kVertexCount, const u32 kStartVertex);
+	void draw_indexed(const u32 kIndexCount, const u32 kStartIndex, const s32 kBaseVertex);
+	void draw_indexed_instanced(const u32 kIndexCount, const u32 kInstanceCount, const u32 kStartIndex, const s32 kBaseVertex, const u32 kStartInstance);
+	void draw_indexed_instanced_indirect(ID3D11Buffer* pArgs, const u32 kArgsOffset);
+
+	// Dispatches flush first too.
+	void dispatch(const u32 kGroupsX, const u32 kGroupsY, const u32 kGroupsZ);
+
+	const StateCacheStats& stats() const { return m_stats; }
+	void reset_stats() { m_stats = {}; }
+
+private:
+	template<typename T>
+	bool changed(T*& rShadow, T* pValue)
+	{
+		if (rShadow == pValue)
+		{
+			m_stats.skipped++;
+			return false;
+		}
+		rShadow = pValue;
+		m_stats.issued++;
+		return true;
+	}
+
+	ID3D11DeviceContext* m_pContext;
+	ComPtr<ID3D11DeviceContext1> m_pContext1;
+
+	D3D11_PRIMITIVE_TOPOLOGY m_topology;
+	ID3D11InputLayout* m_pInputLayout;
+	ID3D11Buffer* m_vertexBuffers[kMaxVertexBuffers];
+	u32 m_vertexStrides[kMaxVertexBuffers];
+	u32 m_vertexOffsets[kMaxVertexBuffers];
+	ID3D11Buffer* m_pIndexBuffer;
+	DXGI_FORMAT m_indexFormat;
+	u32 m_indexOffset;
+
+	ID3D11VertexShader* m_pVS;
+	ID3D11HullShader* m_pHS;
+	ID3D11DomainShader* m_pDS;
+	ID3D11GeometryShader* m_pGS;
+	ID3D11PixelShader* m_pPS;
+	ID3D11ComputeShader* m_pCS;
+
+	// Bound and staged shader resources, dirty range is [m_srvDirtyMin, m_srvDirtyMax).
+	ID3D11ShaderResourceView* m_srvs[ShaderStage::kMaxStages][kMaxShaderResources];
+	ID3D11ShaderResourceView* m_pendingSrvs[ShaderStage::kMaxStages][kMaxShaderResources];
+	u32 m_srvDirtyMin[ShaderStage::kMaxStages];
+	u32 m_srvDirtyMax[ShaderStage::kMaxStages];
+
+	ID3D11SamplerState* m_samplers[ShaderStage::kMaxStages][kMaxSamplers];
+	ID3D11Buffer* m_constantBuffers[ShaderStage::kMaxStages][kMaxConstantBuffers];
+
+	// Bound range of each constant buffer, a count of zero is the whole buffer.
+	u32 m_constantFirst[ShaderStage::kMaxStages][kMaxConstantBuffers];
+	u32 m_constantCount[ShaderStage::kMaxStages][kMaxConstantBuffers];
+
+	StateCacheStats m_stats;
+};
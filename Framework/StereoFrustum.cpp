@@ -0,0 +1,91 @@
+#include "StereoFrustum.h"
+
+namespace
+{
+	// Frustum with its apex kApexOffset behind the center point and the given tangents.
+	StereoCullFrustum build_cull_frustum(const m4x4& centerView, const f32 kUp, const f32 kDown, const f32 kLeft, const f32 kRight,
+		const f32 kApexOffset, const f32 kNear, const f32 kFar)
+	{
+		StereoCullFrustum frustum;
+		frustum.apexOffset = kApexOffset;
+
+		// Moving the apex back does not narrow the frustum vertically, the up and down tangents carry over.
+		const f32 kApexNear = kNear + frustum.apexOffset;
+		const f32 kApexFar = kFar + frustum.apexOffset;
+
+		// View space is left handed (SIMPLE_MATHS_LEFT_HANDED) and looks down +z, so the apex is at -z in the center's view space.
+		frustum.view = centerView * m4x4::CreateTranslation(0.f, 0.f, frustum.apexOffset);
+		frustum.proj = m4x4::CreatePerspectiveOffCenter(-kLeft * kApexNear, kRight * kApexNear, -kDown * kApexNear, kUp * kApexNear, kApexNear, kApexFar);
+		frustum.viewProj = frustum.view * frustum.proj;
+
+		extract_frustum_planes(frustum.viewProj, frustum.planes);
+		return frustum;
+	}
+
+	// Widest tangent of either eye on every side.
+	FovTangents widest_fov_tangents(const FovTangents& leftEye, const FovTangents& rightEye)
+	{
+		return { std::max(leftEye.up, rightEye.up), std::max(leftEye.down, rightEye.down),
+			std::max(leftEye.left, rightEye.left), std::max(leftEye.right, rightEye.right) };
+	}
+}
+
+StereoCullFrustum compute_stereo_cull_frustum(const m4x4& centerView, const FovTangents& leftEye, const FovTangents& rightEye,
+	const f32 kEyeSeparation, const f32 kNear, const f32 kFar)
+{
+	ASSERT(kNear > 0.f && kFar > kNear);
+
+	const FovTangents kFov = widest_fov_tangents(leftEye, rightEye);
+	ASSERT(kFov.left > 0.f && kFov.right > 0.f);
+
+	// Far enough back that both the left and right planes clear the outer eye.
+	const f32 kApexOffset = (0.5f * std::max(kEyeSeparation, 0.f)) / std::min(kFov.left, kFov.right);
+	return build_cull_frustum(centerView, kFov.up, kFov.down, kFov.left, kFov.right, kApexOffset, kNear, kFar);
+}
+
+FovTangents widen_fov_tangents(const FovTangents& fov, const f32 kAngle)
+{
+	// Directions within kAngle of a side's edge must stay kAngle inside the widened plane. The corners
+	// are furthest from it, for the edge tangent t and across tangent c they need the new tangent w with
+	//   (w - t) / sqrt(1 + w * w) = sin(kAngle) * sqrt(1 + t * t + c * c)
+	const f32 kSin = sinf(std::max(kAngle, 0.f));
+	auto widen = [kSin](const f32 kTangent, const f32 kAcross)
+	{
+		const f32 kS = std::min(kSin * sqrtf(1.f + kTangent * kTangent + kAcross * kAcross), 0.99f);
+		return (kTangent + kS * sqrtf(1.f + kTangent * kTangent - kS * kS)) / (1.f - kS * kS);
+	};
+	const f32 kVertical = std::max(fov.up, fov.down);
+	const f32 kHorizontal = std::max(fov.left, fov.right);
+	return { widen(fov.up, kHorizontal), widen(fov.down, kHorizontal), widen(fov.left, kVertical), widen(fov.right, kVertical) };
+}
+
+StereoCullFrustum compute_expanded_stereo_cull_frustum(const m4x4& centerView, const FovTangents& leftEye, const FovTangents& rightEye,
+	const f32 kEyeSeparation, const f32 kNear, const f32 kFar, const f32 kMaxAngle, const f32 kMaxDistance)
+{
+	ASSERT(kNear > 0.f && kFar > kNear && kMaxAngle >= 0.f && kMaxDistance >= 0.f);
+
+	const FovTangents kFov = widen_fov_tangents(widest_fov_tangents(leftEye, rightEye), kMaxAngle);
+	ASSERT(kFov.left > 0.f && kFov.right > 0.f && kFov.up > 0.f && kFov.down > 0.f);
+
+	// Turning about the center point moves each eye along a chord as well, it adds to the distance moved.
+	const f32 kMoved = kMaxDistance + std::max(kEyeSeparation, 0.f) * sinf(0.5f * kMaxAngle);
+
+	// A point s back along the axis is s * sin(half angle) from each side plane, the narrowest side decides.
+	const f32 kNarrowest = std::min(std::min(kFov.left, kFov.right), std::min(kFov.up, kFov.down));
+	const f32 kSinNarrowest = kNarrowest / sqrtf(1.f + kNarrowest * kNarrowest);
+	const f32 kApexOffset = (0.5f * std::max(kEyeSeparation, 0.f)) / std::min(kFov.left, kFov.right) + kMoved / kSinNarrowest;
+
+	// Near and far are measured from the eyes. Turning swings the corners of the near and far rectangles,
+	// a point d ahead and r to the side ends up between d cos(a) - r sin(a) and d cos(a) + r sin(a) ahead.
+	const FovTangents kEyeFov = widest_fov_tangents(leftEye, rightEye);
+	const f32 kHorizontal = std::max(kEyeFov.left, kEyeFov.right);
+	const f32 kVertical = std::max(kEyeFov.up, kEyeFov.down);
+	const f32 kSide = sqrtf(kHorizontal * kHorizontal + kVertical * kVertical);
+	const f32 kCos = cosf(kMaxAngle);
+	const f32 kSin = sinf(kMaxAngle);
+	const f32 kExpandedNear = kNear * (kCos - kSide * kSin) - kMoved;
+	const f32 kExpandedFar = kFar * (kCos + kSide * kSin) + kMoved;
+
+	// A turn so wide the near corners swing behind the eyes still keeps the near plane ahead of the apex.
+	return build_cull_frustum(centerView, kFov.up, kFov.down, kFov.left, kFov.right, kApexOffset, std::max(kExpandedNear, -0.5f * kApexOffset), kExpandedFar);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include "Culling.h"
+
+// Tangents of the half angles of an eye's field of view, same order as ovrFovPort.
+struct FovTangents
+{
+	f32 up;
+	f32 down;
+	f32 left;
+	f32 right;
+};
+
+//================================================================================
+// Stereo Cull Frustum
+// A single frustum that encloses both eye frusta so one culling pass serves
+// both eyes.
+//
+// The eyes sit either side of a center point and look the same way. The union
+// frustum takes the widest tangent of the two eyes on each side and moves
+// its apex back behind the center until the outer planes pass the eyes:
+//
+//      \  left eye   right eye  /
+//       \    *-----+-----*     /    <- eyes, separation apart
+//        \         |          /
+//         \        |  apexOffset = halfSeparation / min(left, right)
+//          \       |        /
+//                apex
+//================================================================================
+struct StereoCullFrustum
+{
+	m4x4 view;       // looks from the apex
+	m4x4 proj;
+	m4x4 viewProj;
+	v4   planes[kNumFrustumPlanes];
+	f32  apexOffset; // distance of the apex behind the center point
+};
+
+// centerView is the view matrix at the midpoint between the eyes, kEyeSeparation is the distance
+// between the eyes along its x axis. Near and far are measured from the eyes.
+StereoCullFrustum compute_stereo_cull_frustum(const m4x4& centerView, const FovTangents& leftEye, const FovTangents& rightEye,
+	const f32 kEyeSeparation, const f32 kNear, const f32 kFar);
+
+// Tangents widened so every direction within kAngle radians of the field of view is inside it.
+FovTangents widen_fov_tangents(const FovTangents& fov, const f32 kAngle);
+
+// The stereo cull frustum grown to hold the eyes after turning up to kMaxAngle radians about the
+// center point and moving up to kMaxDistance, for culling with a pose that is replaced by a later
+// one before drawing. The sides widen by the angle, the apex moves back until a ball of everything
+// the eyes can move around the original apex is inside every side plane, and near and far move to
+// where the turned corners of the eyes' near and far rectangles can reach.
+StereoCullFrustum compute_expanded_stereo_cull_frustum(const m4x4& centerView, const FovTangents& leftEye, const FovTangents& rightEye,
+	const f32 kEyeSeparation, const f32 kNear, const f32 kFar, const f32 kMaxAngle, const f32 kMaxDistance);
@@ -1,6 +1,7 @@
 #include "Texture.h"
 #include "DirectXTK/DDSTextureLoader.h"
 #include "DirectXTK/WICTextureLoader.h"
+#include "StateCache.h"
 
 Texture::Texture()
 	: m_pTexture(nullptr)
@@ -43,9 +44,8 @@ void Texture::init_from_image(ID3D11Device* pDevice, const char* pFilename, bool
 
 void Texture::bind(ID3D11DeviceContext* pDeviceContext, ShaderStage::ShaderStageEnum stage, u32 slot) const
 {
-	// This is not very efficient.
-	// We could bind multiple in a single call.
-	// An opportunity for you to change ;)
+	// This is not very efficient, one call per slot.
+	// Binding through a StateCache merges adjacent slots into a single call.
 
 	switch (stage)
 	{
@@ -69,3 +69,8 @@ void Texture::bind(ID3D11DeviceContext* pDeviceContext, ShaderStage::ShaderStage
 		break;
 	}
 }
+
+void Texture::bind(StateCache& rState, ShaderStage::ShaderStageEnum stage, u32 slot) const
+{
+	rState.set_shader_resources(stage, slot, 1, &m_pTextureView);
+}
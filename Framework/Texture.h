@@ -3,6 +3,8 @@
 #include "CommonHeader.h"
 #include "ShaderSet.h"
 
+class StateCache;
+
 class Texture
 {
 
@@ -20,6 +22,11 @@ public:
 	// bind to the pipeline on a particular shader and slot
 	void bind(ID3D11DeviceContext* pDeviceContext, ShaderStage::ShaderStageEnum stage, u32 slot) const;
 
+	// bind through a state cache, adjacent slots are merged into one call on the next draw
+	void bind(StateCache& rState, ShaderStage::ShaderStageEnum stage, u32 slot) const;
+
+	ID3D11ShaderResourceView* view() const { return m_pTextureView; }
+
 private:
 	ID3D11Resource* m_pTexture;
 	ID3D11ShaderResourceView* m_pTextureView;
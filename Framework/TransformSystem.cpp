@@ -0,0 +1,354 @@
+#include "TransformSystem.h"
+
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace
+{
+	// Local matrix of one transform, same arithmetic as the SSE kernel.
+	void compose_local(const f32 tx, const f32 ty, const f32 tz, const f32 rx, const f32 ry, const f32 rz, const f32 rw,
+		const f32 sx, const f32 sy, const f32 sz, m4x4& rOut)
+	{
+		const f32 x2 = rx + rx, y2 = ry + ry, z2 = rz + rz;
+		const f32 xx = rx * x2, yy = ry * y2, zz = rz * z2;
+		const f32 xy = rx * y2, xz = rx * z2, yz = ry * z2;
+		const f32 wx = rw * x2, wy = rw * y2, wz = rw * z2;
+
+		rOut._11 = (1.f - (yy + zz)) * sx; rOut._12 = (xy + wz) * sx;         rOut._13 = (xz - wy) * sx;         rOut._14 = 0.f;
+		rOut._21 = (xy - wz) * sy;         rOut._22 = (1.f - (xx + zz)) * sy; rOut._23 = (yz + wx) * sy;         rOut._24 = 0.f;
+		rOut._31 = (xz + wy) * sz;         rOut._32 = (yz - wx) * sz;         rOut._33 = (1.f - (xx + yy)) * sz; rOut._34 = 0.f;
+		rOut._41 = tx;                     rOut._42 = ty;                     rOut._43 = tz;                     rOut._44 = 1.f;
+	}
+
+	// local * parent for affine matrices, same arithmetic as the SSE kernel.
+	void compose_world(const m4x4& local, const m4x4& parent, m4x4& rOut)
+	{
+		const f32* pL = &local._11;
+		const f32* pP = &parent._11;
+		f32* pOut = &rOut._11;
+		for (u32 row = 0; row < 4; ++row)
+		{
+			const f32* pRow = pL + row * 4;
+			for (u32 column = 0; column < 4; ++column)
+			{
+				f32 value = pRow[0] * pP[column] + pRow[1] * pP[4 + column] + pRow[2] * pP[8 + column];
+				if (row == 3)
+				{
+					value += pP[12 + column];
+				}
+				pOut[row * 4 + column] = value;
+			}
+		}
+	}
+
+	// Each row of the result is the parent's first three rows weighted by the local row, plus the parent's translation for the last.
+	void compose_world_sse(const m4x4& local, const m4x4& parent, m4x4& rOut)
+	{
+		const __m128 p0 = _mm_loadu_ps(&parent._11);
+		const __m128 p1 = _mm_loadu_ps(&parent._21);
+		const __m128 p2 = _mm_loadu_ps(&parent._31);
+		const __m128 p3 = _mm_loadu_ps(&parent._41);
+
+		const f32* pL = &local._11;
+		f32* pOut = &rOut._11;
+		for (u32 row = 0; row < 4; ++row)
+		{
+			const f32* pRow = pL + row * 4;
+			__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pRow[0]), p0), _mm_mul_ps(_mm_set1_ps(pRow[1]), p1)), _mm_mul_ps(_mm_set1_ps(pRow[2]), p2));
+			if (row == 3)
+			{
+				value = _mm_add_ps(value, p3);
+			}
+			_mm_storeu_ps(pOut + row * 4, value);
+		}
+	}
+
+	u32 lowest_bit(const u64 kBits)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, kBits);
+		return (u32)index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long)kBits))
+		{
+			return (u32)index;
+		}
+		_BitScanForward(&index, (unsigned long)(kBits >> 32));
+		return (u32)index + 32;
+#else
+		return (u32)__builtin_ctzll(kBits);
+#endif
+	}
+
+	// 4 consecutive floats when the indices are consecutive, a gather otherwise.
+	__m128 load4(const std::vector<f32>& values, const u32* pIndices, const bool kConsecutive)
+	{
+		return kConsecutive ? _mm_loadu_ps(&values[pIndices[0]]) : _mm_setr_ps(values[pIndices[0]], values[pIndices[1]], values[pIndices[2]], values[pIndices[3]]);
+	}
+}
+
+constexpr u32 TransformSystem::kNoParent;
+
+void TransformSystem::clear()
+{
+	m_tx.clear(); m_ty.clear(); m_tz.clear();
+	m_rx.clear(); m_ry.clear(); m_rz.clear(); m_rw.clear();
+	m_sx.clear(); m_sy.clear(); m_sz.clear();
+	m_parent.clear();
+	m_firstChild.clear();
+	m_nextSibling.clear();
+	m_local.clear();
+	m_world.clear();
+	m_changed.clear();
+	m_dirtyLocals.clear();
+	m_localDirty.clear();
+	m_dirtyBits.clear();
+	m_dirtyWords.clear();
+}
+
+void TransformSystem::reserve(const u32 kCount)
+{
+	m_tx.reserve(kCount); m_ty.reserve(kCount); m_tz.reserve(kCount);
+	m_rx.reserve(kCount); m_ry.reserve(kCount); m_rz.reserve(kCount); m_rw.reserve(kCount);
+	m_sx.reserve(kCount); m_sy.reserve(kCount); m_sz.reserve(kCount);
+	m_parent.reserve(kCount);
+	m_firstChild.reserve(kCount);
+	m_nextSibling.reserve(kCount);
+	m_local.reserve(kCount);
+	m_world.reserve(kCount);
+	m_changed.reserve(kCount);
+	m_dirtyLocals.reserve(kCount);
+	m_localDirty.reserve(kCount);
+	m_dirtyBits.reserve((kCount + 63) / 64);
+	m_dirtyWords.reserve((kCount + 4095) / 4096);
+}
+
+u32 TransformSystem::create(const u32 kParent, const v3& translation, const quat& rotation, const v3& scale)
+{
+	const u32 kIndex = size();
+	ASSERT(kParent == kNoParent || kParent < kIndex);
+
+	m_tx.push_back(translation.x); m_ty.push_back(translation.y); m_tz.push_back(translation.z);
+	m_rx.push_back(rotation.x); m_ry.push_back(rotation.y); m_rz.push_back(rotation.z); m_rw.push_back(rotation.w);
+	m_sx.push_back(scale.x); m_sy.push_back(scale.y); m_sz.push_back(scale.z);
+	m_parent.push_back(kParent);
+	m_firstChild.push_back(kNoParent);
+	m_nextSibling.push_back(kNoParent);
+	m_local.push_back(m4x4::Identity);
+	m_world.push_back(m4x4::Identity);
+	m_localDirty.push_back(0);
+
+	if (kParent != kNoParent)
+	{
+		m_nextSibling[kIndex] = m_firstChild[kParent];
+		m_firstChild[kParent] = kIndex;
+	}
+
+	m_dirtyBits.resize((size() + 63) / 64, 0);
+	m_dirtyWords.resize((m_dirtyBits.size() + 63) / 64, 0);
+
+	mark_dirty(kIndex);
+	return kIndex;
+}
+
+void TransformSystem::set_translation(const u32 i, const v3& translation)
+{
+	m_tx[i] = translation.x; m_ty[i] = translation.y; m_tz[i] = translation.z;
+	mark_dirty(i);
+}
+
+void TransformSystem::set_rotation(const u32 i, const quat& rotation)
+{
+	m_rx[i] = rotation.x; m_ry[i] = rotation.y; m_rz[i] = rotation.z; m_rw[i] = rotation.w;
+	mark_dirty(i);
+}
+
+void TransformSystem::set_scale(const u32 i, const v3& scale)
+{
+	m_sx[i] = scale.x; m_sy[i] = scale.y; m_sz[i] = scale.z;
+	mark_dirty(i);
+}
+
+void TransformSystem::set_local(const u32 i, const v3& translation, const quat& rotation, const v3& scale)
+{
+	m_tx[i] = translation.x; m_ty[i] = translation.y; m_tz[i] = translation.z;
+	m_rx[i] = rotation.x; m_ry[i] = rotation.y; m_rz[i] = rotation.z; m_rw[i] = rotation.w;
+	m_sx[i] = scale.x; m_sy[i] = scale.y; m_sz[i] = scale.z;
+	mark_dirty(i);
+}
+
+void TransformSystem::mark_dirty(const u32 i)
+{
+	if (!m_localDirty[i])
+	{
+		m_localDirty[i] = 1;
+		m_dirtyLocals.push_back(i);
+	}
+}
+
+void TransformSystem::mark_subtree(const u32 kRoot)
+{
+	// A set bit means its whole subtree is already on the way, so walks stop there.
+	if (m_dirtyBits[kRoot >> 6] & (1ull << (kRoot & 63)))
+	{
+		return;
+	}
+
+	m_stack.push_back(kRoot);
+	while (!m_stack.empty())
+	{
+		const u32 i = m_stack.back();
+		m_stack.pop_back();
+		m_dirtyBits[i >> 6] |= 1ull << (i & 63);
+		m_dirtyWords[i >> 12] |= 1ull << ((i >> 6) & 63);
+
+		for (u32 child = m_firstChild[i]; child != kNoParent; child = m_nextSibling[child])
+		{
+			if (!(m_dirtyBits[child >> 6] & (1ull << (child & 63))))
+			{
+				m_stack.push_back(child);
+			}
+		}
+	}
+}
+
+void TransformSystem::compose_locals(const TransformKernel kernel)
+{
+	// Ascending, so runs of neighbours load straight from the arrays.
+	std::sort(m_dirtyLocals.begin(), m_dirtyLocals.end());
+	const u32 kCount = (u32)m_dirtyLocals.size();
+	const u32* pIndices = m_dirtyLocals.data();
+
+	// Local matrices don't depend on each other, so they can go 4 at a time.
+	u32 n = 0;
+	if (kernel == TransformKernel::kSSE)
+	{
+		const __m128 kOne = _mm_set1_ps(1.f);
+		const __m128 kZero = _mm_setzero_ps();
+
+		for (; n + 4 <= kCount; n += 4)
+		{
+			const u32* pGroup = pIndices + n;
+			const bool kConsecutive = pGroup[3] == pGroup[0] + 3;
+
+			const __m128 rx = load4(m_rx, pGroup, kConsecutive), ry = load4(m_ry, pGroup, kConsecutive), rz = load4(m_rz, pGroup, kConsecutive), rw = load4(m_rw, pGroup, kConsecutive);
+			const __m128 sx = load4(m_sx, pGroup, kConsecutive), sy = load4(m_sy, pGroup, kConsecutive), sz = load4(m_sz, pGroup, kConsecutive);
+
+			const __m128 x2 = _mm_add_ps(rx, rx), y2 = _mm_add_ps(ry, ry), z2 = _mm_add_ps(rz, rz);
+			const __m128 xx = _mm_mul_ps(rx, x2), yy = _mm_mul_ps(ry, y2), zz = _mm_mul_ps(rz, z2);
+			const __m128 xy = _mm_mul_ps(rx, y2), xz = _mm_mul_ps(rx, z2), yz = _mm_mul_ps(ry, z2);
+			const __m128 wx = _mm_mul_ps(rw, x2), wy = _mm_mul_ps(rw, y2), wz = _mm_mul_ps(rw, z2);
+
+			// Each register holds one matrix element for the 4 transforms.
+			__m128 row0[4] = {
+				_mm_mul_ps(_mm_sub_ps(kOne, _mm_add_ps(yy, zz)), sx),
+				_mm_mul_ps(_mm_add_ps(xy, wz), sx),
+				_mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+				kZero };
+			__m128 row1[4] = {
+				_mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+				_mm_mul_ps(_mm_sub_ps(kOne, _mm_add_ps(xx, zz)), sy),
+				_mm_mul_ps(_mm_add_ps(yz, wx), sy),
+				kZero };
+			__m128 row2[4] = {
+				_mm_mul_ps(_mm_add_ps(xz, wy), sz),
+				_mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+				_mm_mul_ps(_mm_sub_ps(kOne, _mm_add_ps(xx, yy)), sz),
+				kZero };
+			__m128 row3[4] = { load4(m_tx, pGroup, kConsecutive), load4(m_ty, pGroup, kConsecutive), load4(m_tz, pGroup, kConsecutive), kOne };
+
+			// Transposing turns element per register into row per register, one register per transform.
+			_MM_TRANSPOSE4_PS(row0[0], row0[1], row0[2], row0[3]);
+			_MM_TRANSPOSE4_PS(row1[0], row1[1], row1[2], row1[3]);
+			_MM_TRANSPOSE4_PS(row2[0], row2[1], row2[2], row2[3]);
+			_MM_TRANSPOSE4_PS(row3[0], row3[1], row3[2], row3[3]);
+
+			for (u32 lane = 0; lane < 4; ++lane)
+			{
+				m4x4& rLocal = m_local[pGroup[lane]];
+				_mm_storeu_ps(&rLocal._11, row0[lane]);
+				_mm_storeu_ps(&rLocal._21, row1[lane]);
+				_mm_storeu_ps(&rLocal._31, row2[lane]);
+				_mm_storeu_ps(&rLocal._41, row3[lane]);
+			}
+		}
+	}
+
+	// The scalar kernel, and the tail the SSE kernel leaves.
+	for (; n < kCount; ++n)
+	{
+		const u32 i = pIndices[n];
+		compose_local(m_tx[i], m_ty[i], m_tz[i], m_rx[i], m_ry[i], m_rz[i], m_rw[i], m_sx[i], m_sy[i], m_sz[i], m_local[i]);
+	}
+
+	for (const u32 i : m_dirtyLocals)
+	{
+		m_localDirty[i] = 0;
+	}
+}
+
+u32 TransformSystem::update()
+{
+	return update(TransformKernel::kSSE);
+}
+
+u32 TransformSystem::update(const TransformKernel kernel)
+{
+	m_changed.clear();
+	if (m_dirtyLocals.empty())
+	{
+		return 0;
+	}
+
+	// Flag every transform below a dirty one, visiting only the dirty subtrees.
+	for (const u32 i : m_dirtyLocals)
+	{
+		mark_subtree(i);
+	}
+	compose_locals(kernel);
+	m_dirtyLocals.clear();
+
+	// Read the flags back in index order, clearing them on the way.
+	for (u32 group = 0; group < (u32)m_dirtyWords.size(); ++group)
+	{
+		u64 words = m_dirtyWords[group];
+		m_dirtyWords[group] = 0;
+		while (words)
+		{
+			const u32 kWord = group * 64 + lowest_bit(words);
+			words &= words - 1;
+
+			u64 bits = m_dirtyBits[kWord];
+			m_dirtyBits[kWord] = 0;
+			while (bits)
+			{
+				m_changed.push_back(kWord * 64 + lowest_bit(bits));
+				bits &= bits - 1;
+			}
+		}
+	}
+
+	// Worlds in order, so each parent is finished before its children read it.
+	for (const u32 i : m_changed)
+	{
+		const u32 kParent = m_parent[i];
+		if (kParent == kNoParent)
+		{
+			m_world[i] = m_local[i];
+		}
+		else if (kernel == TransformKernel::kSSE)
+		{
+			compose_world_sse(m_local[i], m_world[kParent], m_world[i]);
+		}
+		else
+		{
+			compose_world(m_local[i], m_world[kParent], m_world[i]);
+		}
+	}
+
+	return (u32)m_changed.size();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+//================================================================================
+// Transform System
+// Local translation, rotation and scale in structure of arrays layout with a
+// world matrix per transform.
+//
+// Parents are created before their children, so the arrays are in topological
+// order and one forward pass propagates changes down the hierarchy.
+//
+// Setting a local value adds the transform to a dirty list. update() walks the
+// subtree below each dirty transform through the child lists, flagging every
+// transform it reaches in a two level bitmask, then reads the bitmask back in
+// ascending order. Parents come out before their children, and the cost
+// follows the size of the dirty subtrees rather than the number of transforms.
+// The transforms updated are listed in changed() so consumers (bounds, GPU
+// instance data) only touch what moved. With nothing dirty update() returns
+// straight away.
+//
+// Matrices are row vector, world = local * parent world, local = S * R * T.
+// Both are affine, so the last column is never read.
+//================================================================================
+enum class TransformKernel
+{
+	kScalar,
+	kSSE,  // local matrices of 4 transforms per iteration, worlds a row per register
+};
+
+class TransformSystem
+{
+public:
+	static constexpr u32 kNoParent = 0xFFFFFFFF;
+
+	void clear();
+	void reserve(const u32 kCount);
+
+	// Add a transform below kParent (or kNoParent), which must already exist. Starts dirty.
+	u32 create(const u32 kParent, const v3& translation, const quat& rotation, const v3& scale);
+
+	void set_translation(const u32 i, const v3& translation);
+	void set_rotation(const u32 i, const quat& rotation);
+	void set_scale(const u32 i, const v3& scale);
+	void set_local(const u32 i, const v3& translation, const quat& rotation, const v3& scale);
+
+	// Recompute the dirty subtrees, returns the number of world matrices updated.
+	// The same kernel for every call gives the same matrices.
+	u32 update();
+	u32 update(const TransformKernel kernel);
+
+	u32 size() const { return (u32)m_parent.size(); }
+	u32 parent(const u32 i) const { return m_parent[i]; }
+	const m4x4& world(const u32 i) const { return m_world[i]; }
+	const m4x4& local(const u32 i) const { return m_local[i]; }
+
+	// Transforms whose world matrix changed in the last update, in ascending order.
+	const std::vector<u32>& changed() const { return m_changed; }
+
+private:
+	void mark_dirty(const u32 i);
+	void mark_subtree(const u32 kRoot);
+	void compose_locals(const TransformKernel kernel);
+
+	// Local TRS, one array per component.
+	std::vector<f32> m_tx, m_ty, m_tz;
+	std::vector<f32> m_rx, m_ry, m_rz, m_rw;
+	std::vector<f32> m_sx, m_sy, m_sz;
+
+	// Hierarchy, children as a singly linked list per parent.
+	std::vector<u32> m_parent;
+	std::vector<u32> m_firstChild;
+	std::vector<u32> m_nextSibling;
+
+	std::vector<m4x4> m_local;
+	std::vector<m4x4> m_world;
+	std::vector<u32> m_changed;
+
+	// Transforms whose local values were set since the last update, unordered.
+	std::vector<u32> m_dirtyLocals;
+	std::vector<u8> m_localDirty;
+
+	// A bit per transform to update, and a bit per non zero word of those.
+	std::vector<u64> m_dirtyBits;
+	std::vector<u64> m_dirtyWords;
+	std::vector<u32> m_stack;
+};
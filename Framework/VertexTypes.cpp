@@ -0,0 +1,102 @@
+#include "VertexTypes.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Position and Colour
+//////////////////////////////////////////////////////////////////////////
+Vertex_Pos3fColour4ub::Vertex_Pos3fColour4ub() :
+	pos(0.f, 0.f, 0.f)
+{
+}
+
+Vertex_Pos3fColour4ub::Vertex_Pos3fColour4ub(const DirectX::XMFLOAT3 &posArg, VertexColour colourArg) :
+	pos(posArg.x, posArg.y, posArg.z),
+	colour(colourArg)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour and Texture Coordinate
+//////////////////////////////////////////////////////////////////////////
+Vertex_Pos3fTex2fColour4ub::Vertex_Pos3fTex2fColour4ub() :
+	pos(0.f, 0.f, 0.f),
+	tex(0.f, 0.f),
+	colour(0xFFFFffff)
+{
+
+}
+
+Vertex_Pos3fTex2fColour4ub::Vertex_Pos3fTex2fColour4ub(const DirectX::XMFLOAT3 &posArg, const DirectX::XMFLOAT2 &texArg, VertexColour colourArg) :
+	pos(posArg.x, posArg.y, posArg.z),
+	tex(texArg.x, texArg.y),
+	colour(colourArg)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour and Normal
+//////////////////////////////////////////////////////////////////////////
+Vertex_Pos3fColour4ubNormal3f::Vertex_Pos3fColour4ubNormal3f() :
+	pos(0.f, 0.f, 0.f),
+	normal(0.f, 0.f, 0.f)
+{
+}
+
+Vertex_Pos3fColour4ubNormal3f::Vertex_Pos3fColour4ubNormal3f(const DirectX::XMFLOAT3 &posArg, VertexColour colourArg, const DirectX::XMFLOAT3 &normalArg) :
+	pos(posArg.x, posArg.y, posArg.z),
+	colour(colourArg),
+	normal(normalArg.x, normalArg.y, normalArg.z)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour, Normal and Texture
+//////////////////////////////////////////////////////////////////////////
+Vertex_Pos3fColour4ubNormal3fTex2f::Vertex_Pos3fColour4ubNormal3fTex2f() :
+	pos(0.f, 0.f, 0.f),
+	colour(0xFFFFffff),
+	normal(0.f, 0.f, 0.f),
+	tex(0.f, 0.f)
+{
+}
+
+Vertex_Pos3fColour4ubNormal3fTex2f::Vertex_Pos3fColour4ubNormal3fTex2f(const DirectX::XMFLOAT3 &posArg, VertexColour colourArg, const DirectX::XMFLOAT3 &normalArg, const DirectX::XMFLOAT2 &texArg) :
+	pos(posArg.x, posArg.y, posArg.z),
+	colour(colourArg),
+	normal(normalArg.x, normalArg.y, normalArg.z),
+	tex(texArg.x, texArg.y)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour, Normal, Tangent (+sign) and Texture
+//////////////////////////////////////////////////////////////////////////
+Vertex_Pos3fColour4ubNormal3fTangent3fTex2f::Vertex_Pos3fColour4ubNormal3fTangent3fTex2f() :
+	pos(0.f, 0.f, 0.f),
+	colour(0xFFFFffff),
+	normal(0.f, 0.f, 0.f),
+	tangent(0.f, 0.f, 0.f, 0.0f),
+	tex(0.f, 0.f)
+{
+
+}
+
+Vertex_Pos3fColour4ubNormal3fTangent3fTex2f::Vertex_Pos3fColour4ubNormal3fTangent3fTex2f(const DirectX::XMFLOAT3 &posArg, VertexColour colourArg, const DirectX::XMFLOAT3 &normalArg, const DirectX::XMFLOAT2 &texArg) :
+	pos(posArg.x, posArg.y, posArg.z),
+	colour(colourArg),
+	normal(normalArg.x, normalArg.y, normalArg.z),
+	tangent(0.f, 0.f, 0.f, 0.0f),
+	tex(texArg.x, texArg.y)
+{
+
+}
+
+Vertex_Pos3fColour4ubNormal3fTangent3fTex2f::Vertex_Pos3fColour4ubNormal3fTangent3fTex2f(const DirectX::XMFLOAT3 &posArg, VertexColour colourArg, const DirectX::XMFLOAT3 &normalArg, const DirectX::XMFLOAT4 &tangentArg, const DirectX::XMFLOAT2 &texArg) :
+	pos(posArg.x, posArg.y, posArg.z),
+	colour(colourArg),
+	normal(normalArg.x, normalArg.y, normalArg.z),
+	tangent(tangentArg),
+	tex(texArg.x, texArg.y)
+{
+
+}
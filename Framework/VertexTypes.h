@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreHeader.h"
+
+//////////////////////////////////////////////////////////////////////
+// Vertex Types.
+// The vertex layouts themselves, their D3D input descriptions are in
+// VertexFormats.h.
+//////////////////////////////////////////////////////////////////////
+
+using VertexColour = u32;
+
+//////////////////////////////////////////////////////////////////////////
+// Position and Colour
+//////////////////////////////////////////////////////////////////////////
+struct Vertex_Pos3fColour4ub
+{
+	DirectX::XMFLOAT3 pos;
+	VertexColour colour;
+
+	Vertex_Pos3fColour4ub();
+	Vertex_Pos3fColour4ub(const DirectX::XMFLOAT3 &pos, VertexColour colour);
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour and Texture Coordinate
+//////////////////////////////////////////////////////////////////////////
+struct Vertex_Pos3fTex2fColour4ub
+{
+	DirectX::XMFLOAT3 pos;
+	DirectX::XMFLOAT2 tex;
+	VertexColour colour;
+
+	Vertex_Pos3fTex2fColour4ub();
+	Vertex_Pos3fTex2fColour4ub(const DirectX::XMFLOAT3 &pos, const DirectX::XMFLOAT2 &tex, VertexColour colour);
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour and Normal
+//////////////////////////////////////////////////////////////////////////
+struct Vertex_Pos3fColour4ubNormal3f
+{
+	DirectX::XMFLOAT3 pos;
+	VertexColour colour;
+	DirectX::XMFLOAT3 normal;
+
+	Vertex_Pos3fColour4ubNormal3f();
+	Vertex_Pos3fColour4ubNormal3f(const DirectX::XMFLOAT3 &pos, VertexColour colour, const DirectX::XMFLOAT3 &normal);
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour, Normal and Texture 
+//////////////////////////////////////////////////////////////////////////
+struct Vertex_Pos3fColour4ubNormal3fTex2f
+{
+	DirectX::XMFLOAT3 pos;
+	VertexColour colour;
+	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT2 tex;
+
+	Vertex_Pos3fColour4ubNormal3fTex2f();
+	Vertex_Pos3fColour4ubNormal3fTex2f(const DirectX::XMFLOAT3 &pos, VertexColour colour, const DirectX::XMFLOAT3 &normal, const DirectX::XMFLOAT2 &tex);
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Position, Colour, Normal, Tangent (+sign) and Texture 
+//////////////////////////////////////////////////////////////////////////
+struct Vertex_Pos3fColour4ubNormal3fTangent3fTex2f
+{
+	DirectX::XMFLOAT3 pos;
+	VertexColour colour;
+	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT4 tangent;
+	DirectX::XMFLOAT2 tex;
+
+	Vertex_Pos3fColour4ubNormal3fTangent3fTex2f();
+	Vertex_Pos3fColour4ubNormal3fTangent3fTex2f(const DirectX::XMFLOAT3 &pos, VertexColour colour, const DirectX::XMFLOAT3 &normal, const DirectX::XMFLOAT2 &tex);
+	Vertex_Pos3fColour4ubNormal3fTangent3fTex2f(const DirectX::XMFLOAT3 &pos, VertexColour colour, const DirectX::XMFLOAT3 &normal, const DirectX::XMFLOAT4 &tangent, const DirectX::XMFLOAT2 &tex);
+};
@@ -0,0 +1,61 @@
+#include "ViewLayout.h"
+
+ViewTransform compute_view_transform(const ViewRect& viewport, const ViewRect& view)
+{
+	ASSERT(viewport.width > 0.f && viewport.height > 0.f);
+
+	// Viewport ndc of the view's ndc u is u * scale + offset, y flips because pixels run down.
+	const f32 kScaleX = view.width / viewport.width;
+	const f32 kScaleY = view.height / viewport.height;
+	const f32 kOffsetX = (2.f * (view.x - viewport.x) + view.width) / viewport.width - 1.f;
+	const f32 kOffsetY = 1.f - (2.f * (view.y - viewport.y) + view.height) / viewport.height;
+
+	// Edges of the view in viewport ndc, the planes compare x and y against them scaled by w.
+	const f32 kLeft = kOffsetX - kScaleX;
+	const f32 kRight = kOffsetX + kScaleX;
+	const f32 kBottom = kOffsetY - kScaleY;
+	const f32 kTop = kOffsetY + kScaleY;
+
+	ViewTransform transform;
+	transform.scaleOffset = v4(kScaleX, kScaleY, kOffsetX, kOffsetY);
+	transform.clipPlanes[0] = v4(1.f, 0.f, 0.f, -kLeft);   // x >= left * w
+	transform.clipPlanes[1] = v4(-1.f, 0.f, 0.f, kRight);  // x <= right * w
+	transform.clipPlanes[2] = v4(0.f, 1.f, 0.f, -kBottom); // y >= bottom * w
+	transform.clipPlanes[3] = v4(0.f, -1.f, 0.f, kTop);    // y <= top * w
+	return transform;
+}
+
+m4x4 view_offset_matrix(const ViewTransform& transform)
+{
+	// Row vectors, so the offset goes in the w row to be scaled by clip w.
+	m4x4 m = m4x4::Identity;
+	m._11 = transform.scaleOffset.x;
+	m._22 = transform.scaleOffset.y;
+	m._41 = transform.scaleOffset.z;
+	m._42 = transform.scaleOffset.w;
+	return m;
+}
+
+ViewRect bounding_view_rect(const ViewRect* pRects, const u32 kCount)
+{
+	ASSERT(kCount > 0);
+	f32 minX = pRects[0].x;
+	f32 minY = pRects[0].y;
+	f32 maxX = pRects[0].x + pRects[0].width;
+	f32 maxY = pRects[0].y + pRects[0].height;
+	for (u32 i = 1; i < kCount; ++i)
+	{
+		minX = std::min(minX, pRects[i].x);
+		minY = std::min(minY, pRects[i].y);
+		maxX = std::max(maxX, pRects[i].x + pRects[i].width);
+		maxY = std::max(maxY, pRects[i].y + pRects[i].height);
+	}
+	return { minX, minY, maxX - minX, maxY - minY };
+}
+
+void split_view_rect_rows(const ViewRect& rect, ViewRect* pHalvesOut)
+{
+	const f32 kHalfHeight = 0.5f * rect.height;
+	pHalvesOut[0] = { rect.x, rect.y, rect.width, kHalfHeight };
+	pHalvesOut[1] = { rect.x, rect.y + kHalfHeight, rect.width, kHalfHeight };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreHeader.h"
+
+// Most views one pass can draw, the shaders size their per view arrays to match.
+constexpr u32 kMaxViews = 4;
+
+// Clip planes bounding a view, order is left, right, bottom, top.
+constexpr u32 kNumViewClipPlanes = 4;
+
+// A rectangle in render target pixels, y down as for D3D viewports.
+struct ViewRect
+{
+	f32 x;
+	f32 y;
+	f32 width;
+	f32 height;
+};
+
+//================================================================================
+// View Transform
+// Places one view inside the viewport it is rendered through.
+//
+// The view's projection is followed by a scale and offset in clip space,
+//   clip.xy = clip.xy * scale + clip.w * offset
+// which squeezes its whole clip space into its part of the viewport. The clip
+// planes then stop geometry leaking into the neighbouring views, for a point
+// p in the shared clip space dot(plane, p) >= 0 when it is inside the view.
+//================================================================================
+struct ViewTransform
+{
+	v4 scaleOffset; // xy scale, zw offset
+	v4 clipPlanes[kNumViewClipPlanes];
+};
+
+// Transform placing view inside viewport, view need not lie inside the viewport.
+ViewTransform compute_view_transform(const ViewRect& viewport, const ViewRect& view);
+
+// Row vector matrix applying the scale and offset, multiply a projection by it.
+m4x4 view_offset_matrix(const ViewTransform& transform);
+
+// Smallest rectangle holding kCount rects.
+ViewRect bounding_view_rect(const ViewRect* pRects, const u32 kCount);
+
+// The top and bottom halves of rect, top first.
+void split_view_rect_rows(const ViewRect& rect, ViewRect* pHalvesOut);
+
+//================================================================================
+// View Layout
+// kViews views drawn by one pass through a viewport that covers them all,
+// e.g. both eyes side by side, or each eye as a wide periphery view plus a
+// sharper inset. Instanced draws issue kViews instances per object and the
+// vertex shader picks the view from the instance id.
+//================================================================================
+template<u32 kViews>
+struct ViewLayout
+{
+	static_assert(kViews == 1 || kViews == 2 || kViews == 4, "Passes draw 1, 2 or 4 views.");
+	static constexpr u32 kCount = kViews;
+
+	ViewRect viewport;
+	ViewRect views[kViews];
+	ViewTransform transforms[kViews];
+};
+
+// Layout of the given views, the viewport is the rect bounding them.
+template<u32 kViews>
+ViewLayout<kViews> make_view_layout(const ViewRect* pViews)
+{
+	ViewLayout<kViews> layout;
+	layout.viewport = bounding_view_rect(pViews, kViews);
+	for (u32 i = 0; i < kViews; ++i)
+	{
+		layout.views[i] = pViews[i];
+		layout.transforms[i] = compute_view_transform(layout.viewport, pViews[i]);
+	}
+	return layout;
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// GPU Culling
+// Frustum culls every object and counts the visible ones into their draw group's indirect draw.
+///////////////////////////////////////////////////////////////////////////////
+
+#define MAX_VIEWS 4         // kMaxViews in ViewLayout.h
+#define NUM_PLANES 6        // kNumFrustumPlanes in Culling.h
+#define CULL_GROUP_SIZE 64  // kCullThreadGroupSize in CullDrawGroups.h
+
+cbuffer CullCB : register(b0)
+{
+	float4 planes[MAX_VIEWS * NUM_PLANES]; // per view, left, right, bottom, top, near, far
+	uint   viewCount;   // visible in any view, drawn once per view
+	uint   numSlots;
+	uint2  paddingCull;
+};
+
+// Objects sharing a mesh and material, drawn by one indirect draw.
+struct CullDrawGroup
+{
+	uint firstSlot;
+	uint numObjects;
+	uint indexCount;
+	uint firstIndex;
+	int  baseVertex;
+	uint3 padding;
+};
+
+// An object and the draw group of its slot.
+struct CullSlot
+{
+	uint object;
+	uint group;
+};
+
+#define NO_GROUP 0xffffffff
+#define ARGS_STRIDE 20          // sizeof(DrawIndexedIndirectArgs)
+#define INSTANCE_COUNT_OFFSET 4 // offsetof(DrawIndexedIndirectArgs, instanceCount)
+
+StructuredBuffer<CullDrawGroup> drawGroups : register(t0);
+StructuredBuffer<CullSlot> slots : register(t1);      // objects of each group, in the group's slots
+StructuredBuffer<float4> objectBounds : register(t2); // per object, xyz center and w radius
+
+RWStructuredBuffer<uint> visibleObjects : register(u0); // a group's visible objects at the front of its slots
+RWByteAddressBuffer drawArgs : register(u1);            // per group, instance counts cleared before the dispatch
+
+groupshared uint gs_scan[CULL_GROUP_SIZE];
+groupshared uint gs_group[CULL_GROUP_SIZE];
+groupshared uint gs_base[CULL_GROUP_SIZE];
+
+// The plane equation in the same order as cull_spheres, precise stops it being fused so both round alike.
+bool sphere_visible(float4 sphere)
+{
+	bool visible = false;
+	for (uint view = 0; view < viewCount; ++view)
+	{
+		bool inside = true;
+		[unroll]
+		for (uint p = 0; p < NUM_PLANES; ++p)
+		{
+			float4 plane = planes[view * NUM_PLANES + p];
+			precise float d = plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w;
+			inside = inside && !(d < -sphere.w);
+		}
+		visible = visible || inside;
+	}
+	return visible;
+}
+
+// One thread per object. An inclusive scan of the results numbers the visible objects
+// within the thread group, whose slots cover runs of one or a few draw groups. The
+// last thread of each run reserves the run's objects in its draw group with a single
+// atomic on the instance count, so a group's visible objects end up packed at the
+// front of its slots, in an order that depends on which thread group gets there first.
+// cull_draw_groups_reference in CullDrawGroups.cpp does the same on the CPU, compare
+// the two with cull_outputs_match, which sorts each group first.
+[numthreads(CULL_GROUP_SIZE, 1, 1)]
+void CS_CullDrawGroups(uint3 dispatchID : SV_DispatchThreadID, uint threadIndex : SV_GroupIndex)
+{
+	uint object = 0;
+	uint group = NO_GROUP;
+	uint visible = 0;
+	if (dispatchID.x < numSlots)
+	{
+		CullSlot slot = slots[dispatchID.x];
+		object = slot.object;
+		group = slot.group;
+		visible = sphere_visible(objectBounds[object]) ? 1 : 0;
+	}
+
+	gs_scan[threadIndex] = visible;
+	gs_group[threadIndex] = group;
+	GroupMemoryBarrierWithGroupSync();
+
+	[unroll]
+	for (uint offset = 1; offset < CULL_GROUP_SIZE; offset <<= 1)
+	{
+		uint add = threadIndex >= offset ? gs_scan[threadIndex - offset] : 0;
+		GroupMemoryBarrierWithGroupSync();
+		gs_scan[threadIndex] += add;
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	// The run of threads sharing this thread's draw group, and the visible count before it.
+	uint runStart = threadIndex;
+	while (runStart > 0 && gs_group[runStart - 1] == group)
+	{
+		--runStart;
+	}
+	uint runEnd = threadIndex;
+	while (runEnd < CULL_GROUP_SIZE - 1 && gs_group[runEnd + 1] == group)
+	{
+		++runEnd;
+	}
+	uint before = runStart > 0 ? gs_scan[runStart - 1] : 0;
+
+	if (threadIndex == runEnd && group != NO_GROUP)
+	{
+		uint count = gs_scan[threadIndex] - before;
+		uint first = 0;
+		if (count > 0)
+		{
+			drawArgs.InterlockedAdd(group * ARGS_STRIDE + INSTANCE_COUNT_OFFSET, count * viewCount, first);
+		}
+		gs_base[threadIndex] = first / viewCount;
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	if (visible)
+	{
+		visibleObjects[drawGroups[group].firstSlot + gs_base[runEnd] + gs_scan[threadIndex] - before - 1] = object;
+	}
+}
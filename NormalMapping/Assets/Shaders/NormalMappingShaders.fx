@@ -3,28 +3,39 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 
+#define MAX_VIEWS 4 // kMaxViews in ViewLayout.h
+
 cbuffer PerFrameCB : register(b0)
 {
-	matrix matProjection;
-	matrix matView;
+	matrix matViewProj[MAX_VIEWS];        // per view, includes the scale and offset placing it in the pass's viewport
+	float4 viewClipPlanes[MAX_VIEWS * 4]; // per view left, right, bottom, top, keeps each view inside its part of the viewport
 	float4 lightPos;
 	float  time;
-	float  paddingFrame[3];
+	uint   viewCount;      // views drawn by each instanced draw
+	float2 paddingFrame;
 };
 
 cbuffer PerDrawCB : register(b1)
 {
-	float4x4 matMVP;
-	float4x4 matWorld;
-	float3x3 matNormal; // e.g. inverse transpose (upper 3x3 of the world)
-	float4x4 modelViewProj[2];
-	uint    tileFactor;
-	uint    paddingDraw[3];
+	float4 worldRows[3];    // affine world transform, one row per output component
+	uint   tileFactor;
+	uint   instanceOffset;  // first element of this batch in the instance buffer
+	uint   viewIndex;       // view of a single view draw, or the first view of an instanced one
+	uint   paddingDraw;
+};
 
+// Per object data for instanced submission.
+struct InstanceData
+{
+	float4 worldRows[3]; // same layout as PerDrawCB
+	uint   tileFactor;
+	uint3  padding;
 };
 
 Texture2D texDiffuse : register(t0);
 Texture2D texNormal : register(t1);
+StructuredBuffer<InstanceData> instances : register(t2);  // one per object
+StructuredBuffer<uint> instanceIndices : register(t3);     // visible objects, batches are runs of this list
 
 SamplerState linearMipSampler : register(s0);
 
@@ -47,8 +58,8 @@ struct VertexOutput
 	float4 tangent : TANGENT;
 	float2 uv : TEXCOORD;
 	float3 pos_ws : POSITION_WS;
-	float  clipDist : SV_ClipDistance0;
-	float  cullDist : SV_CullDistance0;
+	float4 clipDist : SV_ClipDistance0;
+	float4 cullDist : SV_CullDistance0;
 };
 
 // Sample the normal map and decode
@@ -57,6 +68,25 @@ float3 decode_normal(float2 uv)
 	return texNormal.Sample(linearMipSampler, uv).rgb * 2.0f - 1.0f;
 }
 
+// Transform by the affine world rows, w of the point is one.
+float3 transform_point(float4 rows[3], float3 p)
+{
+	return float3(dot(rows[0], float4(p, 1.0f)), dot(rows[1], float4(p, 1.0f)), dot(rows[2], float4(p, 1.0f)));
+}
+
+// Directions ignore the translation. No shearing or non-uniform scaling so this also does for normals.
+float3 transform_direction(float4 rows[3], float3 d)
+{
+	return float3(dot(rows[0].xyz, d), dot(rows[1].xyz, d), dot(rows[2].xyz, d));
+}
+
+// Distances to the view's clip planes, all positive inside the view.
+float4 view_clip_distances(uint view, float4 vpos)
+{
+	return float4(dot(viewClipPlanes[view * 4 + 0], vpos), dot(viewClipPlanes[view * 4 + 1], vpos),
+		dot(viewClipPlanes[view * 4 + 2], vpos), dot(viewClipPlanes[view * 4 + 3], vpos));
+}
+
 // Builds the 'TBN' matrix, a matrix that can transform from tangent space to world space.
 float3x3 construct_TBN_matrix(float3 N, float3 T, float fSign)
 {
@@ -67,14 +97,14 @@ float3x3 construct_TBN_matrix(float3 N, float3 T, float fSign)
 VertexOutput VS_Mesh(VertexInput input)
 {
 	VertexOutput output;
-	output.vpos  = mul(float4(input.pos, 1.0f), matMVP);
-	output.pos_ws = mul(float4(input.pos, 1.0f), matWorld).xyz;
-	output.cullDist = output.clipDist = 0.5f;
+	output.pos_ws = transform_point(worldRows, input.pos);
+	output.vpos  = mul(float4(output.pos_ws, 1.0f), matViewProj[viewIndex]);
+	output.cullDist = output.clipDist = view_clip_distances(viewIndex, output.vpos);
 	output.color = input.color;
 
 	// Transform the normals and tangent.
-	output.normal = mul(input.normal, matNormal);
-	output.tangent.xyz = mul(input.tangent.xyz, matNormal);
+	output.normal = transform_direction(worldRows, input.normal);
+	output.tangent.xyz = transform_direction(worldRows, input.tangent.xyz);
 	output.tangent.w = input.tangent.w; // sign is encoded pass through
 
 	output.uv = input.uv * tileFactor;
@@ -82,22 +112,22 @@ VertexOutput VS_Mesh(VertexInput input)
 	return output;
 }
 
-VertexOutput VS_Mesh_Instanced(VertexInput input)
+// One object drawn to several views, one instance per view.
+VertexOutput VS_Mesh_Views(VertexInput input)
 {
 	VertexOutput output;
-	const float4 EyeClipPlane[2] = { { -1, 0, 0, 0 }, { 1, 0, 0, 0 } };
-	uint eyeIndex = input.instanceID & 1;
-	// transform to clip space for correct eye (includes offset and scale)
-	output.vpos = mul(float4(input.pos, 1.0f), modelViewProj[eyeIndex]);
-	output.pos_ws = mul(float4(input.pos, 1.0f), matWorld).xyz;
-	// calculate distance from left/right clip plane
-	output.cullDist = output.clipDist = dot(EyeClipPlane[eyeIndex], output.vpos);
+	uint view = viewIndex + input.instanceID;
+	// transform to clip space for the view (includes offset and scale)
+	output.pos_ws = transform_point(worldRows, input.pos);
+	output.vpos = mul(float4(output.pos_ws, 1.0f), matViewProj[view]);
+	// calculate distance from the view's edges
+	output.cullDist = output.clipDist = view_clip_distances(view, output.vpos);
 
 	output.color = input.color;
 
 	// Transform the normals and tangent.
-	output.normal = mul(input.normal, matNormal);
-	output.tangent.xyz = mul(input.tangent.xyz, matNormal);
+	output.normal = transform_direction(worldRows, input.normal);
+	output.tangent.xyz = transform_direction(worldRows, input.tangent.xyz);
 	output.tangent.w = input.tangent.w; // sign is encoded pass through
 
 	output.uv = input.uv * tileFactor;
@@ -105,6 +135,31 @@ VertexOutput VS_Mesh_Instanced(VertexInput input)
 	return output;
 }
 
+VertexOutput VS_Mesh_Instanced(VertexInput input)
+{
+	VertexOutput output;
+
+	// Each object is drawn once per view, consecutive instances are the views of one object.
+	uint view = viewIndex + input.instanceID % viewCount;
+	InstanceData instance = instances[instanceIndices[instanceOffset + input.instanceID / viewCount]];
+
+	output.pos_ws = transform_point(instance.worldRows, input.pos);
+	output.vpos = mul(float4(output.pos_ws, 1.0f), matViewProj[view]);
+
+	// A view alone in its viewport has planes on the viewport's edges, which never clip.
+	output.cullDist = output.clipDist = view_clip_distances(view, output.vpos);
+
+	output.color = input.color;
+
+	output.normal = transform_direction(instance.worldRows, input.normal);
+	output.tangent.xyz = transform_direction(instance.worldRows, input.tangent.xyz);
+	output.tangent.w = input.tangent.w; // sign is encoded pass through
+
+	output.uv = input.uv * instance.tileFactor;
+
+	return output;
+}
+
 
 float4 PS_Mesh(VertexOutput input) : SV_TARGET
 {
@@ -138,4 +193,16 @@ float4 PS_Mesh(VertexOutput input) : SV_TARGET
 	return float4(materialColor.xyz * I, 1.0f);
 }
 
+// Cheaper tier picked by the quality governor, lit with the interpolated normal so the normal map isn't sampled.
+float4 PS_Mesh_VertexNormal(VertexOutput input) : SV_TARGET
+{
+	float4 materialColor = texDiffuse.Sample(linearMipSampler, input.uv);
+
+	float3 L = normalize(lightPos.xyz - input.pos_ws);
+	float3 N = normalize(input.normal);
+	float I = dot(L, N);
+
+	return float4(materialColor.xyz * I, 1.0f);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
@@ -3,10 +3,83 @@
 #include "ShaderSet.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "StateCache.h"
+#include "ParallelRecorder.h"
+#include "DeferredContextBackend.h"
+#include "Culling.h"
+#include "StereoFrustum.h"
+#include "ConstantRing.h"
+#include "FrameArena.h"
+#include "TransformSystem.h"
+#include "ViewLayout.h"
+#include "GeometryPool.h"
+#include "GpuCulling.h"
+#include "MeshSimplify.h"
+#include "OcclusionCulling.h"
+#include "QualityGovernor.h"
+#include "FrameLifecycle.h"
+#include "PoseSource.h"
+#include "OvrHmd.h"
+#include "LogRing.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "PerfStats.h"
+#include "Scene.h"
+#include "SceneGenerator.h"
 #include <OVR_CAPI.h>
+#include <chrono>
 
 using namespace DirectX;
 
+// Static props placed around the crate grid.
+struct PropDesc
+{
+	u32 mesh;
+	u32 texture;
+	v3  translation;
+	s32 yRot;
+	u32 tileFactor;
+};
+
+static const PropDesc kProps[] =
+{
+	{ 2, 2, v3(0.f, -0.5f, 0.f), 0, 9 },     //Floor
+	{ 3, 4, v3(4.f, -0.5f, 2.f), -90, 1 },   //house
+	{ 4, 6, v3(7.f, -0.5f, 2.f), 0, 1 },     //bus
+	{ 5, 8, v3(-2.f, -0.5f, 11.f), 180, 1 }, //house2
+};
+
+// What each of the scene generator's types draws as, every mesh but the floor.
+static const SceneObject kGeneratedTypes[] =
+{
+	{ 0, 0, 0, 1 }, //cube
+	{ 1, 0, 0, 1 }, //crate
+	{ 3, 4, 0, 1 }, //house
+	{ 4, 6, 0, 1 }, //bus
+	{ 5, 8, 0, 1 }, //house2
+};
+
+// Draws a mesh once per view, the views are instances so the vertex shader can pick one.
+template<u32 kViews>
+struct ViewDraw
+{
+	static void draw(StateCache& rState, const Mesh& mesh, u32 lod)
+	{
+		mesh.drawIndexedInstanced(rState, kViews, lod);
+	}
+};
+
+// A single view needs no instancing.
+template<>
+struct ViewDraw<1>
+{
+	static void draw(StateCache& rState, const Mesh& mesh, u32 lod)
+	{
+		mesh.draw(rState, lod);
+	}
+};
+
 //================================================================================
 // Normal Mapping Application
 // An example of how to work with normal maps.
@@ -17,24 +90,85 @@ public:
 
 	struct PerFrameCBData
 	{
-		m4x4 m_matProjection;
-		m4x4 m_matView;
+		m4x4 m_matViewProj[kMaxViews]; // per view, including its place in the viewport
+		v4   m_viewClipPlanes[kMaxViews * kNumViewClipPlanes];
 		v4   m_lightPos;
 		f32  m_time;
-		f32  m_padding[3];
+		u32  m_viewCount;      // views drawn by each instanced draw
+		f32  m_padding[2];
 	};
 
 	struct PerDrawCBData
 	{
-		m4x4 m_matMVP;
-		m4x4 m_matWorld;
-		v4   m_matNormal[3]; // because of structure packing rules this represents a float3x3 in HLSL.
-		m4x4 m_modelViewProj[2];
+		v4   m_worldRows[3];   // affine world transform, see pack_affine_float3x4
 		UINT m_tileFactor;
-		UINT m_padding[3];
+		UINT m_instanceOffset; // first element of the batch in the instance buffer
+		UINT m_viewIndex;      // view of a single view draw, or the first view of an instanced one
+		UINT m_padding;
+	};
+
+	// Element of the instance buffer, one per object, read by VS_Mesh_Instanced.
+	// Only written when the object's transform changes.
+	struct PerInstanceData
+	{
+		v4   m_worldRows[3];
+		u32  m_tileFactor;
+		u32  m_padding[3];
+	};
 
+	// What the passes need from one pose sample.
+	struct EyeViews
+	{
+		XMMATRIX viewProj[2];
+		m4x4 proj[2];
+		v3 position[2];
+		v3 forward[2];
+		v3 up[2];
+		ovrTimewarpProjectionDesc timewarpProjection;
 	};
 
+	// A run of the visible list that share a mesh, level of detail and textures.
+	struct InstanceBatch
+	{
+		u32 mesh;
+		u32 texture;
+		u32 lod;
+		u32 firstInstance; // into the visible list, which indexes the instance buffer
+		u32 numInstances;
+		ConstantSlice slice; // per draw constants when the constant ring is in use
+	};
+
+	enum MeshShaders
+	{
+		kShaderMesh,          // one draw per object per eye
+		kShaderMeshViews,     // one draw per object, views instanced
+		kShaderMeshInstanced, // one draw per mesh, objects and eyes instanced
+
+		kNumMeshShaders
+	};
+
+	static constexpr f32 kNearClip = 0.2f;
+	static constexpr f32 kFarClip = 1000.0f;
+	static constexpr f32 kGridSpacing = 1.5f;
+	static constexpr u32 kNumInstances = 5;
+	static constexpr u32 kNumModelTypes = 2;
+	static constexpr u32 kNumProps = sizeof(kProps) / sizeof(kProps[0]);
+	static constexpr u32 kNumGeneratedTypes = sizeof(kGeneratedTypes) / sizeof(kGeneratedTypes[0]);
+	static constexpr u32 kNumMeshes = 6;
+	static constexpr u32 kNumTextures = 10;
+	static constexpr u32 kMinInstances = 1024; // the instance buffers grow past this for larger scenes
+	static constexpr u32 kMaxRecordChunks = 8;
+	static constexpr u32 kMinChunkDraws = 4;
+	static constexpr u32 kMaxRecordWorkers = 4;
+	static constexpr u32 kPoolVertices = 256 * 1024; // shared by the static meshes, larger ones fall back to their own buffers
+	static constexpr u32 kPoolIndices = 512 * 1024;
+	static constexpr u32 kMaxCullGroups = 64; // mesh and texture pairs the GPU culler can draw
+	static constexpr f32 kDefaultLodPixelError = 1.f;
+	static constexpr u32 kOcclusionWidth = 224;  // per eye, roughly the eye buffer's aspect
+	static constexpr u32 kOcclusionHeight = 256;
+	static constexpr f32 kMaxHeadAngularSpeed = 5.f; // radians per second, a fast head turn
+	static constexpr f32 kMaxHeadSpeed = 2.f;        // metres per second
+
 	void on_init(SystemsInterface& systems) override
 	{
 		m_position = v3(0.5f, 0.5f, 0.5f);
@@ -42,15 +176,19 @@ public:
 		systems.pCamera->eye = v3(3.f, 1.5f, 3.f);
 		systems.pCamera->look_at(v3(3.f, 1.5f, 0.f));
 
-		// compile a set of shaders
-		m_meshShader[0].init(systems.pD3DDevice
-			, ShaderSetDesc::Create_VS_PS("Assets/Shaders/NormalMappingShaders.fx", "VS_Mesh", "PS_Mesh")
-			, { VertexFormatTraits<MeshVertex>::desc, VertexFormatTraits<MeshVertex>::size }
-		);
-		m_meshShader[1].init(systems.pD3DDevice
-			, ShaderSetDesc::Create_VS_PS("Assets/Shaders/NormalMappingShaders.fx", "VS_Mesh_Instanced", "PS_Mesh")
-			, { VertexFormatTraits<MeshVertex>::desc, VertexFormatTraits<MeshVertex>::size }
-		);
+		// compile a set of shaders, every submission path at every shader tier
+		static const char* kVertexShaders[kNumMeshShaders] = { "VS_Mesh", "VS_Mesh_Views", "VS_Mesh_Instanced" };
+		static const char* kPixelShaders[kNumShaderTiers] = { "PS_Mesh_VertexNormal", "PS_Mesh" };
+		for (u32 tier = 0; tier < kNumShaderTiers; ++tier)
+		{
+			for (u32 shader = 0; shader < kNumMeshShaders; ++shader)
+			{
+				m_meshShader[tier][shader].init(systems.pD3DDevice
+					, ShaderSetDesc::Create_VS_PS("Assets/Shaders/NormalMappingShaders.fx", kVertexShaders[shader], kPixelShaders[tier])
+					, { VertexFormatTraits<MeshVertex>::desc, VertexFormatTraits<MeshVertex>::size }
+				);
+			}
+		}
 
 		// Create Per Frame Constant Buffer.
 		m_pPerFrameCB = create_constant_buffer<PerFrameCBData>(systems.pD3DDevice);
@@ -58,15 +196,18 @@ public:
 		// Create Per Frame Constant Buffer.
 		m_pPerDrawCB = create_constant_buffer<PerDrawCBData>(systems.pD3DDevice);
 
+		// The meshes share one vertex and index buffer, so switching mesh doesn't rebind them.
+		m_geometryPool.init(systems.pD3DDevice, systems.pD3DContext, sizeof(MeshVertex), kPoolVertices, kPoolIndices);
+
 		// Initialize a mesh directly.
-		create_mesh_cube(systems.pD3DDevice, m_meshArray[0], 0.5f);
+		create_mesh_cube(systems.pD3DDevice, m_meshArray[0], 0.5f, &m_geometryPool);
 
 		// Initialize a mesh from an .OBJ file
-		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[1], "Assets/Models/WoodCrate/wc1.obj", 1.f);
-		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[2], "Assets/Models/Plane/plane.obj", 2.f);
-		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[3], "Assets/Models/House/house.obj", 0.006f);
-		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[4], "Assets/Models/Bus/bus.obj", 0.1f);
-		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[5], "Assets/Models/House2/house2.obj", 1.f);
+		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[1], "Assets/Models/WoodCrate/wc1.obj", 1.f, &m_geometryPool);
+		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[2], "Assets/Models/Plane/plane.obj", 2.f, &m_geometryPool);
+		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[3], "Assets/Models/House/house.obj", 0.006f, &m_geometryPool, &m_occluders[3]);
+		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[4], "Assets/Models/Bus/bus.obj", 0.1f, &m_geometryPool, &m_occluders[4]);
+		create_mesh_from_obj(systems.pD3DDevice, m_meshArray[5], "Assets/Models/House2/house2.obj", 1.f, &m_geometryPool, &m_occluders[5]);
 
 		// Initialise some textures;
 		m_textures[0].init_from_dds(systems.pD3DDevice, "Assets/Models/WoodCrate/wc1_diffuse.dds");
@@ -85,6 +226,66 @@ public:
 
 		// Setup per-frame data
 		m_perFrameCBData.m_time = 0.0f;
+
+		// Per draw constants are suballocated from rings, the immediate context and each recording chunk get their own.
+		// They start small and grow with the scene in ReserveInstances.
+		m_constantRing.init(systems.pD3DDevice, systems.pD3DContext, kMinInstances * ConstantRing::kSliceAlignment);
+		m_chunkRings.reset(new ConstantRing[kMaxRecordChunks]);
+		for (u32 i = 0; i < kMaxRecordChunks; ++i)
+		{
+			m_chunkRings[i].init(systems.pD3DDevice, systems.pD3DContext, kMinInstances * ConstantRing::kSliceAlignment);
+		}
+
+		// The scene keeps the bounds and levels of detail of each mesh, and the addresses its draw packets use.
+		SceneMesh sceneMeshes[kNumMeshes];
+		for (u32 i = 0; i < kNumMeshes; ++i)
+		{
+			const Mesh& mesh = m_meshArray[i];
+			SceneMesh& sceneMesh = sceneMeshes[i];
+			sceneMesh.pMesh = &mesh;
+			sceneMesh.boundsCenter = mesh.bounds_center();
+			sceneMesh.boundsRadius = mesh.bounds_radius();
+			sceneMesh.numLods = mesh.num_lods();
+			std::copy(mesh.lods(), mesh.lods() + kMaxMeshLods, sceneMesh.lods);
+		}
+		const Texture* pSceneTextures[kNumTextures];
+		for (u32 i = 0; i < kNumTextures; ++i)
+		{
+			pSceneTextures[i] = &m_textures[i];
+		}
+		m_scene.set_meshes(sceneMeshes, kNumMeshes);
+		m_scene.set_textures(pSceneTextures, kNumTextures);
+
+		// Place the objects and their bounds, meshes must be loaded first.
+		// A scene asked for on the command line replaces the hand placed one, e.g. -scene city -instances 100000.
+		parse_scene_args(systems.pCommandLine, m_sceneDesc);
+		BuildScene();
+		m_gpuCuller.init(systems.pD3DDevice);
+		ReserveInstances(systems, m_scene.size());
+		BuildCullGroups(systems.pD3DContext);
+
+		// All scene binds go through the state cache.
+		m_stateCache.init(systems.pD3DContext);
+
+		// Workers for parallel recording, each chunk records into its own deferred context.
+		const u32 kHardwareThreads = std::thread::hardware_concurrency();
+		m_recorder.init(std::min(std::max(kHardwareThreads, 2u) - 1, kMaxRecordWorkers));
+		m_occlusionCuller.init(std::min(std::max(kHardwareThreads, 2u) - 1, kMaxRecordWorkers), kOcclusionWidth, kOcclusionHeight);
+		m_deferredBackend.init(systems.pD3DDevice, systems.pD3DContext);
+		m_chunkStates.resize(kMaxRecordChunks);
+		m_chunkQueueStats.resize(kMaxRecordChunks);
+
+		// Depth is quantized over the projection range for front to back sorting.
+		m_renderQueue.set_depth_range(kNearClip, kFarClip);
+
+		// Late latching records the passes here, so the poses can be swapped before they execute.
+		if (FAILED(systems.pD3DDevice->CreateDeferredContext(0, &m_pLatchContext)))
+		{
+			panicF("Failed to create deferred context");
+		}
+
+		// Quality starts at full and comes down when the GPU misses the 90 Hz budget.
+		m_qualityGovernor.init(QualityGovernorDesc());
 	}
 
 	void on_update(SystemsInterface& systems) override
@@ -98,6 +299,172 @@ public:
 		// This function displays some useful debugging values, camera positions etc.
 		DemoFeatures::editorHud(systems.pDebugDrawContext);
 
+		const FrameLifecycleStats frameStats = systems.pFrameLifecycle->stats();
+		ImGui::Text("Frame %lld: wait %.2f ms, CPU %.2f ms (max %.2f), predicted %.2f ms ahead", (long long)systems.pFrameLifecycle->frame_index(),
+			frameStats.averageWaitMs, frameStats.averageCpuMs, frameStats.maxCpuMs, frameStats.averageLeadMs);
+		ImGui::Text("Frames: %u missed of the last %u, %u skipped", frameStats.missed, frameStats.frames, frameStats.skipped);
+		// Timestamps are only read back on the immediate context, batches in a recorded pass can't be timed.
+		if (ImGui::Checkbox("Late latch poses", &m_lateLatch) && m_lateLatch)
+		{
+			m_gpuBatchScopes = false;
+		}
+		if (m_lateLatch)
+		{
+			ImGui::Text("Late latch: poses resampled %.2f ms after the early ones", m_latchMs);
+		}
+		ImGui::Checkbox("Instanced submission", &m_instancedSubmission);
+		ImGui::Checkbox("Split eye views (stereo, 4 views per pass)", &m_splitEyeViews);
+		ImGui::Checkbox("Frustum culling", &m_frustumCulling);
+		ImGui::Checkbox("GPU culling (instanced)", &m_gpuCulling);
+		ImGui::Checkbox("Occlusion culling (not GPU culled)", &m_occlusionCulling);
+		if (m_occlusionCulling)
+		{
+			const OcclusionStats& occlusion = m_occlusionCuller.stats();
+			ImGui::Text("Occlusion: %u occluders, %u triangles, %u of %u hidden, %.2f ms on %u workers", occlusion.occluders, occlusion.triangles,
+				occlusion.occluded, occlusion.tested, m_occlusionMs, m_occlusionCuller.workers());
+		}
+		if (ImGui::Checkbox("Adaptive quality", &m_adaptiveQuality))
+		{
+			m_qualityGovernor.reset();
+		}
+		if (m_adaptiveQuality)
+		{
+			const QualityGovernorStats& quality = m_qualityGovernor.stats();
+			const QualityLevel& level = m_qualityGovernor.level();
+			ImGui::Text("Quality level %u of %u: viewport %.0f%%, LOD bias %.0f, %s", quality.level, m_qualityGovernor.num_levels() - 1,
+				level.viewportScale * 100.f, level.lodBias, level.shaderTier == ShaderTier::kNormalMapped ? "normal mapped" : "vertex normals");
+			ImGui::Text("Quality: CPU %.2f ms, GPU %.2f ms (p%.0f), %u drops, %u raises, %u failed, raise wait %u",
+				quality.cpuPercentileMs, quality.gpuPercentileMs, m_qualityGovernor.desc().raisePercentile * 100.f,
+				quality.drops, quality.raises, quality.failedRaises, quality.raiseFrames);
+			ImGui::Text("Quality: %u of %u frames over budget, %u CPU bound", quality.overBudgetFrames, quality.frames, quality.cpuBoundFrames);
+		}
+		ImGui::Text("Scene: %s, %u objects, %u animated", m_sceneDesc.enabled ? scene_layout_name(m_sceneDesc.layout) : "sample",
+			m_scene.size(), m_scene.animated());
+		s32 sceneLayout = (s32)m_sceneDesc.layout;
+		ImGui::Combo("Scene layout", &sceneLayout, "Grid\0Clusters\0City\0\0");
+		m_sceneDesc.layout = (SceneLayout)sceneLayout;
+		ImGui::SliderFloat("Animated fraction", &m_sceneDesc.animatedFraction, 0.f, 1.f);
+		static const u32 kSceneSizes[] = { 1000, 10000, 100000, 1000000 };
+		static const char* kSceneSizeNames[] = { "1K", "10K", "100K", "1M" };
+		bool generate = false;
+		for (u32 i = 0; i < 4; ++i)
+		{
+			if (i > 0)
+			{
+				ImGui::SameLine();
+			}
+			if (ImGui::Button(kSceneSizeNames[i]))
+			{
+				m_sceneDesc.count = kSceneSizes[i];
+				generate = true;
+			}
+		}
+		ImGui::SameLine();
+		generate |= ImGui::Button("Generate");
+		ImGui::SameLine();
+		if (ImGui::Button("Sample scene") && m_sceneDesc.enabled)
+		{
+			m_sceneDesc.enabled = false;
+			RebuildScene(systems);
+		}
+		if (generate)
+		{
+			m_sceneDesc.enabled = true;
+			RebuildScene(systems);
+		}
+		if (!m_sceneDesc.enabled)
+		{
+			ImGui::Checkbox("Animate crate grid", &m_animateGrid);
+		}
+		ImGui::Checkbox("Automatic LOD (not GPU culled)", &m_automaticLod);
+		ImGui::SliderFloat("LOD pixel error", &m_lodPixelError, 0.25f, 8.f);
+		const u32* pLodCounts = m_scene.lod_counts();
+		ImGui::Text("LOD objects: %u / %u / %u / %u", pLodCounts[0], pLodCounts[1], pLodCounts[2], pLodCounts[3]);
+		ImGui::Text("Transforms: %u updated, %u instance uploads", m_transformUpdates, m_instanceUploads);
+		if (m_gpuCulling && m_instancedSubmission)
+		{
+			ImGui::Text("Visible objects: culled on the GPU, %u indirect draws per pass", m_gpuCuller.groups());
+		}
+		else
+		{
+			ImGui::Text("Visible objects: %u of %u, one pass for both eyes", m_numVisible, m_scene.size());
+		}
+		ImGui::Checkbox("Parallel recording (mono, non-instanced)", &m_parallelRecording);
+		ImGui::Text("Recorded %u chunks on %u workers", m_recorder.chunks(), m_recorder.workers());
+		ImGui::Text("State calls: %u issued, %u skipped, %u draws", m_lastStateStats.issued, m_lastStateStats.skipped, m_lastStateStats.draws);
+		if (m_constantRing.supported())
+		{
+			const RingAllocator& ring = m_constantRing.allocator();
+			ImGui::Text("Constant ring: %u slices, %u / %u KB, high water %u KB", ring.allocations(), ring.used() / 1024, ring.capacity() / 1024, ring.high_water() / 1024);
+		}
+		else
+		{
+			ImGui::Text("Constant ring: unsupported, mapping per draw");
+		}
+		const FrameArenaStats& arena = systems.pFrameArena->stats();
+		ImGui::Text("Frame arena: %u blocks, %u KB, high water %u KB in %u blocks", arena.blocks, (u32)(arena.bytes / 1024),
+			(u32)(systems.pFrameArena->high_water() / 1024), systems.pFrameArena->high_water_blocks());
+		ImGui::Text("Frame arena heap: %u oversized, %u over budget, %u mallocs", arena.oversized, arena.fallbacks, arena.heapAllocs);
+		const RangeAllocatorStats poolVerts = m_geometryPool.vertex_allocator().stats();
+		const RangeAllocatorStats poolIndices = m_geometryPool.index_allocator().stats();
+		ImGui::Text("Geometry pool: %u meshes, %uK / %uK vertices, %uK / %uK indices", poolVerts.allocations,
+			poolVerts.used / 1024, poolVerts.capacity / 1024, poolIndices.used / 1024, poolIndices.capacity / 1024);
+		ImGui::Text("Geometry pool fragmentation: vertices %.2f, indices %.2f, %u full", poolVerts.fragmentation, poolIndices.fragmentation,
+			poolVerts.failures + poolIndices.failures);
+		if (current_logger())
+		{
+			const LoggerStats log = current_logger()->stats();
+			ImGui::Text("Log: %llu written of %llu, %llu dropped full, %llu rate limited, %u threads", (unsigned long long)log.written,
+				(unsigned long long)log.logged, (unsigned long long)log.dropped, (unsigned long long)log.suppressed, log.threads);
+		}
+		if (current_profiler())
+		{
+			const ProfilerStats profile = current_profiler()->stats();
+			if (ImGui::Button("Capture profile (120 frames to profile.json)"))
+			{
+				current_profiler()->request_capture(120, "profile.json");
+			}
+			ImGui::Text("Profile: %s, %u frames, %llu events on %u threads, %llu dropped", profile.recording ? "capturing" : "idle",
+				profile.frames, (unsigned long long)profile.events, profile.threads, (unsigned long long)profile.dropped);
+		}
+		if (systems.pGpuProfiler)
+		{
+			if (ImGui::Checkbox("GPU time each instance batch (turns off late latching)", &m_gpuBatchScopes) && m_gpuBatchScopes)
+			{
+				m_lateLatch = false;
+			}
+			const GpuProfilerStats& gpu = systems.pGpuProfiler->stats();
+			const GpuFrameTimings& gpuFrame = systems.pGpuProfiler->last_frame();
+			ImGui::Text("GPU frame %llu: %.2f ms, read %u frames late (max %u)", (unsigned long long)gpuFrame.frameNumber, gpuFrame.frameMs,
+				gpuFrame.latency, gpu.maxLatency);
+			ImGui::Text("GPU profiler: %llu resolved, %llu disjoint, %llu skipped, %llu scopes dropped", (unsigned long long)gpu.resolved,
+				(unsigned long long)gpu.disjoint, (unsigned long long)gpu.skipped, (unsigned long long)gpu.droppedScopes);
+			// Batches can run into the hundreds, only the passes get a line each.
+			for (const GpuScopeTiming& scope : gpuFrame.scopes)
+			{
+				if (scope.depth <= 1)
+				{
+					ImGui::Text("  %s: %.2f ms at +%.2f ms", scope.name, scope.durationMs, scope.startMs);
+				}
+			}
+		}
+		if (ImGui::Button("Measure profiler overhead"))
+		{
+			m_profilerOverhead = measure_profiler_overhead(100000);
+		}
+		if (m_profilerOverhead.recordingNs > 0.0)
+		{
+			ImGui::Text("Profile scope %.1f ns idle, %.1f ns capturing", m_profilerOverhead.idleNs, m_profilerOverhead.recordingNs);
+		}
+
+		// Swing the crate grid about its corner, every crate under it moves with it.
+		if (m_animateGrid && !m_sceneDesc.enabled)
+		{
+			m_scene.transforms().set_rotation(m_gridTransform, quat::CreateFromAxisAngle(v3::UnitY, sinf(m_perFrameCBData.m_time * 2.f) * 0.5f));
+		}
+
+		// Spin the generated scene's moving objects by the display clock, a benchmark's is simulated so every run matches.
+		m_scene.animate(systems.pFrameLifecycle->predicted_display_time());
 
 	}
 
@@ -114,144 +481,788 @@ public:
 	}
 
 	//create viewport easily
-	void SetViewport(SystemsInterface& systems, float vpX, float vpY, float vpW, float vpH)
+	void SetViewport(ID3D11DeviceContext* context, float vpX, float vpY, float vpW, float vpH)
 	{
 		D3D11_VIEWPORT D3Dvp;
 		D3Dvp.Width = vpW;    D3Dvp.Height = vpH;
 		D3Dvp.MinDepth = 0;   D3Dvp.MaxDepth = 1;
 		D3Dvp.TopLeftX = vpX; D3Dvp.TopLeftY = vpY;
-		systems.pD3DContext->RSSetViewports(1, &D3Dvp);
+		context->RSSetViewports(1, &D3Dvp);
 	}
 
-	//draws a single model based on the passed in params
-	void DrawSingleModel(ID3D11DeviceContext* pContext, bool renderStereo, XMMATRIX* prod, int mesh, int texture, v3 translation, int yRot, int tileFactor)
+	void SetViewport(ID3D11DeviceContext* context, const ViewRect& rect)
 	{
-		m_meshArray[mesh].bind(pContext);
-		m_textures[texture].bind(pContext, ShaderStage::kPixel, 0);
-		m_textures[texture + 1].bind(pContext, ShaderStage::kPixel, 1);
+		SetViewport(context, rect.x, rect.y, rect.width, rect.height);
+	}
 
+	static ViewRect view_rect(const ovrRecti& rect)
+	{
+		return { (f32)rect.Pos.x, (f32)rect.Pos.y, (f32)rect.Size.w, (f32)rect.Size.h };
+	}
 
-		m4x4 matWorld = m4x4::CreateTranslation(translation) * m4x4::CreateRotationY(degToRad(yRot));
-		if (renderStereo)
+	//the eye viewports scaled down inside the allocated eye texture
+	//packed from the left so the stereo viewport doesn't cover a gap between them
+	static void scale_eye_viewports(SystemsInterface& systems, f32 scale, ovrRecti* pViewportsOut)
+	{
+		s32 x = 0;
+		for (u32 eye = 0; eye < 2; ++eye)
 		{
-			//sets both viewproj matrix for stereo offset
-			m_perDrawCBData.m_modelViewProj[0] = (matWorld * prod[0]).Transpose();
-			m_perDrawCBData.m_modelViewProj[1] = (matWorld * prod[1]).Transpose();
+			const ovrRecti& allocated = *systems.pEyeRenderViewport[eye];
+			pViewportsOut[eye].Pos.x = x;
+			pViewportsOut[eye].Pos.y = allocated.Pos.y;
+			pViewportsOut[eye].Size.w = std::max((s32)(allocated.Size.w * scale + 0.5f), 1);
+			pViewportsOut[eye].Size.h = std::max((s32)(allocated.Size.h * scale + 0.5f), 1);
+			x += pViewportsOut[eye].Size.w;
 		}
-		else
+	}
+
+	//feed the governor the frames the compositor has finished since last time, oldest first
+	void UpdateQualityGovernor(SystemsInterface& systems)
+	{
+		ovrPerfStats perfStats;
+		if (OVR_FAILURE(ovr_GetPerfStats(*systems.pOvrSession, &perfStats)))
 		{
-			//calculate main MVP matrix
-			m4x4 matMVP = matWorld * *prod;
-			m_perDrawCBData.m_matMVP = matMVP.Transpose();
+			return;
 		}
 
-		// Update Per Draw Data
-		m_perDrawCBData.m_matWorld = matWorld.Transpose();
-		m_perDrawCBData.m_tileFactor = tileFactor;
+		for (s32 i = perfStats.FrameStatsCount - 1; i >= 0; --i)
+		{
+			// A frame the app missed is shown again by the compositor, it says nothing new.
+			const ovrPerfStatsPerCompositorFrame& frame = perfStats.FrameStats[i];
+			if (frame.AppFrameIndex == m_lastPerfFrameIndex)
+			{
+				continue;
+			}
+			m_lastPerfFrameIndex = frame.AppFrameIndex;
+			m_qualityGovernor.update({ frame.AppCpuElapsedTime * 1000.f, frame.AppGpuElapsedTime * 1000.f });
+		}
+	}
+
+	//fills the per draw constants of one packet
+	//the view projections are per frame, so only the world and the view to use go per draw
+	static void FillPerDrawData(PerDrawCBData& rDrawData, u32 viewIndex, const DrawPacket& packet)
+	{
+		// No shearing or non-uniform scaling, so the shader uses the same rows for normals.
+		pack_affine_float3x4(packet.matWorld, rDrawData.m_worldRows);
+		rDrawData.m_tileFactor = packet.tileFactor;
+		rDrawData.m_viewIndex = viewIndex;
+	}
+
+	//draws the mesh of a packet once per view, its per draw constants are already bound
+	template<u32 kViews>
+	static void DrawPacketMesh(StateCache& rState, const DrawPacket& packet)
+	{
+		ViewDraw<kViews>::draw(rState, *packet.pMesh, packet.lod);
+	}
 
-		//pack the normals into world
-		pack_upper_float3x3(m_perDrawCBData.m_matWorld, m_perDrawCBData.m_matNormal);
+	//draws a single model from the render queue, the queue has already bound its mesh and textures
+	template<u32 kViews>
+	void DrawSingleModel(StateCache& rState, PerDrawCBData& rDrawData, u32 viewIndex, const DrawPacket& packet)
+	{
+		FillPerDrawData(rDrawData, viewIndex, packet);
 
 		// Push to GPU
-		push_constant_buffer(pContext, m_pPerDrawCB, m_perDrawCBData);
+		push_constant_buffer(rState.context(), m_pPerDrawCB, rDrawData);
 
 		// Draw the mesh.
-		if (renderStereo)
+		DrawPacketMesh<kViews>(rState, packet);
+	}
+
+	// Bind a slice of a constant ring as the per draw buffer of both stages.
+	static void BindPerDrawSlice(StateCache& rState, const ConstantSlice& slice)
+	{
+		rState.set_constant_buffer_range(ShaderStage::kVertex, 1, slice.pBuffer, slice.firstConstant, slice.numConstants);
+		rState.set_constant_buffer_range(ShaderStage::kPixel, 1, slice.pBuffer, slice.firstConstant, slice.numConstants);
+	}
+
+	// Issues the sorted render queue through the state cache, each packet drawn to kViews views from viewIndex on.
+	// With a constant ring all per draw data is written in one map before the draws,
+	// otherwise every draw maps the per draw buffer.
+	template<u32 kViews>
+	class SceneQueueBackend final : public RenderQueueBackend
+	{
+	public:
+		SceneQueueBackend(NormalMappingApp& app, StateCache& rState, FrameArena& rArena, ConstantRing* pRing, u32 viewIndex)
+			: m_app(app)
+			, m_rState(rState)
+			, m_pRing(pRing)
+			, m_viewIndex(viewIndex)
+			, m_slices(FrameAllocator<ConstantSlice>(rArena))
+		{
+		}
+
+		void begin_submit(const RenderQueue& rQueue, const u32 kFirst, const u32 kCount) override
+		{
+			m_slices.clear();
+			m_nextSlice = 0;
+			m_useRing = m_pRing && m_rState.supports_constant_offsets() && m_pRing->begin(m_rState.context());
+			if (!m_useRing)
+			{
+				return;
+			}
+
+			m_slices.reserve(kCount);
+
+			for (u32 i = kFirst; i < kFirst + kCount; ++i)
+			{
+				FillPerDrawData(m_drawData, m_viewIndex, rQueue.sorted_packet(i));
+
+				ConstantSlice slice;
+				if (!m_pRing->push(m_drawData, slice))
+				{
+					// Ring is full, fall back to mapping per draw for this submit.
+					logF(LogLevel::kWarning, "Chunk constant ring full after %u of %u draws, mapping per draw", i - kFirst, kCount);
+					m_useRing = false;
+					break;
+				}
+				m_slices.push_back(slice);
+			}
+			m_pRing->end(m_rState.context());
+		}
+
+		void bind_shader(const ShaderSet* pShader) override
+		{
+			pShader->bind(m_rState);
+		}
+
+		void bind_material(const Texture* pDiffuse, const Texture* pNormal) override
+		{
+			pDiffuse->bind(m_rState, ShaderStage::kPixel, 0);
+			pNormal->bind(m_rState, ShaderStage::kPixel, 1);
+		}
+
+		void bind_mesh(const Mesh* pMesh) override
+		{
+			pMesh->bind(m_rState);
+		}
+
+		void draw(const DrawPacket& packet) override
+		{
+			if (m_useRing)
+			{
+				BindPerDrawSlice(m_rState, m_slices[m_nextSlice++]);
+				DrawPacketMesh<kViews>(m_rState, packet);
+			}
+			else
+			{
+				m_app.DrawSingleModel<kViews>(m_rState, m_drawData, m_viewIndex, packet);
+			}
+		}
+
+	private:
+		NormalMappingApp& m_app;
+		StateCache& m_rState;
+		ConstantRing* m_pRing;
+		u32 m_viewIndex;
+
+		// From the frame arena, the backend only lives for one submit.
+		FrameVector<ConstantSlice> m_slices;
+		u32 m_nextSlice = 0;
+		bool m_useRing = false;
+
+		// Per backend so backends on different threads don't share it.
+		PerDrawCBData m_drawData = {};
+	};
+
+	// Fill the object list and the transforms placing them, from the generator when it's enabled.
+	// Objects sharing a mesh are kept together so the instanced path gets long batches.
+	void BuildScene()
+	{
+		m_scene.clear();
+		if (m_sceneDesc.enabled)
 		{
-			m_meshArray[mesh].drawIndexedInstanced(pContext);
+			BuildGeneratedScene();
 		}
 		else
 		{
-			m_meshArray[mesh].draw(pContext);
+			BuildSampleScene();
+		}
+	}
+
+	// The crate grid and the props around it.
+	void BuildSampleScene()
+	{
+		// The crates hang off one grid transform, their positions are relative to it.
+		TransformSystem& transforms = m_scene.transforms();
+		m_gridTransform = transforms.create(TransformSystem::kNoParent, v3(0.f, 0.f, -3.f), quat::Identity, v3::One);
+		for (u32 i = 0; i < kNumModelTypes; ++i)
+		{
+			for (u32 j = 0; j < kNumInstances; ++j)
+			{
+				const u32 kTransform = transforms.create(m_gridTransform, v3(j * kGridSpacing, i * kGridSpacing, 0.f), quat::Identity, v3::One);
+				m_scene.add_object(i, 0, kTransform, 1);
+			}
 		}
 
+		for (const PropDesc& prop : kProps)
+		{
+			// Props are turned about the world origin after being moved, so their position turns too.
+			const m4x4 kRotation = m4x4::CreateRotationY(degToRad((f32)prop.yRot));
+			const u32 kTransform = transforms.create(TransformSystem::kNoParent, v3::Transform(prop.translation, kRotation), quat::CreateFromRotationMatrix(kRotation), v3::One);
+			m_scene.add_object(prop.mesh, prop.texture, kTransform, prop.tileFactor);
+		}
 	}
 
+	// Thousands to millions of the meshes for scaling tests, the same every run for the same settings.
+	// Every object stands on its own with no parent, so only the animated ones ever update.
+	void BuildGeneratedScene()
+	{
+		m_scene.add_generated(m_sceneDesc, kGeneratedTypes, kNumGeneratedTypes);
+		debugF("Generated a %s scene of %u objects, %u animated, %.1f m apart\n", scene_layout_name(m_sceneDesc.layout), m_scene.size(),
+			m_scene.animated(), m_sceneDesc.spacing);
+	}
 
-	//render the scene to the headset
-	//prod will be a single viewproj matrix for each eye or both for stereo
-	void RenderScene(SystemsInterface& systems, XMMATRIX* prod, bool renderStereo)
+	// Grow the instance buffers and the GPU culler to hold numObjects objects, they never shrink.
+	void ReserveInstances(SystemsInterface& systems, u32 numObjects)
 	{
-		// Update Per Frame Data.
-		m_perFrameCBData.m_matProjection = XMMatrixTranspose(*prod);
-		m_perFrameCBData.m_matView = XMMatrixTranspose(*prod);
-		m_perFrameCBData.m_time += 0.001f;
-		m_perFrameCBData.m_lightPos = v4(sin(m_perFrameCBData.m_time*5.0f) * 4.f + 3.0f, 1.f, 2.f, 0.f);
+		if (numObjects <= m_instanceCapacity)
+		{
+			return;
+		}
+		m_instanceCapacity = std::max(numObjects, kMinInstances);
+		SAFE_RELEASE(m_pInstanceSRV);
+		SAFE_RELEASE(m_pInstanceBuffer);
+		SAFE_RELEASE(m_pInstanceIndexSRV);
+		SAFE_RELEASE(m_pInstanceIndexBuffer);
+
+		// Create the instance buffer, objects are only uploaded when their transform changes.
+		m_pInstanceBuffer = create_default_structured_buffer<PerInstanceData>(systems.pD3DDevice, m_instanceCapacity);
+		m_pInstanceSRV = create_structured_buffer_view(systems.pD3DDevice, m_pInstanceBuffer);
+
+		// Create the visible object list, rewritten every instanced pass.
+		m_pInstanceIndexBuffer = create_structured_buffer<u32>(systems.pD3DDevice, m_instanceCapacity);
+		m_pInstanceIndexSRV = create_structured_buffer_view(systems.pD3DDevice, m_pInstanceIndexBuffer);
+
+		// The GPU culler draws each mesh and texture pair with one indirect draw.
+		m_gpuCuller.reserve(systems.pD3DDevice, m_instanceCapacity, kMaxCullGroups);
+
+		// A frame's slices fit the ring without falling back to a map per draw: the mono path draws every object once per eye,
+		// each in its own pass, and a recording chunk takes at most its share of one eye's draws.
+		const u32 kSlice = RingAllocator::align_up(sizeof(PerDrawCBData), ConstantRing::kSliceAlignment);
+		m_constantRing.reserve(systems.pD3DDevice, 2 * m_instanceCapacity * kSlice);
+		for (u32 i = 0; i < kMaxRecordChunks; ++i)
+		{
+			m_chunkRings[i].reserve(systems.pD3DDevice, (m_instanceCapacity / (kMaxRecordChunks / 2) + 2 * kMinChunkDraws) * kSlice);
+		}
+	}
+
+	// Place the scene again after its settings changed, everything uploads again on the next update.
+	void RebuildScene(SystemsInterface& systems)
+	{
+		BuildScene();
+		ReserveInstances(systems, m_scene.size());
+		BuildCullGroups(systems.pD3DContext);
+	}
+
+	// Recompute the transforms that moved and pass the new world matrices on to the bounds and the instance buffer.
+	// A static scene costs next to nothing here.
+	void UpdateTransforms(SystemsInterface& systems)
+	{
+		m_instanceUploads = 0;
+		m_transformUpdates = m_scene.update_transforms();
+		const std::vector<u32>& changed = m_scene.changed_objects();
+		if (changed.empty())
+		{
+			return;
+		}
+
+		PROFILE_SCOPE("Instance uploads");
+		const u32* pObjects = changed.data();
+		const u32 kNumObjects = (u32)changed.size();
+		PerInstanceData* pInstances = systems.pFrameArena->allocate_array<PerInstanceData>(kNumObjects);
+		v4* pBounds = systems.pFrameArena->allocate_array<v4>(kNumObjects);
+		const SphereBoundsSoA& bounds = m_scene.bounds();
+		for (u32 i = 0; i < kNumObjects; ++i)
+		{
+			const u32 kObject = pObjects[i];
+			const SceneObject& object = m_scene.object(kObject);
+			pBounds[i] = v4(bounds.centerX[kObject], bounds.centerY[kObject], bounds.centerZ[kObject], bounds.radius[kObject]);
+
+			PerInstanceData& instance = pInstances[i];
+			pack_affine_float3x4(m_scene.transforms().world(object.transform), instance.m_worldRows);
+			instance.m_tileFactor = object.tileFactor;
+		}
+
+		// Upload each run of consecutive objects with one update.
+		u32 first = 0;
+		while (first < kNumObjects)
+		{
+			u32 end = first + 1;
+			while (end < kNumObjects && pObjects[end] == pObjects[end - 1] + 1)
+			{
+				++end;
+			}
+
+			update_structured_buffer(systems.pD3DContext, m_pInstanceBuffer, pObjects[first], end - first, &pInstances[first]);
+			m_gpuCuller.update_bounds(systems.pD3DContext, pObjects[first], end - first, &pBounds[first]);
+			m_instanceUploads++;
+			first = end;
+		}
+	}
+
+	// Group the objects by mesh and texture for the GPU culler, each group's objects take consecutive slots.
+	void BuildCullGroups(ID3D11DeviceContext* pContext)
+	{
+		// Objects sharing a mesh are already together, so only the order between groups changes.
+		std::vector<u32> order(m_scene.size());
+		for (u32 i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [this](u32 a, u32 b)
+		{
+			const SceneObject& objectA = m_scene.object(a);
+			const SceneObject& objectB = m_scene.object(b);
+			return objectA.mesh != objectB.mesh ? objectA.mesh < objectB.mesh : objectA.texture < objectB.texture;
+		});
+
+		std::vector<CullDrawGroup> groups;
+		std::vector<u32> slotObjects;
+		slotObjects.reserve(m_scene.size());
+		m_cullBatches.clear();
+		for (const u32 kObject : order)
+		{
+			const SceneObject& object = m_scene.object(kObject);
+			if (m_cullBatches.empty() || m_cullBatches.back().mesh != object.mesh || m_cullBatches.back().texture != object.texture)
+			{
+				const Mesh& mesh = m_meshArray[object.mesh];
+				const u32 kSlot = (u32)slotObjects.size();
+				m_cullBatches.push_back({ object.mesh, object.texture, 0, kSlot, 0, {} });
+				groups.push_back({ kSlot, 0, mesh.indices(), mesh.range().firstIndex, mesh.range().baseVertex, {} });
+			}
+			m_cullBatches.back().numInstances++;
+			groups.back().numObjects++;
+			slotObjects.push_back(kObject);
+		}
+
+		ASSERT(groups.size() <= kMaxCullGroups);
+		m_gpuCuller.set_groups(pContext, groups.data(), (u32)groups.size(), slotObjects.data(), (u32)slotObjects.size());
+	}
+
+	// Find the objects inside the frustum planes, pVisibleOut needs room for every object.
+	void CullScene(const v4* pPlanes, u32* pVisibleOut)
+	{
+		const u32 kNumObjects = m_scene.size();
+		if (!m_frustumCulling)
+		{
+			for (u32 i = 0; i < kNumObjects; ++i)
+			{
+				pVisibleOut[i] = i;
+			}
+			m_numVisible = kNumObjects;
+			return;
+		}
+
+		m_numVisible = m_scene.cull(pPlanes, pVisibleOut);
+	}
+
+	// Drop the visible objects the visible occluders hide from both eyes.
+	// Occluders are never tested, they would only ever hide behind themselves.
+	void OccludeScene(SystemsInterface& systems, const XMMATRIX* viewProj, u32* pVisible)
+	{
+		PROFILE_SCOPE("Occlusion cull");
+		const auto kStart = std::chrono::high_resolution_clock::now();
+
+		OccluderInstance* pOccluders = systems.pFrameArena->allocate_array<OccluderInstance>(m_numVisible);
+		u32 numOccluders = 0;
+		for (u32 i = 0; i < m_numVisible; ++i)
+		{
+			const SceneObject& object = m_scene.object(pVisible[i]);
+			if (!m_occluders[object.mesh].empty())
+			{
+				pOccluders[numOccluders++] = { &m_occluders[object.mesh], m_scene.transforms().world(object.transform) };
+			}
+		}
+		const m4x4 kEyeViewProj[2] = { viewProj[0], viewProj[1] };
+		m_occlusionCuller.render(best_cull_kernel(), kEyeViewProj, 2, pOccluders, numOccluders);
 
+		// Bounds are spheres, test the box around each.
+		const SphereBoundsSoA& bounds = m_scene.bounds();
+		u32 numVisible = 0;
+		for (u32 i = 0; i < m_numVisible; ++i)
+		{
+			const u32 kObject = pVisible[i];
+			const f32 kRadius = bounds.radius[kObject];
+			const v3 kCenter(bounds.centerX[kObject], bounds.centerY[kObject], bounds.centerZ[kObject]);
+			if (m_occluders[m_scene.object(kObject).mesh].empty() && m_occlusionCuller.test(kCenter, v3(kRadius, kRadius, kRadius)))
+			{
+				continue;
+			}
+			pVisible[numVisible++] = kObject;
+		}
+		m_numVisible = numVisible;
+
+		m_occlusionMs = std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - kStart).count();
+	}
+
+	// Pick each object's level of detail from how close its bounds come to the eyes, or draw everything at full detail.
+	void SelectLods(const v3& eyeCenter, f32 pixelsPerUnit, f32 maxPixelError)
+	{
+		if (m_automaticLod)
+		{
+			m_scene.select_lods(eyeCenter, kNearClip, pixelsPerUnit, maxPixelError);
+		}
+		else
+		{
+			m_scene.reset_lods();
+		}
+	}
+
+	static FovTangents fov_tangents(const ovrFovPort& fov)
+	{
+		return { fov.UpTan, fov.DownTan, fov.LeftTan, fov.RightTan };
+	}
+
+
+	// Queue up every object, the queue orders them to minimise state changes.
+	void BuildSceneQueue(const XMMATRIX& viewProj, MeshShaders shader, const u32* pVisible, u32 numVisible)
+	{
+		m_scene.build_queue(m_renderQueue, &m_meshShader[(u32)m_quality.shaderTier][shader], viewProj, pVisible, numVisible);
+	}
+
+	// Update and push the per frame data, once per frame for every view.
+	// pTransforms places each view in the viewport of the pass drawing it, viewCount is the views per instanced draw.
+	void UpdatePerFrameData(ID3D11DeviceContext* pContext, const XMMATRIX* viewProj, const ViewTransform* pTransforms, u32 numViews, u32 viewCount)
+	{
+		SetViewProjections(viewProj, pTransforms, numViews);
+		m_perFrameCBData.m_viewCount = viewCount;
+		m_perFrameCBData.m_time += 0.002f;
+		m_perFrameCBData.m_lightPos = v4(sin(m_perFrameCBData.m_time*5.0f) * 4.f + 3.0f, 1.f, 2.f, 0.f);
 
 		// Push Per Frame Data to GPU
-		push_constant_buffer(systems.pD3DContext, m_pPerFrameCB, m_perFrameCBData);
+		push_constant_buffer(pContext, m_pPerFrameCB, m_perFrameCBData);
+	}
 
-		// Bind our set of shaders depending on if stereo is running
-		m_meshShader[renderStereo].bind(systems.pD3DContext);
+	// Write the views' view projections and clip planes into the per frame data.
+	void SetViewProjections(const XMMATRIX* viewProj, const ViewTransform* pTransforms, u32 numViews)
+	{
+		ASSERT(numViews <= kMaxViews);
+		for (u32 i = 0; i < numViews; ++i)
+		{
+			m_perFrameCBData.m_matViewProj[i] = XMMatrixTranspose(viewProj[i] * view_offset_matrix(pTransforms[i]));
+			for (u32 j = 0; j < kNumViewClipPlanes; ++j)
+			{
+				m_perFrameCBData.m_viewClipPlanes[i * kNumViewClipPlanes + j] = pTransforms[i].clipPlanes[j];
+			}
+		}
+	}
+
+	// Push the per frame data again with views from a later pose, everything else stays as it was.
+	// Draws only see it if they haven't been issued on the immediate context yet.
+	void LatchViewProjections(ID3D11DeviceContext* pImmediate, const XMMATRIX* viewProj, const ViewTransform* pTransforms, u32 numViews)
+	{
+		SetViewProjections(viewProj, pTransforms, numViews);
+		push_constant_buffer(pImmediate, m_pPerFrameCB, m_perFrameCBData);
+	}
+
+	// Start recording the passes into the latch context, carrying over the target and states set on the immediate context.
+	void BeginLatchRecording(SystemsInterface& systems)
+	{
+		ID3D11DeviceContext* pImmediate = systems.pD3DContext;
+		ID3D11RenderTargetView* pRTV = systems.pEyeRenderTexture->GetRTV();
+		ID3D11DepthStencilView* pDSV = systems.pEyeRenderTexture->GetDSV();
+		ComPtr<ID3D11DepthStencilState> pDepthState;
+		ComPtr<ID3D11RasterizerState> pRasterState;
+		UINT stencilRef = 0;
+		pImmediate->OMGetDepthStencilState(pDepthState.GetAddressOf(), &stencilRef);
+		pImmediate->RSGetState(pRasterState.GetAddressOf());
+
+		m_pLatchContext->OMSetRenderTargets(1, &pRTV, pDSV);
+		m_pLatchContext->OMSetDepthStencilState(pDepthState.Get(), stencilRef);
+		m_pLatchContext->RSSetState(pRasterState.Get());
+
+		m_stateCache.init(m_pLatchContext);
+	}
+
+	//combine the tracked eye poses with the main camera and build their view projections
+	static void ComputeEyeViews(SystemsInterface& systems, const PoseSample& pose, const ovrEyeRenderDesc* pRenderDesc, EyeViews& rViews)
+	{
+		for (int eye = 0; eye < 2; ++eye)
+		{
+			//Get the pose information in XM format
+			XMVECTOR eyeQuat = XMLoadFloat4(&pose.eyes[eye].orientation);
+			XMVECTOR eyePos = XMVectorSet(pose.eyes[eye].position.x, pose.eyes[eye].position.y, pose.eyes[eye].position.z, 0);
+
+			// Get view and projection matrices for the Rift camera
+			SimpleMath::Quaternion camRot;
+			m4x4::Transform(systems.pCamera->viewMatrix, camRot);
+			//calculate combined vectors of the main camera and oculus eyes
+			XMVECTOR combinedPos = XMVectorAdd(XMLoadFloat3(&systems.pCamera->eye), XMVector3Rotate(eyePos, camRot));
+			XMVECTOR combinedRot = XMQuaternionMultiply(eyeQuat, camRot);
+			//rotate the camera axes by the main camera, only the view matrix is needed so skip a full Camera
+			rViews.position[eye] = combinedPos;
+			rViews.forward[eye] = XMVector3Rotate(v3::UnitZ, combinedRot);
+			rViews.up[eye] = XMVector3Rotate(v3::UnitY, combinedRot);
+			//generate oculus view and projection matrix
+			XMMATRIX view = m4x4::CreateLookAt(rViews.position[eye], rViews.position[eye] + rViews.forward[eye], rViews.up[eye]);
+			ovrMatrix4f p = ovrMatrix4f_Projection(pRenderDesc[eye].Fov, kNearClip, kFarClip, ovrProjection_None);
+			rViews.timewarpProjection = ovrTimewarpProjectionDesc_FromProjection(p, ovrProjection_None);
+			XMMATRIX proj = projection_matrix(p);
 
+			//create the view projection matrix for application to models
+			rViews.viewProj[eye] = XMMatrixMultiply(view, proj);
+			rViews.proj[eye] = proj;
+		}
+	}
+
+	//each eye's view projection split at the middle of its field of view, top half then bottom half of each eye
+	//the halves go through split_view_rect_rows of the eye rects, which puts them back together
+	static void SplitEyeViewProjections(const EyeViews& views, const ovrEyeRenderDesc* pRenderDesc, XMMATRIX* pViewProjOut)
+	{
+		for (u32 eye = 0; eye < 2; ++eye)
+		{
+			XMMATRIX view = m4x4::CreateLookAt(views.position[eye], views.position[eye] + views.forward[eye], views.up[eye]);
+
+			// Tangents are linear across the view, so the middle row is halfway between the up and down tangents.
+			const ovrFovPort& fov = pRenderDesc[eye].Fov;
+			const f32 kMiddleTan = 0.5f * (fov.UpTan - fov.DownTan);
+			ovrFovPort halves[2] = { fov, fov };
+			halves[0].DownTan = -kMiddleTan;
+			halves[1].UpTan = kMiddleTan;
+			for (u32 half = 0; half < 2; ++half)
+			{
+				XMMATRIX proj = projection_matrix(ovrMatrix4f_Projection(halves[half], kNearClip, kFarClip, ovrProjection_None));
+				pViewProjOut[eye * 2 + half] = XMMatrixMultiply(view, proj);
+			}
+		}
+	}
+
+	//LibOVR matrices are column vector, transpose into a row vector XMMATRIX
+	static XMMATRIX projection_matrix(const ovrMatrix4f& p)
+	{
+		return XMMatrixSet(p.M[0][0], p.M[1][0], p.M[2][0], p.M[3][0],
+						   p.M[0][1], p.M[1][1], p.M[2][1], p.M[3][1],
+						   p.M[0][2], p.M[1][2], p.M[2][2], p.M[3][2],
+						   p.M[0][3], p.M[1][3], p.M[2][3], p.M[3][3]);
+	}
+
+	// Bind the constant buffers and sampler shared by every mesh draw.
+	void BindSceneState(StateCache& rState)
+	{
 		// Bind Constant Buffers, to both PS and VS stages
 		ID3D11Buffer* buffers[] = { m_pPerFrameCB, m_pPerDrawCB };
-		systems.pD3DContext->VSSetConstantBuffers(0, 2, buffers);
-		systems.pD3DContext->PSSetConstantBuffers(0, 2, buffers);
+		rState.set_constant_buffers(ShaderStage::kVertex, 0, 2, buffers);
+		rState.set_constant_buffers(ShaderStage::kPixel, 0, 2, buffers);
 
 		// Bind a sampler state
 		ID3D11SamplerState* samplers[] = { m_pLinearMipSamplerState };
-		systems.pD3DContext->PSSetSamplers(0, 1, samplers);
+		rState.set_samplers(ShaderStage::kPixel, 0, 1, samplers);
+	}
 
-		constexpr f32 kGridSpacing = 1.5f;
-		constexpr u32 kNumInstances = 5;
-		constexpr u32 kNumModelTypes = 2;
+	//render the scene to the headset
+	//each object is drawn to the per frame views [firstView, firstView + kViews), through the viewport already set
+	//viewProj is only used to sort front to back
+	template<u32 kViews>
+	void RenderScene(SystemsInterface& systems, const XMMATRIX& viewProj, u32 firstView, const u32* pVisible, u32 numVisible)
+	{
+		PROFILE_SCOPE("Record");
+		ASSERT(firstView + kViews <= kMaxViews);
+		BindSceneState(m_stateCache);
 
-		for (u32 i = 0; i < kNumModelTypes; ++i)
+		BuildSceneQueue(viewProj, kViews == 1 ? kShaderMesh : kShaderMeshViews, pVisible, numVisible);
+
+		SceneQueueBackend<kViews> backend(*this, m_stateCache, *systems.pFrameArena, &m_constantRing, firstView);
+		m_renderQueue.submit(backend);
+	}
+
+	//render both eyes of the mono path with the draw list recorded on worker threads
+	//the queue is sorted once from the left eye, each eye's half is split into chunks that record into deferred contexts
+	//both eyes share the queue so the visible list must cover both
+	//rBeforeExecute runs once every chunk is recorded, before any executes
+	void RenderSceneParallel(SystemsInterface& systems, XMMATRIX* viewProj, const ViewRect* pEyeRects, const u32* pVisible, u32 numVisible,
+		const std::function<void()>& rBeforeExecute)
+	{
+		PROFILE_SCOPE("Record parallel");
+		ID3D11DeviceContext* pImmediate = systems.pD3DContext;
+
+		BuildSceneQueue(viewProj[0], kShaderMesh, pVisible, numVisible);
+		const u32 kDraws = m_renderQueue.size();
+		if (kDraws == 0)
 		{
-			// Bind a mesh and texture.
-			m_meshArray[i].bind(systems.pD3DContext);
-			m_textures[0].bind(systems.pD3DContext, ShaderStage::kPixel, 0);
-			m_textures[1].bind(systems.pD3DContext, ShaderStage::kPixel, 1);
+			return;
+		}
 
-			// Draw several instances
-			for (u32 j = 0; j < kNumInstances; ++j)
+		// Deferred contexts start from default state, carry over what the framework set on the immediate context.
+		ID3D11RenderTargetView* pRTV = systems.pEyeRenderTexture->GetRTV();
+		ID3D11DepthStencilView* pDSV = systems.pEyeRenderTexture->GetDSV();
+		ComPtr<ID3D11DepthStencilState> pDepthState;
+		ComPtr<ID3D11RasterizerState> pRasterState;
+		UINT stencilRef = 0;
+		pImmediate->OMGetDepthStencilState(pDepthState.GetAddressOf(), &stencilRef);
+		pImmediate->RSGetState(pRasterState.GetAddressOf());
+
+		m_recorder.record(m_deferredBackend, kDraws * 2, kDraws, kMaxRecordChunks, kMinChunkDraws,
+			[&](const u32 kChunk, const RecordChunk& rChunk)
 			{
-				// Compute MVP matrix.
-				m4x4 matWorld = m4x4::CreateTranslation(v3(j * kGridSpacing, i * kGridSpacing, -3.f));
-				if (renderStereo)
-				{
-					m_perDrawCBData.m_modelViewProj[0] = (matWorld * prod[0]).Transpose();
-					m_perDrawCBData.m_modelViewProj[1] = (matWorld * prod[1]).Transpose();
-				}
-				else
-				{
-					m4x4 matMVP = matWorld * *prod;
-					m_perDrawCBData.m_matMVP = matMVP.Transpose();
-				}
+				const u32 eye = rChunk.first / kDraws;
+				ID3D11DeviceContext* pContext = m_deferredBackend.context(kChunk);
 
-				// Update Per Draw Data
-				m_perDrawCBData.m_matWorld = matWorld.Transpose();
-				m_perDrawCBData.m_tileFactor = 1;
+				StateCache& rState = m_chunkStates[kChunk];
+				rState.init(pContext);
+				rState.reset_stats();
+				m_chunkQueueStats[kChunk] = {};
 
-				// Inverse transpose,  but since we didn't do any shearing or non-uniform scaling then we simple grab the upper 3x3 in the shader.
-				pack_upper_float3x3(m_perDrawCBData.m_matWorld, m_perDrawCBData.m_matNormal);
+				pContext->OMSetRenderTargets(1, &pRTV, pDSV);
+				pContext->OMSetDepthStencilState(pDepthState.Get(), stencilRef);
+				pContext->RSSetState(pRasterState.Get());
+				SetViewport(pContext, pEyeRects[eye]);
 
-				// Push to GPU
-				push_constant_buffer(systems.pD3DContext, m_pPerDrawCB, m_perDrawCBData);
+				// The per frame buffer already holds both eyes, it was pushed on the immediate context before recording.
+				BindSceneState(rState);
 
-				// Draw the mesh.
-				if (renderStereo)
-				{
-					m_meshArray[i].drawIndexedInstanced(systems.pD3DContext);
-				}
-				else
+				SceneQueueBackend<1> backend(*this, rState, *systems.pFrameArena, &m_chunkRings[kChunk], eye);
+				m_renderQueue.submit_range(backend, rChunk.first - eye * kDraws, rChunk.count, m_chunkQueueStats[kChunk]);
+			}, rBeforeExecute);
+
+		m_recordedStateStats = {};
+		for (u32 i = 0; i < m_recorder.chunks(); ++i)
+		{
+			const StateCacheStats& chunkStats = m_chunkStates[i].stats();
+			m_recordedStateStats.issued += chunkStats.issued;
+			m_recordedStateStats.skipped += chunkStats.skipped;
+			m_recordedStateStats.draws += chunkStats.draws;
+			m_recordedStateStats.triangles += chunkStats.triangles;
+		}
+	}
+
+	//render the scene with a single instanced draw per mesh
+	//the visible list indexes the persistent instance buffer, each object is drawn to views [firstView, firstView + kViews)
+	template<u32 kViews>
+	void RenderSceneInstanced(SystemsInterface& systems, u32 firstView, const u32* pVisible, u32 numVisible)
+	{
+		PROFILE_SCOPE("Record instanced");
+		ID3D11DeviceContext* pContext = systems.pD3DContext;
+
+		// Instance data is already on the GPU, only the visible object indices go up.
+		ASSERT(numVisible <= m_instanceCapacity);
+		D3D11_MAPPED_SUBRESOURCE subresource;
+		perf_count(PerfCounter::kMapCalls, 1);
+		if (FAILED(pContext->Map(m_pInstanceIndexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource)))
+		{
+			return;
+		}
+		memcpy(subresource.pData, pVisible, numVisible * sizeof(u32));
+		pContext->Unmap(m_pInstanceIndexBuffer, 0);
+
+		// Batches only live for this call, keep them in the frame arena.
+		FrameVector<InstanceBatch> batches(FrameAllocator<InstanceBatch>(*systems.pFrameArena));
+
+		// Visible objects come in scene order, so consecutive objects with the same mesh and level share a batch.
+		for (u32 i = 0; i < numVisible; ++i)
+		{
+			const SceneObject& object = m_scene.object(pVisible[i]);
+			const u32 kLod = m_scene.lod(pVisible[i]);
+			if (batches.empty() || batches.back().mesh != object.mesh || batches.back().texture != object.texture || batches.back().lod != kLod)
+			{
+				batches.push_back({ object.mesh, object.texture, kLod, i, 0, {} });
+			}
+			batches.back().numInstances++;
+		}
+
+		DrawInstanceBatches<kViews>(systems, firstView, batches.data(), (u32)batches.size(), m_pInstanceIndexSRV, nullptr);
+	}
+
+	//cull on the GPU against views [firstView, firstView + kViews) and draw each mesh and texture pair indirectly
+	//the CPU never learns what is visible, it issues the same draws every pass, always at level of detail 0
+	template<u32 kViews>
+	void RenderSceneGpuCulled(SystemsInterface& systems, u32 firstView, const XMMATRIX* pViewProj)
+	{
+		PROFILE_SCOPE("Record GPU culled");
+		m4x4 viewProj[kViews];
+		for (u32 i = 0; i < kViews; ++i)
+		{
+			viewProj[i] = pViewProj[firstView + i];
+		}
+
+		CullConstants constants = make_cull_constants(viewProj, kViews);
+		if (!m_frustumCulling)
+		{
+			// Planes every sphere is in front of.
+			for (v4& plane : constants.planes)
+			{
+				plane = v4(0.f, 0.f, 0.f, 1.f);
+			}
+		}
+
+		// The visible list is about to be written, it can't stay bound to the vertex shader.
+		ID3D11ShaderResourceView* nullViews[] = { nullptr };
+		m_stateCache.set_shader_resources(ShaderStage::kVertex, 3, 1, nullViews);
+		m_gpuCuller.dispatch(m_stateCache, constants);
+
+		DrawInstanceBatches<kViews>(systems, firstView, m_cullBatches.data(), (u32)m_cullBatches.size(), m_gpuCuller.visible_view(), m_gpuCuller.args_buffer());
+	}
+
+	//one draw per batch covering every object and view, batches are runs of the visible list in pVisibleSRV
+	//with pArgs the instance counts come from the GPU, batch i draws with the arguments of group i
+	template<u32 kViews>
+	void DrawInstanceBatches(SystemsInterface& systems, u32 firstView, InstanceBatch* pBatches, u32 numBatches,
+		ID3D11ShaderResourceView* pVisibleSRV, ID3D11Buffer* pArgs)
+	{
+		// The shader splits instances into objects and views by the per frame view count.
+		ASSERT(m_perFrameCBData.m_viewCount == kViews && firstView + kViews <= kMaxViews);
+		ID3D11DeviceContext* pContext = systems.pD3DContext;
+
+		// Per batch constants go into the ring in one map, unless it is unsupported or full.
+		m_perDrawCBData.m_viewIndex = firstView;
+		bool useRing = m_stateCache.supports_constant_offsets() && m_constantRing.begin(pContext);
+		if (useRing)
+		{
+			for (u32 i = 0; i < numBatches; ++i)
+			{
+				m_perDrawCBData.m_instanceOffset = pBatches[i].firstInstance;
+				if (!m_constantRing.push(m_perDrawCBData, pBatches[i].slice))
 				{
-					m_meshArray[i].draw(systems.pD3DContext);
+					logF(LogLevel::kWarning, "Constant ring full after %u of %u batches, mapping per draw", i, numBatches);
+					useRing = false;
+					break;
 				}
-
 			}
+			m_constantRing.end(pContext);
 		}
 
-		//Floor
-		DrawSingleModel(systems.pD3DContext, renderStereo, prod, 2, 2, v3(0.f, -0.5f, 0.f), 0, 9);
-		//house
-		DrawSingleModel(systems.pD3DContext, renderStereo, prod, 3, 4, v3(4.f, -0.5f, 2.f), -90, 1);
-		//bus
-		DrawSingleModel(systems.pD3DContext, renderStereo, prod, 4, 6, v3(7.f, -0.5f, 2.f), 0, 1);
-		//house2
-		DrawSingleModel(systems.pD3DContext, renderStereo, prod, 5, 8, v3(-2.f, -0.5f, 11.f), 180, 1);
+		m_meshShader[(u32)m_quality.shaderTier][kShaderMeshInstanced].bind(m_stateCache);
+
+		// Bind Constant Buffers, to both PS and VS stages
+		ID3D11Buffer* buffers[] = { m_pPerFrameCB, m_pPerDrawCB };
+		m_stateCache.set_constant_buffers(ShaderStage::kVertex, 0, 2, buffers);
+		m_stateCache.set_constant_buffers(ShaderStage::kPixel, 0, 2, buffers);
+
+		// The instance buffers are only read by the vertex shader.
+		ID3D11ShaderResourceView* instanceViews[] = { m_pInstanceSRV, pVisibleSRV };
+		m_stateCache.set_shader_resources(ShaderStage::kVertex, 2, 2, instanceViews);
+
+		// Bind a sampler state
+		ID3D11SamplerState* samplers[] = { m_pLinearMipSamplerState };
+		m_stateCache.set_samplers(ShaderStage::kPixel, 0, 1, samplers);
+
+		GpuProfiler* pBatchProfiler = m_gpuBatchScopes && pContext->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE ? systems.pGpuProfiler : nullptr;
+		for (u32 i = 0; i < numBatches; ++i)
+		{
+			GpuProfileScope batchScope(pBatchProfiler, "Instance batch");
+			const InstanceBatch& batch = pBatches[i];
+			m_meshArray[batch.mesh].bind(m_stateCache);
+			m_textures[batch.texture].bind(m_stateCache, ShaderStage::kPixel, 0);
+			m_textures[batch.texture + 1].bind(m_stateCache, ShaderStage::kPixel, 1);
+
+			if (useRing)
+			{
+				BindPerDrawSlice(m_stateCache, batch.slice);
+			}
+			else
+			{
+				m_perDrawCBData.m_instanceOffset = batch.firstInstance;
+				push_constant_buffer(pContext, m_pPerDrawCB, m_perDrawCBData);
+			}
+
+			if (pArgs)
+			{
+				m_stateCache.draw_indexed_instanced_indirect(pArgs, GpuCuller::args_offset(i));
+			}
+			else
+			{
+				m_meshArray[batch.mesh].drawIndexedInstanced(m_stateCache, batch.numInstances * kViews, batch.lod);
+			}
+		}
 	}
 
 	void on_render(SystemsInterface& systems) override
@@ -259,10 +1270,30 @@ public:
 		//get the current oculus session
 		ovrSessionStatus sessionStatus;
 		ovrResult result = ovr_GetSessionStatus(*systems.pOvrSession, &sessionStatus);
-		printf(std::to_string(result).c_str());
 		if (OVR_FAILURE(result))
 			panicF("Connection failed.");
 
+		// the knobs for this frame, full quality when the governor is off
+		// it reacts to measured times, a benchmark holds full quality so every run draws the same
+		if (m_adaptiveQuality && !systems.benchmark)
+		{
+			UpdateQualityGovernor(systems);
+			m_quality = m_qualityGovernor.level();
+		}
+		else
+		{
+			m_quality = { 1.f, 0.f, ShaderTier::kNormalMapped };
+		}
+		ovrRecti eyeViewports[2];
+		scale_eye_viewports(systems, m_quality.viewportScale, eyeViewports);
+
+		// every pass of the frame adds its per draw constants behind the last, the rings are discarded once here
+		m_constantRing.begin_frame();
+		for (u32 i = 0; i < kMaxRecordChunks; ++i)
+		{
+			m_chunkRings[i].begin_frame();
+		}
+
 		//VR Implementation 
 		ovrHmdDesc hmdDesc = ovr_GetHmdDesc(*systems.pOvrSession);
 
@@ -271,100 +1302,251 @@ public:
 		eyeRenderDesc[0] = ovr_GetRenderDesc(*systems.pOvrSession, ovrEye_Left, hmdDesc.DefaultEyeFov[0]);
 		eyeRenderDesc[1] = ovr_GetRenderDesc(*systems.pOvrSession, ovrEye_Right, hmdDesc.DefaultEyeFov[1]);
 
-		// Get both eye poses simultaneously, with IPD offset already included. 
-		ovrPosef EyeRenderPose[2];
-		ovrPosef HmdToEyePose[2] = { eyeRenderDesc[0].HmdToEyePose,
-									 eyeRenderDesc[1].HmdToEyePose };
+		// Sample the eye poses, predicted for when this frame is displayed.
+		// With late latching they are sampled again once the passes are recorded, so these only cull.
+		FrameLifecycle& frame = *systems.pFrameLifecycle;
+		const PoseSample kEarlyPose = systems.pPoseSource->sample(frame.frame_index(), frame.predicted_display_time());
+		PoseSample renderPose = kEarlyPose; // the pose the views were last pushed with, goes to the layer
 
-		double sensorSampleTime;    // sensorSampleTime is fed into the layer later
-		//get the eye poses
-		ovr_GetEyePoses(*systems.pOvrSession, 0, ovrTrue, HmdToEyePose, EyeRenderPose, &sensorSampleTime);
-
-		ovrTimewarpProjectionDesc posTimewarpProjectionDesc = {};
-
-		//stores the view matricies for switching between instanced & double render
-		XMMATRIX viewProjMatrix[2];
-		XMMATRIX projMatrix[2];
+		EyeViews views;
+		ComputeEyeViews(systems, kEarlyPose, eyeRenderDesc, views);
+		XMMATRIX* viewProjMatrix = views.viewProj;
 
+		// GPU time of both eyes, recorded passes included as they execute on the immediate context.
+		const u32 kEyePassScope = systems.pGpuProfiler ? systems.pGpuProfiler->begin_scope("Eye pass") : GpuProfiler::kInvalidScope;
 		SetAndClearRenderTarget(systems.pEyeRenderTexture->GetRTV(), systems.pEyeRenderTexture->GetDSV(), systems.pD3DContext);
 
-		// Render Scene to Eye Buffers
-		for (int eye = 0; eye < 2; ++eye)
+		// Debug draw and imgui bind state behind the cache's back, start each frame clean.
+		m_stateCache.invalidate();
+		m_stateCache.reset_stats();
+
+		// stereo draws both eyes through one viewport across the target, mono gives each eye its own
+		// split eyes draws each eye as its top and bottom halves, four views through the stereo viewport for the same image
+		const bool kSplitEyes = systems.stereo && m_splitEyeViews;
+		const ViewRect eyeRects[2] = { view_rect(eyeViewports[0]), view_rect(eyeViewports[1]) };
+		const ViewLayout<2> stereoLayout = make_view_layout<2>(eyeRects);
+		ViewTransform eyeTransforms[2];
+		for (u32 eye = 0; eye < 2; ++eye)
+		{
+			eyeTransforms[eye] = systems.stereo ? stereoLayout.transforms[eye] : make_view_layout<1>(&eyeRects[eye]).transforms[0];
+		}
+		ViewRect splitRects[4];
+		split_view_rect_rows(eyeRects[0], &splitRects[0]);
+		split_view_rect_rows(eyeRects[1], &splitRects[2]);
+		const ViewLayout<4> splitLayout = make_view_layout<4>(splitRects);
+		XMMATRIX splitViewProj[4];
+		SplitEyeViewProjections(views, eyeRenderDesc, splitViewProj);
+
+		// the view projections go up once, every path below picks its view by index
+		if (kSplitEyes)
+		{
+			UpdatePerFrameData(systems.pD3DContext, splitViewProj, splitLayout.transforms, 4, 4);
+		}
+		else
 		{
+			UpdatePerFrameData(systems.pD3DContext, viewProjMatrix, eyeTransforms, 2, systems.stereo ? 2 : 1);
+		}
 
-			//Get the pose information from the rift in XM format
-			XMVECTOR eyeQuat = XMLoadFloat4((XMFLOAT4 *)&EyeRenderPose[eye].Orientation.x);
-			XMVECTOR eyePos = XMVectorSet(EyeRenderPose[eye].Position.x, EyeRenderPose[eye].Position.y, EyeRenderPose[eye].Position.z, 0);
+		// one frustum enclosing both eyes, so a single culling pass serves every path below
+		const v3 centerPosition = (views.position[0] + views.position[1]) * 0.5f;
+		const m4x4 centerView = m4x4::CreateLookAt(centerPosition, centerPosition + views.forward[0], views.up[0]);
+		const f32 kEyeSeparation = v3::Distance(views.position[0], views.position[1]);
+		if (m_lateLatch)
+		{
+			// the late pose is at most a frame newer, cull for anywhere the head can get to in that time
+			const f32 kLatchWindow = (f32)frame.hmd()->refresh_interval();
+			m_cullFrustum = compute_expanded_stereo_cull_frustum(centerView, fov_tangents(eyeRenderDesc[0].Fov), fov_tangents(eyeRenderDesc[1].Fov),
+				kEyeSeparation, kNearClip, kFarClip, kMaxHeadAngularSpeed * kLatchWindow, kMaxHeadSpeed * kLatchWindow);
+		}
+		else
+		{
+			m_cullFrustum = compute_stereo_cull_frustum(centerView, fov_tangents(eyeRenderDesc[0].Fov), fov_tangents(eyeRenderDesc[1].Fov),
+				kEyeSeparation, kNearClip, kFarClip);
+		}
+		UpdateTransforms(systems);
 
-			// Get view and projection matrices for the Rift camera
-			SimpleMath::Quaternion camRot;
-			m4x4::Transform(systems.pCamera->viewMatrix, camRot);
-			//calculate combined vectors of the main camera and oculus eyes
-			XMVECTOR combinedPos = XMVectorAdd(XMLoadFloat3(&systems.pCamera->eye), XMVector3Rotate(eyePos, camRot));
-			XMVECTOR combinedRot = XMQuaternionMultiply(eyeQuat, camRot);
-			//create a camera for each eye
-			Camera finalCam;
-			finalCam.eye = combinedPos;
-			//rotate by the main camera
-			finalCam.forward = XMVector3Rotate(finalCam.forward, combinedRot);
-			finalCam.up = XMVector3Rotate(finalCam.up, combinedRot);
-			finalCam.right = XMVector3Rotate(finalCam.right, combinedRot);
-			finalCam.updateMatrices();
-			//generate oculus view and projection matrix
-			XMMATRIX view = finalCam.viewMatrix;
-			ovrMatrix4f p = ovrMatrix4f_Projection(eyeRenderDesc[eye].Fov, 0.2f, 1000.0f, ovrProjection_None);
-			posTimewarpProjectionDesc = ovrTimewarpProjectionDesc_FromProjection(p, ovrProjection_None);
-			//manually set projection matrix
-			XMMATRIX proj = XMMatrixSet(p.M[0][0], p.M[1][0], p.M[2][0], p.M[3][0],
-										p.M[0][1], p.M[1][1], p.M[2][1], p.M[3][1],
-										p.M[0][2], p.M[1][2], p.M[2][2], p.M[3][2],
-										p.M[0][3], p.M[1][3], p.M[2][3], p.M[3][3]);
+		// levels of detail are picked once for both eyes, from the eye that magnifies most
+		// the scaled viewports already coarsen them, the bias goes further
+		f32 lodPixelsPerUnit = 0.f;
+		for (u32 eye = 0; eye < 2; ++eye)
+		{
+			lodPixelsPerUnit = std::max(lodPixelsPerUnit, lod_pixels_per_unit(views.proj[eye], eyeRects[eye].width, eyeRects[eye].height));
+		}
+		SelectLods(centerPosition, lodPixelsPerUnit, m_lodPixelError * exp2f(m_quality.lodBias));
 
-			if (systems.stereo)
+		// GPU culling replaces the CPU pass, otherwise every path below draws from its visible list
+		const bool kGpuCulling = m_gpuCulling && m_instancedSubmission;
+		u32* pVisible = nullptr;
+		if (!kGpuCulling)
+		{
+			pVisible = systems.pFrameArena->allocate_array<u32>(m_scene.size());
+			CullScene(m_cullFrustum.planes, pVisible);
+			if (m_occlusionCulling)
 			{
-				// scale and offset projection matrix to shift image to correct part of texture for each eye
-				XMMATRIX scale = XMMatrixScaling(0.5f, 1.0f, 1.0f);
-				XMMATRIX translate = XMMatrixTranslation((eye == 0) ? -0.5f : 0.5f, 0.0f, 0.0f);
-				proj = XMMatrixMultiply(proj, scale);
-				proj = XMMatrixMultiply(proj, translate);
+				// turning the head doesn't change what hides behind what, the early views do for occlusion
+				OccludeScene(systems, viewProjMatrix, pVisible);
 			}
+		}
 
-			//create the view projection matrix for application to models
-			viewProjMatrix[eye] = XMMatrixMultiply(view, proj);
-			projMatrix[eye] = view;
+		// the GPU culls each view against the expanded frustum when the views can still change
+		XMMATRIX cullViewProj[4] = { viewProjMatrix[0], viewProjMatrix[1] };
+		if (kSplitEyes)
+		{
+			std::copy(splitViewProj, splitViewProj + 4, cullViewProj);
+		}
+		if (m_lateLatch)
+		{
+			std::fill(cullViewProj, cullViewProj + 4, m_cullFrustum.viewProj);
+		}
 
+		// late latching records the passes into a command list, the views are rewritten before it executes
+		// the parallel path records into command lists already, it latches between recording and executing them
+		const bool kParallel = !systems.stereo && m_parallelRecording && !m_instancedSubmission;
+		const bool kRecordLatch = m_lateLatch && !kParallel;
+		SystemsInterface recordSystems = systems;
+		if (kRecordLatch)
+		{
+			BeginLatchRecording(systems);
+			recordSystems.pD3DContext = m_pLatchContext;
 		}
-		if (systems.stereo)
+		bool latched = false;
+		auto latchPoses = [&]()
 		{
-			// use instancing for stereo
-			//set viewport to be the length of both eyes
-			SetViewport(systems, 0.0f, 0.0f, (float)systems.pEyeRenderViewport[0]->Size.w + systems.pEyeRenderViewport[1]->Size.w, (float)systems.pEyeRenderViewport[0]->Size.h);
-			// Update Per Frame Data.
-			m_perFrameCBData.m_matProjection = XMMatrixTranspose(projMatrix[0]);
-			m_perFrameCBData.m_matView = XMMatrixTranspose(viewProjMatrix[0]);
-			m_perFrameCBData.m_time += 0.001f;
-			m_perFrameCBData.m_lightPos = v4(sin(m_perFrameCBData.m_time*5.0f) * 4.f + 3.0f, 1.f, 2.f, 0.f);
+			PROFILE_SCOPE("Late latch");
+			const PoseSample kLatePose = systems.pPoseSource->sample(frame.frame_index(), frame.predicted_display_time());
+			EyeViews lateViews;
+			ComputeEyeViews(systems, kLatePose, eyeRenderDesc, lateViews);
+			if (kSplitEyes)
+			{
+				XMMATRIX lateSplitViewProj[4];
+				SplitEyeViewProjections(lateViews, eyeRenderDesc, lateSplitViewProj);
+				LatchViewProjections(systems.pD3DContext, lateSplitViewProj, splitLayout.transforms, 4);
+			}
+			else
+			{
+				LatchViewProjections(systems.pD3DContext, lateViews.viewProj, eyeTransforms, 2);
+			}
+			m_latchMs = (f32)((kLatePose.sampleTime - kEarlyPose.sampleTime) * 1000.0);
+			renderPose = kLatePose;
+			latched = true;
+		};
 
+		if (kSplitEyes)
+		{
+			// four views instanced through the viewport covering both eyes
+			SetViewport(recordSystems.pD3DContext, splitLayout.viewport);
+			if (kGpuCulling)
+			{
+				RenderSceneGpuCulled<4>(recordSystems, 0, cullViewProj);
+			}
+			else if (m_instancedSubmission)
+			{
+				RenderSceneInstanced<4>(recordSystems, 0, pVisible, m_numVisible);
+			}
+			else
+			{
+				RenderScene<4>(recordSystems, viewProjMatrix[0], 0, pVisible, m_numVisible);
+			}
+		}
+		else if (systems.stereo)
+		{
+			// use instancing for stereo
+			//set viewport to cover both eyes
+			SetViewport(recordSystems.pD3DContext, stereoLayout.viewport);
 			// render scene
-			RenderScene(systems, &viewProjMatrix[0], systems.stereo);
+			if (kGpuCulling)
+			{
+				RenderSceneGpuCulled<2>(recordSystems, 0, cullViewProj);
+			}
+			else if (m_instancedSubmission)
+			{
+				RenderSceneInstanced<2>(recordSystems, 0, pVisible, m_numVisible);
+			}
+			else
+			{
+				RenderScene<2>(recordSystems, viewProjMatrix[0], 0, pVisible, m_numVisible);
+			}
 
 		}
+		else if (kParallel)
+		{
+			// both eyes recorded on worker threads, executed here in order
+			RenderSceneParallel(systems, &viewProjMatrix[0], eyeRects, pVisible, m_numVisible, m_lateLatch ? std::function<void()>(latchPoses) : nullptr);
+		}
 		else
 		{
 			// non-instanced path
 			for (int eye = 0; eye < 2; ++eye)
 			{
 				// set viewport for each eye individually
-				SetViewport(systems, (float)systems.pEyeRenderViewport[eye]->Pos.x, (float)systems.pEyeRenderViewport[eye]->Pos.y,
-					(float)systems.pEyeRenderViewport[eye]->Size.w, (float)systems.pEyeRenderViewport[eye]->Size.h);
+				SetViewport(recordSystems.pD3DContext, eyeRects[eye]);
 
 
 				//render scene
-				RenderScene(systems, &viewProjMatrix[eye], systems.stereo);
+				if (kGpuCulling)
+				{
+					RenderSceneGpuCulled<1>(recordSystems, eye, cullViewProj);
+				}
+				else if (m_instancedSubmission)
+				{
+					RenderSceneInstanced<1>(recordSystems, eye, pVisible, m_numVisible);
+				}
+				else
+				{
+					RenderScene<1>(recordSystems, viewProjMatrix[eye], eye, pVisible, m_numVisible);
+				}
+			}
+		}
+		// Swap in the newest poses just before the recorded passes run.
+		if (kRecordLatch)
+		{
+			PROFILE_SCOPE("Execute latched");
+			ID3D11CommandList* pCommandList = nullptr;
+			if (FAILED(m_pLatchContext->FinishCommandList(FALSE, &pCommandList)))
+			{
+				panicF("Failed to finish command list");
+			}
+			if (!latched)
+			{
+				latchPoses();
 			}
+			systems.pD3DContext->ExecuteCommandList(pCommandList, TRUE);
+			pCommandList->Release();
+		}
+		else if (m_lateLatch && !latched)
+		{
+			// nothing was recorded, still submit the newest poses
+			latchPoses();
+		}
+
+		if (systems.pGpuProfiler)
+		{
+			systems.pGpuProfiler->end_scope(kEyePassScope);
+		}
+
+		// Commit rendering to the swap chain.
+		// Not in a benchmark, its layer goes to the simulated HMD and ovr_EndFrame never takes the committed texture.
+		if (!systems.benchmark)
+		{
+			systems.pEyeRenderTexture->Commit();
+		}
+		m_lastStateStats = m_stateCache.stats();
+		m_lastStateStats.issued += m_recordedStateStats.issued;
+		m_lastStateStats.skipped += m_recordedStateStats.skipped;
+		m_lastStateStats.draws += m_recordedStateStats.draws;
+		m_lastStateStats.triangles += m_recordedStateStats.triangles;
+		m_recordedStateStats = {};
+
+		// The scene's draws, debug draw and imgui aren't counted.
+		perf_count(PerfCounter::kDrawCalls, m_lastStateStats.draws);
+		perf_count(PerfCounter::kTriangles, m_lastStateStats.triangles);
+		perf_count(PerfCounter::kTransformUpdates, m_transformUpdates);
+		if (!kGpuCulling)
+		{
+			perf_count(PerfCounter::kVisibleObjects, m_numVisible);
+			perf_count(PerfCounter::kCulledObjects, m_scene.size() - m_numVisible);
 		}
-		// Commit rendering to the swap chain
-		systems.pEyeRenderTexture->Commit();
+		m_stateCache.init(systems.pD3DContext);
 
 
 
@@ -373,23 +1555,22 @@ public:
 		ovrLayerEyeFovDepth ld = {};
 		ld.Header.Type = ovrLayerType_EyeFovDepth;
 		ld.Header.Flags = 0;
-		ld.ProjectionDesc = posTimewarpProjectionDesc;
-		ld.SensorSampleTime = sensorSampleTime;
+		ld.ProjectionDesc = views.timewarpProjection;
+		ld.SensorSampleTime = renderPose.sampleTime;
 
 		//set final layer params to submit to headset
 		for (int eye = 0; eye < 2; ++eye)
 		{
 			ld.ColorTexture[eye] = systems.pEyeRenderTexture->TextureChain;
 			ld.DepthTexture[eye] = systems.pEyeRenderTexture->DepthTextureChain;
-			ld.Viewport[eye] = *systems.pEyeRenderViewport[eye];
+			ld.Viewport[eye] = eyeViewports[eye];
 			ld.Fov[eye] = hmdDesc.DefaultEyeFov[eye];
-			ld.RenderPose[eye] = EyeRenderPose[eye];
+			ld.RenderPose[eye] = ovr_pose_from_eye(renderPose.eyes[eye]);
 		}
 
 		ovrLayerHeader* layers = &ld.Header;
-		result = ovr_SubmitFrame(*systems.pOvrSession, 0, nullptr, &layers, 1);
-		// exit the rendering loop if submit returns an error, will retry on ovrError_DisplayLost
-		if (!OVR_SUCCESS(result))
+		// exit the rendering loop if submit returns an error
+		if (!systems.pFrameLifecycle->end_frame(&layers, 1))
 			panicF("Fail Rendering Loop!");
 	}
 
@@ -408,10 +1589,67 @@ private:
 	PerDrawCBData m_perDrawCBData;
 	ID3D11Buffer* m_pPerDrawCB = nullptr;
 
-	ShaderSet m_meshShader[2];
+	RenderQueue m_renderQueue;
+	StateCache m_stateCache;
+	StateCacheStats m_lastStateStats = {};
+
+	ParallelRecorder m_recorder;
+	DeferredContextBackend m_deferredBackend;
+	std::vector<StateCache> m_chunkStates;
+	std::vector<RenderQueueStats> m_chunkQueueStats;
+	StateCacheStats m_recordedStateStats = {};
+
+	ConstantRing m_constantRing;
+	std::unique_ptr<ConstantRing[]> m_chunkRings;
+	bool m_parallelRecording = false;
+
+	ID3D11Buffer* m_pInstanceBuffer = nullptr;
+	ID3D11ShaderResourceView* m_pInstanceSRV = nullptr;
+	ID3D11Buffer* m_pInstanceIndexBuffer = nullptr;
+	ID3D11ShaderResourceView* m_pInstanceIndexSRV = nullptr;
+	bool m_instancedSubmission = true;
+	bool m_splitEyeViews = false;
+
+	GpuCuller m_gpuCuller;
+	std::vector<InstanceBatch> m_cullBatches; // one per cull group, a run of slots in the visible list
+	bool m_gpuCulling = false;
+
+	OcclusionCuller m_occlusionCuller;
+	OccluderMesh m_occluders[kNumMeshes]; // per mesh, empty when the mesh doesn't occlude
+	f32 m_occlusionMs = 0.f;
+	bool m_occlusionCulling = true;
+
+	Scene m_scene;
+	u32 m_gridTransform = 0;
+	bool m_animateGrid = false;
+	SceneGeneratorDesc m_sceneDesc;
+	u32 m_instanceCapacity = 0; // objects the instance buffers and the GPU culler hold
+	u32 m_transformUpdates = 0;
+	u32 m_instanceUploads = 0;
+	StereoCullFrustum m_cullFrustum;
+	u32 m_numVisible = 0;
+	bool m_frustumCulling = true;
+
+	f32 m_lodPixelError = kDefaultLodPixelError;
+	bool m_automaticLod = true;
+
+	ShaderSet m_meshShader[kNumShaderTiers][kNumMeshShaders];
+
+	QualityGovernor m_qualityGovernor;
+	QualityLevel m_quality = { 1.f, 0.f, ShaderTier::kNormalMapped }; // knobs this frame renders with
+	s32 m_lastPerfFrameIndex = -1;                                     // app frame the governor last saw
+	bool m_adaptiveQuality = true;
+
+	ID3D11DeviceContext* m_pLatchContext = nullptr; // records the passes when late latching
+	f32 m_latchMs = 0.f;
+	bool m_lateLatch = true;
+	bool m_gpuBatchScopes = false;
+
+	ProfilerOverhead m_profilerOverhead = {};
 	
-	Mesh m_meshArray[6];
-	Texture m_textures[10];
+	GeometryPool m_geometryPool; // before the meshes, they hand their ranges back when destroyed
+	Mesh m_meshArray[kNumMeshes];
+	Texture m_textures[kNumTextures];
 	ID3D11SamplerState* m_pLinearMipSamplerState = nullptr;
 
 	v3 m_position;
@@ -0,0 +1,229 @@
+#include "TestHarness.h"
+#include "CullDrawGroups.h"
+
+namespace
+{
+	// Side by side eyes and the views of a quad layout, each looking a little differently.
+	m4x4 test_view_proj(const u32 kView)
+	{
+		const m4x4 kViewMatrix = m4x4::CreateRotationY(0.3f * (f32)kView - 0.4f) * m4x4::CreateTranslation(-0.5f * (f32)kView, 0.f, 2.f);
+		return kViewMatrix * m4x4::CreatePerspectiveOffCenter(-0.5f, 0.4f + 0.05f * (f32)kView, -0.4f, 0.45f, 0.5f, 100.f);
+	}
+
+	// Spheres scattered around the frusta, a lot of them straddling their planes.
+	void make_bounds(const u32 kCount, const u64 kSeed, SphereBoundsSoA& rBounds, std::vector<v4>& rSpheres)
+	{
+		Random random(kSeed);
+		rBounds.clear();
+		rSpheres.clear();
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			const v3 kCenter(random.range(-60.f, 60.f), random.range(-60.f, 60.f), random.range(-20.f, 120.f));
+			const f32 kRadius = random.range(0.f, 5.f);
+			rBounds.add(kCenter, kRadius);
+			rSpheres.push_back(v4(kCenter.x, kCenter.y, kCenter.z, kRadius));
+		}
+	}
+
+	// Groups of every size either side of a thread group, over a shuffled object list as the app's
+	// is sorted by mesh rather than by object.
+	void make_groups(const u32 kCount, const u64 kSeed, std::vector<CullDrawGroup>& rGroups, std::vector<u32>& rSlotObjects)
+	{
+		Random random(kSeed);
+		rSlotObjects.resize(kCount);
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			rSlotObjects[i] = i;
+		}
+		for (u32 i = kCount; i > 1; --i)
+		{
+			std::swap(rSlotObjects[i - 1], rSlotObjects[random.below(i)]);
+		}
+
+		const u32 kSizes[] = { 0, 1, kCullThreadGroupSize - 1, kCullThreadGroupSize, kCullThreadGroupSize + 1, 3 * kCullThreadGroupSize + 7 };
+		rGroups.clear();
+		u32 slot = 0;
+		for (u32 g = 0; slot < kCount; ++g)
+		{
+			const u32 kSize = std::min(kSizes[g % 6], kCount - slot);
+			const CullDrawGroup kGroup = { slot, kSize, 36 + 3 * g, 1000 * g, (s32)(100 * g) - 50, { 0, 0, 0 } };
+			rGroups.push_back(kGroup);
+			slot += kSize;
+		}
+	}
+}
+
+TEST_CASE(indirect_args_match_the_device_layout)
+{
+	// The cull shader writes the args as raw bytes, DrawIndexedInstancedIndirect reads them as this struct.
+	CHECK_EQ((u32)sizeof(DrawIndexedIndirectArgs), 20u);
+	CHECK_EQ((u32)offsetof(DrawIndexedIndirectArgs, indexCountPerInstance), 0u);
+	CHECK_EQ((u32)offsetof(DrawIndexedIndirectArgs, instanceCount), 4u);
+	CHECK_EQ((u32)offsetof(DrawIndexedIndirectArgs, startIndexLocation), 8u);
+	CHECK_EQ((u32)offsetof(DrawIndexedIndirectArgs, baseVertexLocation), 12u);
+	CHECK_EQ((u32)offsetof(DrawIndexedIndirectArgs, startInstanceLocation), 16u);
+
+	// Structured buffer elements are read in 16 byte rows.
+	CHECK_EQ((u32)sizeof(CullDrawGroup) % 16, 0u);
+	CHECK_EQ((u32)sizeof(CullConstants) % 16, 0u);
+	CHECK_EQ((u32)sizeof(CullSlot), 8u);
+}
+
+TEST_CASE(slots_carry_their_group_and_args_start_empty)
+{
+	std::vector<CullDrawGroup> groups;
+	std::vector<u32> slotObjects;
+	make_groups(1000, 3, groups, slotObjects);
+
+	std::vector<CullSlot> slots;
+	std::vector<DrawIndexedIndirectArgs> args;
+	build_cull_slots(groups.data(), (u32)groups.size(), slotObjects.data(), (u32)slotObjects.size(), slots, args);
+	CHECK_EQ((u32)slots.size(), 1000u);
+	CHECK_EQ((u32)args.size(), (u32)groups.size());
+	for (u32 g = 0; g < groups.size(); ++g)
+	{
+		const CullDrawGroup& group = groups[g];
+		for (u32 slot = group.firstSlot; slot < group.firstSlot + group.numObjects; ++slot)
+		{
+			CHECK_EQ(slots[slot].object, slotObjects[slot]);
+			CHECK_EQ(slots[slot].group, g);
+		}
+
+		// The shader only adds to the instance count, the rest is the group's mesh range.
+		CHECK_EQ(args[g].indexCountPerInstance, group.indexCount);
+		CHECK_EQ(args[g].instanceCount, 0u);
+		CHECK_EQ(args[g].startIndexLocation, group.firstIndex);
+		CHECK_EQ(args[g].baseVertexLocation, group.baseVertex);
+		CHECK_EQ(args[g].startInstanceLocation, 0u);
+	}
+}
+
+TEST_CASE(reference_keeps_what_any_view_sees_per_group)
+{
+	const u32 kCount = 3000;
+	SphereBoundsSoA bounds;
+	std::vector<v4> spheres;
+	make_bounds(kCount, 11, bounds, spheres);
+	std::vector<CullDrawGroup> groups;
+	std::vector<u32> slotObjects;
+	make_groups(kCount, 12, groups, slotObjects);
+
+	for (u32 kViews = 1; kViews <= kMaxViews; ++kViews)
+	{
+		m4x4 viewProj[kMaxViews];
+		for (u32 view = 0; view < kViews; ++view)
+		{
+			viewProj[view] = test_view_proj(view);
+		}
+		const CullConstants kConstants = make_cull_constants(viewProj, kViews);
+		CHECK_EQ(kConstants.viewCount, kViews);
+
+		// What the CPU culler sees, from any of the views.
+		std::vector<u8> seen(kCount, 0);
+		std::vector<u32> visible(kCount);
+		for (u32 view = 0; view < kViews; ++view)
+		{
+			const u32 kVisible = cull_spheres(CullKernel::kScalar, &kConstants.planes[view * kNumFrustumPlanes], bounds, visible.data());
+			for (u32 i = 0; i < kVisible; ++i)
+			{
+				seen[visible[i]] = 1;
+			}
+		}
+
+		// Untouched slots keep a marker, so writes past a group's count show up.
+		const u32 kUntouched = 0xffffffffu;
+		std::vector<u32> visibleOut(kCount, kUntouched);
+		std::vector<DrawIndexedIndirectArgs> args(groups.size());
+		cull_draw_groups_reference(kConstants, groups.data(), (u32)groups.size(), slotObjects.data(), spheres.data(), visibleOut.data(), args.data());
+
+		u32 total = 0;
+		for (u32 g = 0; g < groups.size(); ++g)
+		{
+			const CullDrawGroup& group = groups[g];
+			std::vector<u32> expected;
+			for (u32 i = 0; i < group.numObjects; ++i)
+			{
+				const u32 kObject = slotObjects[group.firstSlot + i];
+				if (seen[kObject])
+				{
+					expected.push_back(kObject);
+				}
+			}
+
+			// Every view draws every visible object once, in slot order at the front of the group.
+			CHECK_EQ(args[g].instanceCount, (u32)expected.size() * kViews);
+			CHECK_EQ(args[g].indexCountPerInstance, group.indexCount);
+			CHECK_EQ(args[g].startIndexLocation, group.firstIndex);
+			CHECK_EQ(args[g].baseVertexLocation, group.baseVertex);
+			CHECK_EQ(args[g].startInstanceLocation, 0u);
+			for (u32 i = 0; i < group.numObjects; ++i)
+			{
+				CHECK_EQ(visibleOut[group.firstSlot + i], i < expected.size() ? expected[i] : kUntouched);
+			}
+			total += (u32)expected.size();
+		}
+
+		// A scene that tells nothing apart proves nothing.
+		CHECK(total > kCount / 20);
+		CHECK(total < kCount);
+	}
+}
+
+TEST_CASE(outputs_match_in_any_order_within_a_group)
+{
+	const u32 kCount = 2000;
+	SphereBoundsSoA bounds;
+	std::vector<v4> spheres;
+	make_bounds(kCount, 21, bounds, spheres);
+	std::vector<CullDrawGroup> groups;
+	std::vector<u32> slotObjects;
+	make_groups(kCount, 22, groups, slotObjects);
+	const u32 kNumGroups = (u32)groups.size();
+
+	m4x4 viewProj[2] = { test_view_proj(0), test_view_proj(1) };
+	const CullConstants kConstants = make_cull_constants(viewProj, 2);
+	std::vector<u32> reference(kCount, 0);
+	std::vector<DrawIndexedIndirectArgs> referenceArgs(kNumGroups);
+	cull_draw_groups_reference(kConstants, groups.data(), kNumGroups, slotObjects.data(), spheres.data(), reference.data(), referenceArgs.data());
+
+	// Thread groups reach a draw group's count in any order, so the GPU's output is a shuffle within each group.
+	Random random(23);
+	std::vector<u32> shuffled = reference;
+	u32 busiest = 0;
+	for (u32 g = 0; g < kNumGroups; ++g)
+	{
+		u32* pFront = &shuffled[groups[g].firstSlot];
+		const u32 kVisible = referenceArgs[g].instanceCount / 2;
+		for (u32 i = kVisible; i > 1; --i)
+		{
+			std::swap(pFront[i - 1], pFront[random.below(i)]);
+		}
+		busiest = referenceArgs[g].instanceCount > referenceArgs[busiest].instanceCount ? g : busiest;
+	}
+	CHECK(referenceArgs[busiest].instanceCount >= 4);
+	CHECK(cull_outputs_match(groups.data(), kNumGroups, 2, reference.data(), referenceArgs.data(), shuffled.data(), referenceArgs.data()));
+
+	// Past the count is leftover from earlier frames and doesn't count.
+	std::vector<u32> stale = shuffled;
+	for (u32 g = 0; g < kNumGroups; ++g)
+	{
+		for (u32 i = referenceArgs[g].instanceCount / 2; i < groups[g].numObjects; ++i)
+		{
+			stale[groups[g].firstSlot + i] = 0xdeadu;
+		}
+	}
+	CHECK(cull_outputs_match(groups.data(), kNumGroups, 2, reference.data(), referenceArgs.data(), stale.data(), referenceArgs.data()));
+
+	// A different object, a different count or a different mesh range is a mismatch.
+	std::vector<u32> wrongObject = shuffled;
+	wrongObject[groups[busiest].firstSlot] = kCount + 1;
+	CHECK(!cull_outputs_match(groups.data(), kNumGroups, 2, reference.data(), referenceArgs.data(), wrongObject.data(), referenceArgs.data()));
+
+	std::vector<DrawIndexedIndirectArgs> wrongArgs = referenceArgs;
+	wrongArgs[busiest].instanceCount -= 2;
+	CHECK(!cull_outputs_match(groups.data(), kNumGroups, 2, reference.data(), referenceArgs.data(), shuffled.data(), wrongArgs.data()));
+
+	wrongArgs = referenceArgs;
+	wrongArgs[busiest].baseVertexLocation++;
+	CHECK(!cull_outputs_match(groups.data(), kNumGroups, 2, reference.data(), referenceArgs.data(), shuffled.data(), wrongArgs.data()));
+}
@@ -0,0 +1,215 @@
+#include "TestHarness.h"
+#include "Culling.h"
+
+namespace
+{
+	m4x4 test_view_proj()
+	{
+		const m4x4 kView = m4x4::CreateTranslation(-1.f, -2.f, 3.f);
+		return kView * m4x4::CreatePerspectiveOffCenter(-0.5f, 0.6f, -0.4f, 0.45f, 0.5f, 100.f);
+	}
+
+	// Volumes scattered around the frustum, a lot of them straddling its planes.
+	void make_bounds(const u32 kCount, const u64 kSeed, SphereBoundsSoA& rSpheres, AabbBoundsSoA& rAabbs)
+	{
+		Random random(kSeed);
+		rSpheres.clear();
+		rAabbs.clear();
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			const v3 kCenter(random.range(-60.f, 60.f), random.range(-60.f, 60.f), random.range(-20.f, 120.f));
+			rSpheres.add(kCenter, random.range(0.f, 5.f));
+			rAabbs.add(kCenter, v3(random.range(0.f, 4.f), random.range(0.f, 4.f), random.range(0.f, 4.f)));
+		}
+	}
+
+	// Signed distance of the volume's nearest point in front of each plane, in double precision.
+	// Positive for every plane means visible, negative for one means culled.
+	f64 sphere_margin(const v4* pPlanes, const SphereBoundsSoA& bounds, const u32 i)
+	{
+		f64 margin = 1e30;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			const f64 kDistance = (f64)plane.x * bounds.centerX[i] + (f64)plane.y * bounds.centerY[i] + (f64)plane.z * bounds.centerZ[i] + plane.w;
+			margin = std::min(margin, kDistance + bounds.radius[i]);
+		}
+		return margin;
+	}
+
+	f64 aabb_margin(const v4* pPlanes, const AabbBoundsSoA& bounds, const u32 i)
+	{
+		f64 margin = 1e30;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			const v4& plane = pPlanes[p];
+			const f64 kDistance = (f64)plane.x * bounds.centerX[i] + (f64)plane.y * bounds.centerY[i] + (f64)plane.z * bounds.centerZ[i] + plane.w;
+			const f64 kRadius = std::fabs((f64)plane.x) * bounds.extentX[i] + std::fabs((f64)plane.y) * bounds.extentY[i] + std::fabs((f64)plane.z) * bounds.extentZ[i];
+			margin = std::min(margin, kDistance + kRadius);
+		}
+		return margin;
+	}
+
+	template <typename Bounds, typename Margin>
+	void check_against_reference(const v4* pPlanes, const Bounds& bounds, const u32* pVisible, const u32 kVisible, Margin margin)
+	{
+		std::vector<u8> visible(bounds.size(), 0);
+		for (u32 i = 0; i < kVisible; ++i)
+		{
+			visible[pVisible[i]] = 1;
+		}
+
+		u32 wrong = 0;
+		for (u32 i = 0; i < bounds.size(); ++i)
+		{
+			// Too close to a plane for float rounding to be sure either way.
+			const f64 kMargin = margin(pPlanes, bounds, i);
+			if (std::fabs(kMargin) > 1e-3)
+			{
+				wrong += (visible[i] != 0) != (kMargin > 0.0) ? 1 : 0;
+			}
+		}
+		CHECK_EQ(wrong, 0u);
+	}
+
+	bool ascending(const u32* pIndices, const u32 kCount)
+	{
+		for (u32 i = 1; i < kCount; ++i)
+		{
+			if (pIndices[i - 1] >= pIndices[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST_CASE(frustum_planes_point_inwards_and_are_normalised)
+{
+	v4 planes[kNumFrustumPlanes];
+	extract_frustum_planes(m4x4::CreatePerspectiveOffCenter(-1.f, 1.f, -1.f, 1.f, 1.f, 10.f), planes);
+	for (const v4& plane : planes)
+	{
+		CHECK_NEAR(v3(plane.x, plane.y, plane.z).Length(), 1.f, 1e-6f);
+	}
+
+	// Left handed, looking down +Z from the origin.
+	const v4 kInside(0.f, 0.f, 5.f, 1.f);
+	for (const v4& plane : planes)
+	{
+		CHECK(plane.Dot(kInside) > 0.f);
+	}
+	CHECK_NEAR(planes[4].Dot(v4(0.f, 0.f, 3.f, 1.f)), 2.f, 1e-5f);  // 2 beyond near
+	CHECK_NEAR(planes[5].Dot(v4(0.f, 0.f, 3.f, 1.f)), 7.f, 1e-4f);  // 7 before far
+	CHECK_NEAR(planes[0].Dot(v4(-2.f, 0.f, 2.f, 1.f)), 0.f, 1e-5f); // on the left plane
+}
+
+TEST_CASE(simd_kernels_match_scalar_exactly)
+{
+	v4 planes[kNumFrustumPlanes];
+	extract_frustum_planes(test_view_proj(), planes);
+
+	// Every tail length of the 4 and 8 wide kernels, then a large set.
+	for (const u32 kCount : { 0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 16u, 17u, 31u, 33u, 10000u })
+	{
+		SphereBoundsSoA spheres;
+		AabbBoundsSoA aabbs;
+		make_bounds(kCount, kCount + 1, spheres, aabbs);
+
+		std::vector<u32> scalarSpheres(kCount), scalarAabbs(kCount);
+		const u32 kSphereCount = cull_spheres(CullKernel::kScalar, planes, spheres, scalarSpheres.data());
+		const u32 kAabbCount = cull_aabbs(CullKernel::kScalar, planes, aabbs, scalarAabbs.data());
+
+		for_each_kernel(best_cull_kernel(), [&](const CullKernel kernel)
+		{
+			std::vector<u32> visible(kCount);
+			const u32 kSpheres = cull_spheres(kernel, planes, spheres, visible.data());
+			CHECK_EQ(kSpheres, kSphereCount);
+			CHECK(std::equal(visible.begin(), visible.begin() + kSpheres, scalarSpheres.begin()));
+
+			const u32 kAabbs = cull_aabbs(kernel, planes, aabbs, visible.data());
+			CHECK_EQ(kAabbs, kAabbCount);
+			CHECK(std::equal(visible.begin(), visible.begin() + kAabbs, scalarAabbs.begin()));
+		});
+	}
+}
+
+TEST_CASE(kernels_match_double_precision_reference)
+{
+	v4 planes[kNumFrustumPlanes];
+	extract_frustum_planes(test_view_proj(), planes);
+
+	SphereBoundsSoA spheres;
+	AabbBoundsSoA aabbs;
+	make_bounds(20000, 7, spheres, aabbs);
+
+	for_each_kernel(best_cull_kernel(), [&](const CullKernel kernel)
+	{
+		std::vector<u32> visible(spheres.size());
+		const u32 kSpheres = cull_spheres(kernel, planes, spheres, visible.data());
+		CHECK(kSpheres > 0 && kSpheres < spheres.size());
+		CHECK(ascending(visible.data(), kSpheres));
+		check_against_reference(planes, spheres, visible.data(), kSpheres, sphere_margin);
+
+		const u32 kAabbs = cull_aabbs(kernel, planes, aabbs, visible.data());
+		CHECK(kAabbs > 0 && kAabbs < aabbs.size());
+		CHECK(ascending(visible.data(), kAabbs));
+		check_against_reference(planes, aabbs, visible.data(), kAabbs, aabb_margin);
+	});
+}
+
+TEST_CASE(touching_a_plane_counts_as_visible)
+{
+	v4 planes[kNumFrustumPlanes];
+	extract_frustum_planes(m4x4::CreatePerspectiveOffCenter(-1.f, 1.f, -1.f, 1.f, 1.f, 10.f), planes);
+
+	// Volumes just reaching the near plane from behind it, which normalises exactly.
+	SphereBoundsSoA spheres;
+	AabbBoundsSoA aabbs;
+	for (u32 i = 0; i < 9; ++i)
+	{
+		spheres.add(v3(0.f, 0.f, 0.5f), 0.5f);
+		aabbs.add(v3(0.f, 0.f, 0.5f), v3(0.25f, 0.25f, 0.5f));
+	}
+	spheres.add(v3(0.f, 0.f, 0.25f), 0.5f);
+	aabbs.add(v3(0.f, 0.f, 0.25f), v3(0.25f, 0.25f, 0.5f));
+
+	for_each_kernel(best_cull_kernel(), [&](const CullKernel kernel)
+	{
+		u32 visible[10];
+		CHECK_EQ(cull_spheres(kernel, planes, spheres, visible), 9u);
+		CHECK_EQ(cull_aabbs(kernel, planes, aabbs, visible), 9u);
+	});
+}
+
+TEST_CASE(merge_visible_is_the_sorted_union)
+{
+	Random random(11);
+	for (u32 trial = 0; trial < 200; ++trial)
+	{
+		// Lists of 0 to 63 ascending indices, overlapping often.
+		std::vector<u32> a, b;
+		const u32 kRange = 1 + random.below(100);
+		for (u32 i = 0; i < kRange; ++i)
+		{
+			if (random.below(3) == 0) a.push_back(i);
+			if (random.below(3) == 0) b.push_back(i);
+		}
+
+		std::vector<u32> merged(a.size() + b.size());
+		const u32 kCount = merge_visible(a.data(), (u32)a.size(), b.data(), (u32)b.size(), merged.data());
+
+		std::vector<u32> expected;
+		std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+		CHECK_EQ(kCount, (u32)expected.size());
+		CHECK(std::equal(expected.begin(), expected.end(), merged.begin()));
+	}
+
+	u32 out[1];
+	const u32 kOne = 5;
+	CHECK_EQ(merge_visible(nullptr, 0, nullptr, 0, out), 0u);
+	CHECK_EQ(merge_visible(&kOne, 1, nullptr, 0, out), 1u);
+	CHECK_EQ(merge_visible(&kOne, 1, &kOne, 1, out), 1u);
+	CHECK_EQ(out[0], 5u);
+}
@@ -0,0 +1,231 @@
+#include "TestHarness.h"
+#include "FrameArena.h"
+#include <thread>
+
+namespace
+{
+	const size_t kBlockSize = 4096;
+
+	bool in_range(const void* p, const void* pFirst, const size_t kSize)
+	{
+		return (const u8*)p >= (const u8*)pFirst && (const u8*)p < (const u8*)pFirst + kSize;
+	}
+}
+
+TEST_CASE(allocations_bump_through_one_block)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 8);
+	arena.begin_frame();
+
+	u8* pFirst = (u8*)arena.allocate(100, 16);
+	u8* pSecond = (u8*)arena.allocate(8, 64);
+	CHECK((uintptr_t)pFirst % 16 == 0);
+	CHECK((uintptr_t)pSecond % 64 == 0);
+	CHECK(pSecond >= pFirst + 100 && pSecond < pFirst + kBlockSize);
+	CHECK_EQ(arena.stats().blocks, 1u);
+	CHECK_EQ(arena.stats().heapAllocs, 0u);
+}
+
+TEST_CASE(blocks_are_reused_two_frames_later)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 8);
+
+	arena.begin_frame();
+	void* pFrameA = arena.allocate(512);
+	arena.begin_frame();
+	void* pFrameB = arena.allocate(512);
+	arena.begin_frame();
+	void* pFrameC = arena.allocate(512);
+
+	// Frame C reclaims frame A's block and starts at its beginning again.
+	CHECK(pFrameA != pFrameB);
+	CHECK(pFrameC == pFrameA);
+	CHECK_EQ(arena.stats().blocks, 1u);
+	CHECK_EQ(arena.high_water_blocks(), 1u);
+	CHECK_EQ(arena.frame_number(), 3ull);
+}
+
+TEST_CASE(memory_survives_the_next_frame)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 64);
+	arena.begin_frame();
+
+	// Fill frame N, then allocate everything frame N + 1 can take.
+	u32* pValues = arena.allocate_array<u32>(200);
+	for (u32 i = 0; i < 200; ++i)
+	{
+		pValues[i] = i * 7;
+	}
+
+	arena.begin_frame();
+	for (u32 i = 0; i < 100; ++i)
+	{
+		memset(arena.allocate(900), 0xCD, 900);
+	}
+
+	bool intact = true;
+	for (u32 i = 0; i < 200; ++i)
+	{
+		intact = intact && pValues[i] == i * 7;
+	}
+	CHECK(intact);
+}
+
+TEST_CASE(cursor_goes_stale_with_the_frame_and_the_arena)
+{
+	FrameArena first;
+	FrameArena second;
+	first.init(kBlockSize, 8);
+	second.init(kBlockSize, 8);
+	first.begin_frame();
+	second.begin_frame();
+
+	// The thread's cursor belongs to one arena at a time, switching takes a new block.
+	void* pFirst = first.allocate(64);
+	void* pSecond = second.allocate(64);
+	void* pFirstAgain = first.allocate(64);
+	CHECK(!in_range(pSecond, pFirst, kBlockSize));
+	CHECK(!in_range(pFirstAgain, pSecond, kBlockSize));
+	CHECK_EQ(first.stats().blocks, 2u);
+	CHECK_EQ(second.stats().blocks, 1u);
+
+	// A new frame invalidates the cursor even with room left in the block.
+	first.begin_frame();
+	first.allocate(64);
+	CHECK_EQ(first.stats().blocks, 1u);
+}
+
+TEST_CASE(each_thread_bumps_through_its_own_block)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 64);
+	arena.begin_frame();
+
+	const u32 kThreads = 4;
+	const u32 kAllocations = 200;
+	std::vector<std::vector<u8*>> pointers(kThreads);
+	std::vector<std::thread> threads;
+	for (u32 t = 0; t < kThreads; ++t)
+	{
+		threads.emplace_back([&arena, &pointers, t]()
+		{
+			for (u32 i = 0; i < kAllocations; ++i)
+			{
+				u8* p = (u8*)arena.allocate(32);
+				memset(p, (int)t, 32);
+				pointers[t].push_back(p);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Nobody overwrote anybody else.
+	bool intact = true;
+	for (u32 t = 0; t < kThreads; ++t)
+	{
+		for (const u8* p : pointers[t])
+		{
+			intact = intact && p[0] == t && p[31] == t;
+		}
+	}
+	CHECK(intact);
+
+	// 200 * 32 bytes is two blocks per thread.
+	CHECK_EQ(arena.stats().blocks, kThreads * 2);
+}
+
+TEST_CASE(oversized_allocations_reuse_their_memory)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 8);
+
+	// A per object list larger than a block, every frame.
+	void* pLists[6];
+	for (u32 frame = 0; frame < 6; ++frame)
+	{
+		arena.begin_frame();
+		pLists[frame] = arena.allocate(100000);
+		memset(pLists[frame], 0xAB, 100000);
+		CHECK_EQ(arena.stats().oversized, 1u);
+		CHECK_EQ(arena.stats().blocks, 0u);
+		CHECK_EQ(arena.stats().heapAllocs, frame < 2 ? 1u : 0u); // one per frame slot, then none
+	}
+	CHECK(pLists[2] == pLists[0] && pLists[4] == pLists[0]);
+	CHECK(pLists[3] == pLists[1] && pLists[5] == pLists[1]);
+
+	// Smaller requests fit the memory already held, a larger one needs more.
+	arena.begin_frame();
+	CHECK(arena.allocate(50000) == pLists[0]);
+	CHECK(arena.allocate(200000) != pLists[0]);
+	CHECK_EQ(arena.stats().heapAllocs, 1u);
+}
+
+TEST_CASE(unused_large_allocations_are_released)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 8);
+
+	// A spike of big allocations in one frame, then quiet frames.
+	arena.begin_frame();
+	for (u32 i = 0; i < 4; ++i)
+	{
+		arena.allocate(100000);
+	}
+	CHECK(arena.stats().bytes >= 400000);
+
+	// Its slot comes round with nothing asked of it and lets them go, so the next spike mallocs again.
+	arena.begin_frame();
+	arena.begin_frame();
+	arena.begin_frame();
+	arena.begin_frame();
+	arena.allocate(100000);
+	CHECK_EQ(arena.stats().heapAllocs, 1u);
+}
+
+TEST_CASE(over_budget_allocations_fall_back_to_the_heap)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 2);
+	arena.begin_frame();
+
+	// Blocks hold 4096, allocations of 1000 take 4 per block, so 2 blocks hold 8.
+	for (u32 i = 0; i < 12; ++i)
+	{
+		memset(arena.allocate(1000, 8), 0xEE, 1000);
+	}
+	const FrameArenaStats& stats = arena.stats();
+	CHECK_EQ(stats.blocks, 2u);
+	CHECK_EQ(stats.fallbacks, 4u);
+	CHECK_EQ(stats.heapAllocs, 4u);
+	CHECK_EQ(stats.oversized, 0u);
+	CHECK_EQ(stats.bytes, 2 * kBlockSize + 4 * (1000 + 8));
+	CHECK_EQ(arena.high_water(), stats.bytes);
+
+	// Fallbacks are freed with their frame and don't change the next frame's accounting.
+	arena.begin_frame();
+	arena.begin_frame();
+	CHECK_EQ(arena.stats().fallbacks, 0u);
+	CHECK_EQ(arena.stats().bytes, 0u);
+}
+
+TEST_CASE(frame_vector_allocates_from_the_arena)
+{
+	FrameArena arena;
+	arena.init(kBlockSize, 8);
+	arena.begin_frame();
+
+	FrameVector<u32> values{ FrameAllocator<u32>(arena) };
+	for (u32 i = 0; i < 100; ++i)
+	{
+		values.push_back(i);
+	}
+	CHECK_EQ(values[99], 99u);
+	CHECK(arena.stats().blocks > 0);
+	CHECK_EQ(arena.stats().heapAllocs, 0u);
+}
@@ -0,0 +1,173 @@
+#include "TestHarness.h"
+#include "FrameLifecycle.h"
+
+namespace
+{
+	const f64 kRefreshRate = 90.0;
+	const f64 kInterval = 1.0 / kRefreshRate;
+
+	// A simulated headset whose session can be lost, which SimulatedHmd never is.
+	class LosableHmd final : public HmdInterface
+	{
+	public:
+		SimulatedHmd hmd = SimulatedHmd(kRefreshRate);
+		bool lost = false;
+
+		HmdFrameStatus wait_to_begin_frame(const s64 kFrameIndex) override { return lost ? HmdFrameStatus::kFailed : hmd.wait_to_begin_frame(kFrameIndex); }
+		bool begin_frame(const s64 kFrameIndex) override { return hmd.begin_frame(kFrameIndex); }
+		f64 predicted_display_time(const s64 kFrameIndex) override { return hmd.predicted_display_time(kFrameIndex); }
+		bool end_frame(const s64 kFrameIndex, const ovrLayerHeader_* const* ppLayers, const u32 kNumLayers) override { return hmd.end_frame(kFrameIndex, ppLayers, kNumLayers); }
+		f64 time_seconds() override { return hmd.time_seconds(); }
+		f64 refresh_interval() override { return hmd.refresh_interval(); }
+	};
+
+	// Renders a frame taking kCpuRefreshes of a refresh between begin and submit.
+	void render_frame(FrameLifecycle& rLifecycle, SimulatedHmd& rHmd, const f64 kCpuRefreshes)
+	{
+		CHECK(rLifecycle.begin_frame() == HmdFrameStatus::kRender);
+		CHECK(rLifecycle.in_frame());
+		rHmd.advance(kCpuRefreshes * kInterval);
+		CHECK(rLifecycle.end_frame(nullptr, 0));
+		CHECK(!rLifecycle.in_frame());
+	}
+}
+
+TEST_CASE(indices_start_at_one_and_go_up_by_one)
+{
+	SimulatedHmd hmd(kRefreshRate);
+	FrameLifecycle lifecycle;
+	lifecycle.init(&hmd);
+	CHECK_EQ(lifecycle.frame_index(), (s64)0);
+	CHECK_EQ(lifecycle.history_size(), 0u);
+
+	for (s64 frame = 1; frame <= 200; ++frame)
+	{
+		CHECK(lifecycle.begin_frame() == HmdFrameStatus::kRender);
+		CHECK_EQ(lifecycle.frame_index(), frame);
+		hmd.advance(0.5 * kInterval);
+		lifecycle.end_frame(nullptr, 0);
+	}
+
+	// The history keeps the last kHistorySize, newest first.
+	CHECK_EQ(lifecycle.history_size(), FrameLifecycle::kHistorySize);
+	for (u32 i = 0; i < lifecycle.history_size(); ++i)
+	{
+		CHECK_EQ(lifecycle.record(i).frameIndex, (s64)(200 - i));
+	}
+}
+
+TEST_CASE(a_skip_waits_again_for_the_same_index)
+{
+	SimulatedHmd hmd(kRefreshRate);
+	FrameLifecycle lifecycle;
+	lifecycle.init(&hmd);
+	render_frame(lifecycle, hmd, 0.5);
+	render_frame(lifecycle, hmd, 0.5);
+
+	// Taken off, the compositor turns down frame 3 three times, nothing is begun.
+	hmd.set_visible(false);
+	for (u32 i = 0; i < 3; ++i)
+	{
+		CHECK(lifecycle.begin_frame() == HmdFrameStatus::kSkip);
+		CHECK(!lifecycle.in_frame());
+		CHECK_EQ(lifecycle.frame_index(), (s64)2);
+	}
+	CHECK_EQ(lifecycle.stats().skipped, 3u);
+	CHECK_EQ(lifecycle.history_size(), 2u);
+
+	// Put back on, frame 3 is the next rendered.
+	hmd.set_visible(true);
+	CHECK(lifecycle.begin_frame() == HmdFrameStatus::kRender);
+	CHECK_EQ(lifecycle.frame_index(), (s64)3);
+	lifecycle.end_frame(nullptr, 0);
+	CHECK_EQ(lifecycle.stats().skipped, 3u);
+}
+
+TEST_CASE(a_lost_session_is_not_a_skip)
+{
+	LosableHmd losable;
+	FrameLifecycle lifecycle;
+	lifecycle.init(&losable);
+	render_frame(lifecycle, losable.hmd, 0.5);
+
+	losable.lost = true;
+	CHECK(lifecycle.begin_frame() == HmdFrameStatus::kFailed);
+	CHECK(!lifecycle.in_frame());
+	CHECK_EQ(lifecycle.frame_index(), (s64)1);
+	CHECK_EQ(lifecycle.stats().skipped, 0u);
+
+	losable.lost = false;
+	losable.hmd.set_visible(false);
+	CHECK(lifecycle.begin_frame() == HmdFrameStatus::kSkip);
+	CHECK_EQ(lifecycle.stats().skipped, 1u);
+}
+
+TEST_CASE(waits_and_leads_follow_the_vsyncs)
+{
+	SimulatedHmd hmd(kRefreshRate);
+	FrameLifecycle lifecycle;
+	lifecycle.init(&hmd);
+
+	// The first frame begins on a vsync with nothing queued, and is predicted to be seen two refreshes on.
+	render_frame(lifecycle, hmd, 0.25);
+	CHECK_NEAR(lifecycle.record(0).beginTime - lifecycle.record(0).waitStart, 0.0, 1e-9);
+	CHECK_NEAR(lifecycle.record(0).predictedDisplayTime - lifecycle.record(0).beginTime, 2.0 * kInterval, 1e-9);
+
+	// After that each waits out the rest of the refresh for the compositor to take the last one,
+	// begins on the vsync and has the same two refreshes of lead.
+	for (u32 i = 0; i < 9; ++i)
+	{
+		render_frame(lifecycle, hmd, 0.25);
+		const FrameRecord& frame = lifecycle.record(0);
+		CHECK_NEAR(frame.beginTime - frame.waitStart, 0.75 * kInterval, 1e-9);
+		CHECK_NEAR(frame.predictedDisplayTime - frame.beginTime, 2.0 * kInterval, 1e-9);
+		CHECK_NEAR(frame.submitTime - frame.beginTime, 0.25 * kInterval, 1e-9);
+		CHECK_NEAR(frame.predictedDisplayTime - lifecycle.record(1).predictedDisplayTime, kInterval, 1e-9);
+	}
+
+	const FrameLifecycleStats kStats = lifecycle.stats();
+	CHECK_EQ(kStats.frames, 10u);
+	CHECK_EQ(kStats.missed, 0u);
+	CHECK_EQ(hmd.missed(), 0u);
+	CHECK_NEAR(kStats.averageWaitMs, 0.75 * kInterval * 1000.0 * 9.0 / 10.0, 1e-4);
+	CHECK_NEAR(kStats.averageCpuMs, 0.25 * kInterval * 1000.0, 1e-4);
+	CHECK_NEAR(kStats.maxCpuMs, 0.25 * kInterval * 1000.0, 1e-4);
+	CHECK_NEAR(kStats.averageLeadMs, 2.0 * kInterval * 1000.0, 1e-4);
+}
+
+TEST_CASE(a_slow_frame_is_missed)
+{
+	SimulatedHmd hmd(kRefreshRate);
+	FrameLifecycle lifecycle;
+	lifecycle.init(&hmd);
+	for (u32 i = 0; i < 5; ++i)
+	{
+		render_frame(lifecycle, hmd, 0.5);
+	}
+	CHECK_EQ(lifecycle.stats().missed, 0u);
+
+	// Past the vsync it was predicted for, the frame is seen a refresh late, and the
+	// next one is predicted two refreshes after it rather than one.
+	render_frame(lifecycle, hmd, 1.5);
+	CHECK_EQ(hmd.missed(), 1u);
+	CHECK_EQ(lifecycle.stats().missed, 0u);
+	render_frame(lifecycle, hmd, 0.5);
+	CHECK_NEAR(lifecycle.record(0).predictedDisplayTime - lifecycle.record(1).predictedDisplayTime, 2.0 * kInterval, 1e-9);
+	CHECK_EQ(lifecycle.stats().missed, 1u);
+	CHECK_NEAR(lifecycle.stats().maxCpuMs, 1.5 * kInterval * 1000.0, 1e-4);
+
+	// Back on time, nothing more is missed.
+	for (u32 i = 0; i < 5; ++i)
+	{
+		render_frame(lifecycle, hmd, 0.5);
+	}
+	CHECK_EQ(lifecycle.stats().missed, 1u);
+	CHECK_EQ(hmd.missed(), 1u);
+
+	// Once the slow frame has left the history it no longer counts.
+	for (u32 i = 0; i < FrameLifecycle::kHistorySize; ++i)
+	{
+		render_frame(lifecycle, hmd, 0.5);
+	}
+	CHECK_EQ(lifecycle.stats().missed, 0u);
+}
@@ -0,0 +1,213 @@
+#include "TestHarness.h"
+#include "GpuProfiler.h"
+
+namespace
+{
+	// 1 MHz, a thousand ticks to the millisecond.
+	const u64 kTicksPerMs = 1000;
+
+	// A frame of 3.5 ms on the GPU: A for 2 ms, then B for 1.5 ms with C nested in its first 0.5 ms.
+	void run_frame(GpuProfiler& rProfiler, FakeGpuTimer& rGpu)
+	{
+		rGpu.next_frame();
+		rProfiler.begin_frame();
+		{
+			GpuProfileScope a(&rProfiler, "A");
+			rGpu.advance(2 * kTicksPerMs);
+		}
+		{
+			GpuProfileScope b(&rProfiler, "B");
+			{
+				GpuProfileScope c(&rProfiler, "C");
+				rGpu.advance(kTicksPerMs / 2);
+			}
+			rGpu.advance(kTicksPerMs);
+		}
+		rProfiler.end_frame();
+
+		// Idle between frames, outside every scope.
+		rGpu.advance(kTicksPerMs / 4);
+	}
+
+	void check_frame_scopes(const GpuFrameTimings& frame)
+	{
+		CHECK_NEAR(frame.frameMs, 3.5f, 1e-4f);
+		CHECK_EQ(frame.scopes.size(), 4u);
+		if (frame.scopes.size() != 4)
+		{
+			return;
+		}
+		const char* kNames[] = { "GPU frame", "A", "B", "C" };
+		const u32 kDepths[] = { 0, 1, 1, 2 };
+		const f32 kStarts[] = { 0.f, 0.f, 2.f, 2.f };
+		const f32 kDurations[] = { 3.5f, 2.f, 1.5f, 0.5f };
+		for (u32 i = 0; i < 4; ++i)
+		{
+			CHECK(strcmp(frame.scopes[i].name, kNames[i]) == 0);
+			CHECK_EQ(frame.scopes[i].depth, kDepths[i]);
+			CHECK_NEAR(frame.scopes[i].startMs, kStarts[i], 1e-4f);
+			CHECK_NEAR(frame.scopes[i].durationMs, kDurations[i], 1e-4f);
+		}
+	}
+}
+
+TEST_CASE(frames_resolve_after_the_gpu_latency)
+{
+	FakeGpuTimer gpu(4, 16, 2);
+	GpuProfiler profiler;
+	profiler.init(&gpu);
+
+	// Frame 1 is ready two frames after it ended, so frame 3's begin reads it.
+	run_frame(profiler, gpu);
+	CHECK_EQ(profiler.last_frame().frameNumber, 0u);
+	run_frame(profiler, gpu);
+	CHECK_EQ(profiler.last_frame().frameNumber, 0u);
+	run_frame(profiler, gpu);
+	CHECK_EQ(profiler.last_frame().frameNumber, 1u);
+	CHECK_EQ(profiler.last_frame().latency, 2u);
+	check_frame_scopes(profiler.last_frame());
+
+	// From then on one frame resolves per frame.
+	for (u32 i = 0; i < 20; ++i)
+	{
+		run_frame(profiler, gpu);
+		CHECK_EQ(profiler.last_frame().frameNumber, profiler.stats().frames - 2);
+	}
+	check_frame_scopes(profiler.last_frame());
+	CHECK_EQ(profiler.stats().frames, 23u);
+	CHECK_EQ(profiler.stats().resolved, 21u);
+	CHECK_EQ(profiler.stats().skipped, 0u);
+	CHECK_EQ(profiler.stats().maxLatency, 2u);
+}
+
+TEST_CASE(enough_slots_for_the_latency_never_skip)
+{
+	// A slot comes round again as many frames later as there are slots, its results are read first.
+	for (const u32 kLatency : { 1u, 2u, 3u, 5u })
+	{
+		FakeGpuTimer gpu(kLatency, 16, kLatency);
+		GpuProfiler profiler;
+		profiler.init(&gpu);
+		for (u32 i = 0; i < 30; ++i)
+		{
+			run_frame(profiler, gpu);
+		}
+		CHECK_EQ(profiler.stats().skipped, 0u);
+		CHECK_EQ(profiler.stats().resolved, 30u - kLatency);
+		CHECK_EQ(profiler.stats().maxLatency, kLatency);
+	}
+}
+
+TEST_CASE(slots_still_in_flight_are_skipped_not_waited_for)
+{
+	// Two slots and a GPU three frames behind, every other frame finds its slot busy.
+	FakeGpuTimer gpu(2, 16, 3);
+	GpuProfiler profiler;
+	profiler.init(&gpu);
+	for (u32 i = 0; i < 30; ++i)
+	{
+		run_frame(profiler, gpu);
+	}
+
+	const GpuProfilerStats kStats = profiler.stats();
+	CHECK(kStats.skipped > 0);
+	CHECK(kStats.resolved > 0);
+
+	// Every timed frame resolves or is still in flight, skipped frames are never read back.
+	CHECK(kStats.resolved + kStats.skipped <= kStats.frames);
+	CHECK(kStats.frames - kStats.skipped - kStats.resolved <= 2u);
+	check_frame_scopes(profiler.last_frame());
+
+	// A skipped frame hands out no scopes, a timed one does.
+	gpu.next_frame();
+	profiler.begin_frame();
+	const bool kTimed = profiler.stats().skipped == kStats.skipped;
+	const u32 kScope = profiler.begin_scope("D");
+	CHECK((kScope != GpuProfiler::kInvalidScope) == kTimed);
+	profiler.end_scope(kScope);
+	profiler.end_frame();
+}
+
+TEST_CASE(disjoint_frames_are_thrown_away)
+{
+	FakeGpuTimer gpu(4, 16, 1);
+	GpuProfiler profiler;
+	profiler.init(&gpu);
+
+	run_frame(profiler, gpu);
+	gpu.make_next_disjoint();
+	run_frame(profiler, gpu); // resolves frame 1, frame 2 ends disjoint
+	CHECK_EQ(profiler.last_frame().frameNumber, 1u);
+
+	run_frame(profiler, gpu); // reads frame 2 and drops it
+	CHECK_EQ(profiler.stats().disjoint, 1u);
+	CHECK_EQ(profiler.last_frame().frameNumber, 1u);
+	check_frame_scopes(profiler.last_frame());
+
+	run_frame(profiler, gpu); // frame 3 is fine again
+	CHECK_EQ(profiler.last_frame().frameNumber, 3u);
+	CHECK_EQ(profiler.stats().resolved, 2u);
+	CHECK_EQ(profiler.stats().disjoint, 1u);
+}
+
+TEST_CASE(latency_is_reported_as_the_gpu_falls_behind)
+{
+	FakeGpuTimer gpu(8, 16, 1);
+	GpuProfiler profiler;
+	profiler.init(&gpu);
+	for (u32 i = 0; i < 5; ++i)
+	{
+		run_frame(profiler, gpu);
+	}
+	CHECK_EQ(profiler.last_frame().latency, 1u);
+
+	// The GPU drops further behind, nothing resolves until it catches up to the new lag.
+	gpu.set_latency(4);
+	const u64 kLastResolved = profiler.last_frame().frameNumber;
+	for (u32 i = 0; i < 3; ++i)
+	{
+		run_frame(profiler, gpu);
+	}
+	CHECK(profiler.last_frame().frameNumber <= kLastResolved + 1);
+	for (u32 i = 0; i < 10; ++i)
+	{
+		run_frame(profiler, gpu);
+	}
+	CHECK_EQ(profiler.last_frame().latency, 4u);
+	CHECK_EQ(profiler.stats().maxLatency, 4u);
+	CHECK_EQ(profiler.stats().skipped, 0u);
+}
+
+TEST_CASE(scopes_past_the_slot_queries_are_dropped)
+{
+	// Six queries: the frame and two scopes.
+	FakeGpuTimer gpu(2, 6, 1);
+	GpuProfiler profiler;
+	profiler.init(&gpu);
+
+	CHECK_EQ(profiler.begin_scope("outside"), GpuProfiler::kInvalidScope);
+
+	gpu.next_frame();
+	profiler.begin_frame();
+	const u32 kFirst = profiler.begin_scope("first");
+	gpu.advance(kTicksPerMs);
+	profiler.end_scope(kFirst);
+	const u32 kSecond = profiler.begin_scope("second");
+	const u32 kThird = profiler.begin_scope("third");
+	gpu.advance(kTicksPerMs);
+	profiler.end_scope(kThird);
+	profiler.end_scope(kSecond);
+	profiler.end_frame();
+	CHECK(kFirst != GpuProfiler::kInvalidScope);
+	CHECK(kSecond != GpuProfiler::kInvalidScope);
+	CHECK_EQ(kThird, GpuProfiler::kInvalidScope);
+	CHECK_EQ(profiler.stats().droppedScopes, 1u);
+
+	gpu.next_frame();
+	profiler.begin_frame();
+	profiler.end_frame();
+	const GpuFrameTimings& frame = profiler.last_frame();
+	CHECK_EQ(frame.frameNumber, 1u);
+	CHECK_EQ(frame.scopes.size(), 3u);
+	CHECK_NEAR(frame.frameMs, 2.f, 1e-4f);
+}
@@ -0,0 +1,218 @@
+#include "TestHarness.h"
+#include "LogRing.h"
+#include <string>
+
+namespace
+{
+	std::string format(const LogRecord& record)
+	{
+		char buffer[256];
+		const u32 kLength = format_log_record(record, buffer, sizeof(buffer));
+		CHECK_EQ(kLength, (u32)strlen(buffer));
+		return buffer;
+	}
+
+	template<typename... Args>
+	std::string format(const char* pFormat, const Args&... args)
+	{
+		return format(make_log_record(LogLevel::kInfo, pFormat, args...));
+	}
+
+	// The rate limit keys on the format's address, each of these is its own format.
+	const char kFormatA[] = "a %u";
+	const char kFormatB[] = "b %u";
+}
+
+TEST_CASE(ring_pops_in_order_across_the_wrap)
+{
+	// Rounded up to four.
+	LogRing ring(3);
+	LogRecord record;
+	CHECK(!ring.pop(record));
+
+	// Three in, two out, again and again, so the indices wrap the slots many times.
+	u32 next = 0;
+	u32 expected = 0;
+	for (u32 round = 0; round < 50; ++round)
+	{
+		for (u32 i = 0; i < 3; ++i)
+		{
+			CHECK(ring.push(make_log_record(LogLevel::kInfo, kFormatA, next++)));
+		}
+		for (u32 i = 0; i < 2; ++i)
+		{
+			CHECK(ring.pop(record));
+			CHECK_EQ(record.args[0].u, (u64)expected++);
+		}
+
+		// Drained before the next round could overflow it.
+		if (next - expected >= 2)
+		{
+			while (ring.pop(record))
+			{
+				CHECK_EQ(record.args[0].u, (u64)expected++);
+			}
+		}
+	}
+	while (ring.pop(record))
+	{
+		CHECK_EQ(record.args[0].u, (u64)expected++);
+	}
+	CHECK_EQ(expected, next);
+	CHECK_EQ(ring.pushed(), (u64)next);
+	CHECK_EQ(ring.dropped(), 0u);
+}
+
+TEST_CASE(a_full_ring_drops_the_new_record)
+{
+	LogRing ring(4);
+	for (u32 i = 0; i < 4; ++i)
+	{
+		CHECK(ring.push(make_log_record(LogLevel::kInfo, kFormatA, i)));
+	}
+
+	// The records already queued are kept, the new ones are lost and counted.
+	CHECK(!ring.push(make_log_record(LogLevel::kInfo, kFormatA, 4u)));
+	CHECK(!ring.push(make_log_record(LogLevel::kInfo, kFormatA, 5u)));
+	CHECK_EQ(ring.dropped(), 2u);
+	CHECK_EQ(ring.pushed(), 4u);
+
+	// Popping one makes room for one.
+	LogRecord record;
+	CHECK(ring.pop(record));
+	CHECK_EQ(record.args[0].u, 0u);
+	CHECK(ring.push(make_log_record(LogLevel::kInfo, kFormatA, 6u)));
+	CHECK(!ring.push(make_log_record(LogLevel::kInfo, kFormatA, 7u)));
+	CHECK_EQ(ring.dropped(), 3u);
+
+	const u64 kExpected[] = { 1, 2, 3, 6 };
+	for (const u64 kValue : kExpected)
+	{
+		CHECK(ring.pop(record));
+		CHECK_EQ(record.args[0].u, kValue);
+	}
+	CHECK(!ring.pop(record));
+}
+
+TEST_CASE(rate_limit_windows_count_what_they_suppress)
+{
+	LogRing ring(4);
+	const s64 kWindow = 100;
+	const u32 kLimit = 3;
+	u32 suppressed = 99;
+
+	// Three per window, the rest of the window drops them.
+	for (s64 tick = 0; tick < 3; ++tick)
+	{
+		CHECK(ring.allow(kFormatA, tick, kWindow, kLimit, suppressed));
+		CHECK_EQ(suppressed, 0u);
+	}
+	for (s64 tick = 3; tick < 8; ++tick)
+	{
+		CHECK(!ring.allow(kFormatA, tick, kWindow, kLimit, suppressed));
+		CHECK_EQ(suppressed, 0u);
+	}
+	CHECK(!ring.allow(kFormatA, kWindow - 1, kWindow, kLimit, suppressed));
+	CHECK_EQ(ring.suppressed(), 6u);
+
+	// Another format has its own count.
+	CHECK(ring.allow(kFormatB, 5, kWindow, kLimit, suppressed));
+	CHECK_EQ(suppressed, 0u);
+
+	// The window starts over a window after its first record, and the first record
+	// allowed carries the count dropped before it, once.
+	CHECK(ring.allow(kFormatA, kWindow, kWindow, kLimit, suppressed));
+	CHECK_EQ(suppressed, 6u);
+	CHECK(ring.allow(kFormatA, kWindow + 1, kWindow, kLimit, suppressed));
+	CHECK_EQ(suppressed, 0u);
+	CHECK(ring.allow(kFormatA, kWindow + 2, kWindow, kLimit, suppressed));
+	CHECK(!ring.allow(kFormatA, kWindow + 3, kWindow, kLimit, suppressed));
+
+	// A quiet gap longer than a window starts a new one whenever the next record comes.
+	CHECK(ring.allow(kFormatA, 10 * kWindow + 50, kWindow, kLimit, suppressed));
+	CHECK_EQ(suppressed, 1u);
+	CHECK_EQ(ring.suppressed(), 7u);
+}
+
+TEST_CASE(length_modifiers_follow_the_packed_argument)
+{
+	// Whatever the format says, the argument is printed at the size it was packed.
+	CHECK(format("%d", (u64)5000000000ull) == "5000000000");
+	CHECK(format("%hhd %hd", (s32)300, (s32)-70000) == "300 -70000");
+	CHECK(format("%lld %llu", (s8)-5, (u8)200) == "-5 200");
+	CHECK(format("%zu %lu", (size_t)42, (u32)7) == "42 7");
+	CHECK(format("%x %08X", 255u, (u64)0xabcdef12345ull) == "ff ABCDEF12345");
+
+	// Between ints and floats the value is converted, not reinterpreted.
+	CHECK(format("%d", 2.75f) == "2");
+	CHECK(format("%.2f %5.1Lf", 3, (u64)12) == "3.00  12.0");
+	CHECK(format("%-4d|%+d|% d", 7, 7, 7) == "7   |+7| 7");
+
+	// Strings, characters, enums and nulls.
+	CHECK(format("%s=%c", "level", 'x') == "level=x");
+	CHECK(format("%s", (const char*)nullptr) == "(null)");
+	CHECK(format("%s", 5) == "(null)");
+	CHECK(format("%d", LogLevel::kError) == "3");
+}
+
+TEST_CASE(percent_signs_missing_and_unknown_conversions)
+{
+	CHECK(format("100%%") == "100%");
+	CHECK(format("%d%% of %u", 50, 8u) == "50% of 8");
+
+	// A conversion with nothing left to print says so, extra arguments are ignored.
+	CHECK(format("%d and %d", 1) == "1 and (missing)");
+	CHECK(format("%s") == "(missing)");
+	CHECK(format("just text", 1, 2) == "just text");
+
+	// Unknown conversions are printed as written and leave the argument for the next.
+	CHECK(format("%y %d", 4) == "%y 4");
+	CHECK(format("%5.2lq|%u", 9u) == "%5.2lq|9");
+	CHECK(format("%y") == "%y");
+
+	// A format cut off after the % stops there.
+	CHECK(format("50%") == "50");
+}
+
+TEST_CASE(formatting_truncates_and_terminates)
+{
+	const LogRecord kRecord = make_log_record(LogLevel::kInfo, "%s and %d more", "a long string", 123456);
+	char buffer[12];
+	memset(buffer, 'x', sizeof(buffer));
+	const u32 kLength = format_log_record(kRecord, buffer, sizeof(buffer));
+	CHECK_EQ(kLength, 11u);
+	CHECK(std::string(buffer) == "a long stri");
+
+	char tiny[1];
+	CHECK_EQ(format_log_record(kRecord, tiny, sizeof(tiny)), 0u);
+	CHECK_EQ(tiny[0], '\0');
+}
+
+TEST_CASE(logger_writes_through_its_sink)
+{
+	std::vector<std::string> lines;
+	LoggerDesc desc;
+	desc.minLevel = LogLevel::kInfo;
+	desc.rateLimit = 2;
+	desc.sink = [&lines](LogLevel, const char* pLine) { lines.push_back(pLine); };
+	Logger logger;
+	logger.init(desc);
+
+	logger.log(LogLevel::kDebug, "below the level");
+	for (u32 i = 0; i < 5; ++i)
+	{
+		logger.log(LogLevel::kWarning, "slow frame %u", i);
+	}
+	logger.flush();
+
+	// Two of the five in the window, the level's prefix after the time.
+	CHECK_EQ((u32)lines.size(), 2u);
+	CHECK(lines.size() == 2 && lines[0].find("] Warning: slow frame 0\n") != std::string::npos);
+	CHECK(lines.size() == 2 && lines[1].find("] Warning: slow frame 1\n") != std::string::npos);
+	const LoggerStats kStats = logger.stats();
+	CHECK_EQ(kStats.logged, 2u);
+	CHECK_EQ(kStats.written, 2u);
+	CHECK_EQ(kStats.suppressed, 3u);
+	CHECK_EQ(kStats.threads, 1u);
+	logger.shutdown();
+}
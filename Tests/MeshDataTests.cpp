@@ -0,0 +1,51 @@
+#include "TestHarness.h"
+#include "MeshData.h"
+#include <string>
+
+TEST_CASE(shapes_merge_into_one_stream)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<u16> indices;
+	CHECK(load_obj_geometry("Tests/Assets/TwoShapes.obj", 2.f, vertices, indices));
+
+	// Two quads, each two triangles, welded across the shapes along their shared edge.
+	CHECK_EQ(indices.size(), 12u);
+	CHECK_EQ(vertices.size(), 6u);
+	bool inRange = true;
+	for (const u16 kIndex : indices)
+	{
+		inRange = inRange && kIndex < vertices.size();
+	}
+	CHECK(inRange);
+
+	// Scaled, z and v flipped for D3D, with the winding reversed to match.
+	CHECK(v3(vertices[indices[0]].pos) == v3(0.f, 0.f, 0.f));
+	CHECK(v3(vertices[indices[1]].pos) == v3(2.f, 2.f, -0.f));
+	CHECK(v3(vertices[indices[2]].pos) == v3(2.f, 0.f, -0.f));
+	CHECK(v3(vertices[indices[1]].normal) == v3(0.f, 0.f, -1.f));
+	CHECK(v2(vertices[indices[1]].tex) == v2(1.f, -1.f));
+
+	// The second shape's triangles use the first shape's vertices for the shared edge.
+	CHECK_EQ(indices[6], indices[2]);
+}
+
+TEST_CASE(missing_files_fail)
+{
+	std::vector<MeshVertex> vertices(3);
+	std::vector<u16> indices(3);
+	CHECK(!load_obj_geometry("Tests/Assets/Missing.obj", 1.f, vertices, indices));
+	CHECK(vertices.empty() && indices.empty());
+}
+
+TEST_CASE(sample_models_load_with_shared_vertices)
+{
+	for (const char* pModel : { "Bus/bus.obj", "House/house.obj", "House2/house2.obj", "Truck/truck.obj" })
+	{
+		const std::string kPath = std::string("NormalMapping/Assets/Models/") + pModel;
+		std::vector<MeshVertex> vertices;
+		std::vector<u16> indices;
+		CHECK(load_obj_geometry(kPath.c_str(), 1.f, vertices, indices));
+		CHECK(indices.size() % 3 == 0);
+		CHECK(!vertices.empty() && vertices.size() < indices.size());
+	}
+}
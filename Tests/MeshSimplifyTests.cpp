@@ -0,0 +1,228 @@
+#include "TestHarness.h"
+#include "MeshSimplify.h"
+#include <string>
+
+namespace
+{
+	const u32 kGridSize = 16; // quads a side
+
+	// uv of a grid position on either side of the seam down x = kGridSize / 2, the right half's
+	// chart far enough along the texture that moving a corner across costs more than any collapse
+	// along the seam.
+	v2 chart_uv(const f32 x, const f32 y, const bool kRight)
+	{
+		return v2(x / (2.f * kGridSize) + (kRight ? 0.5f : 0.f), y / kGridSize);
+	}
+
+	// Flat grid in the xy plane facing +z, split into two uv charts down the middle when kSeam, the
+	// column of positions on the seam getting a vertex for each chart. Left chart vertices first.
+	void make_grid(const bool kSeam, std::vector<MeshVertex>& rVertices, std::vector<u16>& rIndices, u32& rRightChartStart)
+	{
+		const u32 kSeamColumn = kSeam ? kGridSize / 2 : kGridSize;
+		const u32 kSide = kGridSize + 1;
+		std::vector<u16> left(kSide * kSide, 0xFFFF);
+		std::vector<u16> right(kSide * kSide, 0xFFFF);
+		rVertices.clear();
+		rIndices.clear();
+		for (u32 chart = 0; chart < 2; ++chart)
+		{
+			if (chart == 1)
+			{
+				rRightChartStart = (u32)rVertices.size();
+			}
+			for (u32 y = 0; y < kSide; ++y)
+			{
+				for (u32 x = 0; x < kSide; ++x)
+				{
+					if (chart == 0 ? x > kSeamColumn : x < kSeamColumn || !kSeam)
+					{
+						continue;
+					}
+					(chart == 0 ? left : right)[y * kSide + x] = (u16)rVertices.size();
+					rVertices.push_back(MeshVertex(DirectX::XMFLOAT3((f32)x, (f32)y, 0.f), 0xFFFFFFFF, DirectX::XMFLOAT3(0.f, 0.f, 1.f),
+						chart_uv((f32)x, (f32)y, chart == 1)));
+				}
+			}
+		}
+
+		for (u32 y = 0; y < kGridSize; ++y)
+		{
+			for (u32 x = 0; x < kGridSize; ++x)
+			{
+				const std::vector<u16>& chart = x < kSeamColumn ? left : right;
+				const u16 k00 = chart[y * kSide + x];
+				const u16 k10 = chart[y * kSide + x + 1];
+				const u16 k01 = chart[(y + 1) * kSide + x];
+				const u16 k11 = chart[(y + 1) * kSide + x + 1];
+				rIndices.insert(rIndices.end(), { k00, k10, k11, k00, k11, k01 });
+			}
+		}
+	}
+
+	// One eye of a headset, tangents up, down, left and right, and its render target.
+	m4x4 eye_projection(const f32 kUp, const f32 kDown, const f32 kLeft, const f32 kRight)
+	{
+		const f32 kNear = 0.2f;
+		return m4x4::CreatePerspectiveOffCenter(-kLeft * kNear, kRight * kNear, -kDown * kNear, kUp * kNear, kNear, 1000.f);
+	}
+
+	const f32 kEyeWidth = 1344.f;
+	const f32 kEyeHeight = 1600.f;
+}
+
+TEST_CASE(flat_grid_reaches_the_target)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<u16> indices;
+	u32 rightChartStart = 0;
+	make_grid(false, vertices, indices, rightChartStart);
+
+	// A flat grid costs nothing to simplify, all the way down to the target.
+	const u32 kTarget = (u32)indices.size() / 8;
+	std::vector<u16> simplified;
+	SimplifyStats stats = {};
+	const f32 kError = simplify_mesh(&vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size(), kTarget, simplified, &stats);
+	CHECK(simplified.size() <= kTarget);
+	CHECK(simplified.size() > 0 && simplified.size() % 3 == 0);
+	CHECK_NEAR(kError, 0.f, 1e-3f);
+	CHECK_EQ(stats.positions, (kGridSize + 1) * (kGridSize + 1));
+	CHECK_EQ(stats.slides, 0u);
+
+	// The border only slides along itself, the planes through it keep its corners where they are.
+	CHECK_EQ(stats.locked, 0u);
+	CHECK_EQ(stats.constrained, 4 * kGridSize);
+
+	// Every triangle still faces +z and the corners are where they were.
+	u32 cornersKept = 0;
+	for (u32 i = 0; i < simplified.size(); i += 3)
+	{
+		const v3 kA(vertices[simplified[i + 0]].pos);
+		const v3 kB(vertices[simplified[i + 1]].pos);
+		const v3 kC(vertices[simplified[i + 2]].pos);
+		CHECK((kB - kA).Cross(kC - kA).z > 0.f);
+	}
+	for (u32 i = 0; i < vertices.size(); ++i)
+	{
+		const v3 kPosition(vertices[i].pos);
+		const bool kCorner = (kPosition.x == 0.f || kPosition.x == (f32)kGridSize) && (kPosition.y == 0.f || kPosition.y == (f32)kGridSize);
+		if (kCorner && std::find(simplified.begin(), simplified.end(), (u16)i) != simplified.end())
+		{
+			cornersKept++;
+		}
+	}
+	CHECK_EQ(cornersKept, 4u);
+}
+
+TEST_CASE(seams_keep_their_uvs)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<u16> indices;
+	u32 rightChartStart = 0;
+	make_grid(true, vertices, indices, rightChartStart);
+
+	const u32 kTarget = (u32)indices.size() / 4;
+	std::vector<u16> simplified;
+	SimplifyStats stats = {};
+	simplify_mesh(&vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size(), kTarget, simplified, &stats);
+	CHECK(simplified.size() <= kTarget);
+	CHECK_EQ(stats.slides, 0u);
+
+	// Collapses along the seam move both of its vertices together, so every triangle stays on one
+	// chart and each corner has the uv its chart gives its position.
+	bool oneChart = true;
+	bool uvsMatch = true;
+	for (u32 i = 0; i < simplified.size(); i += 3)
+	{
+		const bool kRight = simplified[i] >= rightChartStart;
+		for (u32 c = 0; c < 3; ++c)
+		{
+			const MeshVertex& vertex = vertices[simplified[i + c]];
+			oneChart = oneChart && (simplified[i + c] >= rightChartStart) == kRight;
+			uvsMatch = uvsMatch && v2(vertex.tex) == chart_uv(vertex.pos.x, vertex.pos.y, kRight);
+		}
+	}
+	CHECK(oneChart);
+	CHECK(uvsMatch);
+}
+
+TEST_CASE(sample_models_get_three_levels_or_more)
+{
+	// Scaled as the app loads them.
+	const std::pair<const char*, f32> kModels[] = { { "Bus/bus.obj", 0.1f }, { "House/house.obj", 0.006f }, { "House2/house2.obj", 1.f },
+		{ "Truck/truck.obj", 1.f } };
+	for (const auto& model : kModels)
+	{
+		const std::string kPath = std::string("NormalMapping/Assets/Models/") + model.first;
+		std::vector<MeshVertex> vertices;
+		std::vector<u16> indices;
+		CHECK(load_obj_geometry(kPath.c_str(), model.second, vertices, indices));
+
+		MeshLod lods[kMaxMeshLods];
+		std::vector<u16> lodIndices;
+		const u32 kNumLods = build_lod_chain(&vertices[0], (u32)vertices.size(), &indices[0], (u32)indices.size(), lods, lodIndices);
+		CHECK(kNumLods >= 3);
+
+		// Each level is at most three quarters of the one before, costs more and stays in the buffer.
+		CHECK_EQ(lods[0].indexCount, (u32)indices.size());
+		for (u32 i = 1; i < kNumLods; ++i)
+		{
+			CHECK(lods[i].indexCount * 4 <= lods[i - 1].indexCount * 3);
+			CHECK(lods[i].error > lods[i - 1].error);
+			CHECK_EQ(lods[i].firstIndex, lods[i - 1].firstIndex + lods[i - 1].indexCount);
+		}
+		CHECK_EQ(lods[kNumLods - 1].firstIndex + lods[kNumLods - 1].indexCount, (u32)lodIndices.size());
+		bool inRange = true;
+		for (const u16 kIndex : lodIndices)
+		{
+			inRange = inRange && kIndex < vertices.size();
+		}
+		CHECK(inRange);
+	}
+}
+
+TEST_CASE(pixels_per_unit_matches_the_projection)
+{
+	// Wider than tall per pixel, so the x axis sets the scale.
+	const m4x4 kProj = eye_projection(1.3f, 1.4f, 1.2f, 1.f);
+	const f32 kPixelsPerUnit = lod_pixels_per_unit(kProj, kEyeWidth, kEyeHeight);
+	CHECK_NEAR(kPixelsPerUnit, kEyeWidth / 2.2f, 0.01f);
+
+	// Half a unit sideways kDistance in front of the eye moves that many pixels over kDistance.
+	// In front is +z or -z depending on the math library's handedness, whichever gives a positive w.
+	const f32 kDistance = 5.f;
+	const f32 kZ = v4::Transform(v4(0.f, 0.f, kDistance, 1.f), kProj).w > 0.f ? kDistance : -kDistance;
+	const v4 kCenter = v4::Transform(v4(0.f, 0.f, kZ, 1.f), kProj);
+	const v4 kSide = v4::Transform(v4(0.5f, 0.f, kZ, 1.f), kProj);
+	const f32 kPixels = (kSide.x / kSide.w - kCenter.x / kCenter.w) * kEyeWidth * 0.5f;
+	CHECK_NEAR(kPixels, kPixelsPerUnit * 0.5f / kDistance, 0.01f);
+}
+
+TEST_CASE(both_eyes_pick_the_same_level)
+{
+	const MeshLod kLods[kMaxMeshLods] = { { 0, 300, 0.f }, { 300, 150, 0.05f }, { 450, 72, 0.3f }, { 522, 36, 1.f } };
+
+	// Mirrored eyes with different render targets, as a headset's are after a quality change.
+	const f32 kLeftPixels = lod_pixels_per_unit(eye_projection(1.3f, 1.4f, 1.2f, 1.f), kEyeWidth, kEyeHeight);
+	const f32 kRightPixels = lod_pixels_per_unit(eye_projection(1.3f, 1.4f, 1.f, 1.2f), kEyeWidth * 0.8f, kEyeHeight * 0.8f);
+	const f32 kShared = std::max(kLeftPixels, kRightPixels);
+
+	// The shared scale is never coarser than either eye would pick alone, and only gets coarser
+	// with distance.
+	u32 previous = 0;
+	for (f32 distance = 0.2f; distance < 2000.f; distance *= 1.1f)
+	{
+		const u32 kLod = select_lod(kLods, kMaxMeshLods, distance, kShared, 1.f);
+		CHECK(kLod <= select_lod(kLods, kMaxMeshLods, distance, kLeftPixels, 1.f));
+		CHECK(kLod <= select_lod(kLods, kMaxMeshLods, distance, kRightPixels, 1.f));
+		CHECK(kLod >= previous);
+		previous = kLod;
+	}
+	CHECK_EQ(previous, kMaxMeshLods - 1);
+
+	// A level is picked from where its error projects to the pixel error, a bias scales that.
+	const f32 kSwitch = 0.3f * kShared;
+	CHECK_EQ(select_lod(kLods, kMaxMeshLods, kSwitch * 0.99f, kShared, 1.f), 1u);
+	CHECK_EQ(select_lod(kLods, kMaxMeshLods, kSwitch * 1.01f, kShared, 1.f), 2u);
+	CHECK_EQ(select_lod(kLods, kMaxMeshLods, kSwitch * 0.51f, kShared, 2.f), 2u);
+	CHECK_EQ(select_lod(kLods, 1, 1e6f, kShared, 1.f), 0u);
+}
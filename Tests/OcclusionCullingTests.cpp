@@ -0,0 +1,267 @@
+#include "TestHarness.h"
+#include "OcclusionCulling.h"
+
+namespace
+{
+	const u32 kWidth = 224;
+	const u32 kHeight = 256;
+
+	OccluderMesh make_box(const v3& extents)
+	{
+		OccluderMesh mesh;
+		for (u32 i = 0; i < 8; ++i)
+		{
+			mesh.positions.push_back(v3((i & 1) ? extents.x : -extents.x, (i & 2) ? extents.y : -extents.y, (i & 4) ? extents.z : -extents.z));
+		}
+		const u16 kIndices[] = { 0,1,3,0,3,2, 4,6,7,4,7,5, 0,4,5,0,5,1, 2,3,7,2,7,6, 0,2,6,0,6,4, 1,5,7,1,7,3 };
+		mesh.indices.assign(kIndices, kIndices + 36);
+		return mesh;
+	}
+
+	m4x4 test_projection()
+	{
+		return m4x4::CreatePerspectiveOffCenter(-0.2f, 0.2f, -0.22f, 0.22f, 0.2f, 1000.f);
+	}
+
+	// Boxes scattered in front of the camera, all beyond the near plane.
+	struct TestScene
+	{
+		std::vector<OccluderMesh> meshes;
+		std::vector<OccluderInstance> occluders;
+
+		explicit TestScene(const u64 kSeed, const u32 kCount = 12)
+		{
+			Random random(kSeed);
+			for (u32 i = 0; i < 6; ++i)
+			{
+				meshes.push_back(make_box(v3(random.range(0.5f, 3.f), random.range(0.5f, 3.f), random.range(0.2f, 2.f))));
+			}
+			for (u32 i = 0; i < kCount; ++i)
+			{
+				const v3 kPosition(random.range(-10.f, 10.f), random.range(-6.f, 6.f), random.range(6.f, 40.f));
+				occluders.push_back({ &meshes[i % meshes.size()], m4x4::CreateTranslation(kPosition) });
+			}
+		}
+	};
+
+	void project(const v3& p, const m4x4& m, f64& rX, f64& rY, f64& rZ, f64& rW)
+	{
+		rX = (f64)p.x * m._11 + (f64)p.y * m._21 + (f64)p.z * m._31 + m._41;
+		rY = (f64)p.x * m._12 + (f64)p.y * m._22 + (f64)p.z * m._32 + m._42;
+		rZ = (f64)p.x * m._13 + (f64)p.y * m._23 + (f64)p.z * m._33 + m._43;
+		rW = (f64)p.x * m._14 + (f64)p.y * m._24 + (f64)p.z * m._34 + m._44;
+	}
+
+	// Double precision reference: every pixel center tested against every triangle, nearest depth wins.
+	void reference_rasterize(const m4x4& viewProj, const std::vector<OccluderInstance>& occluders, std::vector<f64>& rDepth)
+	{
+		rDepth.assign(kWidth * kHeight, 1.0);
+		for (const OccluderInstance& occluder : occluders)
+		{
+			const m4x4 kWorldViewProj = occluder.matWorld * viewProj;
+			const OccluderMesh& mesh = *occluder.pMesh;
+			for (size_t t = 0; t < mesh.indices.size(); t += 3)
+			{
+				f64 sx[3], sy[3], sz[3];
+				for (u32 c = 0; c < 3; ++c)
+				{
+					f64 x, y, z, w;
+					project(mesh.positions[mesh.indices[t + c]], kWorldViewProj, x, y, z, w);
+					sx[c] = (x / w * 0.5 + 0.5) * kWidth;
+					sy[c] = (0.5 - y / w * 0.5) * kHeight;
+					sz[c] = z / w;
+				}
+
+				const f64 kArea = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+				if (kArea == 0.0)
+				{
+					continue;
+				}
+
+				for (u32 y = 0; y < kHeight; ++y)
+				{
+					for (u32 x = 0; x < kWidth; ++x)
+					{
+						const f64 px = x + 0.5, py = y + 0.5;
+						const f64 l0 = ((sx[1] - px) * (sy[2] - py) - (sx[2] - px) * (sy[1] - py)) / kArea;
+						const f64 l1 = ((sx[2] - px) * (sy[0] - py) - (sx[0] - px) * (sy[2] - py)) / kArea;
+						const f64 l2 = 1.0 - l0 - l1;
+						if (l0 >= 0.0 && l1 >= 0.0 && l2 >= 0.0)
+						{
+							const f64 kDepth = l0 * sz[0] + l1 * sz[1] + l2 * sz[2];
+							rDepth[y * kWidth + x] = std::min(rDepth[y * kWidth + x], kDepth);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void render(OcclusionBuffer& rBuffer, const CullKernel kernel, const m4x4& viewProj, const std::vector<OccluderInstance>& occluders)
+	{
+		rBuffer.init(kWidth, kHeight);
+		rBuffer.begin(viewProj);
+		for (const OccluderInstance& occluder : occluders)
+		{
+			rBuffer.add_occluder(*occluder.pMesh, occluder.matWorld);
+		}
+		rBuffer.rasterize(kernel);
+	}
+}
+
+TEST_CASE(simd_kernels_match_scalar_exactly)
+{
+	for (u64 seed = 1; seed <= 10; ++seed)
+	{
+		const TestScene kScene(seed);
+		OcclusionBuffer scalar;
+		render(scalar, CullKernel::kScalar, test_projection(), kScene.occluders);
+
+		for_each_kernel(best_cull_kernel(), [&](const CullKernel kernel)
+		{
+			OcclusionBuffer buffer;
+			render(buffer, kernel, test_projection(), kScene.occluders);
+			CHECK(memcmp(scalar.depth(), buffer.depth(), kWidth * kHeight * sizeof(f32)) == 0);
+			CHECK(memcmp(scalar.block_depth(), buffer.block_depth(), kWidth * kHeight / (kOcclusionBlockSize * kOcclusionBlockSize) * sizeof(f32)) == 0);
+		});
+	}
+}
+
+TEST_CASE(matches_reference_rasterizer)
+{
+	u32 coverageDifferences = 0;
+	u32 covered = 0;
+	f64 maxDepthError = 0.0;
+	for (u64 seed = 1; seed <= 10; ++seed)
+	{
+		const TestScene kScene(seed);
+		OcclusionBuffer buffer;
+		render(buffer, best_cull_kernel(), test_projection(), kScene.occluders);
+		CHECK_EQ(buffer.clipped(), 0u);
+
+		std::vector<f64> reference;
+		reference_rasterize(test_projection(), kScene.occluders, reference);
+		for (u32 i = 0; i < kWidth * kHeight; ++i)
+		{
+			const bool kCovered = buffer.depth()[i] < 1.f;
+			const bool kReferenceCovered = reference[i] < 1.0;
+			covered += kReferenceCovered ? 1 : 0;
+			if (kCovered != kReferenceCovered)
+			{
+				coverageDifferences++;
+			}
+			else if (kCovered)
+			{
+				maxDepthError = std::max(maxDepthError, std::fabs(reference[i] - buffer.depth()[i]));
+			}
+		}
+	}
+
+	// Only pixel centers within rounding of an edge may disagree.
+	CHECK(covered > 0);
+	CHECK(coverageDifferences * 1000 < covered);
+	CHECK(maxDepthError < 1e-5);
+}
+
+TEST_CASE(worker_threads_match_the_calling_thread)
+{
+	const m4x4 kViewProj[2] = { test_projection(), m4x4::CreateTranslation(-0.064f, 0.f, 0.f) * test_projection() };
+	for (u64 seed = 1; seed <= 5; ++seed)
+	{
+		const TestScene kScene(seed, 40);
+
+		OcclusionCuller single;
+		single.init(0, kWidth, kHeight);
+		single.render(CullKernel::kScalar, kViewProj, 2, kScene.occluders.data(), (u32)kScene.occluders.size());
+
+		for_each_kernel(best_cull_kernel(), [&](const CullKernel kernel)
+		{
+			OcclusionCuller threaded;
+			threaded.init(3, kWidth, kHeight);
+			CHECK_EQ(threaded.workers(), 3u);
+
+			// Twice, so a second frame on the same workers starts clean.
+			for (u32 frame = 0; frame < 2; ++frame)
+			{
+				threaded.render(kernel, kViewProj, 2, kScene.occluders.data(), (u32)kScene.occluders.size());
+				for (u32 view = 0; view < 2; ++view)
+				{
+					CHECK(memcmp(single.buffer(view).depth(), threaded.buffer(view).depth(), kWidth * kHeight * sizeof(f32)) == 0);
+				}
+				CHECK_EQ(threaded.stats().triangles, single.stats().triangles);
+			}
+		});
+	}
+}
+
+TEST_CASE(occluded_boxes_are_behind_the_reference_depth)
+{
+	// Conservative: every point of a box reported occluded has to be behind the exact depth.
+	Random random(99);
+	u32 occluded = 0;
+	u32 falseOcclusions = 0;
+	for (u64 seed = 1; seed <= 10; ++seed)
+	{
+		const TestScene kScene(seed);
+		OcclusionBuffer buffer;
+		render(buffer, best_cull_kernel(), test_projection(), kScene.occluders);
+
+		std::vector<f64> reference;
+		reference_rasterize(test_projection(), kScene.occluders, reference);
+		for (u32 test = 0; test < 300; ++test)
+		{
+			const v3 kCenter(random.range(-12.f, 12.f), random.range(-8.f, 8.f), random.range(2.f, 60.f));
+			const v3 kExtents(random.range(0.05f, 1.f), random.range(0.05f, 1.f), random.range(0.05f, 1.f));
+			if (!buffer.is_occluded(kCenter, kExtents))
+			{
+				continue;
+			}
+			occluded++;
+
+			for (u32 sample = 0; sample < 500; ++sample)
+			{
+				const v3 kPoint(kCenter.x + random.range(-kExtents.x, kExtents.x), kCenter.y + random.range(-kExtents.y, kExtents.y), kCenter.z + random.range(-kExtents.z, kExtents.z));
+				f64 x, y, z, w;
+				project(kPoint, test_projection(), x, y, z, w);
+				const s32 kX = (s32)std::floor((x / w * 0.5 + 0.5) * kWidth);
+				const s32 kY = (s32)std::floor((0.5 - y / w * 0.5) * kHeight);
+				if (kX >= 0 && kY >= 0 && kX < (s32)kWidth && kY < (s32)kHeight && z / w < reference[kY * kWidth + kX] - 1e-6)
+				{
+					falseOcclusions++;
+					break;
+				}
+			}
+		}
+	}
+
+	CHECK(occluded > 0);
+	CHECK_EQ(falseOcclusions, 0u);
+}
+
+TEST_CASE(wall_hides_what_is_behind_it)
+{
+	const OccluderMesh kWall = make_box(v3(20.f, 20.f, 0.5f));
+	const std::vector<OccluderInstance> kOccluders = { { &kWall, m4x4::CreateTranslation(0.f, 0.f, 10.f) } };
+	OcclusionBuffer buffer;
+	render(buffer, best_cull_kernel(), test_projection(), kOccluders);
+
+	CHECK(buffer.is_occluded(v3(0.f, 0.f, 20.f), v3(1.f, 1.f, 1.f)));
+	CHECK(!buffer.is_occluded(v3(0.f, 0.f, 5.f), v3(1.f, 1.f, 1.f)));
+
+	// Straddling the wall, and crossing the near plane, are never occluded.
+	CHECK(!buffer.is_occluded(v3(0.f, 0.f, 10.f), v3(1.f, 1.f, 2.f)));
+	CHECK(!buffer.is_occluded(v3(0.f, 0.f, 0.f), v3(1.f, 1.f, 1.f)));
+}
+
+TEST_CASE(near_plane_clipping_keeps_the_visible_part)
+{
+	// A floor running from behind the camera out to 50m still hides boxes sunk into it.
+	const OccluderMesh kFloor = make_box(v3(20.f, 0.5f, 30.f));
+	const std::vector<OccluderInstance> kOccluders = { { &kFloor, m4x4::CreateTranslation(0.f, -2.f, 20.f) } };
+	OcclusionBuffer buffer;
+	render(buffer, best_cull_kernel(), test_projection(), kOccluders);
+
+	CHECK(buffer.clipped() > 0);
+	CHECK(buffer.is_occluded(v3(0.f, -4.f, 20.f), v3(0.5f, 0.5f, 0.5f)));
+	CHECK(!buffer.is_occluded(v3(0.f, 0.f, 20.f), v3(0.5f, 0.5f, 0.5f)));
+}
@@ -0,0 +1,115 @@
+#include "TestHarness.h"
+#include "ParallelRecorder.h"
+#include <atomic>
+
+namespace
+{
+	// Chunks cover [0, kItems) in order with nothing missing or repeated, and stay inside their segment.
+	bool chunks_tile_items(const std::vector<RecordChunk>& chunks, const u32 kItems, const u32 kSegmentSize)
+	{
+		u32 next = 0;
+		for (const RecordChunk& chunk : chunks)
+		{
+			if (chunk.first != next || chunk.count == 0)
+			{
+				return false;
+			}
+			if (chunk.first / kSegmentSize != (chunk.first + chunk.count - 1) / kSegmentSize)
+			{
+				return false;
+			}
+			next += chunk.count;
+		}
+		return next == kItems;
+	}
+}
+
+TEST_CASE(partition_chunks_tiles_every_item_in_order)
+{
+	std::vector<RecordChunk> chunks;
+	for (const u32 kItems : { 1u, 7u, 64u, 100u, 1001u })
+	{
+		for (const u32 kSegmentSize : { 1u, 50u, 100000u })
+		{
+			for (const u32 kMaxChunks : { 1u, 3u, 8u, 16u })
+			{
+				const u32 kCount = partition_chunks(kItems, kSegmentSize, kMaxChunks, 4, chunks);
+				CHECK_EQ(kCount, (u32)chunks.size());
+				CHECK(chunks_tile_items(chunks, kItems, kSegmentSize));
+			}
+		}
+	}
+
+	CHECK_EQ(partition_chunks(0, 10, 8, 4, chunks), 0u);
+	CHECK(chunks.empty());
+}
+
+TEST_CASE(partition_chunks_balances_and_respects_the_minimum)
+{
+	std::vector<RecordChunk> chunks;
+
+	// Sizes differ by at most one.
+	CHECK_EQ(partition_chunks(10, 100, 4, 1, chunks), 4u);
+	CHECK(chunks[0].count == 3 && chunks[1].count == 3 && chunks[2].count == 2 && chunks[3].count == 2);
+
+	// No chunk below the minimum, so fewer chunks than asked for.
+	CHECK_EQ(partition_chunks(10, 100, 8, 4, chunks), 2u);
+	CHECK(chunks[0].count == 5 && chunks[1].count == 5);
+
+	// A segment smaller than the minimum still gets its one chunk.
+	CHECK_EQ(partition_chunks(3, 100, 8, 4, chunks), 1u);
+	CHECK_EQ(chunks[0].count, 3u);
+
+	// Two eyes of 6 share 4 chunks, two each, and never cross between eyes.
+	CHECK_EQ(partition_chunks(12, 6, 4, 1, chunks), 4u);
+	CHECK(chunks[1].first + chunks[1].count == 6);
+	CHECK_EQ(chunks[2].first, 6u);
+
+	// More segments than chunks, still one per segment.
+	CHECK_EQ(partition_chunks(12, 2, 4, 1, chunks), 6u);
+}
+
+TEST_CASE(recorder_executes_in_chunk_order)
+{
+	for (const u32 kWorkers : { 0u, 1u, 3u })
+	{
+		ParallelRecorder recorder;
+		recorder.init(kWorkers);
+		CHECK_EQ(recorder.workers(), kWorkers);
+
+		NullRecordingBackend backend;
+		for (u32 frame = 0; frame < 20; ++frame)
+		{
+			const u32 kItems = 500 + frame * 37;
+			std::vector<std::atomic<u32>> recordedItems(kItems);
+			for (std::atomic<u32>& count : recordedItems)
+			{
+				count = 0;
+			}
+
+			bool allRecordedBeforeExecute = false;
+			recorder.record(backend, kItems, kItems / 2 + 1, 8, 16,
+				[&](const u32 kChunk, const RecordChunk& rChunk)
+				{
+					// Every chunk records its own items, in its own begin/end pair.
+					ASSERT(backend.recorded[kChunk] == 1);
+					for (u32 i = rChunk.first; i < rChunk.first + rChunk.count; ++i)
+					{
+						recordedItems[i]++;
+					}
+				},
+				[&]()
+				{
+					allRecordedBeforeExecute = backend.executed.empty() && std::all_of(backend.recorded.begin(), backend.recorded.end(), [](const u8 kState) { return kState == 2; });
+				});
+
+			CHECK(allRecordedBeforeExecute);
+			CHECK(std::all_of(recordedItems.begin(), recordedItems.end(), [](const std::atomic<u32>& count) { return count == 1; }));
+			CHECK_EQ((u32)backend.executed.size(), recorder.chunks());
+			for (u32 i = 0; i < backend.executed.size(); ++i)
+			{
+				CHECK_EQ(backend.executed[i], i);
+			}
+		}
+	}
+}
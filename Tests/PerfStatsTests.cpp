@@ -0,0 +1,149 @@
+#include "TestHarness.h"
+#include "PerfStats.h"
+
+TEST_CASE(percentiles_report_the_upper_edge_of_their_bin)
+{
+	// One millisecond bins, so every edge is exact.
+	FrameTimeHistogram histogram;
+	histogram.init(16.f, 16);
+	CHECK_EQ(histogram.bins(), 17u);
+	CHECK_EQ(histogram.percentile(0.5f), 0.f);
+
+	// Just under an edge stays in the bin below it, on the edge is in the bin above.
+	for (u32 i = 0; i < 25; ++i)
+	{
+		histogram.add(2.999f);
+		histogram.add(3.f);
+	}
+	for (u32 i = 0; i < 45; ++i)
+	{
+		histogram.add(5.5f);
+	}
+	for (u32 i = 0; i < 4; ++i)
+	{
+		histogram.add(9.f);
+	}
+	histogram.add(12.f);
+	CHECK_EQ(histogram.count(), 100u);
+	CHECK_EQ(histogram.bin(2), 25u);
+	CHECK_EQ(histogram.bin(3), 25u);
+	CHECK_EQ(histogram.bin(5), 45u);
+	CHECK_EQ(histogram.bin(9), 4u);
+
+	// The 25th time is the last in [2, 3), the 50th the last in [3, 4).
+	CHECK_EQ(histogram.percentile(0.25f), 3.f);
+	CHECK_EQ(histogram.percentile(0.26f), 4.f);
+	CHECK_EQ(histogram.percentile(0.5f), 4.f);
+	CHECK_EQ(histogram.percentile(0.51f), 6.f);
+	CHECK_EQ(histogram.percentile(0.95f), 6.f);
+	CHECK_EQ(histogram.percentile(0.96f), 10.f);
+	CHECK_EQ(histogram.percentile(0.99f), 10.f);
+
+	// Nothing is above the maximum, so its bin reports it rather than the edge.
+	CHECK_EQ(histogram.percentile(1.f), 12.f);
+	CHECK_EQ(histogram.max_ms(), 12.f);
+	CHECK_NEAR(histogram.mean_ms(), (25 * 2.999 + 25 * 3.0 + 45 * 5.5 + 4 * 9.0 + 12.0) / 100.0, 1e-4);
+
+	histogram.reset();
+	CHECK_EQ(histogram.count(), 0u);
+	CHECK_EQ(histogram.percentile(0.99f), 0.f);
+}
+
+TEST_CASE(times_past_the_maximum_go_to_the_overflow_bin)
+{
+	PerfStatsDesc desc;
+	desc.histogramMaxMs = 50.f;
+	desc.histogramBins = 500;
+	PerfStats stats;
+	stats.init(desc);
+	const FrameTimeHistogram& histogram = stats.histogram();
+	const u32 kOverflow = histogram.bins() - 1;
+	CHECK_EQ(kOverflow, 500u);
+
+	for (u32 i = 0; i < 96; ++i)
+	{
+		stats.end_frame(10.f);
+	}
+	stats.end_frame(50.f); // the maximum is the first time past the last bin
+	stats.end_frame(60.f);
+	stats.end_frame(80.f);
+	stats.end_frame(250.f);
+	CHECK_EQ(histogram.bin(kOverflow), 4u);
+	CHECK_EQ(histogram.bin(kOverflow - 1), 0u);
+
+	// The overflow bin has no upper edge, it reports the slowest time.
+	CHECK_NEAR(histogram.percentile(0.5f), 10.1f, 1e-4f);
+	CHECK_EQ(histogram.percentile(0.97f), 250.f);
+	CHECK_EQ(histogram.percentile(0.99f), 250.f);
+	CHECK_EQ(histogram.max_ms(), 250.f);
+
+	// Negative times are clamped into the first bin.
+	stats.end_frame(-1.f);
+	CHECK_EQ(histogram.bin(0), 1u);
+	CHECK_EQ(histogram.max_ms(), 250.f);
+}
+
+TEST_CASE(missed_frames_count_the_refreshes_they_missed)
+{
+	for (const f32 kRefreshMs : { 10.f, 1000.f / 90.f, 1000.f / 72.f })
+	{
+		PerfStatsDesc desc;
+		desc.refreshMs = kRefreshMs;
+		PerfStats stats;
+		stats.init(desc);
+
+		// Up to half a refresh late is still shown on time.
+		stats.end_frame(0.5f * kRefreshMs);
+		stats.end_frame(kRefreshMs);
+		stats.end_frame(1.4f * kRefreshMs);
+		CHECK_EQ(stats.missed_frames(), 0u);
+		CHECK_EQ(stats.missed_refreshes(), 0u);
+
+		// Past that it takes two refreshes, one was shown without it.
+		stats.end_frame(1.6f * kRefreshMs);
+		CHECK_EQ(stats.missed_frames(), 1u);
+		CHECK_EQ(stats.missed_refreshes(), 1u);
+
+		// 2.6 rounds to three refreshes, two missed.
+		stats.end_frame(2.6f * kRefreshMs);
+		CHECK_EQ(stats.missed_frames(), 2u);
+		CHECK_EQ(stats.missed_refreshes(), 3u);
+		CHECK_EQ(stats.frames(), 5u);
+
+		stats.reset();
+		CHECK_EQ(stats.missed_frames(), 0u);
+		CHECK_EQ(stats.missed_refreshes(), 0u);
+		CHECK_EQ(stats.frames(), 0u);
+	}
+}
+
+TEST_CASE(counters_and_history_move_on_at_the_frame_end)
+{
+	PerfStatsDesc desc;
+	desc.historyFrames = 4;
+	PerfStats stats;
+	stats.init(desc);
+	set_current_perf_stats(&stats);
+
+	for (u32 frame = 1; frame <= 6; ++frame)
+	{
+		perf_count(PerfCounter::kDrawCalls, frame);
+		perf_count(PerfCounter::kDrawCalls, 10);
+		stats.end_frame((f32)frame);
+		CHECK_EQ(stats.last(PerfCounter::kDrawCalls), (u64)frame + 10);
+		CHECK_EQ(stats.last(PerfCounter::kTriangles), 0u);
+	}
+	CHECK_EQ(stats.total(PerfCounter::kDrawCalls), 21u + 60u);
+
+	// The ring keeps the last four, oldest first.
+	CHECK_EQ(stats.history_count(), 4u);
+	for (u32 i = 0; i < 4; ++i)
+	{
+		CHECK_EQ(stats.history(i), (f32)(3 + i));
+	}
+
+	set_current_perf_stats(nullptr);
+	perf_count(PerfCounter::kDrawCalls, 100);
+	stats.end_frame(1.f);
+	CHECK_EQ(stats.last(PerfCounter::kDrawCalls), 0u);
+}
@@ -0,0 +1,120 @@
+#include "TestHarness.h"
+#include "PoseSource.h"
+#include "FrameLifecycle.h"
+
+namespace
+{
+	// Angle between two orientations, radians.
+	f32 angle_between(const quat& a, const quat& b)
+	{
+		const f32 kDot = std::fabs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+		return 2.f * std::acos(std::min(kDot, 1.f));
+	}
+
+	struct LatchErrors
+	{
+		f64 earlyTotal = 0.0;
+		f64 lateTotal = 0.0;
+		f32 earlyMax = 0.f;
+		f32 lateMax = 0.f;
+		f32 latchMax = 0.f; // furthest the late pose turned from the early one
+		u32 frames = 0;
+	};
+
+	// Frames as the app runs them with late latching: poses sampled at the top of the frame,
+	// kCpuSeconds of culling and recording, sampled again, then a little more work to submit.
+	LatchErrors run_latched_frames(SimulatedHmd& rHmd, const u32 kFrames, const f64 kCpuSeconds, const f64 kSubmitSeconds)
+	{
+		FrameLifecycle lifecycle;
+		lifecycle.init(&rHmd);
+		SyntheticPoseSource poses(&rHmd);
+
+		LatchErrors errors;
+		for (u32 i = 0; i < kFrames; ++i)
+		{
+			CHECK(lifecycle.begin_frame() == HmdFrameStatus::kRender);
+			const f64 kDisplayTime = lifecycle.predicted_display_time();
+			const PoseSample kEarly = poses.sample(lifecycle.frame_index(), kDisplayTime);
+			rHmd.advance(kCpuSeconds);
+			const PoseSample kLate = poses.sample(lifecycle.frame_index(), kDisplayTime);
+			rHmd.advance(kSubmitSeconds);
+			CHECK(lifecycle.end_frame(nullptr, 0));
+
+			// Both predict the same display, the late one from closer to it.
+			CHECK_EQ(kEarly.displayTime, kDisplayTime);
+			CHECK_EQ(kLate.displayTime, kDisplayTime);
+			CHECK_NEAR(kLate.sampleTime - kEarly.sampleTime, kCpuSeconds, 1e-9);
+
+			// The simulated compositor shows the frame when it was predicted to.
+			CHECK_NEAR(rHmd.last_display_time(), kDisplayTime, 1e-9);
+
+			const PoseSample kTrue = poses.true_pose(kDisplayTime);
+			const f32 kEarlyError = angle_between(kEarly.eyes[0].orientation, kTrue.eyes[0].orientation);
+			const f32 kLateError = angle_between(kLate.eyes[0].orientation, kTrue.eyes[0].orientation);
+			errors.earlyTotal += kEarlyError;
+			errors.lateTotal += kLateError;
+			errors.earlyMax = std::max(errors.earlyMax, kEarlyError);
+			errors.lateMax = std::max(errors.lateMax, kLateError);
+			errors.latchMax = std::max(errors.latchMax, angle_between(kEarly.eyes[0].orientation, kLate.eyes[0].orientation));
+			errors.frames++;
+		}
+		CHECK_EQ(lifecycle.stats().missed, 0u);
+		return errors;
+	}
+}
+
+TEST_CASE(true_pose_matches_a_prediction_with_no_gap)
+{
+	SimulatedHmd hmd;
+	SyntheticPoseSource poses(&hmd);
+	for (u32 i = 0; i < 50; ++i)
+	{
+		hmd.advance(0.0137);
+		const PoseSample kNow = poses.sample(i, hmd.time_seconds());
+		const PoseSample kTrue = poses.true_pose(hmd.time_seconds());
+		CHECK(angle_between(kNow.eyes[1].orientation, kTrue.eyes[1].orientation) < 1e-3f);
+		CHECK(v3::Distance(kNow.eyes[1].position, kTrue.eyes[1].position) < 1e-5f);
+		CHECK_NEAR(v3::Distance(kTrue.eyes[0].position, kTrue.eyes[1].position), SyntheticPoseSource::kEyeSeparation, 1e-5f);
+	}
+}
+
+TEST_CASE(late_latch_cuts_the_prediction_error)
+{
+	// Six and a half of the 11.1 ms frame sit between the two samples.
+	SimulatedHmd hmd(90.0);
+	const LatchErrors kErrors = run_latched_frames(hmd, 900, 0.0065, 0.0005);
+	CHECK_EQ(hmd.missed(), 0u);
+
+	// The late prediction covers a shorter gap, so it is off by less, on average and at worst.
+	const f64 kEarlyMean = kErrors.earlyTotal / kErrors.frames;
+	const f64 kLateMean = kErrors.lateTotal / kErrors.frames;
+	CHECK(kEarlyMean > 0.0);
+	CHECK(kLateMean < kEarlyMean * 0.6);
+	CHECK(kErrors.lateMax < kErrors.earlyMax);
+}
+
+TEST_CASE(late_pose_stays_within_the_expanded_cull_window)
+{
+	// The app culls for a head turning at its fastest for one refresh between the samples.
+	SimulatedHmd hmd(90.0);
+	SyntheticPoseSource reference(&hmd);
+	const LatchErrors kErrors = run_latched_frames(hmd, 900, 0.009, 0.001);
+	CHECK(kErrors.latchMax > 0.f);
+	CHECK(kErrors.latchMax <= reference.max_angular_speed() * (f32)hmd.refresh_interval());
+}
+
+TEST_CASE(slow_frames_are_seen_late)
+{
+	// A frame that misses its vsync is shown a refresh later than predicted.
+	SimulatedHmd hmd(90.0);
+	FrameLifecycle lifecycle;
+	lifecycle.init(&hmd);
+	for (u32 i = 0; i < 10; ++i)
+	{
+		CHECK(lifecycle.begin_frame() == HmdFrameStatus::kRender);
+		hmd.advance(i == 4 ? 0.015 : 0.005);
+		lifecycle.end_frame(nullptr, 0);
+	}
+	CHECK_EQ(hmd.missed(), 1u);
+	CHECK_EQ(lifecycle.stats().frames, 10u);
+}
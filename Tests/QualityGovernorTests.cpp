@@ -0,0 +1,221 @@
+#include "TestHarness.h"
+#include "QualityGovernor.h"
+
+namespace
+{
+	// A 10 ms budget, drops over 9 ms, raises under 7 ms.
+	QualityGovernorDesc test_desc()
+	{
+		QualityGovernorDesc desc;
+		desc.budgetMs = 10.f;
+		desc.dropThreshold = 0.9f;
+		desc.raiseThreshold = 0.7f;
+		desc.raisePercentile = 0.9f;
+		desc.dropFrames = 4;
+		desc.raiseFrames = 10;
+		desc.maxRaiseFrames = 40;
+		return desc;
+	}
+
+	const f32 kSlowMs = 9.5f;   // over the drop threshold
+	const f32 kMiddleMs = 8.f;  // between the thresholds
+	const f32 kFastMs = 6.f;    // under the raise threshold
+	const f32 kLightCpuMs = 3.f;
+
+	// A recorded trace, runs of frames with the same times.
+	struct Trace
+	{
+		std::vector<FrameTiming> frames;
+
+		Trace& add(const u32 kCount, const f32 kGpuMs, const f32 kCpuMs = kLightCpuMs)
+		{
+			frames.insert(frames.end(), kCount, FrameTiming{ kCpuMs, kGpuMs });
+			return *this;
+		}
+	};
+
+	std::vector<QualityDecision> replay(QualityGovernor& rGovernor, const Trace& trace)
+	{
+		std::vector<QualityDecision> decisions;
+		for (const FrameTiming& timing : trace.frames)
+		{
+			decisions.push_back(rGovernor.update(timing));
+		}
+		return decisions;
+	}
+
+	u32 count(const std::vector<QualityDecision>& decisions, const QualityDecision decision)
+	{
+		return (u32)std::count(decisions.begin(), decisions.end(), decision);
+	}
+
+	// Index of the first decision of a kind, or the trace length.
+	u32 first(const std::vector<QualityDecision>& decisions, const QualityDecision decision)
+	{
+		return (u32)(std::find(decisions.begin(), decisions.end(), decision) - decisions.begin());
+	}
+
+	// Drop to level 1 and raise back to level 0, leaving the last change a raise.
+	void drop_and_raise(QualityGovernor& rGovernor)
+	{
+		replay(rGovernor, Trace().add(rGovernor.desc().dropFrames, kSlowMs).add(rGovernor.stats().raiseFrames, kFastMs));
+	}
+}
+
+TEST_CASE(drops_after_drop_frames_over_the_threshold)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+
+	// Three slow frames, a fast one restarts the count, then four in a row drop.
+	const std::vector<QualityDecision> kDecisions = replay(governor, Trace().add(3, kSlowMs).add(1, kFastMs).add(4, kSlowMs));
+	CHECK_EQ(count(kDecisions, QualityDecision::kDrop), 1u);
+	CHECK_EQ(first(kDecisions, QualityDecision::kDrop), 7u);
+	CHECK_EQ(governor.level_index(), 1u);
+	CHECK_EQ(governor.stats().drops, 1u);
+	CHECK_EQ(governor.stats().lastChangeFrame, 8u);
+
+	// The run starts over at the new level.
+	const std::vector<QualityDecision> kNext = replay(governor, Trace().add(3, kSlowMs));
+	CHECK_EQ(count(kNext, QualityDecision::kDrop), 0u);
+	CHECK(replay(governor, Trace().add(1, kSlowMs))[0] == QualityDecision::kDrop);
+	CHECK_EQ(governor.level_index(), 2u);
+}
+
+TEST_CASE(cheapest_level_holds_however_slow)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+	const std::vector<QualityDecision> kDecisions = replay(governor, Trace().add(1000, 20.f));
+	CHECK_EQ(governor.level_index(), governor.num_levels() - 1);
+	CHECK_EQ(count(kDecisions, QualityDecision::kDrop), governor.num_levels() - 1);
+	CHECK_EQ(governor.stats().overBudgetFrames, 1000u);
+}
+
+TEST_CASE(raise_needs_a_whole_wait_under_the_raise_threshold)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+	replay(governor, Trace().add(4, kSlowMs));
+	CHECK_EQ(governor.level_index(), 1u);
+
+	// Between the thresholds is the hysteresis band, nothing changes however long it lasts.
+	const std::vector<QualityDecision> kBand = replay(governor, Trace().add(500, kMiddleMs));
+	CHECK_EQ(count(kBand, QualityDecision::kHold), 500u);
+	CHECK_EQ(governor.level_index(), 1u);
+
+	// The 90th percentile of ten frames lets one slow frame through, so the ninth fast frame raises.
+	const std::vector<QualityDecision> kFast = replay(governor, Trace().add(10, kFastMs));
+	CHECK_EQ(first(kFast, QualityDecision::kRaise), 8u);
+	CHECK_EQ(governor.level_index(), 0u);
+	CHECK_EQ(governor.stats().raises, 1u);
+}
+
+TEST_CASE(raise_waits_for_frames_since_the_last_change)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+	replay(governor, Trace().add(4, kSlowMs));
+
+	// Frames before the drop don't count, a full raise wait has to pass at the new level.
+	const std::vector<QualityDecision> kDecisions = replay(governor, Trace().add(10, kFastMs));
+	CHECK_EQ(first(kDecisions, QualityDecision::kRaise), 9u);
+}
+
+TEST_CASE(failed_raises_double_the_wait_up_to_the_maximum)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+	drop_and_raise(governor);
+	CHECK_EQ(governor.level_index(), 0u);
+
+	// Each raise that drops straight back doubles the wait, 10, 20, 40 and no further.
+	const u32 kExpectedWaits[] = { 20, 40, 40 };
+	for (u32 i = 0; i < 3; ++i)
+	{
+		replay(governor, Trace().add(4, kSlowMs));
+		CHECK_EQ(governor.stats().failedRaises, i + 1);
+		CHECK_EQ(governor.stats().raiseFrames, kExpectedWaits[i]);
+
+		// The raise comes after exactly the new wait.
+		const std::vector<QualityDecision> kDecisions = replay(governor, Trace().add(kExpectedWaits[i], kFastMs));
+		CHECK_EQ(first(kDecisions, QualityDecision::kRaise), kExpectedWaits[i] - 1);
+	}
+	CHECK_EQ(governor.stats().drops, 4u);
+	CHECK_EQ(governor.stats().raises, 4u);
+}
+
+TEST_CASE(drop_after_a_held_raise_resets_the_wait)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+	drop_and_raise(governor);
+	replay(governor, Trace().add(4, kSlowMs));
+	CHECK_EQ(governor.stats().raiseFrames, 20u);
+	replay(governor, Trace().add(20, kFastMs));
+	CHECK_EQ(governor.level_index(), 0u);
+
+	// The raised level holds longer than the wait, so a later drop is a change in load, not a failed raise.
+	replay(governor, Trace().add(21, kMiddleMs).add(4, kSlowMs));
+	CHECK_EQ(governor.level_index(), 1u);
+	CHECK_EQ(governor.stats().failedRaises, 1u);
+	CHECK_EQ(governor.stats().raiseFrames, 10u);
+}
+
+TEST_CASE(cpu_bound_frames_hold)
+{
+	QualityGovernor governor;
+	governor.init(test_desc());
+
+	// Over budget on the CPU only, dropping wouldn't help.
+	const std::vector<QualityDecision> kDecisions = replay(governor, Trace().add(100, kFastMs, 15.f));
+	CHECK_EQ(count(kDecisions, QualityDecision::kCpuBound), 100u);
+	CHECK_EQ(governor.level_index(), 0u);
+	CHECK_EQ(governor.stats().cpuBoundFrames, 100u);
+	CHECK_EQ(governor.stats().overBudgetFrames, 100u);
+
+	// A slow GPU still drops with the CPU over too.
+	CHECK_EQ(first(replay(governor, Trace().add(4, kSlowMs, 15.f)), QualityDecision::kDrop), 3u);
+	CHECK_EQ(governor.level_index(), 1u);
+
+	// The GPU has headroom but one frame in five misses on the CPU, the CPU percentile blocks the raise.
+	Trace mixed;
+	for (u32 i = 0; i < 40; ++i)
+	{
+		mixed.add(4, kFastMs).add(1, kFastMs, 15.f);
+	}
+	const std::vector<QualityDecision> kMixed = replay(governor, mixed);
+	CHECK_EQ(count(kMixed, QualityDecision::kRaise), 0u);
+	CHECK_EQ(count(kMixed, QualityDecision::kCpuBound), 40u);
+	CHECK_EQ(governor.level_index(), 1u);
+
+	// Once the CPU recovers the raise goes through.
+	CHECK(count(replay(governor, Trace().add(10, kFastMs)), QualityDecision::kRaise) == 1u);
+	CHECK_EQ(governor.level_index(), 0u);
+}
+
+TEST_CASE(replaying_a_trace_repeats_every_decision)
+{
+	Random random(16);
+	Trace trace;
+	for (u32 i = 0; i < 5000; ++i)
+	{
+		// Load that wanders through every band.
+		const f32 kBase = 7.5f + 2.5f * std::sin((f32)i * 0.01f);
+		trace.add(1, kBase + random.range(-1.f, 1.f), random.range(2.f, 11.f));
+	}
+
+	QualityGovernor governor;
+	governor.init(test_desc());
+	const std::vector<QualityDecision> kFirst = replay(governor, trace);
+
+	QualityGovernor other;
+	other.init(test_desc());
+	CHECK(replay(other, trace) == kFirst);
+
+	// reset() forgets everything, so the same trace gives the same decisions again.
+	governor.reset();
+	CHECK(replay(governor, trace) == kFirst);
+	CHECK(count(kFirst, QualityDecision::kDrop) > 0);
+	CHECK(count(kFirst, QualityDecision::kRaise) > 0);
+}
@@ -0,0 +1,133 @@
+#include "TestHarness.h"
+#include "RangeAllocator.h"
+
+namespace
+{
+	struct Allocation
+	{
+		u32 offset;
+		u32 size;
+	};
+
+	// No two live allocations overlap and the free ranges account for the rest.
+	bool consistent(const RangeAllocator& allocator, const std::vector<Allocation>& live)
+	{
+		std::vector<Allocation> sorted = live;
+		std::sort(sorted.begin(), sorted.end(), [](const Allocation& a, const Allocation& b) { return a.offset < b.offset; });
+		u32 used = 0;
+		for (u32 i = 0; i < sorted.size(); ++i)
+		{
+			if (i > 0 && sorted[i - 1].offset + sorted[i - 1].size > sorted[i].offset)
+			{
+				return false;
+			}
+			used += sorted[i].size;
+		}
+		return used == allocator.used() && allocator.allocations() == live.size() && sorted.empty() == (allocator.free_ranges() <= 1 && allocator.largest_free() == allocator.capacity());
+	}
+}
+
+TEST_CASE(allocations_pack_from_the_front)
+{
+	RangeAllocator allocator;
+	allocator.init(100);
+	CHECK_EQ(allocator.allocate(10), 0u);
+	CHECK_EQ(allocator.allocate(20), 10u);
+	CHECK_EQ(allocator.allocate(70), 30u);
+	CHECK_EQ(allocator.used(), 100u);
+	CHECK_EQ(allocator.free_ranges(), 0u);
+
+	// Full, and zero sized requests never succeed.
+	CHECK_EQ(allocator.allocate(1), RangeAllocator::kInvalidOffset);
+	CHECK_EQ(allocator.allocate(0), RangeAllocator::kInvalidOffset);
+	CHECK_EQ(allocator.stats().failures, 2u);
+}
+
+TEST_CASE(best_fit_takes_the_smallest_range_that_holds_it)
+{
+	RangeAllocator allocator;
+	allocator.init(100);
+	const u32 a = allocator.allocate(30);
+	allocator.allocate(10);
+	const u32 c = allocator.allocate(10);
+	allocator.allocate(10);
+
+	// Holes of 30 at 0 and 10 at 40, with 40 left at the end.
+	allocator.free(a, 30);
+	allocator.free(c, 10);
+	CHECK_EQ(allocator.free_ranges(), 3u);
+	CHECK_EQ(allocator.allocate(8), 40u);
+	CHECK_EQ(allocator.allocate(25), 0u);
+	CHECK_EQ(allocator.allocate(40), 60u);
+	CHECK_EQ(allocator.largest_free(), 5u);
+}
+
+TEST_CASE(freed_ranges_merge_with_both_neighbours)
+{
+	RangeAllocator allocator;
+	allocator.init(40);
+	const u32 a = allocator.allocate(10);
+	const u32 b = allocator.allocate(10);
+	const u32 c = allocator.allocate(10);
+	const u32 d = allocator.allocate(10);
+
+	allocator.free(a, 10);
+	allocator.free(c, 10);
+	CHECK_EQ(allocator.free_ranges(), 2u);
+	CHECK_NEAR(allocator.stats().fragmentation, 0.5f, 1e-6);
+
+	// b joins the ranges either side into one, d then extends it to the end.
+	allocator.free(b, 10);
+	CHECK_EQ(allocator.free_ranges(), 1u);
+	CHECK_EQ(allocator.largest_free(), 30u);
+	allocator.free(d, 10);
+	CHECK_EQ(allocator.free_ranges(), 1u);
+	CHECK_EQ(allocator.largest_free(), 40u);
+	CHECK_EQ(allocator.stats().fragmentation, 0.f);
+	CHECK_EQ(allocator.allocate(40), 0u);
+}
+
+TEST_CASE(random_churn_stays_consistent)
+{
+	RangeAllocator allocator;
+	allocator.init(10000);
+	std::vector<Allocation> live;
+	Random random(11);
+	bool ok = true;
+	for (u32 step = 0; step < 20000; ++step)
+	{
+		if (live.empty() || random.below(3) != 0)
+		{
+			const u32 kSize = 1 + random.below(200);
+			const u32 kOffset = allocator.allocate(kSize);
+			if (kOffset != RangeAllocator::kInvalidOffset)
+			{
+				ok = ok && kOffset + kSize <= allocator.capacity();
+				live.push_back({ kOffset, kSize });
+			}
+			else
+			{
+				// Only fails when no single free range is large enough.
+				ok = ok && allocator.largest_free() < kSize;
+			}
+		}
+		else
+		{
+			const u32 kIndex = random.below((u32)live.size());
+			allocator.free(live[kIndex].offset, live[kIndex].size);
+			live[kIndex] = live.back();
+			live.pop_back();
+		}
+		ok = ok && consistent(allocator, live);
+	}
+	CHECK(ok);
+
+	// Everything back in any order leaves one range over the whole capacity.
+	for (const Allocation& allocation : live)
+	{
+		allocator.free(allocation.offset, allocation.size);
+	}
+	CHECK_EQ(allocator.free_ranges(), 1u);
+	CHECK_EQ(allocator.largest_free(), 10000u);
+	CHECK_EQ(allocator.used(), 0u);
+}
@@ -0,0 +1,189 @@
+#include "TestHarness.h"
+#include "RenderQueue.h"
+
+namespace
+{
+	struct KeyedEntry
+	{
+		u64 key;
+		u32 index;
+	};
+
+	// Stand ins for the device objects, the queue only compares their addresses.
+	u8 g_objects[16];
+
+	template <typename T>
+	const T* fake(const u32 i)
+	{
+		return reinterpret_cast<const T*>(&g_objects[i]);
+	}
+
+	DrawPacket make_packet(const u32 kShader, const u32 kMaterial, const u32 kMesh, const u32 kTag)
+	{
+		DrawPacket packet = {};
+		packet.pShader = fake<ShaderSet>(kShader);
+		packet.pDiffuse = fake<Texture>(kMaterial);
+		packet.pNormal = fake<Texture>(kMaterial + 1);
+		packet.pMesh = fake<Mesh>(kMesh);
+		packet.tileFactor = kTag; // identifies the packet in the output
+		return packet;
+	}
+
+	// Sorts with radix_sort_u64 and reports which buffer came back.
+	std::vector<KeyedEntry> radix_sort(const std::vector<u64>& keys, bool& rInScratch, bool& rScratchTouched)
+	{
+		std::vector<KeyedEntry> entries(keys.size());
+		for (u32 i = 0; i < keys.size(); ++i)
+		{
+			entries[i] = { keys[i], i };
+		}
+		std::vector<KeyedEntry> scratch(keys.size(), KeyedEntry{ ~0ull, ~0u });
+
+		const KeyedEntry* pResult = radix_sort_u64(entries.data(), scratch.data(), (u32)keys.size());
+		rInScratch = pResult == scratch.data();
+		rScratchTouched = std::any_of(scratch.begin(), scratch.end(), [](const KeyedEntry& e) { return e.index != ~0u; });
+		return rInScratch ? scratch : entries;
+	}
+}
+
+TEST_CASE(make_key_packs_fields_most_significant_first)
+{
+	CHECK_EQ(RenderQueue::make_key(0, 0, 0, 0), 0ull);
+	CHECK(RenderQueue::make_key(0x12, 0x3456, 0x789A, 0xBCDEF0) == 0x123456789ABCDEF0ull);
+	CHECK(RenderQueue::make_key(0xFF, 0xFFFF, 0xFFFF, 0xFFFFFF) == ~0ull);
+
+	// Each field outranks everything below it.
+	CHECK(RenderQueue::make_key(1, 0, 0, 0) > RenderQueue::make_key(0, 0xFFFF, 0xFFFF, 0xFFFFFF));
+	CHECK(RenderQueue::make_key(0, 1, 0, 0) > RenderQueue::make_key(0, 0, 0xFFFF, 0xFFFFFF));
+	CHECK(RenderQueue::make_key(0, 0, 1, 0) > RenderQueue::make_key(0, 0, 0, 0xFFFFFF));
+	CHECK_EQ(RenderQueue::kShaderBits + RenderQueue::kMaterialBits + RenderQueue::kMeshBits + RenderQueue::kDepthBits, 64u);
+}
+
+TEST_CASE(radix_sort_matches_stable_sort)
+{
+	Random random(3);
+	for (const u32 kCount : { 1u, 2u, 17u, 1000u, 20000u })
+	{
+		// Few distinct keys in every byte, so there are plenty of ties to keep in order.
+		std::vector<u64> keys(kCount);
+		for (u64& key : keys)
+		{
+			key = 0;
+			for (u32 byte = 0; byte < 8; ++byte)
+			{
+				key |= (u64)random.below(3) << (byte * 8 + random.below(8));
+			}
+		}
+
+		bool inScratch, scratchTouched;
+		const std::vector<KeyedEntry> kSorted = radix_sort(keys, inScratch, scratchTouched);
+
+		std::vector<KeyedEntry> expected(kCount);
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			expected[i] = { keys[i], i };
+		}
+		std::stable_sort(expected.begin(), expected.end(), [](const KeyedEntry& a, const KeyedEntry& b) { return a.key < b.key; });
+
+		bool same = true;
+		for (u32 i = 0; i < kCount; ++i)
+		{
+			same = same && kSorted[i].key == expected[i].key && kSorted[i].index == expected[i].index;
+		}
+		CHECK(same);
+	}
+}
+
+TEST_CASE(radix_sort_skips_uniform_digits)
+{
+	bool inScratch, scratchTouched;
+
+	// Every byte the same, no pass runs and the input comes back untouched.
+	std::vector<KeyedEntry> sorted = radix_sort({ 0x0102030405060708ull, 0x0102030405060708ull, 0x0102030405060708ull }, inScratch, scratchTouched);
+	CHECK(!inScratch);
+	CHECK(!scratchTouched);
+	CHECK(sorted[0].index == 0 && sorted[1].index == 1 && sorted[2].index == 2);
+
+	// Only the top byte differs, one pass into the scratch buffer.
+	sorted = radix_sort({ 0x0300000000000005ull, 0x0100000000000005ull, 0x0200000000000005ull }, inScratch, scratchTouched);
+	CHECK(inScratch);
+	CHECK(sorted[0].index == 1 && sorted[1].index == 2 && sorted[2].index == 0);
+
+	// Two differing bytes, two passes and back in the input buffer.
+	sorted = radix_sort({ 0x0200000000000001ull, 0x0100000000000002ull, 0x0100000000000001ull }, inScratch, scratchTouched);
+	CHECK(!inScratch);
+	CHECK(sorted[0].index == 2 && sorted[1].index == 1 && sorted[2].index == 0);
+
+	// Nothing to sort.
+	sorted = radix_sort({}, inScratch, scratchTouched);
+	CHECK(sorted.empty());
+}
+
+TEST_CASE(queue_groups_state_and_draws_front_to_back)
+{
+	RenderQueue queue;
+	queue.set_depth_range(0.f, 100.f);
+
+	// Two shaders, two materials, two meshes, interleaved and at mixed depths.
+	Random random(5);
+	for (u32 i = 0; i < 64; ++i)
+	{
+		queue.push(make_packet(random.below(2), 2 + 2 * random.below(2), 6 + random.below(2), i), random.range(0.f, 100.f));
+	}
+	queue.sort();
+
+	RecordingQueueBackend backend;
+	queue.submit(backend);
+	CHECK_EQ(backend.count(RecordingQueueBackend::kDraw), 64u);
+	CHECK_EQ(queue.stats().packets, 64u);
+
+	// Each shader bound once, each material once per shader, each mesh once per material.
+	CHECK_EQ(backend.count(RecordingQueueBackend::kBindShader), 2u);
+	CHECK(backend.count(RecordingQueueBackend::kBindMaterial) <= 4u);
+	CHECK(backend.count(RecordingQueueBackend::kBindMesh) <= 8u);
+	CHECK_EQ(queue.stats().shaderChanges, backend.count(RecordingQueueBackend::kBindShader));
+
+	// Keys ascend, so within one state depth ascends too.
+	for (u32 i = 1; i < queue.size(); ++i)
+	{
+		CHECK(queue.sorted_key(i - 1) <= queue.sorted_key(i));
+	}
+}
+
+TEST_CASE(queue_keeps_push_order_for_equal_keys)
+{
+	RenderQueue queue;
+	queue.set_depth_range(1.f, 10.f);
+
+	// Everything before the near plane clamps to depth 0, so these share one key.
+	for (u32 i = 0; i < 8; ++i)
+	{
+		queue.push(make_packet(0, 2, 6, i), -1.f - (f32)i);
+	}
+	queue.sort();
+
+	for (u32 i = 0; i < queue.size(); ++i)
+	{
+		CHECK_EQ(queue.sorted_packet(i).tileFactor, i);
+	}
+}
+
+TEST_CASE(submit_range_binds_all_state_for_its_first_packet)
+{
+	RenderQueue queue;
+	for (u32 i = 0; i < 4; ++i)
+	{
+		queue.push(make_packet(0, 2, 6, i), 1.f + (f32)i);
+	}
+	queue.sort();
+
+	RenderQueueStats stats = {};
+	RecordingQueueBackend backend;
+	queue.submit_range(backend, 2, 2, stats);
+	CHECK_EQ(backend.commands.size(), 5u);
+	CHECK(backend.commands[0].type == RecordingQueueBackend::kBindShader);
+	CHECK(backend.commands[1].type == RecordingQueueBackend::kBindMaterial);
+	CHECK(backend.commands[2].type == RecordingQueueBackend::kBindMesh);
+	CHECK_EQ(stats.packets, 2u);
+	CHECK_EQ(stats.meshChanges, 1u);
+}
@@ -0,0 +1,103 @@
+#include "TestHarness.h"
+#include "RingAllocator.h"
+
+namespace
+{
+	// As the constant ring uses it.
+	const u32 kSliceAlignment = 256;
+}
+
+TEST_CASE(allocations_are_aligned_and_packed)
+{
+	RingAllocator ring;
+	ring.init(4096, kSliceAlignment);
+
+	// Sizes either side of the alignment each take whole slices, one after another.
+	const u32 kSizes[] = { 64, 256, 257, 1, 512 };
+	const u32 kOffsets[] = { 0, 256, 512, 1024, 1280 };
+	for (u32 i = 0; i < 5; ++i)
+	{
+		const u32 kOffset = ring.allocate(kSizes[i]);
+		CHECK_EQ(kOffset, kOffsets[i]);
+		CHECK_EQ(kOffset % kSliceAlignment, 0u);
+	}
+	CHECK_EQ(ring.used(), 1792u);
+	CHECK_EQ(ring.allocations(), 5u);
+	CHECK_EQ(ring.aligned_size(320), 512u);
+}
+
+TEST_CASE(constant_ranges_are_whole_multiples_of_16)
+{
+	RingAllocator ring;
+	ring.init(64 * 1024, kSliceAlignment);
+
+	// *SetConstantBuffers1 wants the first constant and the count in multiples of 16 constants.
+	Random random(7);
+	for (u32 i = 0; i < 100; ++i)
+	{
+		const u32 kSize = 1 + random.below(1000);
+		const u32 kOffset = ring.allocate(kSize);
+		if (kOffset == RingAllocator::kInvalidOffset)
+		{
+			break;
+		}
+		u32 firstConstant = 0;
+		u32 numConstants = 0;
+		constant_range(ring, kOffset, kSize, firstConstant, numConstants);
+		CHECK_EQ(firstConstant % 16, 0u);
+		CHECK_EQ(numConstants % 16, 0u);
+		CHECK_EQ(firstConstant * kShaderConstantSize, kOffset);
+		CHECK(numConstants * kShaderConstantSize >= kSize);
+		CHECK(numConstants * kShaderConstantSize < kSize + kSliceAlignment);
+	}
+}
+
+TEST_CASE(overflow_returns_invalid_and_leaves_the_ring)
+{
+	RingAllocator ring;
+	ring.init(1024, kSliceAlignment);
+	CHECK_EQ(ring.allocate(700), 0u);
+
+	// 300 bytes rounds up to 512, past the 256 left.
+	CHECK_EQ(ring.allocate(300), RingAllocator::kInvalidOffset);
+	CHECK_EQ(ring.failures(), 1u);
+	CHECK_EQ(ring.used(), 768u);
+
+	// What still fits is handed out, then the ring is full.
+	CHECK_EQ(ring.allocate(200), 768u);
+	CHECK_EQ(ring.allocate(1), RingAllocator::kInvalidOffset);
+	CHECK_EQ(ring.allocate(0), RingAllocator::kInvalidOffset);
+	CHECK_EQ(ring.failures(), 3u);
+	CHECK_EQ(ring.allocations(), 2u);
+	CHECK_EQ(ring.used(), ring.capacity());
+}
+
+TEST_CASE(reset_starts_over_and_keeps_the_high_water)
+{
+	RingAllocator ring;
+	ring.init(4096, kSliceAlignment);
+	for (u32 i = 0; i < 6; ++i)
+	{
+		ring.allocate(100);
+	}
+	CHECK_EQ(ring.high_water(), 1536u);
+
+	// A quieter frame after a reset leaves the mark where the busiest one put it.
+	ring.reset();
+	CHECK_EQ(ring.used(), 0u);
+	CHECK_EQ(ring.allocations(), 0u);
+	CHECK_EQ(ring.allocate(100), 0u);
+	CHECK_EQ(ring.high_water(), 1536u);
+
+	// A busier one raises it.
+	ring.reset();
+	for (u32 i = 0; i < 10; ++i)
+	{
+		ring.allocate(100);
+	}
+	CHECK_EQ(ring.high_water(), 2560u);
+
+	// Init starts the mark over.
+	ring.init(4096, kSliceAlignment);
+	CHECK_EQ(ring.high_water(), 0u);
+}
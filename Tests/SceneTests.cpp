@@ -0,0 +1,180 @@
+#include "TestHarness.h"
+#include "MeshSimplify.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+
+namespace
+{
+	// Stand ins for the device objects, the scene only hands their addresses on.
+	u8 g_objects[16];
+
+	template <typename T>
+	const T* fake(const u32 i)
+	{
+		return reinterpret_cast<const T*>(&g_objects[i]);
+	}
+
+	// A mesh above its origin with three levels, and a small one with only its full detail.
+	void setup_scene(Scene& rScene)
+	{
+		SceneMesh meshes[2] = {};
+		meshes[0].pMesh = fake<Mesh>(1);
+		meshes[0].boundsCenter = v3(0.f, 1.f, 0.f);
+		meshes[0].boundsRadius = 1.f;
+		meshes[0].lods[0] = { 0, 300, 0.f };
+		meshes[0].lods[1] = { 300, 150, 0.05f };
+		meshes[0].lods[2] = { 450, 72, 0.3f };
+		meshes[0].numLods = 3;
+		meshes[1].pMesh = fake<Mesh>(2);
+		meshes[1].boundsRadius = 0.5f;
+		meshes[1].lods[0] = { 0, 36, 0.f };
+		meshes[1].numLods = 1;
+
+		const Texture* pTextures[4] = { fake<Texture>(3), fake<Texture>(4), fake<Texture>(5), fake<Texture>(6) };
+		rScene.set_meshes(meshes, 2);
+		rScene.set_textures(pTextures, 4);
+	}
+
+	v3 bounds_center(const Scene& scene, const u32 i)
+	{
+		const SphereBoundsSoA& bounds = scene.bounds();
+		return v3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+	}
+}
+
+TEST_CASE(bounds_follow_their_transforms)
+{
+	Scene scene;
+	setup_scene(scene);
+
+	// A transform with no object parents the first object.
+	TransformSystem& transforms = scene.transforms();
+	const u32 kParent = transforms.create(TransformSystem::kNoParent, v3(10.f, 0.f, 0.f), quat::Identity, v3::One);
+	scene.add_object(0, 0, transforms.create(kParent, v3(0.f, 0.f, 5.f), quat::Identity, v3::One), 1);
+	scene.add_object(1, 2, transforms.create(TransformSystem::kNoParent, v3(0.f, 0.f, -3.f), quat::Identity, v3::One), 1);
+	CHECK_EQ(scene.size(), 2u);
+
+	// Everything starts out dirty, the parent is updated but has no bounds.
+	CHECK_EQ(scene.update_transforms(), 3u);
+	CHECK_EQ((u32)scene.changed_objects().size(), 2u);
+	CHECK_NEAR((bounds_center(scene, 0) - v3(10.f, 1.f, 5.f)).Length(), 0.f, 1e-5f);
+	CHECK_NEAR((bounds_center(scene, 1) - v3(0.f, 0.f, -3.f)).Length(), 0.f, 1e-5f);
+	CHECK_EQ(scene.bounds().radius[0], 1.f);
+	CHECK_EQ(scene.bounds().radius[1], 0.5f);
+
+	// Nothing moved.
+	CHECK_EQ(scene.update_transforms(), 0u);
+	CHECK(scene.changed_objects().empty());
+
+	// Moving the parent only moves its child's bounds.
+	transforms.set_translation(kParent, v3(20.f, 0.f, 0.f));
+	CHECK_EQ(scene.update_transforms(), 2u);
+	CHECK_EQ((u32)scene.changed_objects().size(), 1u);
+	CHECK_EQ(scene.changed_objects()[0], 0u);
+	CHECK_NEAR((bounds_center(scene, 0) - v3(20.f, 1.f, 5.f)).Length(), 0.f, 1e-5f);
+
+	scene.clear();
+	CHECK_EQ(scene.size(), 0u);
+	CHECK_EQ(scene.bounds().size(), 0u);
+}
+
+TEST_CASE(only_animated_objects_update)
+{
+	Scene scene;
+	setup_scene(scene);
+
+	const SceneObject kTypes[] = { { 0, 0, 0, 1 }, { 1, 2, 0, 1 } };
+	SceneGeneratorDesc desc;
+	desc.count = 500;
+	desc.animatedFraction = 0.2f;
+	scene.add_generated(desc, kTypes, 2);
+	CHECK_EQ(scene.size(), 500u);
+	CHECK_EQ(desc.spacing, 2.f);
+	CHECK(scene.animated() > 0 && scene.animated() < scene.size());
+	scene.update_transforms();
+
+	// Spinning about +Y keeps every center where it was, only the animated ones are recomputed.
+	std::vector<v3> centers(scene.size());
+	for (u32 i = 0; i < scene.size(); ++i)
+	{
+		centers[i] = bounds_center(scene, i);
+		CHECK_NEAR(centers[i].y, scene.object(i).mesh == 0 ? 0.5f : -0.5f, 1e-5f);
+	}
+	scene.animate(1.25);
+	CHECK_EQ(scene.update_transforms(), scene.animated());
+	CHECK_EQ((u32)scene.changed_objects().size(), scene.animated());
+	bool ascending = true;
+	for (u32 i = 1; i < scene.changed_objects().size(); ++i)
+	{
+		ascending = ascending && scene.changed_objects()[i] > scene.changed_objects()[i - 1];
+	}
+	CHECK(ascending);
+	f32 maxMove = 0.f;
+	for (u32 i = 0; i < scene.size(); ++i)
+	{
+		maxMove = std::max(maxMove, (bounds_center(scene, i) - centers[i]).Length());
+	}
+	CHECK_NEAR(maxMove, 0.f, 1e-4f);
+}
+
+TEST_CASE(queue_draws_the_selected_levels)
+{
+	Scene scene;
+	setup_scene(scene);
+
+	// A row of objects going away along x, tagged by their index.
+	const u32 kNumObjects = 40;
+	TransformSystem& transforms = scene.transforms();
+	for (u32 i = 0; i < kNumObjects; ++i)
+	{
+		const u32 kMesh = i % 4 == 3 ? 1 : 0;
+		scene.add_object(kMesh, 2 * kMesh, transforms.create(TransformSystem::kNoParent, v3(2.f + 3.f * (f32)(i * i), 0.f, 0.f), quat::Identity, v3::One), i);
+	}
+	scene.update_transforms();
+
+	// Each object's level is the one its mesh picks at its distance.
+	const f32 kPixelsPerUnit = 600.f;
+	const f32 kNearClip = 0.2f;
+	scene.select_lods(v3::Zero, kNearClip, kPixelsPerUnit, 1.f);
+	u32 counts[kMaxMeshLods] = {};
+	for (u32 i = 0; i < kNumObjects; ++i)
+	{
+		const SceneMesh& mesh = scene.mesh(scene.object(i).mesh);
+		const f32 kDistance = std::max(bounds_center(scene, i).Length() - mesh.boundsRadius, kNearClip);
+		CHECK_EQ(scene.lod(i), select_lod(mesh.lods, mesh.numLods, kDistance, kPixelsPerUnit, 1.f));
+		counts[scene.lod(i)]++;
+	}
+	for (u32 i = 0; i < kMaxMeshLods; ++i)
+	{
+		CHECK_EQ(scene.lod_counts()[i], counts[i]);
+	}
+	CHECK(counts[0] > 0 && counts[2] > 0);
+
+	// Every other object is visible, each queued with its own level and the triangles it draws.
+	std::vector<u32> visible;
+	u32 expectedTriangles = 0;
+	for (u32 i = 0; i < kNumObjects; i += 2)
+	{
+		visible.push_back(i);
+		expectedTriangles += scene.mesh(scene.object(i).mesh).lods[scene.lod(i)].indexCount / 3;
+	}
+	RenderQueue queue;
+	queue.set_depth_range(kNearClip, 10000.f);
+	const m4x4 kViewProj = m4x4::CreateLookAt(v3::Zero, v3::UnitX, v3::UnitY) * m4x4::CreatePerspectiveFieldOfView(1.f, 1.f, kNearClip, 10000.f);
+	CHECK_EQ(scene.build_queue(queue, fake<ShaderSet>(0), kViewProj, visible.data(), (u32)visible.size()), expectedTriangles);
+	CHECK_EQ(queue.size(), (u32)visible.size());
+	bool levelsMatch = true;
+	for (u32 i = 0; i < queue.size(); ++i)
+	{
+		const DrawPacket& packet = queue.sorted_packet(i);
+		const SceneObject& object = scene.object(packet.tileFactor);
+		levelsMatch = levelsMatch && packet.lod == scene.lod(packet.tileFactor) && packet.pMesh == scene.mesh(object.mesh).pMesh
+			&& packet.pDiffuse == fake<Texture>(3 + object.texture) && packet.pNormal == fake<Texture>(4 + object.texture);
+	}
+	CHECK(levelsMatch);
+
+	// Without automatic levels everything draws at full detail, the visible objects all have the first mesh.
+	scene.reset_lods();
+	CHECK_EQ(scene.lod_counts()[0], kNumObjects);
+	CHECK_EQ(scene.build_queue(queue, fake<ShaderSet>(0), kViewProj, visible.data(), (u32)visible.size()), (u32)visible.size() * 100u);
+}
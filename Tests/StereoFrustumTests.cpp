@@ -0,0 +1,157 @@
+#include "TestHarness.h"
+#include "StereoFrustum.h"
+#include <cfloat>
+
+namespace
+{
+	// Asymmetric like a headset's, each eye wider on its outer side.
+	const FovTangents kLeftEye = { 1.3f, 1.4f, 1.2f, 1.0f };
+	const FovTangents kRightEye = { 1.3f, 1.4f, 1.0f, 1.2f };
+	const f32 kSeparation = 0.064f;
+	const f32 kNear = 0.1f;
+	const f32 kFar = 100.f;
+
+	// Signed distance inside, as the culling tests use the planes.
+	f32 min_plane_distance(const v4* pPlanes, const v3& point)
+	{
+		f32 distance = FLT_MAX;
+		for (u32 p = 0; p < kNumFrustumPlanes; ++p)
+		{
+			distance = std::min(distance, pPlanes[p].x * point.x + pPlanes[p].y * point.y + pPlanes[p].z * point.z + pPlanes[p].w);
+		}
+		return distance;
+	}
+
+	// A point of an eye's frustum in world space, the eye kEye of a head at the origin looking down +z,
+	// turned by rotation about the middle of the head and then moved by offset.
+	v3 eye_frustum_point(Random& random, const u32 kEye, const quat& rotation, const v3& offset)
+	{
+		const FovTangents& fov = kEye == 0 ? kLeftEye : kRightEye;
+
+		// Corners and edges are where containment fails first, so favour them.
+		auto pick = [&random](const f32 kLo, const f32 kHi)
+		{
+			const u32 kChoice = random.below(4);
+			return kChoice == 0 ? kLo : kChoice == 1 ? kHi : random.range(kLo, kHi);
+		};
+		const f32 kDepth = pick(kNear, kFar);
+		const v3 kLocal(pick(-fov.left, fov.right) * kDepth, pick(-fov.down, fov.up) * kDepth, kDepth);
+		const v3 kEyeOffset((kEye == 0 ? -0.5f : 0.5f) * kSeparation, 0.f, 0.f);
+		return v3::Transform(kLocal + kEyeOffset, rotation) + offset;
+	}
+
+	quat random_rotation(Random& random, const f32 kMaxAngle)
+	{
+		v3 axis(random.range(-1.f, 1.f), random.range(-1.f, 1.f), random.range(-1.f, 1.f));
+		axis.Normalize();
+		return quat::CreateFromAxisAngle(axis, random.range(0.f, 1.f) < 0.5f ? kMaxAngle : random.range(0.f, kMaxAngle));
+	}
+
+	v3 random_offset(Random& random, const f32 kMaxDistance)
+	{
+		v3 direction(random.range(-1.f, 1.f), random.range(-1.f, 1.f), random.range(-1.f, 1.f));
+		direction.Normalize();
+		return direction * (random.range(0.f, 1.f) < 0.5f ? kMaxDistance : random.range(0.f, kMaxDistance));
+	}
+}
+
+TEST_CASE(cull_frustum_contains_both_eyes)
+{
+	const StereoCullFrustum kFrustum = compute_stereo_cull_frustum(m4x4::Identity, kLeftEye, kRightEye, kSeparation, kNear, kFar);
+	CHECK_NEAR(kFrustum.apexOffset, 0.5f * kSeparation / 1.2f, 1e-6f);
+
+	Random random(18);
+	f32 worst = FLT_MAX;
+	for (u32 i = 0; i < 20000; ++i)
+	{
+		worst = std::min(worst, min_plane_distance(kFrustum.planes, eye_frustum_point(random, i & 1, quat::Identity, v3::Zero)));
+	}
+	CHECK(worst > -1e-4f);
+}
+
+TEST_CASE(cull_frustum_apex_is_behind_the_eyes)
+{
+	// View space is left handed and looks down +z, the apex has to be at -z or it cuts off what is just ahead of the eyes.
+	const StereoCullFrustum kFrustum = compute_stereo_cull_frustum(m4x4::Identity, kLeftEye, kRightEye, kSeparation, kNear, kFar);
+	const v3 kApex = v3::Transform(v3(0.f, 0.f, -kFrustum.apexOffset), kFrustum.view);
+	CHECK(v3::Distance(kApex, v3::Zero) < 1e-5f);
+
+	// Small objects on each eye's near plane, straight ahead and at its outer edges, all survive culling.
+	SphereBoundsSoA bounds;
+	for (const f32 kX : { -0.5f * kSeparation, 0.5f * kSeparation })
+	{
+		bounds.add(v3(kX, 0.f, kNear), 0.01f);
+		bounds.add(v3(kX - kLeftEye.left * kNear, 0.f, kNear), 0.01f);
+		bounds.add(v3(kX + kRightEye.right * kNear, 0.f, kNear), 0.01f);
+	}
+	std::vector<u32> visible(bounds.size());
+	CHECK_EQ(cull_spheres(CullKernel::kScalar, kFrustum.planes, bounds, visible.data()), bounds.size());
+
+	// Behind the eyes is still culled.
+	SphereBoundsSoA behind;
+	behind.add(v3(0.f, 0.f, -kFrustum.apexOffset - 0.1f), 0.01f);
+	CHECK_EQ(cull_spheres(CullKernel::kScalar, kFrustum.planes, behind, visible.data()), 0u);
+}
+
+TEST_CASE(widened_tangents_grow_with_the_angle)
+{
+	const FovTangents kSame = widen_fov_tangents(kLeftEye, 0.f);
+	CHECK_NEAR(kSame.up, kLeftEye.up, 1e-6f);
+	CHECK_NEAR(kSame.left, kLeftEye.left, 1e-6f);
+
+	// A turn of a in the plane of a side adds a to that side's angle, the corners need more.
+	const FovTangents kWide = widen_fov_tangents(kLeftEye, 0.1f);
+	CHECK(atanf(kWide.left) > atanf(kLeftEye.left) + 0.1f - 1e-5f);
+	CHECK(atanf(kWide.up) > atanf(kLeftEye.up) + 0.1f - 1e-5f);
+	CHECK(kWide.right > kLeftEye.right && kWide.down > kLeftEye.down);
+}
+
+TEST_CASE(expanded_frustum_contains_eyes_turned_and_moved)
+{
+	// One 90 Hz frame of a fast head, as the app culls for when late latching.
+	const f32 kMaxAngle = 5.f / 90.f;
+	const f32 kMaxDistance = 2.f / 90.f;
+	const StereoCullFrustum kFrustum = compute_expanded_stereo_cull_frustum(m4x4::Identity, kLeftEye, kRightEye, kSeparation, kNear, kFar,
+		kMaxAngle, kMaxDistance);
+
+	Random random(180);
+	f32 worst = FLT_MAX;
+	for (u32 i = 0; i < 50000; ++i)
+	{
+		const quat kRotation = random_rotation(random, kMaxAngle);
+		const v3 kOffset = random_offset(random, kMaxDistance);
+		worst = std::min(worst, min_plane_distance(kFrustum.planes, eye_frustum_point(random, i & 1, kRotation, kOffset)));
+	}
+	CHECK(worst > -1e-4f);
+
+	// The plain frustum doesn't hold them, or this test would prove nothing.
+	const StereoCullFrustum kPlain = compute_stereo_cull_frustum(m4x4::Identity, kLeftEye, kRightEye, kSeparation, kNear, kFar);
+	f32 plainWorst = FLT_MAX;
+	for (u32 i = 0; i < 2000; ++i)
+	{
+		plainWorst = std::min(plainWorst, min_plane_distance(kPlain.planes, eye_frustum_point(random, i & 1, random_rotation(random, kMaxAngle), random_offset(random, kMaxDistance))));
+	}
+	CHECK(plainWorst < -0.1f);
+}
+
+TEST_CASE(expanded_frustum_follows_the_center_view)
+{
+	// The same containment for a head somewhere else, looking another way.
+	const quat kHeadRotation = quat::CreateFromYawPitchRoll(0.7f, -0.3f, 0.1f);
+	const v3 kHeadPosition(3.f, 1.6f, -2.f);
+	const m4x4 kCenterView = m4x4::CreateLookAt(kHeadPosition, kHeadPosition + v3::Transform(v3::UnitZ, kHeadRotation), v3::Transform(v3::UnitY, kHeadRotation));
+
+	const f32 kMaxAngle = 0.05f;
+	const f32 kMaxDistance = 0.02f;
+	const StereoCullFrustum kFrustum = compute_expanded_stereo_cull_frustum(kCenterView, kLeftEye, kRightEye, kSeparation, kNear, kFar,
+		kMaxAngle, kMaxDistance);
+
+	Random random(181);
+	f32 worst = FLT_MAX;
+	for (u32 i = 0; i < 20000; ++i)
+	{
+		const v3 kLocal = eye_frustum_point(random, i & 1, random_rotation(random, kMaxAngle), random_offset(random, kMaxDistance));
+		worst = std::min(worst, min_plane_distance(kFrustum.planes, v3::Transform(kLocal, kHeadRotation) + kHeadPosition));
+	}
+	CHECK(worst > -1e-4f);
+}
@@ -0,0 +1,53 @@
+#include "TestHarness.h"
+
+namespace
+{
+	const char* g_pCurrentTest = "";
+	u32 g_failures = 0;
+}
+
+std::vector<TestCase>& test_registry()
+{
+	static std::vector<TestCase> s_tests;
+	return s_tests;
+}
+
+void test_fail(const char* pFile, const int kLine, const char* pFormat, ...)
+{
+	char buffer[1024] = { '\0' };
+	va_list args;
+	va_start(args, pFormat);
+	std::vsnprintf(buffer, sizeof(buffer), pFormat, args);
+	va_end(args);
+
+	std::fprintf(stderr, "%s(%d): %s failed %s\n", pFile, kLine, g_pCurrentTest, buffer);
+	g_failures++;
+}
+
+int main(int argc, char** argv)
+{
+	// An argument runs only the tests with it in their name.
+	const char* pFilter = argc > 1 ? argv[1] : nullptr;
+
+	u32 run = 0;
+	u32 failed = 0;
+	for (const TestCase& test : test_registry())
+	{
+		if (pFilter && !strstr(test.pName, pFilter))
+		{
+			continue;
+		}
+
+		g_pCurrentTest = test.pName;
+		const u32 kFailuresBefore = g_failures;
+		test.pFunction();
+		run++;
+
+		const bool kPassed = g_failures == kFailuresBefore;
+		failed += kPassed ? 0 : 1;
+		std::printf("%s %s\n", kPassed ? "[ pass ]" : "[ FAIL ]", test.pName);
+	}
+
+	std::printf("%u of %u tests passed\n", run - failed, run);
+	return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreHeader.h"
+#include <vector>
+
+//================================================================================
+// Test Harness
+// Just enough to check the platform free modules under CTest. Each test file
+// is its own executable, TEST_CASE registers a function and main runs them
+// all, returning non zero when any CHECK failed.
+//
+// CHECK carries on after a failure so one run reports every broken case.
+//================================================================================
+struct TestCase
+{
+	const char* pName;
+	void (*pFunction)();
+};
+
+std::vector<TestCase>& test_registry();
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* pName, void (*pFunction)())
+	{
+		test_registry().push_back({ pName, pFunction });
+	}
+};
+
+// Records a failure of the running test.
+void test_fail(const char* pFile, const int kLine, const char* pFormat, ...);
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestRegistrar s_register_##name(#name, name); \
+	static void name()
+
+#define CHECK(x) \
+	if (!(x)) { test_fail(__FILE__, __LINE__, "CHECK(%s)", #x); }
+
+#define CHECK_EQ(a, b) \
+	if (!((a) == (b))) { test_fail(__FILE__, __LINE__, "CHECK_EQ(%s, %s) %.9g != %.9g", #a, #b, (double)(a), (double)(b)); }
+
+#define CHECK_NEAR(a, b, tolerance) \
+	if (!(std::fabs((double)(a) - (double)(b)) <= (double)(tolerance))) { test_fail(__FILE__, __LINE__, "CHECK_NEAR(%s, %s) %.9g != %.9g", #a, #b, (double)(a), (double)(b)); }
+
+// Kernels this CPU can run, scalar first.
+template <typename Kernel, typename Fn>
+void for_each_kernel(const Kernel kBest, Fn fn)
+{
+	for (u32 kernel = 0; kernel <= (u32)kBest; ++kernel)
+	{
+		fn((Kernel)kernel);
+	}
+}
@@ -0,0 +1,230 @@
+#include "TestHarness.h"
+#include "TransformSystem.h"
+
+namespace
+{
+	struct LocalValues
+	{
+		v3 translation;
+		quat rotation;
+		v3 scale;
+	};
+
+	LocalValues random_local(Random& rRandom)
+	{
+		quat rotation = quat::CreateFromAxisAngle(v3(rRandom.range(-1.f, 1.f), rRandom.range(-1.f, 1.f), 1.f), rRandom.range(-kfPI, kfPI));
+		rotation.Normalize();
+		return { v3(rRandom.range(-5.f, 5.f), rRandom.range(-5.f, 5.f), rRandom.range(-5.f, 5.f)), rotation, v3(rRandom.range(0.5f, 2.f), rRandom.range(0.5f, 2.f), rRandom.range(0.5f, 2.f)) };
+	}
+
+	// A forest where later roots and children interleave, so no subtree is contiguous.
+	struct TestHierarchy
+	{
+		std::vector<u32> parents;
+		std::vector<LocalValues> locals;
+
+		TestHierarchy(const u32 kCount, const u64 kSeed)
+		{
+			Random random(kSeed);
+			for (u32 i = 0; i < kCount; ++i)
+			{
+				parents.push_back((i == 0 || random.below(5) == 0) ? TransformSystem::kNoParent : random.below(i));
+				locals.push_back(random_local(random));
+			}
+		}
+
+		void create(TransformSystem& rSystem) const
+		{
+			for (u32 i = 0; i < parents.size(); ++i)
+			{
+				rSystem.create(parents[i], locals[i].translation, locals[i].rotation, locals[i].scale);
+			}
+		}
+
+		// Built from SimpleMath one matrix at a time, parents first.
+		std::vector<m4x4> reference_worlds() const
+		{
+			std::vector<m4x4> worlds(parents.size());
+			for (u32 i = 0; i < parents.size(); ++i)
+			{
+				const m4x4 kLocal = m4x4::CreateScale(locals[i].scale) * m4x4::CreateFromQuaternion(locals[i].rotation) * m4x4::CreateTranslation(locals[i].translation);
+				worlds[i] = parents[i] == TransformSystem::kNoParent ? kLocal : kLocal * worlds[parents[i]];
+			}
+			return worlds;
+		}
+
+		// i and everything below it, ascending.
+		std::vector<u32> subtree(const u32 kRoot) const
+		{
+			std::vector<u32> result;
+			for (u32 i = 0; i < parents.size(); ++i)
+			{
+				for (u32 node = i; node != TransformSystem::kNoParent; node = parents[node])
+				{
+					if (node == kRoot)
+					{
+						result.push_back(i);
+						break;
+					}
+				}
+			}
+			return result;
+		}
+	};
+
+	f32 max_difference(const m4x4& a, const m4x4& b)
+	{
+		f32 difference = 0.f;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			difference = std::max(difference, std::fabs((&a._11)[i] - (&b._11)[i]));
+		}
+		return difference;
+	}
+}
+
+TEST_CASE(worlds_match_simple_math)
+{
+	const TestHierarchy kHierarchy(500, 1);
+	const std::vector<m4x4> kReference = kHierarchy.reference_worlds();
+
+	for_each_kernel(TransformKernel::kSSE, [&](const TransformKernel kernel)
+	{
+		TransformSystem transforms;
+		kHierarchy.create(transforms);
+		CHECK_EQ(transforms.update(kernel), 500u);
+
+		f32 error = 0.f;
+		for (u32 i = 0; i < transforms.size(); ++i)
+		{
+			error = std::max(error, max_difference(transforms.world(i), kReference[i]) / std::max(1.f, std::fabs(kReference[i]._41)));
+		}
+		CHECK(error < 1e-4f);
+	});
+}
+
+TEST_CASE(kernels_agree_exactly)
+{
+	const TestHierarchy kHierarchy(1000, 2);
+	TransformSystem scalar;
+	TransformSystem sse;
+	kHierarchy.create(scalar);
+	kHierarchy.create(sse);
+
+	// A few frames of scattered changes, the same on both.
+	Random random(3);
+	for (u32 frame = 0; frame < 5; ++frame)
+	{
+		for (u32 change = 0; change < 50; ++change)
+		{
+			const u32 i = random.below(1000);
+			const LocalValues kLocal = random_local(random);
+			scalar.set_local(i, kLocal.translation, kLocal.rotation, kLocal.scale);
+			sse.set_local(i, kLocal.translation, kLocal.rotation, kLocal.scale);
+		}
+		CHECK_EQ(scalar.update(TransformKernel::kScalar), sse.update(TransformKernel::kSSE));
+
+		bool same = true;
+		for (u32 i = 0; i < 1000; ++i)
+		{
+			same = same && scalar.world(i) == sse.world(i) && scalar.local(i) == sse.local(i);
+		}
+		CHECK(same);
+	}
+}
+
+TEST_CASE(clean_update_does_nothing)
+{
+	const TestHierarchy kHierarchy(100, 4);
+	TransformSystem transforms;
+	kHierarchy.create(transforms);
+	transforms.update();
+
+	CHECK_EQ(transforms.update(), 0u);
+	CHECK(transforms.changed().empty());
+}
+
+TEST_CASE(changed_lists_exactly_the_dirty_subtrees)
+{
+	const TestHierarchy kHierarchy(400, 5);
+	TransformSystem transforms;
+	kHierarchy.create(transforms);
+	transforms.update();
+
+	Random random(6);
+	for (u32 test = 0; test < 50; ++test)
+	{
+		// One to three dirty transforms, possibly nested, possibly set twice.
+		std::vector<u32> expected;
+		const u32 kDirty = 1 + random.below(3);
+		for (u32 n = 0; n < kDirty; ++n)
+		{
+			const u32 i = random.below(400);
+			transforms.set_translation(i, v3((f32)test, 0.f, 0.f));
+			transforms.set_scale(i, v3::One);
+			const std::vector<u32> kSubtree = kHierarchy.subtree(i);
+			expected.insert(expected.end(), kSubtree.begin(), kSubtree.end());
+		}
+		std::sort(expected.begin(), expected.end());
+		expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+		CHECK_EQ(transforms.update(), (u32)expected.size());
+		CHECK(transforms.changed() == expected);
+	}
+}
+
+TEST_CASE(incremental_updates_match_a_fresh_build)
+{
+	TestHierarchy hierarchy(2000, 7);
+	TransformSystem transforms;
+	hierarchy.create(transforms);
+	transforms.update();
+
+	// Ten frames of edits, applied to both the system and the description.
+	Random random(8);
+	for (u32 frame = 0; frame < 10; ++frame)
+	{
+		for (u32 change = 0; change < 100; ++change)
+		{
+			const u32 i = random.below(2000);
+			hierarchy.locals[i] = random_local(random);
+			transforms.set_local(i, hierarchy.locals[i].translation, hierarchy.locals[i].rotation, hierarchy.locals[i].scale);
+		}
+		transforms.update();
+	}
+
+	TransformSystem fresh;
+	hierarchy.create(fresh);
+	fresh.update();
+
+	bool same = true;
+	for (u32 i = 0; i < 2000; ++i)
+	{
+		same = same && transforms.world(i) == fresh.world(i);
+	}
+	CHECK(same);
+}
+
+TEST_CASE(transforms_created_after_an_update_join_the_next)
+{
+	TransformSystem transforms;
+	const u32 kRoot = transforms.create(TransformSystem::kNoParent, v3(1.f, 0.f, 0.f), quat::Identity, v3::One);
+	transforms.update();
+
+	// Enough to cross a bitmask word.
+	for (u32 i = 0; i < 100; ++i)
+	{
+		transforms.create(kRoot, v3(0.f, (f32)i, 0.f), quat::Identity, v3::One);
+	}
+	CHECK_EQ(transforms.update(), 100u);
+	CHECK_EQ(transforms.changed().front(), 1u);
+	CHECK_EQ(transforms.world(100)._41, 1.f);
+	CHECK_EQ(transforms.world(100)._42, 99.f);
+
+	transforms.set_translation(kRoot, v3(2.f, 0.f, 0.f));
+	CHECK_EQ(transforms.update(), 101u);
+	CHECK_EQ(transforms.world(64)._41, 2.f);
+
+	transforms.clear();
+	CHECK_EQ(transforms.update(), 0u);
+}
@@ -0,0 +1,168 @@
+#include "TestHarness.h"
+#include "ViewLayout.h"
+
+namespace
+{
+	// Pixel of a point in the viewport's clip space, y down.
+	v2 clip_to_pixel(const v4& clip, const ViewRect& viewport)
+	{
+		return v2(viewport.x + (clip.x / clip.w * 0.5f + 0.5f) * viewport.width, viewport.y + (0.5f - clip.y / clip.w * 0.5f) * viewport.height);
+	}
+
+	// The point of the viewport's clip space at a pixel, at depth w.
+	v4 pixel_to_clip(const v2& pixel, const ViewRect& viewport, const f32 w)
+	{
+		const f32 kX = (pixel.x - viewport.x) / viewport.width * 2.f - 1.f;
+		const f32 kY = 1.f - (pixel.y - viewport.y) / viewport.height * 2.f;
+		return v4(kX * w, kY * w, 0.5f * w, w);
+	}
+
+	f32 plane_distance(const v4& plane, const v4& p)
+	{
+		return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w * p.w;
+	}
+
+	bool inside(const ViewTransform& transform, const v4& p)
+	{
+		for (const v4& plane : transform.clipPlanes)
+		{
+			if (plane_distance(plane, p) < 0.f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Two eyes side by side, each split into a top and bottom view.
+	ViewLayout<4> split_stereo_layout()
+	{
+		const ViewRect kEyes[2] = { { 0.f, 0.f, 640.f, 720.f }, { 640.f, 0.f, 640.f, 720.f } };
+		ViewRect views[4];
+		split_view_rect_rows(kEyes[0], &views[0]);
+		split_view_rect_rows(kEyes[1], &views[2]);
+		return make_view_layout<4>(views);
+	}
+}
+
+TEST_CASE(stereo_eyes_take_each_half_of_the_viewport)
+{
+	const ViewRect kEyes[2] = { { 0.f, 0.f, 640.f, 720.f }, { 640.f, 0.f, 640.f, 720.f } };
+	const ViewLayout<2> kLayout = make_view_layout<2>(kEyes);
+
+	CHECK_EQ(kLayout.viewport.width, 1280.f);
+	CHECK_EQ(kLayout.viewport.height, 720.f);
+	CHECK(kLayout.transforms[0].scaleOffset == v4(0.5f, 1.f, -0.5f, 0.f));
+	CHECK(kLayout.transforms[1].scaleOffset == v4(0.5f, 1.f, 0.5f, 0.f));
+
+	// A single view fills its own viewport.
+	const ViewLayout<1> kMono = make_view_layout<1>(&kEyes[1]);
+	CHECK(kMono.transforms[0].scaleOffset == v4(1.f, 1.f, 0.f, 0.f));
+	CHECK_EQ(kMono.viewport.x, 640.f);
+}
+
+TEST_CASE(view_corners_land_on_the_view_rect)
+{
+	// Uneven views, offset from the origin and apart from each other.
+	const ViewRect kViews[4] = { { 100.f, 50.f, 300.f, 200.f }, { 420.f, 50.f, 100.f, 400.f }, { 100.f, 300.f, 250.f, 150.f }, { 700.f, 500.f, 60.f, 30.f } };
+	const ViewLayout<4> kLayout = make_view_layout<4>(kViews);
+	CHECK_EQ(kLayout.viewport.x, 100.f);
+	CHECK_EQ(kLayout.viewport.y, 50.f);
+	CHECK_EQ(kLayout.viewport.width, 660.f);
+	CHECK_EQ(kLayout.viewport.height, 480.f);
+
+	for (u32 i = 0; i < 4; ++i)
+	{
+		const m4x4 kOffset = view_offset_matrix(kLayout.transforms[i]);
+		const ViewRect& view = kViews[i];
+		for (const f32 kW : { 1.f, 0.25f, 30.f })
+		{
+			// The view's ndc corners, projected with some w, top left first.
+			const v4 kTopLeft = v4::Transform(v4(-kW, kW, 0.3f * kW, kW), kOffset);
+			const v4 kBottomRight = v4::Transform(v4(kW, -kW, 0.3f * kW, kW), kOffset);
+			const v2 kTopLeftPixel = clip_to_pixel(kTopLeft, kLayout.viewport);
+			const v2 kBottomRightPixel = clip_to_pixel(kBottomRight, kLayout.viewport);
+			CHECK_NEAR(kTopLeftPixel.x, view.x, 1e-3);
+			CHECK_NEAR(kTopLeftPixel.y, view.y, 1e-3);
+			CHECK_NEAR(kBottomRightPixel.x, view.x + view.width, 1e-3);
+			CHECK_NEAR(kBottomRightPixel.y, view.y + view.height, 1e-3);
+
+			// Depth and w pass through untouched.
+			CHECK_EQ(kTopLeft.z, 0.3f * kW);
+			CHECK_EQ(kTopLeft.w, kW);
+		}
+	}
+}
+
+TEST_CASE(clip_planes_keep_each_view_inside_its_rect)
+{
+	const ViewLayout<4> kLayout = split_stereo_layout();
+
+	// Every pixel center is inside exactly the view whose rect holds it, at any depth.
+	Random random(1);
+	u32 wrong = 0;
+	for (u32 test = 0; test < 2000; ++test)
+	{
+		const v2 kPixel(random.below(1280) + 0.5f, random.below(720) + 0.5f);
+		const v4 kClip = pixel_to_clip(kPixel, kLayout.viewport, random.range(0.1f, 50.f));
+		for (u32 i = 0; i < 4; ++i)
+		{
+			const ViewRect& view = kLayout.views[i];
+			const bool kInRect = kPixel.x >= view.x && kPixel.x < view.x + view.width && kPixel.y >= view.y && kPixel.y < view.y + view.height;
+			if (inside(kLayout.transforms[i], kClip) != kInRect)
+			{
+				wrong++;
+			}
+		}
+	}
+	CHECK_EQ(wrong, 0u);
+}
+
+TEST_CASE(neighbouring_views_share_their_edge)
+{
+	const ViewLayout<4> kLayout = split_stereo_layout();
+
+	// Left eye's views side by side with the right eye's, top views above bottom views.
+	const v4* pTopLeft = kLayout.transforms[0].clipPlanes;
+	const v4* pBottomLeft = kLayout.transforms[1].clipPlanes;
+	const v4* pTopRight = kLayout.transforms[2].clipPlanes;
+
+	// The planes either side of a shared edge are the same plane facing opposite ways, so no pixel is drawn twice or dropped.
+	CHECK(pTopLeft[1] == -pTopRight[0]);
+	CHECK(pTopLeft[2] == -pBottomLeft[3]);
+	CHECK(pBottomLeft[3] == v4(0.f, -1.f, 0.f, 0.f)); // the middle row of the viewport
+
+	// Points on the seam are inside both.
+	const v4 kSeam(0.f, 0.5f, 0.5f, 1.f);
+	CHECK(inside(kLayout.transforms[0], kSeam));
+	CHECK(inside(kLayout.transforms[2], kSeam));
+}
+
+TEST_CASE(split_projections_recompose_the_full_view)
+{
+	// A frustum split at its middle row, each half squeezed back into its half of the rect, draws the same image.
+	const f32 kLeft = -0.4f, kRight = 0.6f, kBottom = -0.5f, kTop = 0.3f;
+	const f32 kMiddle = 0.5f * (kBottom + kTop);
+	const m4x4 kFull = m4x4::CreatePerspectiveOffCenter(kLeft, kRight, kBottom, kTop, 0.1f, 100.f);
+	const m4x4 kHalves[2] = {
+		m4x4::CreatePerspectiveOffCenter(kLeft, kRight, kMiddle, kTop, 0.1f, 100.f),
+		m4x4::CreatePerspectiveOffCenter(kLeft, kRight, kBottom, kMiddle, 0.1f, 100.f) };
+
+	const ViewRect kEye = { 0.f, 0.f, 640.f, 720.f };
+	ViewRect rows[2];
+	split_view_rect_rows(kEye, rows);
+	CHECK_EQ(rows[0].height, 360.f);
+	CHECK_EQ(rows[1].y, 360.f);
+
+	const ViewLayout<2> kLayout = make_view_layout<2>(rows);
+	for (u32 half = 0; half < 2; ++half)
+	{
+		const m4x4 kPlaced = kHalves[half] * view_offset_matrix(kLayout.transforms[half]);
+		f32 error = 0.f;
+		for (u32 i = 0; i < 16; ++i)
+		{
+			error = std::max(error, std::fabs((&kPlaced._11)[i] - (&kFull._11)[i]));
+		}
+		CHECK(error < 1e-5f);
+	}
+}